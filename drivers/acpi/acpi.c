@@ -28,9 +28,13 @@
  * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
  * OF THE POSSIBILITY OF SUCH DAMAGE.
  */
+#include <kconfig.h>
+#include <libpayload-config.h>
+#include <libpayload.h>
 #include <conf_table.h>
 #include <stdint.h>
 #include <string.h>
+#include <ewperf.h>
 #include "acpi.h"
 #include "AcpiTableProtocol.h"
 #include "acpi50.h"
@@ -358,6 +362,94 @@ static EFIAPI EFI_STATUS UninstallAcpiTable(__attribute__((__unused__))
 	return EFI_UNSUPPORTED;
 }
 
+/* Firmware Performance Data Table */
+#define FPDT_SIGNATURE SIGNATURE_32('F', 'P', 'D', 'T')
+#define FPDT_BOOT_POINTER_RECORD_TYPE 0x0000
+
+struct fpdt {
+	EFI_ACPI_DESCRIPTION_HEADER header;
+	ewperf_record_header_t boot_pointer;
+	UINT32 reserved;
+	UINT64 fbpt_address;
+} __attribute__((packed));
+
+/* The FBPT is reserved and published at initialization: pages
+   allocated at ExitBootServices() would not be part of the memory
+   map the OS loader already got.  Its records are refreshed in place
+   at ExitBootServices(). */
+#define FBPT_PAGES	16
+#define FBPT_SIZE	(FBPT_PAGES * EFI_PAGE_SIZE)
+
+static EFI_EXIT_BOOT_SERVICES saved_exit_boot_services;
+static VOID *fbpt;
+
+static EFI_STATUS install_fpdt(void)
+{
+	struct fpdt fpdt = {
+		.header = {
+			.Signature = FPDT_SIGNATURE,
+			.Length = sizeof(fpdt),
+			.Revision = 1,
+		},
+		.boot_pointer = {
+			.type = FPDT_BOOT_POINTER_RECORD_TYPE,
+			.length = sizeof(fpdt) - sizeof(fpdt.header),
+			.revision = 1
+		}
+	};
+	EFI_PHYSICAL_ADDRESS address;
+	EFI_STATUS ret;
+	UINTN key;
+
+	ret = p_st->BootServices->AllocatePages(AllocateAnyPages,
+						EfiReservedMemoryType,
+						FBPT_PAGES, &address);
+	if (EFI_ERROR(ret))
+		return ret;
+
+	ret = ewperf_write_fbpt((VOID *)(UINTN)address, FBPT_SIZE);
+	if (EFI_ERROR(ret))
+		goto err;
+
+	memcpy(fpdt.header.OemId, Rsdp->oem_id, sizeof(fpdt.header.OemId));
+	fpdt.fbpt_address = address;
+	fpdt.header.Checksum = checksum((UINT8 *)&fpdt, sizeof(fpdt));
+
+	ret = InstallAcpiTable(NULL, &fpdt, sizeof(fpdt), &key);
+	if (EFI_ERROR(ret))
+		goto err;
+
+	fbpt = (VOID *)(UINTN)address;
+	return EFI_SUCCESS;
+
+err:
+	p_st->BootServices->FreePages(address, FBPT_PAGES);
+	return ret;
+}
+
+static EFIAPI EFI_STATUS
+acpi_exit_boot_services(EFI_HANDLE ImageHandle, UINTN MapKey)
+{
+	EFI_STATUS ret;
+
+	ewperf_boot_step(EWPERF_EXIT_BOOT_SERVICES_ENTRY);
+
+	/* Add the records collected since the initialization */
+	if (fbpt)
+		ewperf_write_fbpt(fbpt, FBPT_SIZE);
+
+	ret = uefi_call_wrapper(saved_exit_boot_services, 2,
+				ImageHandle, MapKey);
+	if (EFI_ERROR(ret))
+		return ret;
+
+	ewperf_boot_step(EWPERF_EXIT_BOOT_SERVICES_EXIT);
+	if (fbpt)
+		ewperf_update_fbpt(fbpt);
+
+	return ret;
+}
+
 static EFI_STATUS acpi_init(EFI_SYSTEM_TABLE *st)
 {
 	EFI_STATUS ret;
@@ -397,6 +489,17 @@ static EFI_STATUS acpi_init(EFI_SYSTEM_TABLE *st)
 
 	table->VendorTable = Rsdp;
 
+	if (!ewperf_get_tsc_freq())
+		ewperf_set_tsc_freq(timer_hz());
+
+	ret = install_fpdt();
+	if (EFI_ERROR(ret))
+		ewerr("ACPI: failed to install the FPDT, ret=0x%zx",
+		      (size_t)ret);
+
+	saved_exit_boot_services = st->BootServices->ExitBootServices;
+	st->BootServices->ExitBootServices = acpi_exit_boot_services;
+
 	return EFI_SUCCESS;
 }
 
@@ -410,6 +513,11 @@ static EFI_STATUS acpi_exit(EFI_SYSTEM_TABLE *st)
 	if (!st)
 		return EFI_INVALID_PARAMETER;
 
+	if (saved_exit_boot_services) {
+		st->BootServices->ExitBootServices = saved_exit_boot_services;
+		saved_exit_boot_services = NULL;
+	}
+
 	ret = get_rsdp(&rsdp, &guid);
 
 	if (EFI_ERROR(ret))
@@ -124,6 +124,101 @@ NvmeWriteBlocks (
 	IN  VOID     *DataAddress
 );
 
+/**
+  This function reads data from Nvme device into a scatter-gather list of
+  buffers, using a single command whenever the buffers allow it.
+
+  @param[in]  DeviceIndex   Specifies the block device to which the function wants
+                            to talk.
+  @param[in]  StartLBA      The starting logical block address to read from.
+  @param[in]  Segs          The destination segments, each a multiple of the
+                            intrinsic block size of the device.
+  @param[in]  NbSegs        The number of segments.
+
+  @retval EFI_SUCCESS       The operation is done correctly.
+  @retval Others            The operation fails.
+
+**/
+EFI_STATUS
+EFIAPI
+NvmeReadBlocksV (
+	IN  UINTN                DeviceIndex,
+	IN  EFI_PEI_LBA          StartLBA,
+	IN  CONST NVME_SG_ENTRY  *Segs,
+	IN  UINTN                NbSegs
+);
+
+/**
+  This function writes a scatter-gather list of buffers to Nvme device,
+  using a single command whenever the buffers allow it.
+
+  @param[in]  DeviceIndex   Specifies the block device to which the function wants
+                            to talk.
+  @param[in]  StartLBA      The starting logical block address to write to.
+  @param[in]  Segs          The source segments, each a multiple of the
+                            intrinsic block size of the device.
+  @param[in]  NbSegs        The number of segments.
+
+  @retval EFI_SUCCESS       The operation is done correctly.
+  @retval Others            The operation fails.
+
+**/
+EFI_STATUS
+EFIAPI
+NvmeWriteBlocksV (
+	IN  UINTN                DeviceIndex,
+	IN  EFI_LBA              StartLBA,
+	IN  CONST NVME_SG_ENTRY  *Segs,
+	IN  UINTN                NbSegs
+);
+
+
+/**
+  This function zeroes blocks of Nvme device without any data transfer.
+
+  @param[in]  DeviceIndex   Specifies the block device to which the function wants
+                            to talk.
+  @param[in]  StartLBA      The starting logical block address to zero.
+  @param[in]  NumberOfBlocks The number of blocks to zero.
+
+  @retval EFI_SUCCESS       The operation is done correctly.
+  @retval EFI_UNSUPPORTED   The device does not support Write Zeroes.
+  @retval Others            The operation fails.
+
+**/
+EFI_STATUS
+EFIAPI
+NvmeWriteZeroesBlocks (
+	IN  UINTN                DeviceIndex,
+	IN  EFI_LBA              StartLBA,
+	IN  UINTN                NumberOfBlocks
+);
+
+
+/**
+  This function copies blocks of Nvme device to another location of
+  the device without any data transfer.
+
+  @param[in]  DeviceIndex   Specifies the block device to which the function wants
+                            to talk.
+  @param[in]  SrcLBA        The starting logical block address to copy from.
+  @param[in]  DstLBA        The starting logical block address to copy to.
+  @param[in]  NumberOfBlocks The number of blocks to copy.
+
+  @retval EFI_SUCCESS       The operation is done correctly.
+  @retval EFI_UNSUPPORTED   The device does not support Copy.
+  @retval Others            The operation fails.
+
+**/
+EFI_STATUS
+EFIAPI
+NvmeCopyBlocks (
+	IN  UINTN                DeviceIndex,
+	IN  EFI_LBA              SrcLBA,
+	IN  EFI_LBA              DstLBA,
+	IN  UINTN                NumberOfBlocks
+);
+
 
 /**
   This function initializes Nvme device
@@ -145,6 +240,32 @@ NvmeWriteBlocks (
 **/
 EFI_STATUS EFIAPI NvmeInitialize (IN UINTN NvmeHcPciBase);
 
+/**
+  Start the initialization of the Nvme device without waiting for the
+  controller to be ready.  NvmeCompleteInitialize() must then be called until
+  it returns something else than EFI_NOT_READY.
+
+  @param[in]  NvmeHcPciBase Nvme Host Controller's PCI ConfigSpace Base address
+
+  @retval EFI_SUCCESS           The controller is being enabled.
+  @retval EFI_OUT_OF_RESOURCES  The request could not be executed due to a lack of resources.
+  @retval Others                The request could not be executed successfully.
+
+**/
+EFI_STATUS EFIAPI NvmeStartInitialize (IN UINTN NvmeHcPciBase);
+
+/**
+  Complete the initialization started by NvmeStartInitialize() if the
+  controller is ready.
+
+  @retval EFI_SUCCESS           The device is initialized.
+  @retval EFI_NOT_READY         The controller is not ready yet.
+  @retval EFI_TIMEOUT           The controller was not ready in time.
+  @retval Others                The request could not be executed successfully.
+
+**/
+EFI_STATUS EFIAPI NvmeCompleteInitialize (VOID);
+
 EFI_NVM_EXPRESS_PASS_THRU_PROTOCOL *NvmeGetPassthru(void);
 
 EFI_STORAGE_SECURITY_COMMAND_PROTOCOL *NvmeGetSecurityInterface(void);
@@ -13,6 +13,8 @@
 
 **/
 
+#include <kconfig.h>
+#include <libpayload.h>
 #include <efi.h>
 #include <efilib.h>
 #include <pci/pci.h>
@@ -24,6 +26,11 @@
 #define PCI_BASE_ADDRESSREG_OFFSET                  0x10
 
 NVME_CONTROLLER_PRIVATE_DATA        *mNvmeCtrlPrivate;
+//
+// Controller being enabled, from NvmeStartInitialize() to NvmeCompleteInitialize()
+//
+static NVME_CONTROLLER_PRIVATE_DATA *mNvmeInitPrivate;
+static UINT64                       mNvmeInitStart;
 NVME_DEVICE_PRIVATE_DATA            *mMultiNvmeDrive[10]; //maxium 10
 NvmCtrlPlatformInfo NvmCtrlInfo = { {1,0,0} };
 
@@ -254,29 +261,20 @@ DiscoverAllNamespaces (
 }
 
 /**
-  Starts a device controller or a bus controller.
-
-  The Start() function is designed to be invoked from the EFI boot service ConnectController().
-  As a result, much of the error checking on the parameters to Start() has been moved into this
-  common boot service. It is legal to call Start() from other locations,
-  but the following calling restrictions must be followed or the system behavior will not be deterministic.
-  1. ControllerHandle must be a valid EFI_HANDLE.
-  2. If RemainingDevicePath is not NULL, then it must be a pointer to a naturally aligned
-     EFI_DEVICE_PATH_PROTOCOL.
-  3. Prior to calling Start(), the Supported() function for the driver specified by This must
-     have been called with the same calling parameters, and Supported() must have returned EFI_SUCCESS.
+  Start the initialization of the Nvme device.  The controller is enabled
+  but not waited for: NvmeCompleteInitialize() must then be called until it
+  returns something else than EFI_NOT_READY.
 
-  @param[in]  VOID
+  @param[in]  NvmeHcPciBase  Nvme Host Controller's PCI ConfigSpace Base address
 
-  @retval EFI_SUCCESS              The device was started.
-  @retval EFI_DEVICE_ERROR         The device could not be started due to a device error.Currently not implemented.
+  @retval EFI_SUCCESS              The controller is being enabled.
   @retval EFI_OUT_OF_RESOURCES     The request could not be completed due to a lack of resources.
   @retval Others                   The driver failded to start the device.
 
 **/
 EFI_STATUS
 EFIAPI
-NvmeInitialize (
+NvmeStartInitialize (
   IN  UINTN               NvmeHcPciBase
   )
 {
@@ -329,10 +327,73 @@ NvmeInitialize (
   Private->NvmeHCBase = (addr & ~0xf);
   DEBUG_NVME ((EFI_D_INFO, "NvmeControllerInit: NvmeHCBase = 0x%X\n", addr));
 
-  Status = NvmeControllerInit (Private);
+  Status = NvmeControllerStart (Private);
   if (EFI_ERROR(Status)) {
     goto Exit;
   }
+  mNvmeInitPrivate = Private;
+  mNvmeInitStart   = timer_us (0);
+
+  return EFI_SUCCESS;
+
+Exit:
+  if (EFI_ERROR (Status)) {
+      if ((Private != NULL) && (Private->ControllerData != NULL)) {
+         FreeZero (Private->ControllerData);
+      }
+  }
+
+  DEBUG_NVME ((EFI_D_INFO, "NvmeInitialize: end with 0x%X\n", Status));
+
+  return Status;
+}
+
+/**
+  Complete the initialization started by NvmeStartInitialize() once the
+  controller is ready: identify it, create the I/O queues and discover the
+  namespaces.
+
+  @retval EFI_SUCCESS              The device was started.
+  @retval EFI_NOT_READY            The controller is not ready yet.
+  @retval EFI_NOT_STARTED          NvmeStartInitialize() was not called.
+  @retval EFI_TIMEOUT              The controller was not ready in time.
+  @retval Others                   The driver failded to start the device.
+
+**/
+EFI_STATUS
+EFIAPI
+NvmeCompleteInitialize (
+  VOID
+  )
+{
+  EFI_STATUS                          Status;
+  NVME_CONTROLLER_PRIVATE_DATA        *Private;
+
+  Private = mNvmeInitPrivate;
+  if (Private == NULL) {
+    return EFI_NOT_STARTED;
+  }
+
+  Status = NvmeControllerReady (Private);
+  if (Status == EFI_NOT_READY) {
+    if (timer_us (mNvmeInitStart) < NvmeReadyTimeout (Private) * 1000ULL) {
+      return EFI_NOT_READY;
+    }
+    Status = EFI_TIMEOUT;
+  }
+  mNvmeInitPrivate = NULL;
+
+  DEBUG_NVME ((EFI_D_INFO, "NVMe controller is enabled with status [0x%x].\n", Status));
+  if (!EFI_ERROR (Status)) {
+    Status = NvmeControllerFinish (Private);
+  }
+  if (EFI_ERROR (Status)) {
+    if (Private->ControllerData != NULL) {
+      FreeZero (Private->ControllerData);
+    }
+    DEBUG_NVME ((EFI_D_INFO, "NvmeInitialize: end with 0x%X\n", Status));
+    return Status;
+  }
   mNvmeCtrlPrivate = Private;
 
   Status = DiscoverAllNamespaces (
@@ -341,15 +402,45 @@ NvmeInitialize (
 
   DEBUG_NVME ((EFI_D_INFO, "NvmeInitialize: end successfully\n"));
   return EFI_SUCCESS;
+}
 
-Exit:
+/**
+  Starts a device controller or a bus controller.
+
+  The Start() function is designed to be invoked from the EFI boot service ConnectController().
+  As a result, much of the error checking on the parameters to Start() has been moved into this
+  common boot service. It is legal to call Start() from other locations,
+  but the following calling restrictions must be followed or the system behavior will not be deterministic.
+  1. ControllerHandle must be a valid EFI_HANDLE.
+  2. If RemainingDevicePath is not NULL, then it must be a pointer to a naturally aligned
+     EFI_DEVICE_PATH_PROTOCOL.
+  3. Prior to calling Start(), the Supported() function for the driver specified by This must
+     have been called with the same calling parameters, and Supported() must have returned EFI_SUCCESS.
+
+  @param[in]  VOID
+
+  @retval EFI_SUCCESS              The device was started.
+  @retval EFI_DEVICE_ERROR         The device could not be started due to a device error.Currently not implemented.
+  @retval EFI_OUT_OF_RESOURCES     The request could not be completed due to a lack of resources.
+  @retval Others                   The driver failded to start the device.
+
+**/
+EFI_STATUS
+EFIAPI
+NvmeInitialize (
+  IN  UINTN               NvmeHcPciBase
+  )
+{
+  EFI_STATUS                          Status;
+
+  Status = NvmeStartInitialize (NvmeHcPciBase);
   if (EFI_ERROR (Status)) {
-      if ((Private != NULL) && (Private->ControllerData != NULL)) {
-         FreeZero (Private->ControllerData);
-      }
+    return Status;
   }
 
-  DEBUG_NVME ((EFI_D_INFO, "NvmeInitialize: end with 0x%X\n", Status));
+  while ((Status = NvmeCompleteInitialize ()) == EFI_NOT_READY) {
+    NanoSecondDelay (1000 * 1000);
+  }
 
   return Status;
 }
@@ -461,3 +552,103 @@ NvmeWriteBlocks (
   return Status;
 }
 
+/**
+  This function reads data from Nvme device into a scatter-gather list of
+  buffers.
+
+  @param[in]  DeviceIndex   Specifies the block device to which the function wants
+                            to talk.
+  @param[in]  StartLBA      The starting logical block address to read from.
+  @param[in]  Segs          The destination segments.
+  @param[in]  NbSegs        The number of segments.
+
+  @retval EFI_SUCCESS       The operation is done correctly.
+  @retval Others            The operation fails.
+
+**/
+EFI_STATUS
+EFIAPI
+NvmeReadBlocksV (
+  IN  UINTN                         DeviceIndex __attribute__((unused)),
+  IN  EFI_PEI_LBA                   StartLBA,
+  IN  CONST NVME_SG_ENTRY           *Segs,
+  IN  UINTN                         NbSegs
+  )
+{
+  return NvmeBlockIoReadBlocksV(&mMultiNvmeDrive[0]->BlockIo, 0, StartLBA, Segs, NbSegs);
+}
+
+/**
+  This function writes a scatter-gather list of buffers to Nvme device.
+
+  @param[in]  DeviceIndex   Specifies the block device to which the function wants
+                            to talk.
+  @param[in]  StartLBA      The starting logical block address to write to.
+  @param[in]  Segs          The source segments.
+  @param[in]  NbSegs        The number of segments.
+
+  @retval EFI_SUCCESS       The operation is done correctly.
+  @retval Others            The operation fails.
+
+**/
+EFI_STATUS
+EFIAPI
+NvmeWriteBlocksV (
+  IN  UINTN                         DeviceIndex __attribute__((unused)),
+  IN  EFI_LBA                       StartLBA,
+  IN  CONST NVME_SG_ENTRY           *Segs,
+  IN  UINTN                         NbSegs
+  )
+{
+  return NvmeBlockIoWriteBlocksV(&mMultiNvmeDrive[0]->BlockIo, 0, StartLBA, Segs, NbSegs);
+}
+
+/**
+  This function zeroes blocks of Nvme device without any data transfer.
+
+  @param[in]  DeviceIndex   Specifies the block device to which the function wants
+                            to talk.
+  @param[in]  StartLBA      The starting logical block address to zero.
+  @param[in]  NumberOfBlocks The number of blocks to zero.
+
+  @retval EFI_SUCCESS       The operation is done correctly.
+  @retval Others            The operation fails.
+
+**/
+EFI_STATUS
+EFIAPI
+NvmeWriteZeroesBlocks (
+  IN  UINTN                         DeviceIndex __attribute__((unused)),
+  IN  EFI_LBA                       StartLBA,
+  IN  UINTN                         NumberOfBlocks
+  )
+{
+  return NvmeBlockIoWriteZeroes(&mMultiNvmeDrive[0]->BlockIo, 0, StartLBA, NumberOfBlocks);
+}
+
+/**
+  This function copies blocks of Nvme device to another location of
+  the device without any data transfer.
+
+  @param[in]  DeviceIndex   Specifies the block device to which the function wants
+                            to talk.
+  @param[in]  SrcLBA        The starting logical block address to copy from.
+  @param[in]  DstLBA        The starting logical block address to copy to.
+  @param[in]  NumberOfBlocks The number of blocks to copy.
+
+  @retval EFI_SUCCESS       The operation is done correctly.
+  @retval Others            The operation fails.
+
+**/
+EFI_STATUS
+EFIAPI
+NvmeCopyBlocks (
+  IN  UINTN                         DeviceIndex __attribute__((unused)),
+  IN  EFI_LBA                       SrcLBA,
+  IN  EFI_LBA                       DstLBA,
+  IN  UINTN                         NumberOfBlocks
+  )
+{
+  return NvmeBlockIoCopy(&mMultiNvmeDrive[0]->BlockIo, 0, SrcLBA, DstLBA, NumberOfBlocks);
+}
+
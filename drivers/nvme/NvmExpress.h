@@ -40,6 +40,14 @@ VOID
   IN NVME_BLKIO2_SUBTASK         *SubtaskPtr
 );
 
+//
+// Scatter-gather segment of a vectored transfer.
+//
+typedef struct {
+	VOID                              *Buffer;
+	UINTN                             Length;
+} NVME_SG_ENTRY;
+
 #include "NvmExpressPassthru.h"
 #include "NvmExpressBlockIo.h"
 #include "NvmExpressHci.h"
@@ -218,6 +226,12 @@ struct _NVME_DEVICE_PRIVATE_DATA {
   char                                     ModelName[80];
   NVME_ADMIN_NAMESPACE_DATA                NamespaceData;
 
+  //
+  // Page holding the Source Range entries of the Copy command,
+  // allocated on first use.
+  //
+  NVME_COPY_RANGE                          *CopyRanges;
+
   NVME_CONTROLLER_PRIVATE_DATA             *Controller;
 
   EFI_STORAGE_SECURITY_COMMAND_PROTOCOL    StorageSecurity;
@@ -360,6 +374,42 @@ NvmExpressPassThru (
   IN     ASYNC_IO_CALL_BACK                          *Event OPTIONAL
   );
 
+/**
+  Sends an NVM Express Command Packet whose data buffer is described by a
+  scatter-gather list, see NvmExpressPassThru().
+
+  @param[in]     This                A pointer to the EFI_NVM_EXPRESS_PASS_THRU_PROTOCOL instance.
+  @param[in]     NamespaceId         A 32 bit namespace ID as defined in the NVMe specification.
+  @param[in,out] Packet              A pointer to the NVM Express Command Packet.
+  @param[in]     Event               Must be NULL when Segs is not NULL.
+  @param[in]     Segs                The scatter-gather segments, or NULL.
+  @param[in]     NbSegs              The number of segments.
+
+**/
+EFI_STATUS
+EFIAPI
+NvmExpressPassThruSg (
+  IN     EFI_NVM_EXPRESS_PASS_THRU_PROTOCOL          *This,
+  IN     UINT32                                      NamespaceId,
+  IN OUT EFI_NVM_EXPRESS_PASS_THRU_COMMAND_PACKET    *Packet,
+  IN     ASYNC_IO_CALL_BACK                          *Event OPTIONAL,
+  IN     CONST NVME_SG_ENTRY                         *Segs OPTIONAL,
+  IN     UINTN                                       NbSegs
+  );
+
+/**
+  Check whether a scatter-gather list can be described by a single PRP list.
+
+  @param[in]     Segs                The scatter-gather segments.
+  @param[in]     NbSegs              The number of segments.
+
+**/
+BOOLEAN
+NvmeSgIsPrpCompatible (
+  IN CONST NVME_SG_ENTRY                             *Segs,
+  IN UINTN                                           NbSegs
+  );
+
 /**
   Used to retrieve the next namespace ID for this NVM Express controller.
 
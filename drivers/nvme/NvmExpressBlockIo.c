@@ -280,6 +280,220 @@ NvmeWrite (
 	return Status;
 }
 
+/**
+	Deallocate-free zeroing of some blocks of the device with the Write
+	Zeroes command, no data is transferred.
+
+	@param  Device                 The pointer to the NVME_DEVICE_PRIVATE_DATA data structure.
+	@param  Lba                    The start block number.
+	@param  Blocks                 Total block number to be zeroed.
+
+	@retval EFI_SUCCESS            The blocks are zeroed.
+	@retval EFI_UNSUPPORTED        The controller does not support the command.
+	@retval Others                 Fail to zero all the blocks.
+**/
+EFI_STATUS
+NvmeWriteZeroes (
+	IN NVME_DEVICE_PRIVATE_DATA      *Device,
+	IN UINT64                        Lba,
+	IN UINTN                         Blocks
+)
+{
+	NVME_CONTROLLER_PRIVATE_DATA             *Private;
+	EFI_NVM_EXPRESS_PASS_THRU_COMMAND_PACKET CommandPacket;
+	EFI_NVM_EXPRESS_COMMAND                  Command;
+	EFI_NVM_EXPRESS_COMPLETION               Completion;
+	EFI_STATUS                               Status;
+	UINT32                                   Count;
+
+	Private = Device->Controller;
+	if ((Private->ControllerData->Oncs & WRITE_ZEROES_SUPPORTED) == 0) {
+		return EFI_UNSUPPORTED;
+	}
+
+	//
+	// Wait for the device's asynchronous I/O queue to become empty.
+	//
+	while (!IsListEmpty (&Device->AsyncQueue)) {
+		NanoSecondDelay(100 * 1000);
+	}
+
+	Status = EFI_SUCCESS;
+	while (Blocks > 0) {
+		//
+		// The Number of Logical Blocks field is 16 bits wide.
+		//
+		Count = (Blocks > 0x10000) ? 0x10000 : (UINT32)Blocks;
+
+		ZeroMem (&CommandPacket, sizeof(EFI_NVM_EXPRESS_PASS_THRU_COMMAND_PACKET));
+		ZeroMem (&Command, sizeof(EFI_NVM_EXPRESS_COMMAND));
+		ZeroMem (&Completion, sizeof(EFI_NVM_EXPRESS_COMPLETION));
+
+		CommandPacket.NvmeCmd        = &Command;
+		CommandPacket.NvmeCompletion = &Completion;
+
+		CommandPacket.NvmeCmd->Cdw0.Opcode = NVME_IO_WRITE_ZEROES_OPC;
+		CommandPacket.NvmeCmd->Nsid  = Device->NamespaceId;
+		CommandPacket.CommandTimeout = NVME_GENERIC_TIMEOUT;
+		CommandPacket.QueueType      = NVME_IO_QUEUE;
+
+		CommandPacket.NvmeCmd->Cdw10 = (UINT32)Lba;
+		CommandPacket.NvmeCmd->Cdw11 = (UINT32)RShiftU64(Lba, 32);
+		CommandPacket.NvmeCmd->Cdw12 = (Count - 1) & 0xFFFF;
+
+		CommandPacket.NvmeCmd->Flags = CDW10_VALID | CDW11_VALID | CDW12_VALID;
+
+		Status = Private->Passthru.PassThru (
+			&Private->Passthru,
+			Device->NamespaceId,
+			&CommandPacket,
+			NULL
+			);
+		if (EFI_ERROR(Status)) {
+			break;
+		}
+
+		Blocks -= Count;
+		Lba    += Count;
+	}
+
+	return Status;
+}
+
+/**
+	Copy some blocks of the device to another location of the same
+	namespace with the Copy command, the data does not cross the bus.
+
+	@param  Device                 The pointer to the NVME_DEVICE_PRIVATE_DATA data structure.
+	@param  SrcLba                 The start block number to copy from.
+	@param  DstLba                 The start block number to copy to.
+	@param  Blocks                 Total block number to be copied.
+
+	@retval EFI_SUCCESS            The blocks are copied.
+	@retval EFI_UNSUPPORTED        The controller does not support the command.
+	@retval EFI_OUT_OF_RESOURCES   The Source Range entries page cannot be allocated.
+	@retval Others                 Fail to copy all the blocks.
+**/
+EFI_STATUS
+NvmeCopy (
+	IN NVME_DEVICE_PRIVATE_DATA      *Device,
+	IN UINT64                        SrcLba,
+	IN UINT64                        DstLba,
+	IN UINTN                         Blocks
+)
+{
+	NVME_CONTROLLER_PRIVATE_DATA             *Private;
+	NVME_ADMIN_NAMESPACE_DATA                *NamespaceData;
+	EFI_NVM_EXPRESS_PASS_THRU_COMMAND_PACKET CommandPacket;
+	EFI_NVM_EXPRESS_COMMAND                  Command;
+	EFI_NVM_EXPRESS_COMPLETION               Completion;
+	EFI_STATUS                               Status;
+	UINT32                                   MaxRangeBlocks;
+	UINT32                                   MaxRanges;
+	UINT64                                   MaxCopyBlocks;
+	UINT64                                   Copied;
+	UINT32                                   Count;
+	UINT32                                   Ranges;
+
+	Private = Device->Controller;
+	if ((Private->ControllerData->Oncs & COPY_SUPPORTED) == 0) {
+		return EFI_UNSUPPORTED;
+	}
+
+	if (Device->CopyRanges == NULL) {
+		Device->CopyRanges = nvme_alloc_pages (1);
+		if (Device->CopyRanges == NULL) {
+			return EFI_OUT_OF_RESOURCES;
+		}
+	}
+
+	//
+	// The Number of Logical Blocks field of a Source Range entry is 16
+	// bits wide, a zero MSSRL or MCL does not report any further limit.
+	//
+	NamespaceData  = &Device->NamespaceData;
+	MaxRangeBlocks = 0x10000;
+	if (NamespaceData->Mssrl != 0 && NamespaceData->Mssrl < MaxRangeBlocks) {
+		MaxRangeBlocks = NamespaceData->Mssrl;
+	}
+	MaxRanges = (UINT32)NamespaceData->Msrc + 1;
+	if (MaxRanges > EFI_PAGE_SIZE / sizeof (NVME_COPY_RANGE)) {
+		MaxRanges = EFI_PAGE_SIZE / sizeof (NVME_COPY_RANGE);
+	}
+	MaxCopyBlocks = (UINT64)MaxRangeBlocks * MaxRanges;
+	if (NamespaceData->Mcl != 0 && NamespaceData->Mcl < MaxCopyBlocks) {
+		MaxCopyBlocks = NamespaceData->Mcl;
+	}
+
+	//
+	// Wait for the device's asynchronous I/O queue to become empty.
+	//
+	while (!IsListEmpty (&Device->AsyncQueue)) {
+		NanoSecondDelay(100 * 1000);
+	}
+
+	Status = EFI_SUCCESS;
+	while (Blocks > 0) {
+		//
+		// Consecutive Source Range entries, all copied to DstLba onwards.
+		//
+		ZeroMem (Device->CopyRanges, EFI_PAGE_SIZE);
+		for (Ranges = 0, Copied = 0;
+		     Ranges < MaxRanges && Copied < MaxCopyBlocks && Copied < Blocks;
+		     Ranges++, Copied += Count) {
+			Count = MaxRangeBlocks;
+			if (Count > MaxCopyBlocks - Copied) {
+				Count = (UINT32)(MaxCopyBlocks - Copied);
+			}
+			if (Count > Blocks - Copied) {
+				Count = (UINT32)(Blocks - Copied);
+			}
+
+			Device->CopyRanges[Ranges].Slba = SrcLba + Copied;
+			Device->CopyRanges[Ranges].Nlb  = (UINT16)(Count - 1);
+		}
+
+		ZeroMem (&CommandPacket, sizeof(EFI_NVM_EXPRESS_PASS_THRU_COMMAND_PACKET));
+		ZeroMem (&Command, sizeof(EFI_NVM_EXPRESS_COMMAND));
+		ZeroMem (&Completion, sizeof(EFI_NVM_EXPRESS_COMPLETION));
+
+		CommandPacket.NvmeCmd        = &Command;
+		CommandPacket.NvmeCompletion = &Completion;
+
+		CommandPacket.NvmeCmd->Cdw0.Opcode = NVME_IO_COPY_OPC;
+		CommandPacket.NvmeCmd->Nsid  = Device->NamespaceId;
+		CommandPacket.TransferBuffer = Device->CopyRanges;
+		CommandPacket.TransferLength = Ranges * sizeof (NVME_COPY_RANGE);
+		CommandPacket.CommandTimeout = NVME_GENERIC_TIMEOUT;
+		CommandPacket.QueueType      = NVME_IO_QUEUE;
+
+		//
+		// Source Range entries use descriptor format 0.
+		//
+		CommandPacket.NvmeCmd->Cdw10 = (UINT32)DstLba;
+		CommandPacket.NvmeCmd->Cdw11 = (UINT32)RShiftU64(DstLba, 32);
+		CommandPacket.NvmeCmd->Cdw12 = (Ranges - 1) & 0xFF;
+
+		CommandPacket.NvmeCmd->Flags = CDW10_VALID | CDW11_VALID | CDW12_VALID;
+
+		Status = Private->Passthru.PassThru (
+			&Private->Passthru,
+			Device->NamespaceId,
+			&CommandPacket,
+			NULL
+			);
+		if (EFI_ERROR(Status)) {
+			break;
+		}
+
+		Blocks -= (UINTN)Copied;
+		SrcLba += Copied;
+		DstLba += Copied;
+	}
+
+	return Status;
+}
+
 /**
 	Flushes all modified data to the device.
 
@@ -506,6 +720,304 @@ NvmeBlockIoWriteBlocks (
 	return Status;
 }
 
+/**
+	Read or write a scatter-gather list of buffers with a single command
+	when the segments can be described by one PRP list, one command per
+	segment otherwise.
+
+	@param  Device                 The pointer to the NVME_DEVICE_PRIVATE_DATA data structure.
+	@param  Write                  TRUE to write the segments, FALSE to read them.
+	@param  Lba                    The start block number.
+	@param  Blocks                 Total block number to be transferred.
+	@param  Segs                   The scatter-gather segments.
+	@param  NbSegs                 The number of segments.
+
+	@retval EFI_SUCCESS            Datum are transferred.
+	@retval Others                 Fail to transfer all the datum.
+**/
+static
+EFI_STATUS
+NvmeRwv (
+	IN NVME_DEVICE_PRIVATE_DATA      *Device,
+	IN BOOLEAN                       Write,
+	IN UINT64                        Lba,
+	IN UINTN                         Blocks,
+	IN CONST NVME_SG_ENTRY           *Segs,
+	IN UINTN                         NbSegs
+)
+{
+	NVME_CONTROLLER_PRIVATE_DATA             *Private;
+	EFI_NVM_EXPRESS_PASS_THRU_COMMAND_PACKET CommandPacket;
+	EFI_NVM_EXPRESS_COMMAND                  Command;
+	EFI_NVM_EXPRESS_COMPLETION               Completion;
+	EFI_STATUS                               Status;
+	UINT32                                   BlockSize;
+	UINT32                                   MaxTransferBlocks;
+	UINTN                                    Index;
+
+	Private    = Device->Controller;
+	BlockSize  = Device->Media.BlockSize;
+
+	if (Private->ControllerData->Mdts != 0) {
+		MaxTransferBlocks = (1 << (Private->ControllerData->Mdts)) * (1 << (Private->Cap.Mpsmin + 12)) / BlockSize;
+	} else {
+		MaxTransferBlocks = 1024;
+	}
+
+	if (NbSegs == 1 || Blocks > MaxTransferBlocks || Blocks > 0x10000 ||
+	    !IsListEmpty (&Device->AsyncQueue) ||
+	    !NvmeSgIsPrpCompatible (Segs, NbSegs)) {
+		for (Index = 0; Index < NbSegs; Index++) {
+			if (Write)
+				Status = NvmeWrite (Device, Segs[Index].Buffer, Lba, Segs[Index].Length / BlockSize);
+			else
+				Status = NvmeRead (Device, Segs[Index].Buffer, Lba, Segs[Index].Length / BlockSize);
+			if (EFI_ERROR(Status))
+				return Status;
+			Lba += Segs[Index].Length / BlockSize;
+		}
+		return EFI_SUCCESS;
+	}
+
+	ZeroMem (&CommandPacket, sizeof(EFI_NVM_EXPRESS_PASS_THRU_COMMAND_PACKET));
+	ZeroMem (&Command, sizeof(EFI_NVM_EXPRESS_COMMAND));
+	ZeroMem (&Completion, sizeof(EFI_NVM_EXPRESS_COMPLETION));
+
+	CommandPacket.NvmeCmd        = &Command;
+	CommandPacket.NvmeCompletion = &Completion;
+
+	CommandPacket.NvmeCmd->Cdw0.Opcode = Write ? NVME_IO_WRITE_OPC : NVME_IO_READ_OPC;
+	CommandPacket.NvmeCmd->Nsid  = Device->NamespaceId;
+
+	CommandPacket.TransferLength = (UINT32)Blocks * BlockSize;
+	CommandPacket.CommandTimeout = NVME_GENERIC_TIMEOUT;
+	CommandPacket.QueueType      = NVME_IO_QUEUE;
+
+	CommandPacket.NvmeCmd->Cdw10 = (UINT32)Lba;
+	CommandPacket.NvmeCmd->Cdw11 = (UINT32)RShiftU64(Lba, 32);
+	CommandPacket.NvmeCmd->Cdw12 = (Blocks - 1) & 0xFFFF;
+	//
+	// Set Force Unit Access bit (bit 30) to use write-through behaviour
+	//
+	if (Write)
+		CommandPacket.NvmeCmd->Cdw12 |= BIT30;
+
+	CommandPacket.NvmeCmd->Flags = CDW10_VALID | CDW11_VALID | CDW12_VALID;
+
+	Status = NvmExpressPassThruSg (
+		&Private->Passthru,
+		Device->NamespaceId,
+		&CommandPacket,
+		NULL,
+		Segs,
+		NbSegs
+		);
+
+	return Status;
+}
+
+/**
+	Check a scatter-gather transfer request against the media.
+
+	@retval EFI_SUCCESS           The request is valid, *Blocks is set.
+	@retval Others                See NvmeBlockIoReadBlocks().
+**/
+static
+EFI_STATUS
+NvmeCheckSegs (
+	IN  EFI_BLOCK_IO_PROTOCOL   *This,
+	IN  UINT32                  MediaId,
+	IN  EFI_LBA                 Lba,
+	IN  CONST NVME_SG_ENTRY     *Segs,
+	IN  UINTN                   NbSegs,
+	OUT UINTN                   *Blocks
+)
+{
+	EFI_BLOCK_IO_MEDIA          *Media;
+	UINTN                       Index;
+
+	if (This == NULL || (Segs == NULL && NbSegs != 0))
+		return EFI_INVALID_PARAMETER;
+
+	Media = This->Media;
+	if (MediaId != Media->MediaId)
+		return EFI_MEDIA_CHANGED;
+
+	*Blocks = 0;
+	for (Index = 0; Index < NbSegs; Index++) {
+		if (Segs[Index].Buffer == NULL || Segs[Index].Length == 0)
+			return EFI_INVALID_PARAMETER;
+
+		if ((Segs[Index].Length % Media->BlockSize) != 0)
+			return EFI_BAD_BUFFER_SIZE;
+
+		if (Media->IoAlign > 0 && (((UINTN)Segs[Index].Buffer & (Media->IoAlign - 1)) != 0))
+			return EFI_INVALID_PARAMETER;
+
+		*Blocks += Segs[Index].Length / Media->BlockSize;
+	}
+
+	if (*Blocks != 0 && (Lba + *Blocks - 1) > Media->LastBlock)
+		return EFI_INVALID_PARAMETER;
+
+	return EFI_SUCCESS;
+}
+
+/**
+  Read consecutive blocks from Lba into a scatter-gather list of buffers.
+
+  @param  This       Indicates a pointer to the calling context.
+  @param  MediaId    Id of the media, changes every time the media is replaced.
+  @param  Lba        The starting Logical Block Address to read from
+  @param  Segs       The destination segments, each a multiple of the block size.
+  @param  NbSegs     The number of segments.
+
+  @retval EFI_SUCCESS           The data was read correctly from the device.
+  @retval Others                See NvmeBlockIoReadBlocks().
+
+**/
+EFI_STATUS
+EFIAPI
+NvmeBlockIoReadBlocksV (
+	IN  EFI_BLOCK_IO_PROTOCOL   *This,
+	IN  UINT32                  MediaId,
+	IN  EFI_LBA                 Lba,
+	IN  CONST NVME_SG_ENTRY     *Segs,
+	IN  UINTN                   NbSegs
+)
+{
+	EFI_STATUS                  Status;
+	UINTN                       Blocks;
+
+	Status = NvmeCheckSegs (This, MediaId, Lba, Segs, NbSegs, &Blocks);
+	if (EFI_ERROR(Status) || Blocks == 0)
+		return Status;
+
+	return NvmeRwv (NVME_DEVICE_PRIVATE_DATA_FROM_BLOCK_IO (This), FALSE,
+			Lba, Blocks, Segs, NbSegs);
+}
+
+/**
+  Write a scatter-gather list of buffers to consecutive blocks from Lba.
+
+  @param  This       Indicates a pointer to the calling context.
+  @param  MediaId    The media ID that the write request is for.
+  @param  Lba        The starting logical block address to be written.
+  @param  Segs       The source segments, each a multiple of the block size.
+  @param  NbSegs     The number of segments.
+
+  @retval EFI_SUCCESS           The data was written correctly to the device.
+  @retval Others                See NvmeBlockIoWriteBlocks().
+
+**/
+EFI_STATUS
+EFIAPI
+NvmeBlockIoWriteBlocksV (
+	IN  EFI_BLOCK_IO_PROTOCOL   *This,
+	IN  UINT32                  MediaId,
+	IN  EFI_LBA                 Lba,
+	IN  CONST NVME_SG_ENTRY     *Segs,
+	IN  UINTN                   NbSegs
+)
+{
+	EFI_STATUS                  Status;
+	UINTN                       Blocks;
+
+	Status = NvmeCheckSegs (This, MediaId, Lba, Segs, NbSegs, &Blocks);
+	if (EFI_ERROR(Status) || Blocks == 0)
+		return Status;
+
+	return NvmeRwv (NVME_DEVICE_PRIVATE_DATA_FROM_BLOCK_IO (This), TRUE,
+			Lba, Blocks, Segs, NbSegs);
+}
+
+/**
+  Zero consecutive blocks from Lba without transferring any data.
+
+  @param  This       Indicates a pointer to the calling context.
+  @param  MediaId    The media ID that the request is for.
+  @param  Lba        The starting logical block address to be zeroed.
+  @param  Blocks     The number of blocks to zero.
+
+  @retval EFI_SUCCESS           The blocks were zeroed.
+  @retval EFI_UNSUPPORTED       The controller does not support Write Zeroes.
+  @retval EFI_MEDIA_CHANGED     The MediaId does not match the current device.
+  @retval EFI_INVALID_PARAMETER The range is not valid for the device.
+
+**/
+EFI_STATUS
+EFIAPI
+NvmeBlockIoWriteZeroes (
+	IN  EFI_BLOCK_IO_PROTOCOL   *This,
+	IN  UINT32                  MediaId,
+	IN  EFI_LBA                 Lba,
+	IN  UINTN                   Blocks
+)
+{
+	EFI_BLOCK_IO_MEDIA          *Media;
+
+	if (This == NULL)
+		return EFI_INVALID_PARAMETER;
+
+	Media = This->Media;
+	if (MediaId != Media->MediaId)
+		return EFI_MEDIA_CHANGED;
+
+	if (Blocks == 0)
+		return EFI_SUCCESS;
+
+	if (Lba > Media->LastBlock || Blocks - 1 > Media->LastBlock - Lba)
+		return EFI_INVALID_PARAMETER;
+
+	return NvmeWriteZeroes (NVME_DEVICE_PRIVATE_DATA_FROM_BLOCK_IO (This),
+				Lba, Blocks);
+}
+
+/**
+  Copy consecutive blocks from SrcLba to DstLba inside the device.
+
+  @param  This       Indicates a pointer to the calling context.
+  @param  MediaId    The media ID that the request is for.
+  @param  SrcLba     The starting logical block address to copy from.
+  @param  DstLba     The starting logical block address to copy to.
+  @param  Blocks     The number of blocks to copy.
+
+  @retval EFI_SUCCESS           The blocks were copied.
+  @retval EFI_UNSUPPORTED       The controller does not support Copy.
+  @retval EFI_MEDIA_CHANGED     The MediaId does not match the current device.
+  @retval EFI_INVALID_PARAMETER A range is not valid for the device.
+
+**/
+EFI_STATUS
+EFIAPI
+NvmeBlockIoCopy (
+	IN  EFI_BLOCK_IO_PROTOCOL   *This,
+	IN  UINT32                  MediaId,
+	IN  EFI_LBA                 SrcLba,
+	IN  EFI_LBA                 DstLba,
+	IN  UINTN                   Blocks
+)
+{
+	EFI_BLOCK_IO_MEDIA          *Media;
+
+	if (This == NULL)
+		return EFI_INVALID_PARAMETER;
+
+	Media = This->Media;
+	if (MediaId != Media->MediaId)
+		return EFI_MEDIA_CHANGED;
+
+	if (Blocks == 0)
+		return EFI_SUCCESS;
+
+	if (SrcLba > Media->LastBlock || Blocks - 1 > Media->LastBlock - SrcLba ||
+	    DstLba > Media->LastBlock || Blocks - 1 > Media->LastBlock - DstLba)
+		return EFI_INVALID_PARAMETER;
+
+	return NvmeCopy (NVME_DEVICE_PRIVATE_DATA_FROM_BLOCK_IO (This),
+			 SrcLba, DstLba, Blocks);
+}
+
 /**
   Flush the Block Device.
 
@@ -94,6 +94,82 @@ NvmeBlockIoWriteBlocks (
 	IN  VOID                    *Buffer
 );
 
+/**
+	Read consecutive blocks from Lba into a scatter-gather list of buffers,
+	with a single command when the segments are PRP compatible.
+
+	@param  This       Indicates a pointer to the calling context.
+	@param  MediaId    Id of the media, changes every time the media is replaced.
+	@param  Lba        The starting Logical Block Address to read from
+	@param  Segs       The destination segments, each a multiple of the block size.
+	@param  NbSegs     The number of segments.
+**/
+EFI_STATUS
+EFIAPI
+NvmeBlockIoReadBlocksV (
+	IN  EFI_BLOCK_IO_PROTOCOL   *This,
+	IN  UINT32                  MediaId,
+	IN  EFI_LBA                 Lba,
+	IN  CONST NVME_SG_ENTRY     *Segs,
+	IN  UINTN                   NbSegs
+);
+
+/**
+	Write a scatter-gather list of buffers to consecutive blocks from Lba,
+	with a single command when the segments are PRP compatible.
+
+	@param  This       Indicates a pointer to the calling context.
+	@param  MediaId    The media ID that the write request is for.
+	@param  Lba        The starting logical block address to be written.
+	@param  Segs       The source segments, each a multiple of the block size.
+	@param  NbSegs     The number of segments.
+**/
+EFI_STATUS
+EFIAPI
+NvmeBlockIoWriteBlocksV (
+	IN  EFI_BLOCK_IO_PROTOCOL   *This,
+	IN  UINT32                  MediaId,
+	IN  EFI_LBA                 Lba,
+	IN  CONST NVME_SG_ENTRY     *Segs,
+	IN  UINTN                   NbSegs
+);
+
+/**
+	Zero consecutive blocks from Lba with the Write Zeroes command.
+
+	@param  This       Indicates a pointer to the calling context.
+	@param  MediaId    The media ID that the request is for.
+	@param  Lba        The starting logical block address to be zeroed.
+	@param  Blocks     The number of blocks to zero.
+**/
+EFI_STATUS
+EFIAPI
+NvmeBlockIoWriteZeroes (
+	IN  EFI_BLOCK_IO_PROTOCOL   *This,
+	IN  UINT32                  MediaId,
+	IN  EFI_LBA                 Lba,
+	IN  UINTN                   Blocks
+);
+
+/**
+	Copy consecutive blocks from SrcLba to DstLba with the Copy command.
+
+	@param  This       Indicates a pointer to the calling context.
+	@param  MediaId    The media ID that the request is for.
+	@param  SrcLba     The starting logical block address to copy from.
+	@param  DstLba     The starting logical block address to copy to.
+	@param  Blocks     The number of blocks to copy.
+**/
+EFI_STATUS
+EFIAPI
+NvmeBlockIoCopy (
+	IN  EFI_BLOCK_IO_PROTOCOL   *This,
+	IN  UINT32                  MediaId,
+	IN  EFI_LBA                 SrcLba,
+	IN  EFI_LBA                 DstLba,
+	IN  UINTN                   Blocks
+);
+
 /**
 	Flush the Block Device.
 
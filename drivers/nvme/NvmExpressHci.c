@@ -474,29 +474,43 @@ NvmeDisableController (
 }
 
 /**
-  Enable the Nvm Express controller.
+  Get the maximum time the Nvm Express controller takes to become ready.
 
   @param  Private          The pointer to the NVME_CONTROLLER_PRIVATE_DATA data structure.
 
-  @return EFI_SUCCESS      Successfully enable the controller.
-  @return EFI_DEVICE_ERROR Fail to enable the controller.
-  @return EFI_TIMEOUT      Fail to enable the controller in given time slot.
+  @return The timeout in milliseconds.
+
+**/
+UINT32
+NvmeReadyTimeout (
+	IN NVME_CONTROLLER_PRIVATE_DATA     *Private
+)
+{
+	//
+	// Cap.To specifies max delay time in 500ms increments for Csts.Rdy to set after
+	// Cc.Enable.
+	//
+	if (Private->Cap.To == 0)
+		return 500;
+
+	return Private->Cap.To * 500;
+}
+
+/**
+  Set the enable bit of the Nvm Express controller without waiting for it to be ready.
+
+  @param  Private          The pointer to the NVME_CONTROLLER_PRIVATE_DATA data structure.
+
+  @return EFI_SUCCESS      Successfully set the enable bit.
+  @return EFI_DEVICE_ERROR Fail to set the enable bit.
 
 **/
 EFI_STATUS
-NvmeEnableController (
+NvmeStartController (
 	IN NVME_CONTROLLER_PRIVATE_DATA     *Private
 )
 {
 	NVME_CC                Cc;
-	NVME_CSTS              Csts;
-	EFI_STATUS             Status;
-	UINT32                 Index;
-	UINT8                  Timeout;
-	UINT32                 NvmeHCBase;
-
-	//NVME PCI base address
-	NvmeHCBase = Private->NvmeHCBase;
 
 	//
 	// Enable the controller.
@@ -507,31 +521,63 @@ NvmeEnableController (
 	Cc.Iosqes = 6;
 	Cc.Iocqes = 4;
 
-	Status = WriteNvmeControllerConfiguration (NvmeHCBase, &Cc);
+	return WriteNvmeControllerConfiguration (Private->NvmeHCBase, &Cc);
+}
+
+/**
+  Check whether the Nvm Express controller started by NvmeStartController() is ready.
+
+  @param  Private          The pointer to the NVME_CONTROLLER_PRIVATE_DATA data structure.
+
+  @return EFI_SUCCESS      The controller is ready.
+  @return EFI_NOT_READY    The controller is not ready yet.
+  @return EFI_DEVICE_ERROR Fail to read the controller status.
+
+**/
+EFI_STATUS
+NvmeControllerReady (
+	IN NVME_CONTROLLER_PRIVATE_DATA     *Private
+)
+{
+	NVME_CSTS              Csts;
+	EFI_STATUS             Status;
+
+	Status = ReadNvmeControllerStatus (Private->NvmeHCBase, &Csts);
 	if (EFI_ERROR(Status))
 		return Status;
 
+	return Csts.Rdy ? EFI_SUCCESS : EFI_NOT_READY;
+}
+
+/**
+  Wait for the Nvm Express controller started by NvmeStartController() to be ready.
+
+  @param  Private          The pointer to the NVME_CONTROLLER_PRIVATE_DATA data structure.
+
+  @return EFI_SUCCESS      The controller is ready.
+  @return EFI_DEVICE_ERROR Fail to read the controller status.
+  @return EFI_TIMEOUT      The controller was not ready in given time slot.
+
+**/
+EFI_STATUS
+NvmeWaitController (
+	IN NVME_CONTROLLER_PRIVATE_DATA     *Private
+)
+{
+	EFI_STATUS             Status;
+	UINT32                 Index;
+
 	//
-	// Cap.To specifies max delay time in 500ms increments for Csts.Rdy to set after
-	// Cc.Enable. Loop produces a 1 millisecond delay per itteration, up to 500 * Cap.To.
+	// Loop produces a 1 millisecond delay per itteration, up to NvmeReadyTimeout().
 	//
-	if (Private->Cap.To == 0)
-		Timeout = 1;
-	else
-		Timeout = Private->Cap.To;
-
-	for (Index = (Timeout * 500); Index != 0; --Index) {
+	for (Index = NvmeReadyTimeout (Private); Index != 0; --Index) {
 		NanoSecondDelay(1000 * 1000);
 
 		//
 		// Check if the controller is initialized
 		//
-		Status = ReadNvmeControllerStatus (NvmeHCBase, &Csts);
-
-		if (EFI_ERROR(Status))
-			return Status;
-
-		if (Csts.Rdy)
+		Status = NvmeControllerReady (Private);
+		if (Status != EFI_NOT_READY)
 			break;
 	}
 
@@ -786,16 +832,18 @@ NvmeCreateIoSubmissionQueue (
 }
 
 /**
-  Initialize the Nvm Express controller.
+  Start the initialization of the Nvm Express controller: program the admin
+  queues and set the enable bit.  NvmeControllerFinish() completes it once
+  NvmeControllerReady() reports the controller ready.
 
   @param[in] Private                 The pointer to the NVME_CONTROLLER_PRIVATE_DATA data structure.
 
-  @retval EFI_SUCCESS                The NVM Express Controller is initialized successfully.
+  @retval EFI_SUCCESS                The NVM Express Controller is being enabled.
   @retval Others                     A device error occurred while initializing the controller.
 
 **/
 EFI_STATUS
-NvmeControllerInit (
+NvmeControllerStart (
 	IN NVME_CONTROLLER_PRIVATE_DATA    *Private
 )
 {
@@ -803,8 +851,6 @@ NvmeControllerInit (
 	NVME_AQA                        Aqa;
 	NVME_ASQ                        Asq;
 	NVME_ACQ                        Acq;
-	UINT8                           Sn[21];
-	UINT8                           Mn[41];
 	UINT32                          NvmeHCBase;
 
 	//NVME PCI base address
@@ -908,9 +954,27 @@ NvmeControllerInit (
 	if (EFI_ERROR(Status))
 		return Status;
 
-	Status = NvmeEnableController (Private);
-	if (EFI_ERROR(Status))
-		return Status;
+	return NvmeStartController (Private);
+}
+
+/**
+  Complete the initialization of the Nvm Express controller started by
+  NvmeControllerStart(): identify it and create the I/O queues.
+
+  @param[in] Private                 The pointer to the NVME_CONTROLLER_PRIVATE_DATA data structure.
+
+  @retval EFI_SUCCESS                The NVM Express Controller is initialized successfully.
+  @retval Others                     A device error occurred while initializing the controller.
+
+**/
+EFI_STATUS
+NvmeControllerFinish (
+	IN NVME_CONTROLLER_PRIVATE_DATA    *Private
+)
+{
+	EFI_STATUS                      Status;
+	UINT8                           Sn[21];
+	UINT8                           Mn[41];
 
 	//
 	// Allocate buffer for Identify Controller data
@@ -970,3 +1034,30 @@ NvmeControllerInit (
 	return Status;
 }
 
+/**
+  Initialize the Nvm Express controller.
+
+  @param[in] Private                 The pointer to the NVME_CONTROLLER_PRIVATE_DATA data structure.
+
+  @retval EFI_SUCCESS                The NVM Express Controller is initialized successfully.
+  @retval Others                     A device error occurred while initializing the controller.
+
+**/
+EFI_STATUS
+NvmeControllerInit (
+	IN NVME_CONTROLLER_PRIVATE_DATA    *Private
+)
+{
+	EFI_STATUS                      Status;
+
+	Status = NvmeControllerStart (Private);
+	if (EFI_ERROR(Status))
+		return Status;
+
+	Status = NvmeWaitController (Private);
+	if (EFI_ERROR(Status))
+		return Status;
+
+	return NvmeControllerFinish (Private);
+}
+
@@ -55,6 +55,64 @@ NvmHcRwMmio (
 	IN OUT VOID                  *Data
 );
 
+/**
+  Start the initialization of the Nvm Express controller: program the admin
+  queues and set the enable bit.
+
+  @param[in] Private                 The pointer to the NVME_CONTROLLER_PRIVATE_DATA data structure.
+
+  @retval EFI_SUCCESS                The NVM Express Controller is being enabled.
+  @retval Others                     A device error occurred while initializing the controller.
+
+**/
+EFI_STATUS
+NvmeControllerStart (
+	IN NVME_CONTROLLER_PRIVATE_DATA    *Private
+);
+
+/**
+  Check whether the Nvm Express controller started by NvmeControllerStart() is ready.
+
+  @param[in] Private                 The pointer to the NVME_CONTROLLER_PRIVATE_DATA data structure.
+
+  @retval EFI_SUCCESS                The controller is ready.
+  @retval EFI_NOT_READY              The controller is not ready yet.
+  @retval EFI_DEVICE_ERROR           Fail to read the controller status.
+
+**/
+EFI_STATUS
+NvmeControllerReady (
+	IN NVME_CONTROLLER_PRIVATE_DATA    *Private
+);
+
+/**
+  Get the maximum time the Nvm Express controller takes to become ready.
+
+  @param[in] Private                 The pointer to the NVME_CONTROLLER_PRIVATE_DATA data structure.
+
+  @return The timeout in milliseconds.
+
+**/
+UINT32
+NvmeReadyTimeout (
+	IN NVME_CONTROLLER_PRIVATE_DATA    *Private
+);
+
+/**
+  Complete the initialization of the Nvm Express controller once ready:
+  identify it and create the I/O queues.
+
+  @param[in] Private                 The pointer to the NVME_CONTROLLER_PRIVATE_DATA data structure.
+
+  @retval EFI_SUCCESS                The NVM Express Controller is initialized successfully.
+  @retval Others                     A device error occurred while initializing the controller.
+
+**/
+EFI_STATUS
+NvmeControllerFinish (
+	IN NVME_CONTROLLER_PRIVATE_DATA    *Private
+);
+
 /**
   Initialize the Nvm Express controller.
 
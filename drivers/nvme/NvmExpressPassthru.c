@@ -354,6 +354,121 @@ EXIT:
 	return NULL;
 }
 
+/**
+  Check whether a scatter-gather list can be described by a single PRP
+  list: every segment but the first must start on a memory page boundary
+  and every segment but the last must end on one.
+
+  @param[in]     Segs                The scatter-gather segments.
+  @param[in]     NbSegs              The number of segments.
+
+  @retval TRUE   The segments can be transferred by a single command.
+  @retval FALSE  The segments must be transferred one by one.
+
+**/
+BOOLEAN
+NvmeSgIsPrpCompatible (
+	IN CONST NVME_SG_ENTRY              *Segs,
+	IN UINTN                            NbSegs
+)
+{
+	UINTN                       Index;
+
+	for (Index = 0; Index < NbSegs; Index++) {
+		if (Segs[Index].Length == 0)
+			return FALSE;
+
+		if (Index != 0 && ((UINTN)Segs[Index].Buffer & (EFI_PAGE_SIZE - 1)) != 0)
+			return FALSE;
+
+		if (Index != NbSegs - 1 &&
+		    (((UINTN)Segs[Index].Buffer + Segs[Index].Length) & (EFI_PAGE_SIZE - 1)) != 0)
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
+/**
+  Create the PRP lists describing a scatter-gather transfer.  The first
+  memory page of the first segment is addressed by PRP entry 1 and is
+  not part of the lists.
+
+  @param[in]     Segs                The scatter-gather segments.
+  @param[in]     NbSegs              The number of segments.
+  @param[out]    PrpListHost         The host base address of PRP lists.
+  @param[out]    PrpEntries          The number of data PRP entries.
+
+  @retval The pointer to the first PRP List of the PRP lists.
+
+**/
+static UINT64 *
+NvmeCreateSgPrpList (
+	IN CONST NVME_SG_ENTRY              *Segs,
+	IN UINTN                            NbSegs,
+	OUT    VOID                         **PrpListHost,
+	OUT    UINTN                        *PrpEntries
+)
+{
+	UINTN                       PrpEntryNo;
+	UINTN                       PrpListNo;
+	UINTN                       Entries;
+	UINTN                       Left;
+	UINTN                       PrpEntryIndex;
+	UINTN                       Index;
+	UINT64                      Addr;
+	UINT64                      End;
+	UINT64                      *PrpList;
+
+	PrpEntryNo = EFI_PAGE_SIZE / sizeof (UINT64);
+
+	Entries = 0;
+	for (Index = 0; Index < NbSegs; Index++) {
+		Addr = (UINT64)(UINTN)Segs[Index].Buffer;
+		End  = Addr + Segs[Index].Length;
+		if (Index == 0)
+			Addr = (Addr + EFI_PAGE_SIZE) & ~(EFI_PAGE_SIZE - 1);
+		if (End > Addr)
+			Entries += EFI_SIZE_TO_PAGES(End - Addr);
+	}
+	*PrpEntries = Entries;
+
+	//
+	// Each PRP list but the last one ends with a pointer to the next list.
+	//
+	PrpListNo = 1;
+	for (Left = Entries; Left > PrpEntryNo; Left -= PrpEntryNo - 1)
+		PrpListNo++;
+
+	PrpList = nvme_alloc_pages(PrpListNo);
+	if (PrpList == NULL) {
+		DEBUG_NVME ((EFI_D_ERROR, "NvmeCreateSgPrpList: create PrpList failure!\n"));
+		return NULL;
+	}
+	*PrpListHost = PrpList;
+
+	PrpEntryIndex = 0;
+	Left = Entries;
+	for (Index = 0; Index < NbSegs; Index++) {
+		Addr = (UINT64)(UINTN)Segs[Index].Buffer;
+		End  = Addr + Segs[Index].Length;
+		if (Index == 0)
+			Addr = (Addr + EFI_PAGE_SIZE) & ~(EFI_PAGE_SIZE - 1);
+
+		for (; Addr < End; Addr += EFI_PAGE_SIZE) {
+			if (PrpEntryIndex == PrpEntryNo - 1 && Left > 1) {
+				PrpList[PrpEntryIndex] = (UINT64)(UINTN)(PrpList + PrpEntryNo);
+				PrpList += PrpEntryNo;
+				PrpEntryIndex = 0;
+			}
+			PrpList[PrpEntryIndex++] = Addr;
+			Left--;
+		}
+	}
+
+	return *PrpListHost;
+}
+
 /**
   Sends an NVM Express Command Packet to an NVM Express controller or namespace. This function supports
   both blocking I/O and non-blocking I/O. The blocking I/O functionality is required, and the non-blocking
@@ -394,6 +509,40 @@ NvmExpressPassThru (
 	IN OUT EFI_NVM_EXPRESS_PASS_THRU_COMMAND_PACKET    *Packet,
 	IN     ASYNC_IO_CALL_BACK                          *Event
 )
+{
+	return NvmExpressPassThruSg (This, NamespaceId, Packet, Event, NULL, 0);
+}
+
+/**
+  Sends an NVM Express Command Packet whose data buffer is described by a
+  scatter-gather list rather than by Packet->TransferBuffer.  All the
+  segments are mapped by the PRP entries of a single command.
+
+  @param[in]     This                A pointer to the EFI_NVM_EXPRESS_PASS_THRU_PROTOCOL instance.
+  @param[in]     NamespaceId         A 32 bit namespace ID as defined in the NVMe specification.
+  @param[in,out] Packet              A pointer to the NVM Express Command Packet.
+  @param[in]     Event               Must be NULL when Segs is not NULL, the scatter-gather
+                                     PRP lists are only supported for blocking commands.
+  @param[in]     Segs                The scatter-gather segments, or NULL to use
+                                     Packet->TransferBuffer.
+  @param[in]     NbSegs              The number of segments.
+
+  @retval EFI_SUCCESS                The NVM Express Command Packet was sent.
+  @retval EFI_INVALID_PARAMETER      The segments cannot be described by PRP entries.
+  @retval EFI_UNSUPPORTED            A non-blocking scatter-gather command was requested.
+  @retval Others                     See NvmExpressPassThru().
+
+**/
+EFI_STATUS
+EFIAPI
+NvmExpressPassThruSg (
+	IN     EFI_NVM_EXPRESS_PASS_THRU_PROTOCOL          *This,
+	IN     UINT32                                      NamespaceId,
+	IN OUT EFI_NVM_EXPRESS_PASS_THRU_COMMAND_PACKET    *Packet,
+	IN     ASYNC_IO_CALL_BACK                          *Event,
+	IN     CONST NVME_SG_ENTRY                         *Segs,
+	IN     UINTN                                       NbSegs
+)
 {
 	NVME_CONTROLLER_PRIVATE_DATA   *Private;
 	EFI_STATUS                     Status;
@@ -412,6 +561,8 @@ NvmExpressPassThru (
 	UINT32                         Data;
 	NVME_PASS_THRU_ASYNC_REQ       *AsyncRequest;
 	UINT64                         TimeCount;
+	VOID                           *SgPrpListHost;
+	UINTN                          SgPrpEntries;
 
 	//
 	// check the data fields in Packet parameter.
@@ -419,6 +570,16 @@ NvmExpressPassThru (
 	if ((This == NULL) || (Packet == NULL))
 		return EFI_INVALID_PARAMETER;
 
+	if (Segs != NULL) {
+		if (NbSegs == 0 || !NvmeSgIsPrpCompatible (Segs, NbSegs))
+			return EFI_INVALID_PARAMETER;
+
+		if (Event != NULL && *Event != NULL)
+			return EFI_UNSUPPORTED;
+
+		Packet->TransferBuffer = Segs[0].Buffer;
+	}
+
 	if ((Packet->NvmeCmd == NULL) || (Packet->NvmeCompletion == NULL))
 		return EFI_INVALID_PARAMETER;
 
@@ -468,10 +629,11 @@ NvmExpressPassThru (
 		}
 	}
 
-	PrpListHost = NULL;
-	PrpListNo   = 0;
-	Prp         = NULL;
-	Status      = EFI_SUCCESS;
+	PrpListHost   = NULL;
+	PrpListNo     = 0;
+	Prp           = NULL;
+	SgPrpListHost = NULL;
+	Status        = EFI_SUCCESS;
 
 	if (Packet->QueueType == NVME_ADMIN_QUEUE)
 		QueueId = 0;
@@ -539,7 +701,22 @@ NvmExpressPassThru (
 	Offset = ((UINT16)Sq->Prp[0]) & (EFI_PAGE_SIZE - 1);
 	Bytes  = Packet->TransferLength;
 
-	if ((Offset + Bytes) > (EFI_PAGE_SIZE * 2)) {
+	if (Segs != NULL && NbSegs > 1) {
+		//
+		// Map the remaining pages of every segment, a single remaining
+		// page is addressed directly by the second PRP entry.
+		//
+		Prp = NvmeCreateSgPrpList (Segs, NbSegs, &SgPrpListHost, &SgPrpEntries);
+		if (Prp == NULL) {
+			Status = EFI_OUT_OF_RESOURCES;
+			goto EXIT;
+		}
+
+		if (SgPrpEntries == 1)
+			Sq->Prp[1] = Prp[0];
+		else if (SgPrpEntries > 1)
+			Sq->Prp[1] = (UINT64)(UINTN)Prp;
+	} else if ((Offset + Bytes) > (EFI_PAGE_SIZE * 2)) {
 		//
 		// Create PrpList for remaining data buffer.
 		//
@@ -589,7 +766,7 @@ NvmExpressPassThru (
 
 	Status = NvmHcRwMmio(Private->NvmeHCBase, NVME_SQTDBL_OFFSET(QueueId, Private->Cap.Dstrd), FALSE, sizeof (Data), &Data);
 	if (EFI_ERROR (Status))
-		return Status;
+		goto EXIT;
 
 	//
 	// For non-blocking requests, return directly if the command is placed
@@ -669,6 +846,9 @@ NvmExpressPassThru (
 	}
 
 EXIT:
+	if (SgPrpListHost != NULL)
+		nvme_free_pages(SgPrpListHost);
+
 	return Status;
 }
 
@@ -296,6 +296,20 @@ typedef struct {
 	UINT16 Elbatm;              /* Expected Logical Block Application Tag Mask */
 } NVME_COMPARE;
 
+//
+// Copy command Source Range entry, descriptor format 0
+//
+typedef struct {
+	UINT64 Rsvd1;
+	UINT64 Slba;                /* Starting LBA */
+	UINT16 Nlb;                 /* Number of Logical Blocks, 0's based */
+	UINT16 Rsvd2;
+	UINT32 Eilbrt;              /* Expected Initial Logical Block Reference Tag */
+	UINT16 Elbat;               /* Expected Logical Block Application Tag */
+	UINT16 Elbatm;              /* Expected Logical Block Application Tag Mask */
+	UINT32 Rsvd3;
+} NVME_COPY_RANGE;
+
 typedef union {
 	NVME_READ                   Read;
 	NVME_WRITE                  Write;
@@ -368,6 +382,8 @@ typedef struct {
 	UINT16 Rsvd3;               /* Reserved as of Nvm Express 1.1 Spec */
 	UINT32 Nn;                  /* Number of Namespaces */
 	UINT16 Oncs;                /* Optional NVM Command Support */
+	#define WRITE_ZEROES_SUPPORTED          BIT3
+	#define COPY_SUPPORTED                  BIT8
 	UINT16 Fuses;               /* Fused Operation Support */
 	UINT8  Fna;                 /* Format NVM Attributes */
 	UINT8  Vwc;                 /* Volatile Write Cache */
@@ -420,7 +436,11 @@ typedef struct {
 	UINT8  Dps;                 /* End-to-end Data Protection Type Settings */
 	UINT8  Nmic;                /* Namespace Multi-path I/O and Namespace Sharing Capabilities */
 	UINT8  Rescap;              /* Reservation Capabilities */
-	UINT8  Rsvd1[88];           /* Reserved as of Nvm Express 1.1 Spec */
+	UINT8  Rsvd1[42];           /* Reserved as of Nvm Express 1.1 Spec */
+	UINT16 Mssrl;               /* Maximum Single Source Range Length */
+	UINT32 Mcl;                 /* Maximum Copy Length */
+	UINT8  Msrc;                /* Maximum Source Range Count, 0's based */
+	UINT8  Rsvd3[39];           /* Reserved as of Nvm Express 1.1 Spec */
 	UINT64 Eui64;               /* IEEE Extended Unique Identifier */
 	//
 	// LBA Format
@@ -748,6 +768,8 @@ typedef struct {
 #define NVME_IO_FLUSH_OPC                    0
 #define NVME_IO_WRITE_OPC                    1
 #define NVME_IO_READ_OPC                     2
+#define NVME_IO_WRITE_ZEROES_OPC             8
+#define NVME_IO_COPY_OPC                     0x19
 
 #pragma pack()
 
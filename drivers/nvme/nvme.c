@@ -45,25 +45,6 @@ static EFI_STATUS _init(storage_t *s)
 {
 	DEVICE_BLOCK_INFO	  BlockInfo;
 	EFI_STATUS ret;
-	pcidev_t pci_dev = 0;
-	size_t i;
-
-	for (i = 0; i < ARRAY_SIZE(SUPPORTED_DEVICES); i++)
-		if (pci_find_device(SUPPORTED_DEVICES[i].vid,
-				SUPPORTED_DEVICES[i].did,
-				&pci_dev))
-			break;
-
-	DEBUG_NVME ((EFI_D_INFO, "pci_dev = 0x%X\n", pci_dev));
-	if (!pci_dev)
-		return EFI_UNSUPPORTED;
-
-	ret = NvmeInitialize(pci_dev);
-	if (ret)
-		DEBUG_NVME ((EFI_D_INFO, "NvmeInitialize ret = 0x%X\n", ret));
-
-	if (ret)
-		return EFI_DEVICE_ERROR;
 
 	ret = NvmeGetMediaInfo(DEVICE_INDEX_DEFAULT, &BlockInfo);
 	if (EFI_ERROR(ret)) {
@@ -110,12 +91,76 @@ static EFI_LBA _write(storage_t *s,
 	return 0;
 }
 
+#define NVME_MAX_SEGS	16
+
+static EFI_LBA _rwv(storage_t *s, EFI_LBA start, EFI_LBA count,
+		    const storage_seg_t *segs, UINTN nb_segs, BOOLEAN write)
+{
+	NVME_SG_ENTRY entries[NVME_MAX_SEGS];
+	EFI_STATUS ret;
+	EFI_LBA done;
+	UINTN i, n;
+
+	for (done = 0; nb_segs; nb_segs -= n, segs += n) {
+		n = min(nb_segs, (UINTN)NVME_MAX_SEGS);
+		for (i = 0; i < n; i++) {
+			entries[i].Buffer = segs[i].buf;
+			entries[i].Length = segs[i].len;
+		}
+
+		if (write)
+			ret = NvmeWriteBlocksV(DEVICE_INDEX_DEFAULT,
+					       start + done, entries, n);
+		else
+			ret = NvmeReadBlocksV(DEVICE_INDEX_DEFAULT,
+					      start + done, entries, n);
+		if (EFI_ERROR(ret)) {
+			DEBUG_NVME ((EFI_D_INFO, "nvme_rwv	Error =0x%lx\n", ret));
+			return 0;
+		}
+
+		for (i = 0; i < n; i++)
+			done += segs[i].len / s->blk_sz;
+	}
+
+	return done == count ? count : 0;
+}
+
+static EFI_LBA _readv(storage_t *s, EFI_LBA start, EFI_LBA count,
+		      const storage_seg_t *segs, UINTN nb_segs)
+{
+	return _rwv(s, start, count, segs, nb_segs, FALSE);
+}
+
+static EFI_LBA _writev(storage_t *s, EFI_LBA start, EFI_LBA count,
+		       const storage_seg_t *segs, UINTN nb_segs)
+{
+	return _rwv(s, start, count, segs, nb_segs, TRUE);
+}
+
+static EFI_STATUS _write_zeroes(storage_t *s __attribute__((unused)),
+				EFI_LBA start, EFI_LBA count)
+{
+	return NvmeWriteZeroesBlocks(DEVICE_INDEX_DEFAULT, start, count);
+}
+
+static EFI_STATUS _copy(storage_t *s __attribute__((unused)),
+			EFI_LBA src, EFI_LBA dst, EFI_LBA count)
+{
+	return NvmeCopyBlocks(DEVICE_INDEX_DEFAULT, src, dst, count);
+}
+
 
 static storage_t nvme_storage = {
 	.init = _init,
 	.read = _read,
 	.write = _write,
+	.readv = _readv,
+	.writev = _writev,
+	.write_zeroes = _write_zeroes,
+	.copy = _copy,
 	.erase = NULL,
+	.type = STORAGE_NVME,
 	.pci_function = 0,
 	.pci_device = 0,
 };
@@ -125,12 +170,16 @@ static EFI_HANDLE nvme_handle;
 static EFI_GUID nvme_pass_thru_guid = EFI_NVM_EXPRESS_PASS_THRU_PROTOCOL_GUID;
 static EFI_GUID nvme_security_guid = EFI_STORAGE_SECURITY_COMMAND_PROTOCOL_GUID;
 
-static EFI_STATUS nvme_drv_init(EFI_SYSTEM_TABLE *st)
+/* Set from nvme_drv_init() to the end of the controller initialization
+   in nvme_drv_poll(). */
+static BOOLEAN nvme_starting;
+
+static EFI_STATUS nvme_drv_init(EFI_SYSTEM_TABLE *st __attribute__((unused)))
 {
 	EFI_STATUS ret;
 	boot_dev_t *boot_dev;
-	EFI_STORAGE_SECURITY_COMMAND_PROTOCOL *StorageSecurity;
-	EFI_NVM_EXPRESS_PASS_THRU_PROTOCOL *nvme_passthru;
+	pcidev_t pci_dev = 0;
+	size_t i;
 
 	boot_dev = get_boot_media();
 	if (!boot_dev)
@@ -138,6 +187,48 @@ static EFI_STATUS nvme_drv_init(EFI_SYSTEM_TABLE *st)
 	if (boot_dev->type != STORAGE_NVME)
 		return EFI_SUCCESS;
 
+	for (i = 0; i < ARRAY_SIZE(SUPPORTED_DEVICES); i++)
+		if (pci_find_device(SUPPORTED_DEVICES[i].vid,
+				SUPPORTED_DEVICES[i].did,
+				&pci_dev))
+			break;
+
+	DEBUG_NVME ((EFI_D_INFO, "pci_dev = 0x%X\n", pci_dev));
+	if (!pci_dev)
+		return EFI_UNSUPPORTED;
+
+	/* The controller is only enabled here, nvme_drv_poll() waits
+	   for it to be ready while the other drivers are
+	   initialized. */
+	ret = NvmeStartInitialize(pci_dev);
+	if (EFI_ERROR(ret)) {
+		DEBUG_NVME ((EFI_D_INFO, "NvmeInitialize ret = 0x%X\n", ret));
+		return EFI_DEVICE_ERROR;
+	}
+
+	nvme_starting = TRUE;
+	return EFI_SUCCESS;
+}
+
+static EFI_STATUS nvme_drv_poll(EFI_SYSTEM_TABLE *st)
+{
+	EFI_STATUS ret;
+	EFI_STORAGE_SECURITY_COMMAND_PROTOCOL *StorageSecurity;
+	EFI_NVM_EXPRESS_PASS_THRU_PROTOCOL *nvme_passthru;
+
+	if (!nvme_starting)
+		return EFI_SUCCESS;
+
+	ret = NvmeCompleteInitialize();
+	if (ret == EFI_NOT_READY)
+		return ret;
+
+	nvme_starting = FALSE;
+	if (EFI_ERROR(ret)) {
+		DEBUG_NVME ((EFI_D_INFO, "NvmeInitialize ret = 0x%X\n", ret));
+		return EFI_DEVICE_ERROR;
+	}
+
 	nvme_storage.pci_device = (NVME_DISKBUS >> 8) & 0xff;
 	nvme_storage.pci_function = NVME_DISKBUS & 0xff;
 	ret = storage_init(st, &nvme_storage, &nvme_handle);
@@ -193,6 +284,12 @@ ewdrv_t nvme_drv = {
 	.name = "nvme",
 	.description = "PCI NVME driver",
 	.init = nvme_drv_init,
-	.exit = nvme_drv_exit
+	.poll = nvme_drv_poll,
+	.exit = nvme_drv_exit,
+	.lazy = TRUE,
+	.provides = (const EFI_GUID * const []){
+		&nvme_pass_thru_guid, &nvme_security_guid, NULL
+	},
+	.storages = EWDRV_STORAGE(STORAGE_NVME)
 };
 
@@ -98,6 +98,85 @@ uint64_t mmc_read_count(void) {
 		 m->ext_csd[EXT_CSD_SEC_COUNT + 3] << 24);
 }
 
+/*
+** TRIM can stand for writing zeroes only if the card supports it and
+** reports that erased memory reads as zeroes.
+*/
+bool mmc_trim_zeroes(void)
+{
+	struct mmc *m = &card;
+
+	return m->card_type == CARD_TYPE_MMC
+		&& (m->ext_csd[EXT_CSD_SEC_FEATURE_SUPPORT] & EXT_CSD_SEC_GB_CL_EN)
+		&& m->ext_csd[EXT_CSD_ERASED_MEM_CONT] == 0;
+}
+
+static int mmc_erase_cmd(unsigned index, uint32_t args)
+{
+	struct cmd c;
+
+	memset(&c, 0, sizeof(c));
+	c.index    = index;
+	c.args     = args;
+	c.resp_len = 32;
+	c.flags    = index == CMD_ERASE ? CMDF_BUSY_CHECK : 0;
+	c.retry    = 5;
+
+	return __mmc_send_cmd(&c);
+}
+
+/*
+** TRIM the [START, START + COUNT[ blocks and wait for the card to
+** leave the programming state, for at most TRIM_MULT x 300ms per
+** erase group.
+*/
+int mmc_trim(uint32_t start, uint32_t count)
+{
+	struct mmc *m = &card;
+	struct cmd c;
+	uint64_t begin, timeout;
+	uint32_t grp_blocks;
+	uint8_t state;
+
+	if (!count)
+		return 0;
+
+	if (mmc_erase_cmd(CMD_ERASE_GROUP_START, start)
+	    || mmc_erase_cmd(CMD_ERASE_GROUP_END, start + count - 1)
+	    || mmc_erase_cmd(CMD_ERASE, MMC_ERASE_ARG_TRIM))
+		return 1;
+
+	/* HC_ERASE_GRP_SIZE is in 512KiB units */
+	grp_blocks = m->ext_csd[EXT_CSD_HC_ERASE_GRP_SIZE] * 1024;
+	if (!grp_blocks)
+		grp_blocks = 1024;
+	timeout = m->ext_csd[EXT_CSD_TRIM_MULT] * 300 * 1000;
+	if (!timeout)
+		timeout = 300 * 1000;
+	timeout *= (count + grp_blocks - 1) / grp_blocks;
+
+	memset(&c, 0, sizeof(c));
+	begin = timer_us(0);
+	do
+	{
+		if (timer_us(begin) > timeout)
+			return 1;
+
+		c.resp_len = 32;
+		c.index    = CMD_GET_STATE;
+		c.flags    = 0;
+		c.args     = m->rca << 16;
+		c.retry    = 5;
+		if (__mmc_send_cmd(&c) != 0)
+			return 1;
+
+		state = (c.resp [0] >> 9) & 0xf;
+
+	} while (state == 7); /* 7 = Programming State */
+
+	return 0;
+}
+
 /* ------------------------------------------------------------------------ */
 /*
 ** Print salient properties read from the eMMC CID and EXT_CSD registers
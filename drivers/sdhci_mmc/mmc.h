@@ -48,6 +48,12 @@
 #define CMD_SET_BLOCK_COUNT		23
 #define CMD_WRITE_SINGLE_BLOCK		24
 #define CMD_WRITE_MULTIPLE_BLOCKS	25
+#define CMD_ERASE_GROUP_START		35
+#define CMD_ERASE_GROUP_END		36
+#define CMD_ERASE			38
+
+/* CMD38 argument */
+#define MMC_ERASE_ARG_TRIM		0x00000001
 
 // SD Card
 #define CMD_SEND_IF_COND	8
@@ -175,6 +181,12 @@ struct cmd
 
 #define EXT_CSD_SEC_COUNT	212
 
+#define EXT_CSD_ERASED_MEM_CONT		181
+#define EXT_CSD_HC_ERASE_GRP_SIZE	224
+#define EXT_CSD_SEC_FEATURE_SUPPORT	231
+#define EXT_CSD_SEC_GB_CL_EN		(1 << 4)	/* TRIM supported */
+#define EXT_CSD_TRIM_MULT		232
+
 extern int mmc_init_card(pcidev_t dev);
 extern int mmc_send_cmd(struct cmd *c);
 extern int mmc_wait_cmd_done(struct cmd *c);
@@ -189,5 +201,7 @@ extern int mmc_enable_sdr25(struct mmc *m);
 
 extern void mmc_dll_tune(void);
 extern uint64_t mmc_read_count(void);
+extern bool mmc_trim_zeroes(void);
+extern int mmc_trim(uint32_t start, uint32_t count);
 extern int mmc_update_ext_csd(void);
 #endif
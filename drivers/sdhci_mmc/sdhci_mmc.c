@@ -173,11 +173,34 @@ static EFI_LBA _write(storage_t *s, EFI_LBA start, EFI_LBA count, const void *bu
 	return split_and_transfer_data(s, false, start, count, (void *)buf);
 }
 
+/* TRIM commands are kept small enough for the card to complete them
+   within a few erase group timeouts. */
+#define TRIM_MAX_BLOCKS	(64 * 1024)
+
+static EFI_STATUS _write_zeroes(storage_t *s __attribute__((unused)),
+				EFI_LBA start, EFI_LBA count)
+{
+	EFI_LBA n;
+
+	if (!mmc_trim_zeroes())
+		return EFI_UNSUPPORTED;
+
+	for (; count; start += n, count -= n) {
+		n = count > TRIM_MAX_BLOCKS ? TRIM_MAX_BLOCKS : count;
+		if (mmc_trim(start, n))
+			return EFI_DEVICE_ERROR;
+	}
+
+	return EFI_SUCCESS;
+}
+
 static storage_t sdhci_mmc_storage = {
 	.init = _init,
 	.read = _read,
 	.write = _write,
+	.write_zeroes = _write_zeroes,
 	.erase = NULL,
+	.type = STORAGE_EMMC,
 	.pci_function = 0,
 	.pci_device = 0,
 };
@@ -244,11 +267,12 @@ sdio_send_command(EFI_SD_HOST_IO_PROTOCOL *This,
 	return EFI_SUCCESS;
 }
 
+static EFI_GUID sdio_guid = EFI_SD_HOST_IO_PROTOCOL_GUID;
+
 static EFI_STATUS sdhci_mmc_init(EFI_SYSTEM_TABLE *st)
 {
 	EFI_STATUS ret;
 	EFI_SD_HOST_IO_PROTOCOL *sdio;
-	EFI_GUID sdio_guid = EFI_SD_HOST_IO_PROTOCOL_GUID;
 	boot_dev_t *boot_dev;
 
 	if (!st)
@@ -300,5 +324,8 @@ ewdrv_t sdhci_mmc_drv = {
 	.name = "sdhci_mmc",
 	.description = "SDHCI PCI eMMC driver",
 	.init = sdhci_mmc_init,
-	.exit = sdhci_mmc_exit
+	.exit = sdhci_mmc_exit,
+	.lazy = TRUE,
+	.provides = (const EFI_GUID * const []){ &sdio_guid, NULL },
+	.storages = EWDRV_STORAGE(STORAGE_EMMC)
 };
@@ -72,6 +72,8 @@
 #define EFI_SCSI_OP_WRITE_VERIFY    0x2e
 #define EFI_SCSI_OP_WRITE_LONG      0x3f
 #define EFI_SCSI_OP_WRITE_SAME      0x41
+#define EFI_SCSI_OP_UNMAP           0x42
+#define EFI_SCSI_OP_WRITE_SAME16    0x93
 
 //
 // Additional commands for Sequential Access Devices
@@ -251,6 +253,23 @@ typedef struct {
 	UINT8 MaximumPrefetchXdreadXdwriteTransferLength3;
 	UINT8 MaximumPrefetchXdreadXdwriteTransferLength2;
 	UINT8 MaximumPrefetchXdreadXdwriteTransferLength1;
+	UINT8 MaximumUnmapLbaCount4;
+	UINT8 MaximumUnmapLbaCount3;
+	UINT8 MaximumUnmapLbaCount2;
+	UINT8 MaximumUnmapLbaCount1;
+	UINT8 MaximumUnmapBlockDescriptorCount4;
+	UINT8 MaximumUnmapBlockDescriptorCount3;
+	UINT8 MaximumUnmapBlockDescriptorCount2;
+	UINT8 MaximumUnmapBlockDescriptorCount1;
+	UINT8 OptimalUnmapGranularity4;
+	UINT8 OptimalUnmapGranularity3;
+	UINT8 OptimalUnmapGranularity2;
+	UINT8 OptimalUnmapGranularity1;
+	UINT8 UnmapGranularityAlignment4;
+	UINT8 UnmapGranularityAlignment3;
+	UINT8 UnmapGranularityAlignment2;
+	UINT8 UnmapGranularityAlignment1;
+	UINT8 Reserved_36_63[28];
 } EFI_SCSI_BLOCK_LIMITS_VPD_PAGE;
 
 ///
@@ -302,6 +321,8 @@ typedef struct {
 	UINT8 BlockSize0;
 	UINT8 Protection;
 	UINT8 LogicPerPhysical;
+	#define EFI_SCSI_LBPME  BIT7  // Logical block provisioning management enabled
+	#define EFI_SCSI_LBPRZ  BIT6  // Unmapped logical blocks read as zeroes
 	UINT8 LowestAlignLogic2;
 	UINT8 LowestAlignLogic1;
 	UINT8 Reserved[16];
@@ -11,6 +11,8 @@
 
 **/
 
+#include <kconfig.h>
+#include <libpayload.h>
 #include "UfsInternal.h"
 #include "UfsBlockIoLib.h"
 
@@ -1257,6 +1259,603 @@ UfsWriteBlocks(
 	return Status;
 }
 
+/**
+  Execute a READ or WRITE SCSI command whose data buffer is a scatter-gather
+  list on a specific UFS device.
+
+  @param[in]  DeviceIndex   Specifies the block device to which the function wants
+                            to talk.
+  @param[in]  StartLBA      The starting logical block address.
+  @param[in]  Segs          The dword aligned data segments.
+  @param[in]  SegCount      The number of segments.
+  @param[in]  Write         TRUE to write the segments, FALSE to read them.
+
+  @retval EFI_SUCCESS       The operation is done correctly.
+  @retval Others            The operation fails.
+
+**/
+static
+EFI_STATUS
+UfsRwBlocksSg(
+	IN  UINTN                          DeviceIndex,
+	IN  EFI_LBA                        StartLBA,
+	IN  UFS_SG_ENTRY                   *Segs,
+	IN  UINT32                         SegCount,
+	IN  BOOLEAN                        Write
+	)
+{
+	EFI_STATUS                         Status;
+	UFS_PEIM_HC_PRIVATE_DATA           *Private;
+	UFS_SCSI_REQUEST_PACKET            Packet;
+	UINT8                              Cdb[UFS_SCSI_OP_LENGTH_SIXTEEN];
+	EFI_SCSI_SENSE_DATA                SenseData;
+	UINT8                              SenseDataLength;
+	BOOLEAN                            NeedRetry;
+	UINT32                             Length;
+	UINT32                             NumberOfBlocks;
+	UINT32                             Index;
+
+	Private = UfsGetPrivateData();
+	if (Private == NULL)
+		return EFI_NOT_FOUND;
+
+	if ((Private->Luns.BitMask & (BIT0 << DeviceIndex)) == 0)
+		return EFI_ACCESS_DENIED;
+
+	Length = 0;
+	for (Index = 0; Index < SegCount; Index++)
+		Length += Segs[Index].Length;
+
+	if (Length % Private->Media[DeviceIndex].BlockSize != 0)
+		return EFI_BAD_BUFFER_SIZE;
+
+	NumberOfBlocks = Length / Private->Media[DeviceIndex].BlockSize;
+
+	NeedRetry = TRUE;
+	do {
+		ZeroMem(&SenseData, sizeof (SenseData));
+		SenseDataLength = sizeof (SenseData);
+		Status = UfsTestUnitReady(
+			Private,
+			DeviceIndex,
+			&SenseData,
+			&SenseDataLength
+			);
+		if (!EFI_ERROR(Status))
+			break;
+
+		if (SenseDataLength == 0)
+			continue;
+
+		Status = UfsParsingSenseKeys(&(Private->Media[DeviceIndex]), &SenseData, &NeedRetry);
+		if (EFI_ERROR(Status))
+			return EFI_DEVICE_ERROR;
+	} while (NeedRetry);
+
+	ZeroMem(&Packet, sizeof (UFS_SCSI_REQUEST_PACKET));
+	ZeroMem(Cdb, sizeof (Cdb));
+
+	if (Private->Media[DeviceIndex].LastBlock < 0xfffffffful) {
+		Cdb[0] = Write ? EFI_SCSI_OP_WRITE10 : EFI_SCSI_OP_READ10;
+		WriteUnaligned32((UINT32 *)&Cdb[2], SwapBytes32((UINT32)StartLBA));
+		WriteUnaligned16((UINT16 *)&Cdb[7], SwapBytes16((UINT16)NumberOfBlocks));
+		Packet.CdbLength = UFS_SCSI_OP_LENGTH_TEN;
+	} else {
+		Cdb[0] = Write ? EFI_SCSI_OP_WRITE16 : EFI_SCSI_OP_READ16;
+		WriteUnaligned64((UINT64 *)&Cdb[2], SwapBytes64(StartLBA));
+		WriteUnaligned32((UINT32 *)&Cdb[10], SwapBytes32(NumberOfBlocks));
+		Packet.CdbLength = UFS_SCSI_OP_LENGTH_SIXTEEN;
+	}
+
+	Packet.Timeout      = UFS_TIMEOUT;
+	Packet.Cdb          = Cdb;
+	Packet.DataSegs     = Segs;
+	Packet.DataSegCount = SegCount;
+	if (Write) {
+		Packet.OutTransferLength = Length;
+		Packet.DataDirection     = UfsDataOut;
+	} else {
+		Packet.InTransferLength  = Length;
+		Packet.DataDirection     = UfsDataIn;
+	}
+
+	Status = UfsExecScsiCmds(Private, (UINT8)DeviceIndex, &Packet);
+	if (EFI_ERROR(Status))
+		return Status;
+
+	if ((Write ? Packet.OutTransferLength : Packet.InTransferLength) != Length)
+		return EFI_DEVICE_ERROR;
+
+	return EFI_SUCCESS;
+}
+
+/**
+  Transfer a scatter-gather list of buffers from or to consecutive blocks.
+  Consecutive dword aligned segments are grouped in single commands of at
+  most 64KB, the other segments are transferred one by one.
+
+  @param[in]  DeviceIndex   Specifies the block device to which the function wants
+                            to talk.
+  @param[in]  StartLBA      The starting logical block address.
+  @param[in]  Segs          The data segments, each a multiple of the block size.
+  @param[in]  SegCount      The number of segments.
+  @param[in]  Write         TRUE to write the segments, FALSE to read them.
+
+  @retval EFI_SUCCESS       The operation is done correctly.
+  @retval Others            The operation fails.
+
+**/
+static
+EFI_STATUS
+UfsRwBlocksV(
+	IN  UINTN                          DeviceIndex,
+	IN  EFI_LBA                        StartLBA,
+	IN  UFS_SG_ENTRY                   *Segs,
+	IN  UINT32                         SegCount,
+	IN  BOOLEAN                        Write
+	)
+{
+	EFI_STATUS                         Status;
+	UFS_PEIM_HC_PRIVATE_DATA           *Private;
+	UINT32                             BlockSize;
+	UINT32                             Length;
+	UINT32                             Count;
+
+	Private = UfsGetPrivateData();
+	if (Private == NULL)
+		return EFI_NOT_FOUND;
+
+	if (DeviceIndex >= UFS_PEIM_MAX_LUNS)
+		return EFI_INVALID_PARAMETER;
+
+	BlockSize = Private->Media[DeviceIndex].BlockSize;
+
+	while (SegCount > 0) {
+		Length = 0;
+		for (Count = 0; Count < SegCount; Count++) {
+			if (((UINTN)Segs[Count].Buffer & (BIT0 | BIT1)) != 0 ||
+			    Length + Segs[Count].Length > SIZE_64KB)
+				break;
+			Length += Segs[Count].Length;
+		}
+
+		if (Count > 1) {
+			Status = UfsRwBlocksSg(DeviceIndex, StartLBA, Segs, Count, Write);
+		} else {
+			Count  = 1;
+			Length = Segs[0].Length;
+			if (Write)
+				Status = UfsWriteBlocks(DeviceIndex, StartLBA, Length, Segs[0].Buffer);
+			else
+				Status = UfsReadBlocks(DeviceIndex, StartLBA, Length, Segs[0].Buffer);
+		}
+		if (EFI_ERROR(Status))
+			return Status;
+
+		StartLBA += Length / BlockSize;
+		Segs     += Count;
+		SegCount -= Count;
+	}
+
+	return EFI_SUCCESS;
+}
+
+/**
+  This function reads data from UFS into a scatter-gather list of buffers.
+
+  @param[in]  DeviceIndex   Specifies the block device to which the function wants
+                            to talk.
+  @param[in]  StartLBA      The starting logical block address to read from.
+  @param[in]  Segs          The destination segments, each a multiple of the
+                            intrinsic block size of the device.
+  @param[in]  SegCount      The number of segments.
+
+  @retval EFI_SUCCESS       The operation is done correctly.
+  @retval Others            The operation fails.
+
+**/
+EFI_STATUS
+EFIAPI
+UfsReadBlocksV(
+	IN  UINTN                          DeviceIndex,
+	IN  EFI_LBA                        StartLBA,
+	IN  UFS_SG_ENTRY                   *Segs,
+	IN  UINT32                         SegCount
+	)
+{
+	return UfsRwBlocksV(DeviceIndex, StartLBA, Segs, SegCount, FALSE);
+}
+
+/**
+  This function writes a scatter-gather list of buffers to UFS.
+
+  @param[in]  DeviceIndex   Specifies the block device to which the function wants
+                            to talk.
+  @param[in]  StartLBA      The starting logical block address to write to.
+  @param[in]  Segs          The source segments, each a multiple of the
+                            intrinsic block size of the device.
+  @param[in]  SegCount      The number of segments.
+
+  @retval EFI_SUCCESS       The operation is done correctly.
+  @retval Others            The operation fails.
+
+**/
+EFI_STATUS
+EFIAPI
+UfsWriteBlocksV(
+	IN  UINTN                          DeviceIndex,
+	IN  EFI_LBA                        StartLBA,
+	IN  UFS_SG_ENTRY                   *Segs,
+	IN  UINT32                         SegCount
+	)
+{
+	return UfsRwBlocksV(DeviceIndex, StartLBA, Segs, SegCount, TRUE);
+}
+
+/**
+  Execute INQUIRY SCSI command on a specific UFS device to read a Vital
+  Product Data page.
+
+  @param[in]  Private              A pointer to UFS_PEIM_HC_PRIVATE_DATA data structure.
+  @param[in]  Lun                  The lun on which the SCSI cmd executed.
+  @param[in]  PageCode             The VPD page to read.
+  @param[out] Page                 A pointer to the VPD page buffer.
+  @param[in, out] PageLength       On input, the size of Page, on output the length read.
+
+  @retval EFI_SUCCESS              The command executed successfully.
+  @retval EFI_DEVICE_ERROR         A device error occurred while attempting to send SCSI Request Packet.
+  @retval EFI_TIMEOUT              A timeout occurred while waiting for the SCSI Request Packet to execute.
+
+**/
+static
+EFI_STATUS
+UfsInquiryVpd (
+	IN     UFS_PEIM_HC_PRIVATE_DATA     *Private,
+	IN     UINTN                        Lun,
+	IN     UINT8                        PageCode,
+	OUT    VOID                         *Page,
+	IN OUT UINT32                       *PageLength
+	)
+{
+	UFS_SCSI_REQUEST_PACKET             Packet;
+	UINT8                               Cdb[UFS_SCSI_OP_LENGTH_SIX];
+	EFI_STATUS                          Status;
+
+	ZeroMem(&Packet, sizeof(UFS_SCSI_REQUEST_PACKET));
+	ZeroMem(Cdb, sizeof(Cdb));
+
+	Cdb[0]  = EFI_SCSI_OP_INQUIRY;
+	Cdb[1]  = BIT0;          // EVPD
+	Cdb[2]  = PageCode;
+	WriteUnaligned16((UINT16 *)&Cdb[3], SwapBytes16((UINT16)*PageLength));
+
+	Packet.Timeout          = UFS_TIMEOUT;
+	Packet.Cdb              = Cdb;
+	Packet.CdbLength        = sizeof(Cdb);
+	Packet.InDataBuffer     = Page;
+	Packet.InTransferLength = *PageLength;
+	Packet.DataDirection    = UfsDataIn;
+
+	Status = UfsExecScsiCmds(Private, (UINT8)Lun, &Packet);
+	if (EFI_ERROR(Status)) {
+		return Status;
+	}
+
+	if (Packet.TargetStatus != 0) {
+		return EFI_DEVICE_ERROR;
+	}
+
+	*PageLength = Packet.InTransferLength;
+	return EFI_SUCCESS;
+}
+
+/**
+  Execute UNMAP SCSI command on a specific UFS device for a single range,
+  split in block descriptors of at most 0xffffffff blocks.  The range must
+  fit in UFS_UNMAP_MAX_DESCRIPTORS of them.
+
+  @param[in]  Private              A pointer to UFS_PEIM_HC_PRIVATE_DATA data structure.
+  @param[in]  Lun                  The lun on which the SCSI cmd executed.
+  @param[in]  StartLba             The start LBA.
+  @param[in]  SectorNum            The sector number to be unmapped.
+
+  @retval EFI_SUCCESS              The command executed successfully.
+  @retval EFI_UNSUPPORTED          The device rejected the command (ILLEGAL REQUEST).
+  @retval EFI_DEVICE_ERROR         A device error occurred while attempting to send SCSI Request Packet.
+  @retval EFI_TIMEOUT              A timeout occurred while waiting for the SCSI Request Packet to execute.
+
+**/
+static
+EFI_STATUS
+UfsUnmap(
+	IN  UFS_PEIM_HC_PRIVATE_DATA     *Private,
+	IN  UINTN                        Lun,
+	IN  EFI_LBA                      StartLba,
+	IN  UINT64                       SectorNum
+)
+{
+	UFS_SCSI_REQUEST_PACKET             Packet;
+	UINT8                               Cdb[UFS_SCSI_OP_LENGTH_TEN];
+	UINT8                               Param[8 + 16 * UFS_UNMAP_MAX_DESCRIPTORS];
+	UINT8                               *Descriptor;
+	UINT32                              Count;
+	UINT16                              Length;
+	EFI_SCSI_SENSE_DATA                 SenseData;
+	EFI_STATUS                          Status;
+
+	ZeroMem(&Packet, sizeof (UFS_SCSI_REQUEST_PACKET));
+	ZeroMem(Cdb, sizeof (Cdb));
+	ZeroMem(Param, sizeof (Param));
+	ZeroMem(&SenseData, sizeof (SenseData));
+
+	//
+	// Parameter list header followed by the block descriptors.
+	//
+	Descriptor = &Param[8];
+	while (SectorNum > 0) {
+		Count = (SectorNum > 0xffffffff) ? 0xffffffff : (UINT32)SectorNum;
+		WriteUnaligned64((UINT64 *)&Descriptor[0], SwapBytes64(StartLba));
+		WriteUnaligned32((UINT32 *)&Descriptor[8], SwapBytes32(Count));
+		Descriptor += 16;
+		StartLba   += Count;
+		SectorNum  -= Count;
+	}
+	Length = (UINT16)(Descriptor - Param);
+	WriteUnaligned16((UINT16 *)&Param[0], SwapBytes16(Length - 2));
+	WriteUnaligned16((UINT16 *)&Param[2], SwapBytes16(Length - 8));
+
+	Cdb[0] = EFI_SCSI_OP_UNMAP;
+	WriteUnaligned16((UINT16 *)&Cdb[7], SwapBytes16(Length));
+
+	Packet.Timeout = UFS_TIMEOUT;
+	Packet.Cdb = Cdb;
+	Packet.CdbLength = sizeof (Cdb);
+	Packet.OutDataBuffer = Param;
+	Packet.OutTransferLength = Length;
+	Packet.DataDirection = UfsDataOut;
+	Packet.SenseData = &SenseData;
+	Packet.SenseDataLength = sizeof (SenseData);
+
+	Status = UfsExecScsiCmds(Private, (UINT8)Lun, &Packet);
+	if (Packet.SenseDataLength != 0 &&
+	    SenseData.Sense_Key == EFI_SCSI_SK_ILLEGAL_REQUEST) {
+		return EFI_UNSUPPORTED;
+	}
+
+	if (!EFI_ERROR(Status) && Packet.TargetStatus != 0) {
+		Status = EFI_DEVICE_ERROR;
+	}
+
+	return Status;
+}
+
+/**
+  Execute WRITE SAME (16) SCSI command on a specific UFS device, replicating
+  a zeroed block and allowing the device to unmap the range.
+
+  @param[in]  Private              A pointer to UFS_PEIM_HC_PRIVATE_DATA data structure.
+  @param[in]  Lun                  The lun on which the SCSI cmd executed.
+  @param[in]  StartLba             The start LBA.
+  @param[in]  SectorNum            The sector number to be zeroed.
+
+  @retval EFI_SUCCESS              The command executed successfully.
+  @retval EFI_DEVICE_ERROR         A device error occurred while attempting to send SCSI Request Packet.
+  @retval EFI_TIMEOUT              A timeout occurred while waiting for the SCSI Request Packet to execute.
+
+**/
+static
+EFI_STATUS
+UfsWriteSame16(
+	IN  UFS_PEIM_HC_PRIVATE_DATA     *Private,
+	IN  UINTN                        Lun,
+	IN  EFI_LBA                      StartLba,
+	IN  UINT32                       SectorNum
+)
+{
+	UFS_SCSI_REQUEST_PACKET             Packet;
+	UINT8                               Cdb[UFS_SCSI_OP_LENGTH_SIXTEEN];
+
+	ZeroMem(&Packet, sizeof (UFS_SCSI_REQUEST_PACKET));
+	ZeroMem(Cdb, sizeof (Cdb));
+
+	Cdb[0] = EFI_SCSI_OP_WRITE_SAME16;
+	Cdb[1] = BIT3;           // UNMAP
+	WriteUnaligned64((UINT64 *)&Cdb[2], SwapBytes64(StartLba));
+	WriteUnaligned32((UINT32 *)&Cdb[10], SwapBytes32(SectorNum));
+
+	Packet.Timeout = UFS_TIMEOUT;
+	Packet.Cdb = Cdb;
+	Packet.CdbLength = sizeof (Cdb);
+	Packet.OutDataBuffer = Private->ZeroBlock;
+	Packet.OutTransferLength = Private->Media[Lun].BlockSize;
+	Packet.DataDirection = UfsDataOut;
+
+	return UfsExecScsiCmds(Private, (UINT8)Lun, &Packet);
+}
+
+/**
+  Read the UNMAP limits of a LUN from its Block Limits VPD page.  A LUN
+  without this page gets one block descriptor per command and no LBA
+  count limit.
+
+  @param[in]  Private              A pointer to UFS_PEIM_HC_PRIVATE_DATA data structure.
+  @param[in]  Lun                  The lun to probe.
+
+  @retval TRUE                     The LUN implements UNMAP.
+  @retval FALSE                    The LUN reports a zero maximum.
+
+**/
+static
+BOOLEAN
+UfsProbeUnmapLimits(
+	IN  UFS_PEIM_HC_PRIVATE_DATA     *Private,
+	IN  UINTN                        Lun
+)
+{
+	EFI_SCSI_BLOCK_LIMITS_VPD_PAGE      BlockLimits;
+	UINT32                              DataLength;
+	EFI_STATUS                          Status;
+
+	Private->MaxUnmapLbaCount[Lun]    = 0xffffffff;
+	Private->MaxUnmapDescriptors[Lun] = 1;
+
+	ZeroMem (&BlockLimits, sizeof(BlockLimits));
+	DataLength = sizeof(BlockLimits);
+	Status = UfsInquiryVpd(Private, Lun, EFI_SCSI_PAGE_CODE_BLOCK_LIMITS_VPD, &BlockLimits, &DataLength);
+	if (EFI_ERROR(Status) ||
+	    DataLength < offsetof(EFI_SCSI_BLOCK_LIMITS_VPD_PAGE, OptimalUnmapGranularity4) ||
+	    BlockLimits.PageCode != EFI_SCSI_PAGE_CODE_BLOCK_LIMITS_VPD)
+		return TRUE;
+
+	Private->MaxUnmapLbaCount[Lun] =
+		(BlockLimits.MaximumUnmapLbaCount4 << 24) | (BlockLimits.MaximumUnmapLbaCount3 << 16) |
+		(BlockLimits.MaximumUnmapLbaCount2 << 8) | BlockLimits.MaximumUnmapLbaCount1;
+	Private->MaxUnmapDescriptors[Lun] =
+		(BlockLimits.MaximumUnmapBlockDescriptorCount4 << 24) | (BlockLimits.MaximumUnmapBlockDescriptorCount3 << 16) |
+		(BlockLimits.MaximumUnmapBlockDescriptorCount2 << 8) | BlockLimits.MaximumUnmapBlockDescriptorCount1;
+	if (Private->MaxUnmapDescriptors[Lun] > UFS_UNMAP_MAX_DESCRIPTORS)
+		Private->MaxUnmapDescriptors[Lun] = UFS_UNMAP_MAX_DESCRIPTORS;
+
+	DEBUG_UFS((EFI_D_VERBOSE, "Ufs Lun %d unmaps up to 0x%x blocks in %d descriptors\n",
+		   Lun, Private->MaxUnmapLbaCount[Lun], Private->MaxUnmapDescriptors[Lun]));
+
+	return Private->MaxUnmapLbaCount[Lun] != 0 && Private->MaxUnmapDescriptors[Lun] != 0;
+}
+
+/**
+  Find out how a LUN can zero blocks without data transfer: UNMAP when
+  the unmapped blocks read as zeroes, WRITE SAME (16) otherwise.
+
+  @param[in]  Private              A pointer to UFS_PEIM_HC_PRIVATE_DATA data structure.
+  @param[in]  Lun                  The lun to probe.
+
+  @return The UFS_ZEROES_* method of the LUN.
+
+**/
+static
+UINT8
+UfsProbeZeroes(
+	IN  UFS_PEIM_HC_PRIVATE_DATA     *Private,
+	IN  UINTN                        Lun
+)
+{
+	EFI_SCSI_DISK_CAPACITY_DATA16       Capacity16;
+	UINT32                              DataLength;
+	UINT8                               SenseDataLength;
+	EFI_STATUS                          Status;
+
+	ZeroMem (&Capacity16, sizeof(Capacity16));
+	DataLength      = sizeof(Capacity16);
+	SenseDataLength = 0;
+	Status = UfsReadCapacity16(Private, Lun, &Capacity16, &DataLength, NULL, &SenseDataLength);
+	if (!EFI_ERROR(Status) &&
+	    (Capacity16.LowestAlignLogic2 & (EFI_SCSI_LBPME | EFI_SCSI_LBPRZ)) == (EFI_SCSI_LBPME | EFI_SCSI_LBPRZ) &&
+	    UfsProbeUnmapLimits(Private, Lun))
+		return UFS_ZEROES_UNMAP;
+
+	//
+	// The zeroed block is shared by the LUNs: it is sized to the largest
+	// block size.
+	//
+	if (Private->ZeroBlockSize < Private->Media[Lun].BlockSize) {
+		if (Private->ZeroBlock != NULL)
+			free(Private->ZeroBlock);
+		Private->ZeroBlockSize = 0;
+		Private->ZeroBlock = calloc(1, Private->Media[Lun].BlockSize);
+		if (Private->ZeroBlock == NULL)
+			return UFS_ZEROES_UNKNOWN;
+		Private->ZeroBlockSize = Private->Media[Lun].BlockSize;
+	}
+
+	return UFS_ZEROES_WRITE_SAME;
+}
+
+/**
+  This function zeroes blocks of UFS without transferring their data.
+
+  @param[in]  DeviceIndex     Specifies the block device to which the function wants
+                              to talk.
+  @param[in]  StartLBA        The starting logical block address to zero.
+  @param[in]  NumberOfBlocks  The number of blocks to zero.
+
+  @retval EFI_SUCCESS         The operation is done correctly.
+  @retval EFI_UNSUPPORTED     The LUN can not zero blocks without data transfer,
+                              the caller has to write zeroes.
+  @retval Others              The operation fails.
+
+**/
+EFI_STATUS
+EFIAPI
+UfsWriteZeroesBlocks(
+	IN  UINTN                          DeviceIndex,
+	IN  EFI_LBA                        StartLBA,
+	IN  UINTN                          NumberOfBlocks
+	)
+{
+	UFS_PEIM_HC_PRIVATE_DATA           *Private;
+	EFI_STATUS                         Status;
+	UINT64                             Count;
+
+	Private = UfsGetPrivateData();
+	if (Private == NULL)
+		return EFI_NOT_FOUND;
+
+	if (DeviceIndex >= UFS_PEIM_MAX_LUNS)
+		return EFI_INVALID_PARAMETER;
+
+	if ((Private->Luns.BitMask & (BIT0 << DeviceIndex)) == 0)
+		return EFI_ACCESS_DENIED;
+
+	if (NumberOfBlocks == 0)
+		return EFI_SUCCESS;
+
+	if (StartLBA > Private->Media[DeviceIndex].LastBlock ||
+	    NumberOfBlocks - 1 > Private->Media[DeviceIndex].LastBlock - StartLBA)
+		return EFI_INVALID_PARAMETER;
+
+	if (Private->Zeroes[DeviceIndex] == UFS_ZEROES_UNKNOWN)
+		Private->Zeroes[DeviceIndex] = UfsProbeZeroes(Private, DeviceIndex);
+
+	while (NumberOfBlocks > 0) {
+		switch (Private->Zeroes[DeviceIndex]) {
+		case UFS_ZEROES_UNMAP:
+			//
+			// MAXIMUM UNMAP LBA COUNT bounds the blocks of one command,
+			// 0xffffffff meaning no limit but the descriptors count.
+			//
+			Count = (UINT64)0xffffffff * Private->MaxUnmapDescriptors[DeviceIndex];
+			if (Private->MaxUnmapLbaCount[DeviceIndex] != 0xffffffff)
+				Count = Private->MaxUnmapLbaCount[DeviceIndex];
+			if (Count > NumberOfBlocks)
+				Count = NumberOfBlocks;
+			Status = UfsUnmap(Private, DeviceIndex, StartLBA, Count);
+			break;
+		case UFS_ZEROES_WRITE_SAME:
+			Count = (NumberOfBlocks > 0xffffffff) ? 0xffffffff : NumberOfBlocks;
+			Status = UfsWriteSame16(Private, DeviceIndex, StartLBA, (UINT32)Count);
+			//
+			// WRITE SAME is optional for UFS devices: do not try it
+			// again if the device rejects it.
+			//
+			if (EFI_ERROR(Status))
+				Status = EFI_UNSUPPORTED;
+			break;
+		default:
+			return EFI_UNSUPPORTED;
+		}
+
+		if (Status == EFI_UNSUPPORTED)
+			Private->Zeroes[DeviceIndex] = UFS_ZEROES_NONE;
+		if (EFI_ERROR(Status))
+			return Status;
+
+		StartLBA       += Count;
+		NumberOfBlocks -= Count;
+	}
+
+	return EFI_SUCCESS;
+}
+
 /**
   Gets a block device's media information.
 
@@ -1309,33 +1908,143 @@ UfsGetMediaInfo(
 	return EFI_SUCCESS;
 }
 
+//
+// Initialization in progress, from UfsStartInitialize() to the last
+// UfsCompleteInitialize() call.
+//
+static UFS_HC_PEI_PRIVATE_DATA  *mUfsPrivateHcData;
+static UINT8                    mUfsController;
+static UINT64                   mUfsStart;
+static BOOLEAN                  mUfsStarting;
+
 /**
-  The function will initialize UFS device.
+  Start enabling the host controller mUfsController.
 
-  Based on UfsHcPciBase, this function will initialize UFS host controller, allocate
-  necessary resources, and enumarate all the LUNs.
+  @retval EFI_NOT_READY          The host controller is being enabled.
+  @retval EFI_SUCCESS            There is no controller left to initialize.
 
-  @param[in]  UfsHcPciBase       UFS Host Controller's PCI ConfigSpace Base address
-  @param[in]  DevInitPhase       For the performance optimization,
-	Device initialization is separated to several phases.
+**/
+static
+EFI_STATUS
+UfsStartController(
+	VOID
+	)
+{
+	EFI_STATUS                    Status;
+	UFS_PEIM_HC_PRIVATE_DATA      *Private;
+	UINTN                         MmioBase;
 
-  @retval EFI_SUCCESS            The driver is successfully initialized.
+	Private  = gPrivate;
+	MmioBase = 0;
+
+	Status = GetUfsHcMmioBar(mUfsPrivateHcData, mUfsController, &MmioBase);
+	//
+	// When status is error, meant no controller is found
+	//
+	if (EFI_ERROR(Status)) {
+		return EFI_SUCCESS;
+	}
+
+	CopyMem(Private, &gUfsHcTemplate, sizeof(UFS_PEIM_HC_PRIVATE_DATA));
+	Private->UfsHcBase = MmioBase;
+
+	//
+	// Initialize the memory pool which will be used in all transactions.
+	//
+	Status = UfsInitMemPool(Private);
+	if (EFI_ERROR(Status)) {
+		return EFI_SUCCESS;
+	}
+
+	//
+	// Initialize UFS Host Controller H/W: HCE is polled by
+	// UfsCompleteInitialize().
+	//
+	UfsStartHostController(Private);
+	mUfsStart = timer_us(0);
+
+	return EFI_NOT_READY;
+}
+
+/**
+  Initialize the UFS device attached to an initialized host controller and
+  enumerate its LUNs.
+
+  @param[in]  Private            The pointer to the UFS_PEIM_HC_PRIVATE_DATA data structure.
+
+  @retval EFI_SUCCESS            The device is initialized.
   @retval Others                 Can't initialize the UFS device.
 
 **/
+static
 EFI_STATUS
-EFIAPI
-InitializeUfs(
-	IN  pcidev_t pci_dev
+UfsInitDevice(
+	IN  UFS_PEIM_HC_PRIVATE_DATA  *Private
 	)
 {
 	EFI_STATUS                    Status;
-	UFS_PEIM_HC_PRIVATE_DATA      *Private;
 	UINT32                        Index;
 	UFS_CONFIG_DESC               Config;
-	UINTN                         MmioBase;
-	UINT8                         Controller;
-	UFS_HC_PEI_PRIVATE_DATA      *UfsPrivateHcData;
+
+	//
+	// UFS 2.0 spec Section 13.1.3.3:
+	// At the end of the UFS Interconnect Layer initialization on both host and device side,
+	// the host shall send a NOP OUT UPIU to verify that the device UTP Layer is ready.
+	//
+	Status = UfsExecNopCmds(Private);
+	if (EFI_ERROR(Status)) {
+		DEBUG_UFS((EFI_D_VERBOSE, "Ufs Sending NOP IN command Error, Status = %d\n", Status));
+		return Status;
+	}
+
+	//
+	// The host enables the device initialization completion by setting fDeviceInit flag.
+	//
+	Status = UfsSetFlag(Private, UfsFlagDevInit);
+	if (EFI_ERROR(Status)) {
+		DEBUG_UFS((EFI_D_VERBOSE, "Ufs Set fDeviceInit Flag Error, Status = %d\n", Status));
+		return Status;
+	}
+
+	//
+	// Get Ufs Device's Lun Info by reading Configuration Descriptor.
+	//
+	Status = UfsRwDeviceDesc(Private, TRUE, UfsConfigDesc, 0, 0, &Config, sizeof (UFS_CONFIG_DESC));
+	if (EFI_ERROR(Status)) {
+		DEBUG_UFS((EFI_D_VERBOSE, "Ufs Get Configuration Descriptor Error, Status = %d\n", Status));
+		return Status;
+	}
+
+	for (Index = 0; Index < UFS_PEIM_MAX_LUNS; Index++) {
+		if (Config.UnitDescConfParams[Index].LunEn != 0) {
+			Private->Luns.BitMask |= (BIT0 << Index);
+			DEBUG_UFS((EFI_D_VERBOSE, "Ufs %d Lun %d is enabled\n", mUfsController, Index));
+		}
+	}
+
+	return EFI_SUCCESS;
+}
+
+/**
+  Start the initialization of the UFS device.
+
+  Based on UfsHcPciBase, this function allocates the necessary resources and
+  starts enabling the first UFS host controller.  UfsCompleteInitialize()
+  must then be called until it returns something else than EFI_NOT_READY.
+
+  @param[in]  pci_dev            UFS Host Controller's PCI device
+
+  @retval EFI_SUCCESS            The initialization is started.
+  @retval Others                 Can't initialize the UFS device.
+
+**/
+EFI_STATUS
+EFIAPI
+UfsStartInitialize(
+	IN  pcidev_t pci_dev
+	)
+{
+	UFS_PEIM_HC_PRIVATE_DATA      *Private;
 
 	gPrivate = (UFS_PEIM_HC_PRIVATE_DATA *)malloc(sizeof(UFS_PEIM_HC_PRIVATE_DATA));
 	if (gPrivate == NULL) {
@@ -1347,8 +2056,8 @@ InitializeUfs(
 
 	ZeroMem(Private, sizeof(UFS_PEIM_HC_PRIVATE_DATA));
 
-	UfsPrivateHcData = (UFS_HC_PEI_PRIVATE_DATA *)malloc(sizeof (UFS_HC_PEI_PRIVATE_DATA));
-	if (UfsPrivateHcData == NULL) {
+	mUfsPrivateHcData = (UFS_HC_PEI_PRIVATE_DATA *)malloc(sizeof (UFS_HC_PEI_PRIVATE_DATA));
+	if (mUfsPrivateHcData == NULL) {
 		DEBUG_UFS((EFI_D_VERBOSE, "Failed to allocate memory for UFS_HC_PEI_PRIVATE_DATA! \n"));
 		return EFI_OUT_OF_RESOURCES;
 	}
@@ -1356,91 +2065,99 @@ InitializeUfs(
 	//
 	// Init Ufs data
 	//
-	InitializeUfsHcPeim(UfsPrivateHcData, pci_dev);
+	InitializeUfsHcPeim(mUfsPrivateHcData, pci_dev);
 
+	mUfsController = 0;
+	mUfsStarting   = UfsStartController() == EFI_NOT_READY;
 
-	Controller = 0;
-	MmioBase   = 0;
+	return EFI_SUCCESS;
+}
 
-	while (TRUE) {
-		Status = GetUfsHcMmioBar(UfsPrivateHcData, Controller, &MmioBase);
-		//
-		// When status is error, meant no controller is found
-		//
-		if (EFI_ERROR(Status)) {
-			break;
-		}
+/**
+  Go on with the initialization started by UfsStartInitialize(): once the
+  host controller is enabled, bring the link up, initialize the device,
+  enumerate all the LUNs and start enabling the next host controller.
 
-		if (Private == NULL) {
-			Status = EFI_OUT_OF_RESOURCES;
-			break;
-		}
+  @retval EFI_SUCCESS            All the host controllers are handled.
+  @retval EFI_NOT_READY          A host controller is still being enabled.
 
-		CopyMem(Private, &gUfsHcTemplate, sizeof(UFS_PEIM_HC_PRIVATE_DATA));
-		Private->UfsHcBase = MmioBase;
+**/
+EFI_STATUS
+EFIAPI
+UfsCompleteInitialize(
+	VOID
+	)
+{
+	EFI_STATUS                    Status;
+	UFS_PEIM_HC_PRIVATE_DATA      *Private;
 
-		//
-		// Initialize the memory pool which will be used in all transactions.
-		//
-		Status = UfsInitMemPool(Private);
-		if (EFI_ERROR(Status)) {
-			Status = EFI_OUT_OF_RESOURCES;
-			break;
+	if (!mUfsStarting) {
+		return EFI_SUCCESS;
+	}
+
+	Private = gPrivate;
+
+	Status = UfsHostControllerReady(Private);
+	if (Status == EFI_NOT_READY) {
+		if (timer_us(mUfsStart) < DivU64x32(UFS_TIMEOUT, 10, NULL)) {
+			return EFI_NOT_READY;
 		}
+		DEBUG_UFS((EFI_D_VERBOSE, "UfsDevicePei: Enable Host Controller Fails, Status = %d\n", EFI_DEVICE_ERROR));
+		Status = EFI_DEVICE_ERROR;
+	}
 
-		//
-		// Initialize UFS Host Controller H/W.
-		//
-		Status = UfsControllerInit(Private);
+	if (!EFI_ERROR(Status)) {
+		Status = UfsControllerFinish(Private);
 		if (EFI_ERROR(Status)) {
 			DEBUG_UFS((EFI_D_VERBOSE, "UfsDevicePei: Host Controller Initialization Error, Status = %d\n", Status));
-			Controller++;
-			continue;
 		}
+	}
 
-		//
-		// UFS 2.0 spec Section 13.1.3.3:
-		// At the end of the UFS Interconnect Layer initialization on both host and device side,
-		// the host shall send a NOP OUT UPIU to verify that the device UTP Layer is ready.
-		//
-		Status = UfsExecNopCmds(Private);
-		if (EFI_ERROR(Status)) {
-			DEBUG_UFS((EFI_D_VERBOSE, "Ufs Sending NOP IN command Error, Status = %d\n", Status));
-			Controller++;
-			continue;
-		}
+	if (!EFI_ERROR(Status)) {
+		UfsInitDevice(Private);
+	}
 
-		//
-		// The host enables the device initialization completion by setting fDeviceInit flag.
-		//
-		Status = UfsSetFlag(Private, UfsFlagDevInit);
-		if (EFI_ERROR(Status)) {
-			DEBUG_UFS((EFI_D_VERBOSE, "Ufs Set fDeviceInit Flag Error, Status = %d\n", Status));
-			Controller++;
-			continue;
-		}
+	mUfsController++;
+	Status = UfsStartController();
+	if (Status != EFI_NOT_READY) {
+		mUfsStarting = FALSE;
+	}
 
-		//
-		// Get Ufs Device's Lun Info by reading Configuration Descriptor.
-		//
-		Status = UfsRwDeviceDesc(Private, TRUE, UfsConfigDesc, 0, 0, &Config, sizeof (UFS_CONFIG_DESC));
-		if (EFI_ERROR(Status)) {
-			DEBUG_UFS((EFI_D_VERBOSE, "Ufs Get Configuration Descriptor Error, Status = %d\n", Status));
-			Controller++;
-			continue;
-		}
+	return Status;
+}
 
-		for (Index = 0; Index < UFS_PEIM_MAX_LUNS; Index++) {
-			if (Config.UnitDescConfParams[Index].LunEn != 0) {
-				Private->Luns.BitMask |= (BIT0 << Index);
-				DEBUG_UFS((EFI_D_VERBOSE, "Ufs %d Lun %d is enabled\n", Controller, Index));
-			}
-		}
+/**
+  The function will initialize UFS device.
 
-		Controller++;
+  Based on UfsHcPciBase, this function will initialize UFS host controller, allocate
+  necessary resources, and enumarate all the LUNs.
+
+  @param[in]  UfsHcPciBase       UFS Host Controller's PCI ConfigSpace Base address
+  @param[in]  DevInitPhase       For the performance optimization,
+	Device initialization is separated to several phases.
+
+  @retval EFI_SUCCESS            The driver is successfully initialized.
+  @retval Others                 Can't initialize the UFS device.
+
+**/
+EFI_STATUS
+EFIAPI
+InitializeUfs(
+	IN  pcidev_t pci_dev
+	)
+{
+	EFI_STATUS                    Status;
+
+	Status = UfsStartInitialize(pci_dev);
+	if (EFI_ERROR(Status)) {
+		return Status;
 	}
 
-	return EFI_SUCCESS;
+	while ((Status = UfsCompleteInitialize()) == EFI_NOT_READY) {
+		udelay(1);
+	}
+
+	return Status;
 }
 
 UINT8 mUfsTargetId[TARGET_MAX_BYTES];
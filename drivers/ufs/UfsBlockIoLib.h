@@ -91,6 +91,74 @@ UfsWriteBlocks(
 	OUT VOID                           *Buffer
 );
 
+/**
+  This function reads data from UFS into a scatter-gather list of buffers,
+  using single commands for the dword aligned segments.
+
+  @param[in]  DeviceIndex   Specifies the block device to which the function wants
+                            to talk.
+  @param[in]  StartLBA      The starting logical block address to read from.
+  @param[in]  Segs          The destination segments.
+  @param[in]  SegCount      The number of segments.
+
+  @retval EFI_SUCCESS       The operation is done correctly.
+  @retval Others            The operation fails.
+
+**/
+EFI_STATUS
+EFIAPI
+UfsReadBlocksV(
+	IN  UINTN                          DeviceIndex,
+	IN  EFI_LBA                        StartLBA,
+	IN  UFS_SG_ENTRY                   *Segs,
+	IN  UINT32                         SegCount
+);
+
+/**
+  This function writes a scatter-gather list of buffers to UFS, using
+  single commands for the dword aligned segments.
+
+  @param[in]  DeviceIndex   Specifies the block device to which the function wants
+                            to talk.
+  @param[in]  StartLBA      The starting logical block address to write to.
+  @param[in]  Segs          The source segments.
+  @param[in]  SegCount      The number of segments.
+
+  @retval EFI_SUCCESS       The operation is done correctly.
+  @retval Others            The operation fails.
+
+**/
+EFI_STATUS
+EFIAPI
+UfsWriteBlocksV(
+	IN  UINTN                          DeviceIndex,
+	IN  EFI_LBA                        StartLBA,
+	IN  UFS_SG_ENTRY                   *Segs,
+	IN  UINT32                         SegCount
+);
+
+/**
+  This function zeroes blocks of UFS without transferring their data,
+  with UNMAP when the unmapped blocks read as zeroes or WRITE SAME (16).
+
+  @param[in]  DeviceIndex     Specifies the block device to which the function wants
+                              to talk.
+  @param[in]  StartLBA        The starting logical block address to zero.
+  @param[in]  NumberOfBlocks  The number of blocks to zero.
+
+  @retval EFI_SUCCESS         The operation is done correctly.
+  @retval EFI_UNSUPPORTED     The LUN can not zero blocks without data transfer.
+  @retval Others              The operation fails.
+
+**/
+EFI_STATUS
+EFIAPI
+UfsWriteZeroesBlocks(
+	IN  UINTN                          DeviceIndex,
+	IN  EFI_LBA                        StartLBA,
+	IN  UINTN                          NumberOfBlocks
+);
+
 /**
   Gets a block device's media information.
 
@@ -135,6 +203,36 @@ InitializeUfs(
 	IN  pcidev_t pci_dev
 	);
 
+/**
+  Start the initialization of the UFS device without waiting for the host
+  controller to be enabled.  UfsCompleteInitialize() must then be called
+  until it returns something else than EFI_NOT_READY.
+
+  @param[in]  pci_dev            UFS Host Controller's PCI device
+
+  @retval EFI_SUCCESS            The initialization is started.
+  @retval Others                 Can't initialize the UFS device.
+
+**/
+EFI_STATUS
+EFIAPI
+UfsStartInitialize(
+	IN  pcidev_t pci_dev
+	);
+
+/**
+  Go on with the initialization started by UfsStartInitialize().
+
+  @retval EFI_SUCCESS            All the host controllers are handled.
+  @retval EFI_NOT_READY          A host controller is still being enabled.
+
+**/
+EFI_STATUS
+EFIAPI
+UfsCompleteInitialize(
+	VOID
+	);
+
 UFS_PEIM_HC_PRIVATE_DATA *
 UfsGetPrivateData();
 
@@ -477,6 +477,34 @@ UfsInitUtpPrdt(
 	return EFI_SUCCESS;
 }
 
+/**
+  Initialize UTP PRDT for a scatter-gather data transfer.
+
+  @param[in] Prdt         The base address of PRDT.
+  @param[in] Segs         The segments to be read or written.
+  @param[in] SegCount     The number of segments.
+
+  @retval EFI_SUCCESS     The initialization succeed.
+
+**/
+EFI_STATUS
+UfsInitUtpPrdtSg(
+	IN  UTP_TR_PRD                       *Prdt,
+	IN  UFS_SG_ENTRY                     *Segs,
+	IN  UINT32                           SegCount
+	)
+{
+	UINT32     Index;
+
+	for (Index = 0; Index < SegCount; Index++) {
+		UfsInitUtpPrdt(Prdt, Segs[Index].Buffer, Segs[Index].Length);
+		Prdt += DivU64x32((UINT64)Segs[Index].Length + UFS_MAX_DATA_LEN_PER_PRD - 1,
+			UFS_MAX_DATA_LEN_PER_PRD, NULL);
+	}
+
+	return EFI_SUCCESS;
+}
+
 /**
   Initialize QUERY REQUEST UPIU.
 
@@ -559,6 +587,7 @@ UfsCreateScsiCommandDesc(
 	UTP_TR_PRD               *PrdtBase;
 	UFS_DATA_DIRECTION       DataDirection;
 	UINT8                    *Cdb = NULL;
+	UINT32                   Index;
 
 	ASSERT((Private != NULL) && (Packet != NULL) && (Trd != NULL));
 
@@ -576,8 +605,15 @@ UfsCreateScsiCommandDesc(
 		DataDirection = UfsNoData;
 	}
 
-	PrdtNumber = (UINTN)DivU64x32((UINT64)Length + UFS_MAX_DATA_LEN_PER_PRD - 1,
-		UFS_MAX_DATA_LEN_PER_PRD, NULL);
+	if (Packet->DataSegs != NULL) {
+		PrdtNumber = 0;
+		for (Index = 0; Index < Packet->DataSegCount; Index++)
+			PrdtNumber += (UINTN)DivU64x32((UINT64)Packet->DataSegs[Index].Length + UFS_MAX_DATA_LEN_PER_PRD - 1,
+				UFS_MAX_DATA_LEN_PER_PRD, NULL);
+	} else {
+		PrdtNumber = (UINTN)DivU64x32((UINT64)Length + UFS_MAX_DATA_LEN_PER_PRD - 1,
+			UFS_MAX_DATA_LEN_PER_PRD, NULL);
+	}
 
 	TotalLen    = ROUNDUP8(sizeof(UTP_COMMAND_UPIU)) + ROUNDUP8(sizeof(UTP_RESPONSE_UPIU)) + PrdtNumber * sizeof(UTP_TR_PRD);
 	CommandDesc = UfsAllocateMem(Private->Pool, TotalLen);
@@ -605,7 +641,10 @@ UfsCreateScsiCommandDesc(
 		Length = (Length + 3) & (~(BIT0 | BIT1));
 	}
 	UfsInitCommandUpiu(CommandUpiu, Lun, Private->TaskTag++, Packet->Cdb, Packet->CdbLength, DataDirection, Length);
-	UfsInitUtpPrdt(PrdtBase, Buffer, Length);
+	if (Packet->DataSegs != NULL)
+		UfsInitUtpPrdtSg(PrdtBase, Packet->DataSegs, Packet->DataSegCount);
+	else
+		UfsInitUtpPrdt(PrdtBase, Buffer, Length);
 
 	//
 	// Fill UTP_TRD associated fields
@@ -1987,6 +2026,51 @@ UfsEnableHostController (
 	return EFI_SUCCESS;
 }
 
+/**
+  Start enabling the UFS host controller without waiting for it.
+
+  @param[in] Private                 The pointer to the UFS_PEIM_HC_PRIVATE_DATA data structure.
+
+**/
+VOID
+UfsStartHostController (
+	IN  UFS_PEIM_HC_PRIVATE_DATA       *Private
+	)
+{
+	UINTN                  Address;
+
+	Address = Private->UfsHcBase + UFS_HC_ENABLE_OFFSET;
+	if ((read32((void *)Address) & UFS_HC_HCE_EN) == UFS_HC_HCE_EN) {
+		return;
+	}
+
+	write32((void *)Address, UFS_HC_HCE_EN);
+}
+
+/**
+  Check if the UFS host controller enabled by UfsStartHostController() is ready.
+
+  @param[in] Private                 The pointer to the UFS_PEIM_HC_PRIVATE_DATA data structure.
+
+  @retval EFI_SUCCESS                HCE is read as '1'.
+  @retval EFI_NOT_READY              HCE is still read as '0'.
+
+**/
+EFI_STATUS
+UfsHostControllerReady (
+	IN  UFS_PEIM_HC_PRIVATE_DATA       *Private
+	)
+{
+	UINT32                 Data;
+
+	Data = read32((void *)(Private->UfsHcBase + UFS_HC_ENABLE_OFFSET));
+	if ((Data & UFS_HC_HCE_EN) != UFS_HC_HCE_EN) {
+		return EFI_NOT_READY;
+	}
+
+	return EFI_SUCCESS;
+}
+
 /**
   Detect if a UFS device attached.
 
@@ -2196,6 +2280,26 @@ UfsControllerInit(
 		return Status;
 	}
 
+	return UfsControllerFinish(Private);
+}
+
+/**
+  Finish the initialization of an enabled UFS host controller: detect the
+  device and set up the request lists.
+
+  @param[in] Private                 The pointer to the UFS_PEIM_HC_PRIVATE_DATA data structure.
+
+  @retval EFI_SUCCESS                The Ufs Host Controller is initialized successfully.
+  @retval Others                     A device error occurred while initializing the controller.
+
+**/
+EFI_STATUS
+UfsControllerFinish(
+	IN  UFS_PEIM_HC_PRIVATE_DATA       *Private
+	)
+{
+	EFI_STATUS             Status;
+
 	Status = UfsDeviceDetection(Private);
 	if (EFI_ERROR(Status)) {
 		DEBUG_UFS((EFI_D_VERBOSE, "UfsDevicePei: Device Detection Fails, Status = %d\n", Status));
@@ -72,6 +72,19 @@
 #define UFS_SCSI_OP_LENGTH_TEN      0xa
 #define UFS_SCSI_OP_LENGTH_SIXTEEN  0x10
 
+//
+// How a LUN zeroes blocks without data transfer, probed on first use.
+//
+#define UFS_ZEROES_UNKNOWN          0
+#define UFS_ZEROES_UNMAP            1
+#define UFS_ZEROES_WRITE_SAME       2
+#define UFS_ZEROES_NONE             3
+
+//
+// Most block descriptors sent in one UNMAP command.
+//
+#define UFS_UNMAP_MAX_DESCRIPTORS   8
+
 #define EFI_D_VERBOSE "UFS Debug: "
 #define UNUSED_PARAM        __attribute__((__unused__))
 
@@ -125,6 +138,14 @@ typedef struct {
 	EFI_LBA                    LastBlock;
 } EFI_PEI_BLOCK_IO2_MEDIA;
 
+///
+/// Scatter-gather segment of a SCSI request data buffer.
+///
+typedef struct {
+	VOID   *Buffer;
+	UINT32 Length;
+} UFS_SG_ENTRY;
+
 typedef struct {
 	UINT8    Lun[UFS_PEIM_MAX_LUNS];
 	UINT16   BitMask:12;              // Bit 0~7 is for common luns. Bit 8~11 is reserved for those well known luns
@@ -196,6 +217,13 @@ typedef struct {
 	/// output, the number of bytes written to the SenseData buffer.
 	///
 	UINT8  SenseDataLength;
+	///
+	/// Optional scatter-gather list used instead of InDataBuffer or
+	/// OutDataBuffer for the data transfer. Every segment must be dword
+	/// aligned, the transfer length is the sum of their lengths.
+	///
+	UFS_SG_ENTRY *DataSegs;
+	UINT32       DataSegCount;
 } UFS_SCSI_REQUEST_PACKET;
 
 typedef struct _UFS_PEIM_HC_PRIVATE_DATA {
@@ -217,6 +245,11 @@ typedef struct _UFS_PEIM_HC_PRIVATE_DATA {
 	VOID                              *UtpTmrlBase;
 	UINT8                             Nutmrs;
 	UFS_PEIM_EXPOSED_LUNS             Luns;
+	UINT8                             Zeroes[UFS_PEIM_MAX_LUNS];
+	UINT32                            MaxUnmapLbaCount[UFS_PEIM_MAX_LUNS];
+	UINT32                            MaxUnmapDescriptors[UFS_PEIM_MAX_LUNS];
+	VOID                              *ZeroBlock;
+	UINT32                            ZeroBlockSize;
 	VOID                              *FreeUtpTrlBase;
 	VOID                              *FreeUtpTmrlBase;
 } UFS_PEIM_HC_PRIVATE_DATA;
@@ -275,6 +308,46 @@ UfsControllerInit(
 	IN  UFS_PEIM_HC_PRIVATE_DATA       *Private
 	);
 
+/**
+  Start enabling the UFS host controller without waiting for it.
+
+  @param[in] Private                 The pointer to the UFS_PEIM_HC_PRIVATE_DATA data structure.
+
+**/
+VOID
+UfsStartHostController (
+	IN  UFS_PEIM_HC_PRIVATE_DATA       *Private
+	);
+
+/**
+  Check if the UFS host controller enabled by UfsStartHostController() is ready.
+
+  @param[in] Private                 The pointer to the UFS_PEIM_HC_PRIVATE_DATA data structure.
+
+  @retval EFI_SUCCESS                HCE is read as '1'.
+  @retval EFI_NOT_READY              HCE is still read as '0'.
+
+**/
+EFI_STATUS
+UfsHostControllerReady (
+	IN  UFS_PEIM_HC_PRIVATE_DATA       *Private
+	);
+
+/**
+  Finish the initialization of an enabled UFS host controller: detect the
+  device and set up the request lists.
+
+  @param[in] Private                 The pointer to the UFS_PEIM_HC_PRIVATE_DATA data structure.
+
+  @retval EFI_SUCCESS                The Ufs Host Controller is initialized successfully.
+  @retval Others                     A device error occurred while initializing the controller.
+
+**/
+EFI_STATUS
+UfsControllerFinish(
+	IN  UFS_PEIM_HC_PRIVATE_DATA       *Private
+	);
+
 /**
   Stop the UFS host controller.
 
@@ -43,23 +43,8 @@ static struct supported_device {
 static EFI_STATUS _init(storage_t *s)
 {
 	EFI_STATUS ret;
-	pcidev_t pci_dev = 0;
-	size_t i;
 	DEVICE_BLOCK_INFO     BlockInfo;
 
-	for (i = 0; i < ARRAY_SIZE(SUPPORTED_DEVICES); i++)
-		if (pci_find_device(SUPPORTED_DEVICES[i].vid,
-				SUPPORTED_DEVICES[i].did,
-				&pci_dev))
-			break;
-
-	if (!pci_dev)
-		return EFI_UNSUPPORTED;
-
-	ret = InitializeUfs(pci_dev);
-	if (ret)
-		return EFI_DEVICE_ERROR;
-
 	ret = UfsGetMediaInfo(DEVICE_INDEX_DEFAULT, &BlockInfo);
 	if (EFI_ERROR(ret)) {
 		DEBUG_UFS((EFI_D_VERBOSE, "MmcGetMediaInfo Error %d\n", ret));
@@ -113,11 +98,85 @@ static EFI_LBA _write(storage_t *s, EFI_LBA start, EFI_LBA count, const void *bu
 	return transfered;
 }
 
+#define UFS_MAX_SEGS	16
+
+static EFI_LBA _rwv(storage_t *s, EFI_LBA start, EFI_LBA count,
+		    const storage_seg_t *segs, UINTN nb_segs, BOOLEAN write)
+{
+	UFS_SG_ENTRY entries[UFS_MAX_SEGS];
+	EFI_LBA done = 0, seg_count;
+	EFI_STATUS ret;
+	UINTN i, n;
+
+	while (nb_segs) {
+		/* Segments too large for a single command go through the
+		   regular path which splits them. */
+		seg_count = segs[0].len / s->blk_sz;
+		if (seg_count > UFS_BLOCK_MAX) {
+			if (write)
+				n = _write(s, start + done, seg_count, segs[0].buf);
+			else
+				n = _read(s, start + done, seg_count, segs[0].buf);
+			if (n != seg_count)
+				return 0;
+			done += seg_count;
+			segs++;
+			nb_segs--;
+			continue;
+		}
+
+		for (n = 0; n < nb_segs && n < UFS_MAX_SEGS; n++) {
+			if (segs[n].len / s->blk_sz > UFS_BLOCK_MAX)
+				break;
+			entries[n].Buffer = segs[n].buf;
+			entries[n].Length = segs[n].len;
+		}
+
+		if (write)
+			ret = UfsWriteBlocksV(DEVICE_INDEX_DEFAULT, start + done,
+					      entries, n);
+		else
+			ret = UfsReadBlocksV(DEVICE_INDEX_DEFAULT, start + done,
+					     entries, n);
+		if (EFI_ERROR(ret))
+			return 0;
+
+		for (i = 0; i < n; i++)
+			done += segs[i].len / s->blk_sz;
+		segs += n;
+		nb_segs -= n;
+	}
+
+	return done == count ? count : 0;
+}
+
+static EFI_LBA _readv(storage_t *s, EFI_LBA start, EFI_LBA count,
+		      const storage_seg_t *segs, UINTN nb_segs)
+{
+	return _rwv(s, start, count, segs, nb_segs, FALSE);
+}
+
+static EFI_LBA _writev(storage_t *s, EFI_LBA start, EFI_LBA count,
+		       const storage_seg_t *segs, UINTN nb_segs)
+{
+	return _rwv(s, start, count, segs, nb_segs, TRUE);
+}
+
+static EFI_STATUS _write_zeroes(storage_t *s __attribute__((unused)),
+				EFI_LBA start, EFI_LBA count)
+{
+	return UfsWriteZeroesBlocks(DEVICE_INDEX_DEFAULT, start, count);
+}
+
 static storage_t storage_ufs_storage = {
 	.init = _init,
 	.read = _read,
 	.write = _write,
+	.readv = _readv,
+	.writev = _writev,
+	.write_zeroes = _write_zeroes,
 	.erase = NULL,
+	.type = STORAGE_UFS,
 	.pci_function = 0,
 	.pci_device = 0,
 };
@@ -126,11 +185,53 @@ static EFI_HANDLE handle;
 //  static EFI_HANDLE handle_scsi_protocol;
 static EFI_GUID ufs_ps_protocol_guid = EFI_EXT_SCSI_PASS_THRU_PROTOCOL_GUID;
 
+/* Set from storage_ufs_init() to the end of the controller
+   initialization in storage_ufs_poll(). */
+static BOOLEAN ufs_starting;
+
 static EFI_STATUS storage_ufs_init(EFI_SYSTEM_TABLE *st)
 {
 	EFI_STATUS ret;
-	UFS_PEIM_HC_PRIVATE_DATA *Private;
 	boot_dev_t *boot_dev;
+	pcidev_t pci_dev = 0;
+	size_t i;
+
+	if (!st)
+		return EFI_INVALID_PARAMETER;
+
+	boot_dev = get_boot_media();
+	if (!boot_dev)
+		return EFI_INVALID_PARAMETER;
+	if (boot_dev->type != STORAGE_UFS)
+		return EFI_SUCCESS;
+
+	storage_ufs_storage.pci_device = (boot_dev->diskbus >> 8) & 0xff;
+	storage_ufs_storage.pci_function = boot_dev->diskbus & 0xff;
+
+	for (i = 0; i < ARRAY_SIZE(SUPPORTED_DEVICES); i++)
+		if (pci_find_device(SUPPORTED_DEVICES[i].vid,
+				SUPPORTED_DEVICES[i].did,
+				&pci_dev))
+			break;
+
+	if (!pci_dev)
+		return EFI_UNSUPPORTED;
+
+	/* The host controller is only enabled here,
+	   storage_ufs_poll() waits for it while the other drivers
+	   are initialized. */
+	ret = UfsStartInitialize(pci_dev);
+	if (ret)
+		return EFI_DEVICE_ERROR;
+
+	ufs_starting = TRUE;
+	return EFI_SUCCESS;
+}
+
+static EFI_STATUS storage_ufs_poll(EFI_SYSTEM_TABLE *st)
+{
+	EFI_STATUS ret;
+	UFS_PEIM_HC_PRIVATE_DATA *Private;
 	static EFI_EXT_SCSI_PASS_THRU_MODE mode = {
 		0xFFFFFFFF,
 		EFI_EXT_SCSI_PASS_THRU_ATTRIBUTES_PHYSICAL | EFI_EXT_SCSI_PASS_THRU_ATTRIBUTES_LOGICAL,
@@ -148,17 +249,16 @@ static EFI_STATUS storage_ufs_init(EFI_SYSTEM_TABLE *st)
 		};
 	ufs_default.Mode = &mode;
 
-	if (!st)
-		return EFI_INVALID_PARAMETER;
-
-	boot_dev = get_boot_media();
-	if (!boot_dev)
-		return EFI_INVALID_PARAMETER;
-	if (boot_dev->type != STORAGE_UFS)
+	if (!ufs_starting)
 		return EFI_SUCCESS;
 
-	storage_ufs_storage.pci_device = (boot_dev->diskbus >> 8) & 0xff;
-	storage_ufs_storage.pci_function = boot_dev->diskbus & 0xff;
+	ret = UfsCompleteInitialize();
+	if (ret == EFI_NOT_READY)
+		return ret;
+
+	ufs_starting = FALSE;
+	if (ret)
+		return EFI_DEVICE_ERROR;
 
 	ret = storage_init(st, &storage_ufs_storage, &handle);
 	if (EFI_ERROR(ret))
@@ -186,5 +286,9 @@ ewdrv_t ufs_drv = {
 	.name = "storage_ufs",
 	.description = "STORAGE PCI UFS driver",
 	.init = storage_ufs_init,
-	.exit = storage_ufs_exit
+	.poll = storage_ufs_poll,
+	.exit = storage_ufs_exit,
+	.lazy = TRUE,
+	.provides = (const EFI_GUID * const []){ &ufs_ps_protocol_guid, NULL },
+	.storages = EWDRV_STORAGE(STORAGE_UFS)
 };
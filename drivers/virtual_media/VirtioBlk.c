@@ -304,6 +304,7 @@ SynchronousRequest (
 	EFI_STATUS              Status;
 	EFI_STATUS              UnmapStatus;
 	UINT32                  Flags = 0;
+	BOOLEAN                 IsRange;
 
 	BlockSize = Dev->BlockIoMedia.BlockSize;
 
@@ -325,7 +326,10 @@ SynchronousRequest (
 	Request.IoPrio = 0;
 	Request.Sector = MultU64x32(Lba, BlockSize / 512);
 
-	if (RequestType != VIRTIO_BLK_T_DISCARD) {
+	IsRange = (RequestType == VIRTIO_BLK_T_DISCARD ||
+		   RequestType == VIRTIO_BLK_T_WRITE_ZEROES);
+
+	if (!IsRange) {
 		Request.Type   = RequestIsWrite ?
 			(BufferSize == 0 ? VIRTIO_BLK_T_FLUSH : VIRTIO_BLK_T_OUT) :
 			VIRTIO_BLK_T_IN;
@@ -376,7 +380,7 @@ SynchronousRequest (
 	// Map data buffer
 	//
 	if (BufferSize > 0) {
-		if (RequestType == VIRTIO_BLK_T_DISCARD)
+		if (IsRange)
 			Status = VirtioMapAllBytesInSharedBuffer(
 				Dev->VirtIo,
 				VirtioOperationBusMasterRead,
@@ -447,7 +451,7 @@ SynchronousRequest (
 	// data buffer for read/write in second desc
 	//
 	if (BufferSize > 0) {
-		if (RequestType == VIRTIO_BLK_T_DISCARD)
+		if (IsRange)
 			VirtioAppendDesc(
 				&Dev->Ring,
 				EraseRangeDeviceAddress,
@@ -509,7 +513,7 @@ SynchronousRequest (
 
 	UnmapDataBuffer:
 	if (BufferSize > 0) {
-		if (RequestType == VIRTIO_BLK_T_DISCARD)
+		if (IsRange)
 			UnmapStatus = Dev->VirtIo->UnmapSharedBuffer (Dev->VirtIo, EraseRangeMapping);
 		else
 			UnmapStatus = Dev->VirtIo->UnmapSharedBuffer (Dev->VirtIo, BufferMapping);
@@ -763,6 +767,251 @@ VirtioBlkWriteBlocks (
 	return Status;
 }
 
+/**
+
+  Format a read / write request whose data buffer is a scatter-gather list
+  as a chain of virtio descriptors: the request header, one descriptor per
+  data segment and the host status.  The caller ensures that the ring holds
+  at least NbSegs + 2 descriptors.
+
+  @param[in] Dev             The virtio-blk device the request is targeted
+                             at.
+
+  @param[in] Lba             Logical Block Address of the transfer.
+
+  @param[in] Segs            The guest side areas to read data from the
+                             device into, or write data to the device from.
+
+  @param[in] NbSegs          The number of segments.
+
+  @param[in] RequestIsWrite  TRUE iff data transfer goes from guest to
+                             device.
+
+  @retval EFI_SUCCESS        Transfer complete.
+  @retval EFI_DEVICE_ERROR   See SynchronousRequest().
+
+**/
+STATIC
+EFI_STATUS
+SynchronousRequestSg (
+	IN              VBLK_DEV            *Dev,
+	IN              EFI_LBA             Lba,
+	IN              VIRTIO_BLK_SG_ENTRY *Segs,
+	IN              UINTN               NbSegs,
+	IN              BOOLEAN             RequestIsWrite
+	)
+{
+	volatile VIRTIO_BLK_REQ Request;
+	volatile UINT8          *HostStatus;
+	VOID                    *HostStatusBuffer;
+	DESC_INDICES            Indices;
+	VOID                    *RequestMapping;
+	VOID                    *StatusMapping;
+	VOID                    *BufferMapping;
+	EFI_PHYSICAL_ADDRESS    BufferDeviceAddress;
+	EFI_PHYSICAL_ADDRESS    HostStatusDeviceAddress;
+	EFI_PHYSICAL_ADDRESS    RequestDeviceAddress;
+	EFI_STATUS              Status;
+	UINTN                   Index;
+
+	ASSERT (Dev->Ring.QueueSize >= NbSegs + 2);
+
+	Request.IoPrio = 0;
+	Request.Sector = MultU64x32(Lba, Dev->BlockIoMedia.BlockSize / 512);
+	Request.Type   = RequestIsWrite ? VIRTIO_BLK_T_OUT : VIRTIO_BLK_T_IN;
+
+	Status = Dev->VirtIo->AllocateSharedPages (
+		Dev->VirtIo,
+		EFI_SIZE_TO_PAGES (sizeof *HostStatus),
+		&HostStatusBuffer
+		);
+	if (EFI_ERROR (Status)) {
+		return EFI_DEVICE_ERROR;
+	}
+
+	HostStatus = HostStatusBuffer;
+	*HostStatus = VIRTIO_BLK_S_IOERR;
+
+	Status = VirtioMapAllBytesInSharedBuffer (
+		Dev->VirtIo,
+		VirtioOperationBusMasterRead,
+		(VOID *) &Request,
+		sizeof Request,
+		&RequestDeviceAddress,
+		&RequestMapping
+	);
+	if (EFI_ERROR (Status)) {
+		Status = EFI_DEVICE_ERROR;
+		goto FreeHostStatusBuffer;
+	}
+
+	Status = VirtioMapAllBytesInSharedBuffer (
+		Dev->VirtIo,
+		VirtioOperationBusMasterCommonBuffer,
+		HostStatusBuffer,
+		sizeof *HostStatus,
+		&HostStatusDeviceAddress,
+		&StatusMapping
+		);
+	if (EFI_ERROR (Status)) {
+		Status = EFI_DEVICE_ERROR;
+		goto UnmapRequestBuffer;
+	}
+
+	VirtioPrepare (&Dev->Ring, &Indices);
+
+	VirtioAppendDesc (
+		&Dev->Ring,
+		RequestDeviceAddress,
+		sizeof Request,
+		VRING_DESC_F_NEXT,
+		&Indices
+		);
+
+	//
+	// One descriptor per data segment. The shared buffer mappings of
+	// this transport are identities, they need no unmapping.
+	//
+	for (Index = 0; Index < NbSegs; Index++) {
+		Status = VirtioMapAllBytesInSharedBuffer (
+			Dev->VirtIo,
+			(RequestIsWrite ?
+			VirtioOperationBusMasterRead :
+			VirtioOperationBusMasterWrite),
+			Segs[Index].Buffer,
+			Segs[Index].Length,
+			&BufferDeviceAddress,
+			&BufferMapping
+			);
+		if (EFI_ERROR (Status)) {
+			Status = EFI_DEVICE_ERROR;
+			goto UnmapStatusBuffer;
+		}
+
+		VirtioAppendDesc (
+			&Dev->Ring,
+			BufferDeviceAddress,
+			(UINT32) Segs[Index].Length,
+			VRING_DESC_F_NEXT | (RequestIsWrite ? 0 : VRING_DESC_F_WRITE),
+			&Indices
+			);
+	}
+
+	VirtioAppendDesc (
+		&Dev->Ring,
+		HostStatusDeviceAddress,
+		sizeof *HostStatus,
+		VRING_DESC_F_WRITE,
+		&Indices
+		);
+
+	if (VirtioFlush (Dev->VirtIo, 0, &Dev->Ring, &Indices,
+		NULL) == EFI_SUCCESS &&
+		*HostStatus == VIRTIO_BLK_S_OK) {
+		Status = EFI_SUCCESS;
+	} else {
+		Status = EFI_DEVICE_ERROR;
+		DEBUG ((DEBUG_INFO, "%s:VirtioFlush fail !!!!!!!!!!!!\n",
+		__FUNCTION__));
+	}
+
+	UnmapStatusBuffer:
+		Dev->VirtIo->UnmapSharedBuffer (Dev->VirtIo, StatusMapping);
+
+	UnmapRequestBuffer:
+		Dev->VirtIo->UnmapSharedBuffer (Dev->VirtIo, RequestMapping);
+
+	FreeHostStatusBuffer:
+		Dev->VirtIo->FreeSharedPages (
+			Dev->VirtIo,
+			EFI_SIZE_TO_PAGES (sizeof *HostStatus),
+			HostStatusBuffer
+			);
+
+	return Status;
+}
+
+STATIC
+EFI_STATUS
+VirtioBlkRwBlocksV (
+	IN  EFI_BLOCK_IO_PROTOCOL     *This,
+	IN  EFI_LBA                   Lba,
+	IN  VIRTIO_BLK_SG_ENTRY       *Segs,
+	IN  UINTN                     NbSegs,
+	IN  BOOLEAN                   RequestIsWrite
+	)
+{
+	VBLK_DEV   *Dev;
+	EFI_STATUS Status;
+	UINTN      BufferSize;
+	UINTN      Index;
+
+	Dev = VIRTIO_BLK_FROM_BLOCK_IO (This);
+
+	BufferSize = 0;
+	for (Index = 0; Index < NbSegs; Index++) {
+		if (Segs[Index].Length == 0 ||
+		    Segs[Index].Length % Dev->BlockIoMedia.BlockSize != 0) {
+			return EFI_BAD_BUFFER_SIZE;
+		}
+		BufferSize += Segs[Index].Length;
+	}
+
+	if (BufferSize == 0) {
+		return EFI_SUCCESS;
+	}
+
+	if (NbSegs + 2 > Dev->Ring.QueueSize) {
+		for (Index = 0; Index < NbSegs; Index++) {
+			if (RequestIsWrite)
+				Status = VirtioBlkWriteBlocks (This, 0, Lba, Segs[Index].Length, Segs[Index].Buffer);
+			else
+				Status = VirtioBlkReadBlocks (This, 0, Lba, Segs[Index].Length, Segs[Index].Buffer);
+			if (EFI_ERROR (Status)) {
+				return Status;
+			}
+			Lba += Segs[Index].Length / Dev->BlockIoMedia.BlockSize;
+		}
+		return EFI_SUCCESS;
+	}
+
+	Status = VerifyReadWriteRequest (
+		&Dev->BlockIoMedia,
+		Lba,
+		BufferSize,
+		RequestIsWrite
+		);
+	if (EFI_ERROR (Status)) {
+		return Status;
+	}
+
+	return SynchronousRequestSg (Dev, Lba, Segs, NbSegs, RequestIsWrite);
+}
+
+EFI_STATUS
+EFIAPI
+VirtioBlkReadBlocksV (
+	IN  EFI_BLOCK_IO_PROTOCOL     *This,
+	IN  EFI_LBA                   Lba,
+	IN  VIRTIO_BLK_SG_ENTRY       *Segs,
+	IN  UINTN                     NbSegs
+	)
+{
+	return VirtioBlkRwBlocksV (This, Lba, Segs, NbSegs, FALSE);
+}
+
+EFI_STATUS
+EFIAPI
+VirtioBlkWriteBlocksV (
+	IN  EFI_BLOCK_IO_PROTOCOL     *This,
+	IN  EFI_LBA                   Lba,
+	IN  VIRTIO_BLK_SG_ENTRY       *Segs,
+	IN  UINTN                     NbSegs
+	)
+{
+	return VirtioBlkRwBlocksV (This, Lba, Segs, NbSegs, TRUE);
+}
+
 /**
 
   EraseBlocks() operation for virtio-blk.
@@ -807,6 +1056,60 @@ VirtioBlkEraseBlocks (
 	return Status;
 }
 
+/**
+
+  WriteZeroes operation for virtio-blk, the device is allowed to
+  deallocate the zeroed range.
+
+  RequestType that pass to SynchronousRequest() is VIRTIO_BLK_T_WRITE_ZEROES,
+  split so that the sector count of each request fits its 32 bits field.
+
+**/
+
+EFI_STATUS
+EFIAPI
+VirtioBlkWriteZeroes (
+	IN EFI_BLOCK_IO_PROTOCOL            *This,
+	IN EFI_LBA                          Lba,
+	IN UINTN                            Size
+	)
+{
+	EFI_STATUS Status;
+	VBLK_DEV   *Dev;
+	UINT64     Features;
+	UINTN      Chunk;
+
+	Dev = VIRTIO_BLK_FROM_BLOCK_IO (This);
+
+	Status = Dev->VirtIo->GetDeviceFeatures (Dev->VirtIo, &Features);
+	if (EFI_ERROR (Status)) {
+		return Status;
+	}
+
+	if (!(Features & VIRTIO_BLK_F_WRITE_ZEROES))
+		return EFI_UNSUPPORTED;
+
+	while (Size > 0) {
+		Chunk = (Size > SIZE_1GB) ? SIZE_1GB : Size;
+		Status = SynchronousRequest (
+			Dev,
+			Lba,
+			Chunk,
+			NULL,
+			TRUE, // RequestIsWrite
+			VIRTIO_BLK_T_WRITE_ZEROES
+		);
+		if (EFI_ERROR (Status)) {
+			return Status;
+		}
+
+		Lba  += Chunk / Dev->BlockIoMedia.BlockSize;
+		Size -= Chunk;
+	}
+
+	return EFI_SUCCESS;
+}
+
 /**
 
   FlushBlocks() operation for virtio-blk.
@@ -112,6 +112,44 @@ VirtioWriteBlocks (
 	return VirtioBlkWriteBlocks(&gBlkdev->BlockIo, DeviceIndex, StartLBA, DataSize, DataAddress);
 }
 
+/**
+  This function transfers data between VirtioBlk and a scatter-gather list
+  of buffers with a single request.
+
+  @param[in]  DeviceIndex   Specifies the block device to which the function wants
+                            to talk.
+  @param[in]  StartLBA      The starting logical block address.
+  @param[in]  Segs          The data segments, each a multiple of the block size.
+  @param[in]  NbSegs        The number of segments.
+
+  @retval EFI_SUCCESS       The operation is done correctly.
+  @retval Others            The operation fails.
+
+**/
+EFI_STATUS
+EFIAPI
+VirtioReadBlocksV (
+	IN  __attribute__((unused)) UINTN DeviceIndex,
+	IN  EFI_LBA                       StartLBA,
+	IN  VIRTIO_BLK_SG_ENTRY           *Segs,
+	IN  UINTN                         NbSegs
+	)
+{
+	return VirtioBlkReadBlocksV(&gBlkdev->BlockIo, StartLBA, Segs, NbSegs);
+}
+
+EFI_STATUS
+EFIAPI
+VirtioWriteBlocksV (
+	IN  __attribute__((unused)) UINTN DeviceIndex,
+	IN  EFI_LBA                       StartLBA,
+	IN  VIRTIO_BLK_SG_ENTRY           *Segs,
+	IN  UINTN                         NbSegs
+	)
+{
+	return VirtioBlkWriteBlocksV(&gBlkdev->BlockIo, StartLBA, Segs, NbSegs);
+}
+
 /**
   This function erase a specified number of device blocks.
 
@@ -137,6 +175,32 @@ VirtioEraseBlocks (
 	return VirtioBlkEraseBlocks(&gBlkdev->EraseBlock, DeviceIndex, StartLBA, NULL, Size);
 }
 
+/**
+  This function zeroes a specified number of device blocks without
+  transferring any data.
+
+  @param[in]  DeviceIndex   Specifies the block device to which the function wants
+                            to talk.
+  @param[in]  StartLBA      The starting logical block address to be zeroed.
+  @param[in]  Size          The size in bytes to be zeroed, a multiple of the
+                            block size of the device.
+
+  @retval EFI_SUCCESS       The operation is done correctly.
+  @retval EFI_UNSUPPORTED   The device does not support write zeroes.
+  @retval Others            The operation fails.
+
+**/
+EFI_STATUS
+EFIAPI
+VirtioWriteZeroes (
+	IN  __attribute__((unused)) UINTN DeviceIndex,
+	IN EFI_LBA                       StartLBA,
+	IN UINTN                         Size
+	)
+{
+	return VirtioBlkWriteZeroes(&gBlkdev->BlockIo, StartLBA, Size);
+}
+
 
 /**
   This function initializes VirtioBlk device
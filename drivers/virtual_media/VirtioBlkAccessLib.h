@@ -95,6 +95,52 @@ VirtioWriteBlocks (
 	IN  VOID                          *DataAddress
 	);
 
+/**
+  This function reads data from VirtioBlk into a scatter-gather list of
+  buffers with a single request.
+
+  @param[in]  DeviceIndex   Specifies the block device to which the function wants
+                            to talk.
+  @param[in]  StartLBA      The starting logical block address to read from.
+  @param[in]  Segs          The destination segments.
+  @param[in]  NbSegs        The number of segments.
+
+  @retval EFI_SUCCESS       The operation is done correctly.
+  @retval Others            The operation fails.
+
+**/
+EFI_STATUS
+EFIAPI
+VirtioReadBlocksV (
+	IN  UINTN                         DeviceIndex,
+	IN  EFI_LBA                       StartLBA,
+	IN  VIRTIO_BLK_SG_ENTRY           *Segs,
+	IN  UINTN                         NbSegs
+	);
+
+/**
+  This function writes a scatter-gather list of buffers to VirtioBlk with a
+  single request.
+
+  @param[in]  DeviceIndex   Specifies the block device to which the function wants
+                            to talk.
+  @param[in]  StartLBA      The starting logical block address to write to.
+  @param[in]  Segs          The source segments.
+  @param[in]  NbSegs        The number of segments.
+
+  @retval EFI_SUCCESS       The operation is done correctly.
+  @retval Others            The operation fails.
+
+**/
+EFI_STATUS
+EFIAPI
+VirtioWriteBlocksV (
+	IN  UINTN                         DeviceIndex,
+	IN  EFI_LBA                       StartLBA,
+	IN  VIRTIO_BLK_SG_ENTRY           *Segs,
+	IN  UINTN                         NbSegs
+	);
+
 /**
   This function erase a specified number of device blocks.
 
@@ -117,6 +163,29 @@ VirtioEraseBlocks (
 	IN UINTN                         Size
 	);
 
+/**
+  This function zeroes a specified number of device blocks without
+  transferring any data.
+
+  @param[in]  DeviceIndex   Specifies the block device to which the function wants
+                            to talk.
+  @param[in]  StartLBA      The starting logical block address to be zeroed.
+  @param[in]  Size          The size in bytes to be zeroed, a multiple of the
+                            block size of the device.
+
+  @retval EFI_SUCCESS       The operation is done correctly.
+  @retval EFI_UNSUPPORTED   The device does not support write zeroes.
+  @retval Others            The operation fails.
+
+**/
+EFI_STATUS
+EFIAPI
+VirtioWriteZeroes (
+	IN UINTN                         DeviceIndex,
+	IN EFI_LBA                       StartLBA,
+	IN UINTN                         Size
+	);
+
 /**
   This function initializes VirtioBlk device
 
@@ -168,6 +168,31 @@ VirtioBlkWriteBlocks (
 	IN VOID                  *Buffer
 	);
 
+/**
+
+  Vectored read / write operation for virtio-blk: the data segments are
+  chained as consecutive descriptors of a single request when the ring is
+  large enough, and transferred one by one otherwise.
+
+**/
+EFI_STATUS
+EFIAPI
+VirtioBlkReadBlocksV (
+	IN  EFI_BLOCK_IO_PROTOCOL     *This,
+	IN  EFI_LBA                   Lba,
+	IN  VIRTIO_BLK_SG_ENTRY       *Segs,
+	IN  UINTN                     NbSegs
+	);
+
+EFI_STATUS
+EFIAPI
+VirtioBlkWriteBlocksV (
+	IN  EFI_BLOCK_IO_PROTOCOL     *This,
+	IN  EFI_LBA                   Lba,
+	IN  VIRTIO_BLK_SG_ENTRY       *Segs,
+	IN  UINTN                     NbSegs
+	);
+
 /**
 
   EraseBlocks() operation for virtio-blk.
@@ -187,6 +212,23 @@ VirtioBlkEraseBlocks (
 	IN UINTN                     Size
 	);
 
+/**
+
+  WriteZeroes operation for virtio-blk.
+
+  Zero Size bytes from Lba without transferring any data.  Return
+  EFI_UNSUPPORTED if the device does not offer VIRTIO_BLK_F_WRITE_ZEROES.
+
+**/
+
+EFI_STATUS
+EFIAPI
+VirtioBlkWriteZeroes (
+	IN EFI_BLOCK_IO_PROTOCOL     *This,
+	IN EFI_LBA                   Lba,
+	IN UINTN                     Size
+	);
+
 /**
 
   FlushBlocks() operation for virtio-blk.
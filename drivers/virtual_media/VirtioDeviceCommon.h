@@ -198,4 +198,12 @@ typedef struct {
 	UINT32   BlockSize;
 } DEVICE_BLOCK_INFO;
 
+//
+// Scatter-gather segment of a virtio-blk data transfer.
+//
+typedef struct {
+	VOID     *Buffer;
+	UINTN    Length;
+} VIRTIO_BLK_SG_ENTRY;
+
 #endif
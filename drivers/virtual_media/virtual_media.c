@@ -109,6 +109,51 @@ static EFI_LBA _write(storage_t *s, EFI_LBA start, EFI_LBA count, const void *bu
 		return 0;
 }
 
+#define VIRTUAL_MEDIA_MAX_SEGS	16
+
+static EFI_LBA _rwv(storage_t *s, EFI_LBA start, EFI_LBA count,
+		    const storage_seg_t *segs, UINTN nb_segs, BOOLEAN write)
+{
+	VIRTIO_BLK_SG_ENTRY entries[VIRTUAL_MEDIA_MAX_SEGS];
+	EFI_LBA done = 0;
+	EFI_STATUS ret;
+	UINTN i, n;
+
+	for (; nb_segs; nb_segs -= n, segs += n) {
+		n = min(nb_segs, (UINTN)VIRTUAL_MEDIA_MAX_SEGS);
+		for (i = 0; i < n; i++) {
+			entries[i].Buffer = segs[i].buf;
+			entries[i].Length = segs[i].len;
+		}
+
+		if (write)
+			ret = VirtioWriteBlocksV(DEVICE_INDEX_DEFAULT,
+						 start + done, entries, n);
+		else
+			ret = VirtioReadBlocksV(DEVICE_INDEX_DEFAULT,
+						start + done, entries, n);
+		if (EFI_ERROR(ret))
+			return 0;
+
+		for (i = 0; i < n; i++)
+			done += segs[i].len / s->blk_sz;
+	}
+
+	return done == count ? count : 0;
+}
+
+static EFI_LBA _readv(storage_t *s, EFI_LBA start, EFI_LBA count,
+		      const storage_seg_t *segs, UINTN nb_segs)
+{
+	return _rwv(s, start, count, segs, nb_segs, FALSE);
+}
+
+static EFI_LBA _writev(storage_t *s, EFI_LBA start, EFI_LBA count,
+		       const storage_seg_t *segs, UINTN nb_segs)
+{
+	return _rwv(s, start, count, segs, nb_segs, TRUE);
+}
+
 static EFI_STATUS _erase(storage_t *s, EFI_LBA start, UINTN Size)
 {
 	EFI_STATUS ret;
@@ -123,11 +168,21 @@ static EFI_STATUS _erase(storage_t *s, EFI_LBA start, UINTN Size)
 	return ret;
 }
 
+static EFI_STATUS _write_zeroes(storage_t *s, EFI_LBA start, EFI_LBA count)
+{
+	return VirtioWriteZeroes(DEVICE_INDEX_DEFAULT, start,
+				 count * s->blk_sz);
+}
+
 static storage_t storage_virtual_media = {
 	.init = _init,
 	.read = _read,
 	.write = _write,
+	.readv = _readv,
+	.writev = _writev,
+	.write_zeroes = _write_zeroes,
 	.erase = _erase,
+	.type = STORAGE_VIRTUAL,
 	.pci_function = 0,
 	.pci_device = 0,
 };
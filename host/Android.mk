@@ -5,20 +5,33 @@ LOCAL_MODULE := efiwrapper_host-$(TARGET_BUILD_VARIANT)
 LOCAL_MODULE_STEM := efiwrapper_host
 LOCAL_CFLAGS := $(EFIWRAPPER_HOST_CFLAGS)
 LOCAL_STATIC_LIBRARIES := \
-	libefiwrapper_host-$(TARGET_BUILD_VARIANT)
+	libefiwrapper_host-$(TARGET_BUILD_VARIANT) \
+	libz
 LOCAL_SRC_FILES := \
 	main.c \
 	event.c \
 	disk.c \
+	aio.c \
+	overlay.c \
+	backing.c \
+	composite.c \
+	timing.c \
+	trace.c \
 	fifo.c \
 	worker.c \
+	drvrunner.c \
+	boottime.c \
+	fpdt.c \
+	fdutil.c \
+	iostats.c \
 	tcp4.c \
 	fileio.c \
 	gop.c \
 	image.c \
 	pe.c \
 	host_time.c \
-	terminal_conin.c
+	terminal_conin.c \
+	serial.c
 LOCAL_LDFLAGS := -ldl 
 LOCAL_MODULE_HOST_ARCH := $(EFIWRAPPER_HOST_ARCH)
 LOCAL_C_INCLUDES := $(EFIWRAPPER_HOST_C_INCLUDES)
@@ -0,0 +1,677 @@
+/*
+ * Copyright (c) 2026, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define _GNU_SOURCE
+#define _LARGEFILE64_SOURCE
+#include <ewlib.h>
+#include <ewlog.h>
+#include <errno.h>
+#include <linux/io_uring.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "aio.h"
+
+/* io_uring request slot.  The slot index is the SQE user data and,
+   with fixed buffers, the index of the registered buffer. */
+typedef struct aio_slot {
+	storage_req_t *req;
+	struct iovec iov;
+	off64_t off;
+	size_t len;
+	size_t done;
+	int fd;
+	bool fixed;
+} aio_slot_t;
+
+typedef struct uring {
+	int fd;
+	void *sq_ptr;
+	size_t sq_size;
+	void *cq_ptr;
+	size_t cq_size;
+	unsigned *sq_tail;
+	unsigned *sq_mask;
+	unsigned *sq_array;
+	unsigned *cq_head;
+	unsigned *cq_tail;
+	unsigned *cq_mask;
+	struct io_uring_sqe *sqes;
+	size_t sqes_size;
+	struct io_uring_cqe *cqes;
+	/* Queued SQEs not yet consumed by the kernel */
+	unsigned to_submit;
+	aio_slot_t *slots;
+	unsigned *free_slots;
+	unsigned nb_free;
+	unsigned char *fixed_bufs;
+} uring_t;
+
+typedef struct pool {
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	storage_req_t *todo;
+	storage_req_t **todo_tail;
+	storage_req_t *done;
+	bool stop;
+	pthread_t threads[AIO_MAX_THREADS];
+	unsigned nb_threads;
+} pool_t;
+
+struct aio {
+	aio_engine_t engine;
+	int fd;
+	int direct_fd;
+	UINT32 blk_sz;
+	unsigned depth;
+	/* Requests waiting for a free io_uring slot */
+	storage_req_t *pending;
+	storage_req_t **pending_tail;
+	/* Set by aio_free() */
+	bool stopped;
+	uring_t ring;
+	pool_t pool;
+};
+
+static bool direct_aligned(aio_t *aio, off64_t off, size_t len,
+			   const void *buf)
+{
+	return aio->direct_fd != -1 && !(off % AIO_DIRECT_ALIGN) &&
+		!(len % AIO_DIRECT_ALIGN) &&
+		!((uintptr_t)buf % AIO_DIRECT_ALIGN);
+}
+
+/*
+ * io_uring engine, driven with raw system calls to avoid a liburing
+ * dependency.
+ */
+
+static int uring_enter(int fd, unsigned to_submit, unsigned min_complete,
+		       unsigned flags)
+{
+	return syscall(__NR_io_uring_enter, fd, to_submit, min_complete,
+		       flags, NULL, 0);
+}
+
+static void uring_unmap(uring_t *ring)
+{
+	if (ring->sqes)
+		munmap(ring->sqes, ring->sqes_size);
+	if (ring->cq_ptr && ring->cq_ptr != ring->sq_ptr)
+		munmap(ring->cq_ptr, ring->cq_size);
+	if (ring->sq_ptr)
+		munmap(ring->sq_ptr, ring->sq_size);
+	close(ring->fd);
+}
+
+static EFI_STATUS uring_init(aio_t *aio, bool fixed_buffers)
+{
+	uring_t *ring = &aio->ring;
+	struct io_uring_params p;
+	struct iovec *iovs;
+	unsigned char *cq;
+	unsigned i;
+	int ret;
+
+	memset(&p, 0, sizeof(p));
+	ring->fd = syscall(__NR_io_uring_setup, aio->depth, &p);
+	if (ring->fd == -1) {
+		ewdbg("io_uring is not available, %s", strerror(errno));
+		return EFI_UNSUPPORTED;
+	}
+
+	ring->sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+	ring->cq_size = p.cq_off.cqes +
+		p.cq_entries * sizeof(struct io_uring_cqe);
+	if (p.features & IORING_FEAT_SINGLE_MMAP)
+		ring->sq_size = ring->cq_size = max(ring->sq_size,
+						    ring->cq_size);
+
+	ring->sq_ptr = mmap(NULL, ring->sq_size, PROT_READ | PROT_WRITE,
+			    MAP_SHARED | MAP_POPULATE, ring->fd,
+			    IORING_OFF_SQ_RING);
+	if (ring->sq_ptr == MAP_FAILED) {
+		ring->sq_ptr = NULL;
+		goto err;
+	}
+
+	if (p.features & IORING_FEAT_SINGLE_MMAP)
+		ring->cq_ptr = ring->sq_ptr;
+	else {
+		ring->cq_ptr = mmap(NULL, ring->cq_size,
+				    PROT_READ | PROT_WRITE,
+				    MAP_SHARED | MAP_POPULATE, ring->fd,
+				    IORING_OFF_CQ_RING);
+		if (ring->cq_ptr == MAP_FAILED) {
+			ring->cq_ptr = NULL;
+			goto err;
+		}
+	}
+
+	ring->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+	ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE,
+			  MAP_SHARED | MAP_POPULATE, ring->fd,
+			  IORING_OFF_SQES);
+	if (ring->sqes == MAP_FAILED) {
+		ring->sqes = NULL;
+		goto err;
+	}
+
+	ring->sq_tail = (unsigned *)((char *)ring->sq_ptr + p.sq_off.tail);
+	ring->sq_mask = (unsigned *)((char *)ring->sq_ptr +
+				     p.sq_off.ring_mask);
+	ring->sq_array = (unsigned *)((char *)ring->sq_ptr + p.sq_off.array);
+	cq = ring->cq_ptr;
+	ring->cq_head = (unsigned *)(cq + p.cq_off.head);
+	ring->cq_tail = (unsigned *)(cq + p.cq_off.tail);
+	ring->cq_mask = (unsigned *)(cq + p.cq_off.ring_mask);
+	ring->cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+
+	ring->slots = calloc(aio->depth, sizeof(*ring->slots));
+	ring->free_slots = calloc(aio->depth, sizeof(*ring->free_slots));
+	if (!ring->slots || !ring->free_slots)
+		goto err;
+
+	for (i = 0; i < aio->depth; i++)
+		ring->free_slots[i] = aio->depth - 1 - i;
+	ring->nb_free = aio->depth;
+
+	if (!fixed_buffers)
+		return EFI_SUCCESS;
+
+	/* One registered buffer per slot.  Registration fails if the
+	   buffers exceed RLIMIT_MEMLOCK on kernels which account them
+	   there, the requests then use the caller buffers. */
+	iovs = calloc(aio->depth, sizeof(*iovs));
+	if (!iovs ||
+	    posix_memalign((void **)&ring->fixed_bufs, AIO_DIRECT_ALIGN,
+			   (size_t)aio->depth * AIO_FIXED_BUF_SIZE)) {
+		free(iovs);
+		ring->fixed_bufs = NULL;
+		goto err;
+	}
+
+	for (i = 0; i < aio->depth; i++) {
+		iovs[i].iov_base = ring->fixed_bufs +
+			(size_t)i * AIO_FIXED_BUF_SIZE;
+		iovs[i].iov_len = AIO_FIXED_BUF_SIZE;
+	}
+
+	ret = syscall(__NR_io_uring_register, ring->fd,
+		      IORING_REGISTER_BUFFERS, iovs, aio->depth);
+	free(iovs);
+	if (ret == -1) {
+		ewerr("Failed to register io_uring fixed buffers, %s",
+		      strerror(errno));
+		free(ring->fixed_bufs);
+		ring->fixed_bufs = NULL;
+	}
+
+	return EFI_SUCCESS;
+
+err:
+	free(ring->slots);
+	free(ring->free_slots);
+	uring_unmap(ring);
+	return EFI_OUT_OF_RESOURCES;
+}
+
+/* Queue the SQE transferring the remaining bytes of slot I. */
+static void uring_prepare(aio_t *aio, unsigned i)
+{
+	uring_t *ring = &aio->ring;
+	aio_slot_t *slot = &ring->slots[i];
+	bool read = slot->req->op == STORAGE_OP_READ;
+	unsigned tail = *ring->sq_tail, idx = tail & *ring->sq_mask;
+	struct io_uring_sqe *sqe = &ring->sqes[idx];
+
+	memset(sqe, 0, sizeof(*sqe));
+	sqe->fd = slot->fd;
+	sqe->off = slot->off + slot->done;
+	sqe->user_data = i;
+	if (slot->fixed) {
+		sqe->opcode = read ? IORING_OP_READ_FIXED :
+			IORING_OP_WRITE_FIXED;
+		sqe->addr = (uintptr_t)(ring->fixed_bufs +
+					(size_t)i * AIO_FIXED_BUF_SIZE +
+					slot->done);
+		sqe->len = slot->len - slot->done;
+		sqe->buf_index = i;
+	} else {
+		sqe->opcode = read ? IORING_OP_READV : IORING_OP_WRITEV;
+		slot->iov.iov_base = (char *)slot->req->buf + slot->done;
+		slot->iov.iov_len = slot->len - slot->done;
+		sqe->addr = (uintptr_t)&slot->iov;
+		sqe->len = 1;
+	}
+
+	ring->sq_array[idx] = idx;
+	__atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+	ring->to_submit++;
+}
+
+static void uring_start(aio_t *aio, storage_req_t *req)
+{
+	uring_t *ring = &aio->ring;
+	unsigned i = ring->free_slots[--ring->nb_free];
+	aio_slot_t *slot = &ring->slots[i];
+
+	slot->req = req;
+	slot->off = (off64_t)req->lba * aio->blk_sz;
+	slot->len = req->count * aio->blk_sz;
+	slot->done = 0;
+	slot->fixed = ring->fixed_bufs && slot->len <= AIO_FIXED_BUF_SIZE;
+	slot->fd = direct_aligned(aio, slot->off, slot->len,
+				  slot->fixed ? ring->fixed_bufs : req->buf) ?
+		aio->direct_fd : aio->fd;
+
+	if (slot->fixed && req->op == STORAGE_OP_WRITE)
+		memcpy(ring->fixed_bufs + (size_t)i * AIO_FIXED_BUF_SIZE,
+		       req->buf, slot->len);
+
+	uring_prepare(aio, i);
+}
+
+/* Hand the queued SQEs to the kernel.  The ones it could not take,
+   on a transient error, are retried by the next aio_poll(). */
+static void uring_flush(aio_t *aio)
+{
+	uring_t *ring = &aio->ring;
+	int ret;
+
+	while (ring->to_submit) {
+		ret = uring_enter(ring->fd, ring->to_submit, 0, 0);
+		if (ret > 0) {
+			ring->to_submit -= ret;
+			continue;
+		}
+		if (ret == -1 && errno == EINTR)
+			continue;
+		if (ret == -1 && errno != EAGAIN && errno != EBUSY)
+			ewerr("Failed to submit io_uring requests, %s",
+			      strerror(errno));
+		break;
+	}
+}
+
+/* Reap the CQEs and return the list of the finished requests. */
+static storage_req_t *uring_reap(aio_t *aio)
+{
+	uring_t *ring = &aio->ring;
+	unsigned head = *ring->cq_head;
+	storage_req_t *done = NULL, *req;
+	struct io_uring_cqe *cqe;
+	aio_slot_t *slot;
+	unsigned i;
+
+	while (head != __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE)) {
+		cqe = &ring->cqes[head++ & *ring->cq_mask];
+		i = cqe->user_data;
+		slot = &ring->slots[i];
+		req = slot->req;
+
+		if (cqe->res > 0) {
+			slot->done += cqe->res;
+			/* Short transfer, issue the remaining bytes */
+			if (slot->done < slot->len) {
+				uring_prepare(aio, i);
+				continue;
+			}
+			req->status = EFI_SUCCESS;
+			if (slot->fixed && req->op == STORAGE_OP_READ)
+				memcpy(req->buf, ring->fixed_bufs +
+				       (size_t)i * AIO_FIXED_BUF_SIZE,
+				       slot->len);
+		} else {
+			ewerr("Disk %s failed at offset %lld, %s",
+			      req->op == STORAGE_OP_READ ? "read" : "write",
+			      (long long)(slot->off + slot->done),
+			      cqe->res ? strerror(-cqe->res) :
+			      "unexpected end of file");
+			req->status = EFI_DEVICE_ERROR;
+		}
+
+		ring->free_slots[ring->nb_free++] = i;
+		req->next = done;
+		done = req;
+	}
+	__atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+
+	return done;
+}
+
+static void uring_start_pending(aio_t *aio)
+{
+	storage_req_t *req;
+
+	while (aio->pending && aio->ring.nb_free) {
+		req = aio->pending;
+		aio->pending = req->next;
+		if (!aio->pending)
+			aio->pending_tail = &aio->pending;
+		uring_start(aio, req);
+	}
+}
+
+/* Prepend the LIST of requests to DONE and return the new list. */
+static storage_req_t *join(storage_req_t *list, storage_req_t *done)
+{
+	storage_req_t **tail = &list;
+
+	while (*tail)
+		tail = &(*tail)->next;
+	*tail = done;
+
+	return list;
+}
+
+/* Wait for the requests in flight and release the ring.  Return the
+   list of the requests to complete: the finished ones with their
+   status, the others with EFI_ABORTED. */
+static storage_req_t *uring_free(aio_t *aio)
+{
+	uring_t *ring = &aio->ring;
+	storage_req_t *done = NULL, *req;
+	unsigned i;
+
+	uring_flush(aio);
+	while (ring->nb_free + ring->to_submit < aio->depth) {
+		if (uring_enter(ring->fd, 0, 1, IORING_ENTER_GETEVENTS) == -1 &&
+		    errno != EINTR)
+			break;
+		/* Short transfers are not resumed anymore. */
+		ring->to_submit = 0;
+		done = join(uring_reap(aio), done);
+	}
+
+	/* The requests still holding a slot were not submitted or
+	   their short transfer is not resumed. */
+	for (i = 0; i < ring->nb_free; i++)
+		ring->slots[ring->free_slots[i]].req = NULL;
+	for (i = 0; i < aio->depth; i++) {
+		req = ring->slots[i].req;
+		if (!req)
+			continue;
+		req->status = EFI_ABORTED;
+		req->next = done;
+		done = req;
+	}
+
+	free(ring->fixed_bufs);
+	free(ring->slots);
+	free(ring->free_slots);
+	uring_unmap(ring);
+
+	return done;
+}
+
+/*
+ * Thread pool engine
+ */
+
+static EFI_STATUS transfer(aio_t *aio, storage_req_t *req)
+{
+	off64_t off = (off64_t)req->lba * aio->blk_sz;
+	size_t len = req->count * aio->blk_sz, done;
+	int fd = direct_aligned(aio, off, len, req->buf) ?
+		aio->direct_fd : aio->fd;
+	char *buf = req->buf;
+	ssize_t ret;
+
+	for (done = 0; done < len; done += ret) {
+		if (req->op == STORAGE_OP_READ)
+			ret = pread64(fd, buf + done, len - done, off + done);
+		else
+			ret = pwrite64(fd, buf + done, len - done, off + done);
+
+		if (ret > 0)
+			continue;
+
+		if (ret == -1 && errno == EINTR) {
+			ret = 0;
+			continue;
+		}
+
+		ewerr("Disk %s failed at offset %lld, %s",
+		      req->op == STORAGE_OP_READ ? "read" : "write",
+		      (long long)(off + done),
+		      ret ? strerror(errno) : "unexpected end of file");
+		return EFI_DEVICE_ERROR;
+	}
+
+	return EFI_SUCCESS;
+}
+
+static void *pool_thread(void *arg)
+{
+	aio_t *aio = arg;
+	pool_t *pool = &aio->pool;
+	storage_req_t *req;
+
+	pthread_mutex_lock(&pool->lock);
+	for (;;) {
+		while (!pool->todo && !pool->stop)
+			pthread_cond_wait(&pool->cond, &pool->lock);
+
+		req = pool->todo;
+		if (!req)
+			break;
+
+		pool->todo = req->next;
+		if (!pool->todo)
+			pool->todo_tail = &pool->todo;
+		pthread_mutex_unlock(&pool->lock);
+
+		req->status = transfer(aio, req);
+
+		pthread_mutex_lock(&pool->lock);
+		req->next = pool->done;
+		pool->done = req;
+	}
+	pthread_mutex_unlock(&pool->lock);
+
+	return NULL;
+}
+
+static void pool_stop(aio_t *aio)
+{
+	pool_t *pool = &aio->pool;
+	unsigned i;
+
+	pthread_mutex_lock(&pool->lock);
+	pool->stop = true;
+	pthread_cond_broadcast(&pool->cond);
+	pthread_mutex_unlock(&pool->lock);
+
+	for (i = 0; i < pool->nb_threads; i++)
+		pthread_join(pool->threads[i], NULL);
+
+	pthread_cond_destroy(&pool->cond);
+	pthread_mutex_destroy(&pool->lock);
+}
+
+static EFI_STATUS pool_init(aio_t *aio)
+{
+	pool_t *pool = &aio->pool;
+	unsigned n = min(aio->depth, AIO_MAX_THREADS);
+
+	if (pthread_mutex_init(&pool->lock, NULL))
+		return EFI_DEVICE_ERROR;
+
+	if (pthread_cond_init(&pool->cond, NULL)) {
+		pthread_mutex_destroy(&pool->lock);
+		return EFI_DEVICE_ERROR;
+	}
+
+	pool->todo_tail = &pool->todo;
+	for (; pool->nb_threads < n; pool->nb_threads++)
+		if (pthread_create(&pool->threads[pool->nb_threads], NULL,
+				   pool_thread, aio))
+			break;
+
+	if (!pool->nb_threads) {
+		pool_stop(aio);
+		return EFI_DEVICE_ERROR;
+	}
+
+	return EFI_SUCCESS;
+}
+
+/*
+ * Engine independent interface
+ */
+
+aio_t *aio_new(int fd, UINT32 blk_sz, aio_engine_t engine,
+	       const aio_config_t *config)
+{
+	EFI_STATUS ret = EFI_UNSUPPORTED;
+	aio_t *aio;
+
+	aio = calloc(1, sizeof(*aio));
+	if (!aio)
+		return NULL;
+
+	aio->fd = fd;
+	aio->direct_fd = config->direct_fd;
+	aio->blk_sz = blk_sz;
+	aio->depth = max(config->depth, 1U);
+	aio->pending_tail = &aio->pending;
+
+	if (engine == AIO_URING) {
+		ret = uring_init(aio, config->fixed_buffers);
+		if (!EFI_ERROR(ret))
+			aio->engine = AIO_URING;
+	}
+
+	if (EFI_ERROR(ret)) {
+		ret = pool_init(aio);
+		aio->engine = AIO_THREADS;
+	}
+
+	if (EFI_ERROR(ret)) {
+		free(aio);
+		return NULL;
+	}
+
+	return aio;
+}
+
+const char *aio_engine_name(aio_t *aio)
+{
+	return aio->engine == AIO_URING ? "io_uring" : "threads";
+}
+
+EFI_STATUS aio_submit(aio_t *aio, storage_req_t *req)
+{
+	pool_t *pool = &aio->pool;
+
+	if (!req->count)
+		return EFI_INVALID_PARAMETER;
+
+	if (aio->stopped)
+		return EFI_ABORTED;
+
+	req->next = NULL;
+	if (aio->engine == AIO_THREADS) {
+		pthread_mutex_lock(&pool->lock);
+		*pool->todo_tail = req;
+		pool->todo_tail = &req->next;
+		pthread_cond_signal(&pool->cond);
+		pthread_mutex_unlock(&pool->lock);
+		return EFI_SUCCESS;
+	}
+
+	if (!aio->ring.nb_free) {
+		*aio->pending_tail = req;
+		aio->pending_tail = &req->next;
+		return EFI_SUCCESS;
+	}
+
+	uring_start(aio, req);
+	uring_flush(aio);
+
+	return EFI_SUCCESS;
+}
+
+void aio_poll(aio_t *aio)
+{
+	storage_req_t *done, *next;
+
+	if (aio->engine == AIO_THREADS) {
+		pthread_mutex_lock(&aio->pool.lock);
+		done = aio->pool.done;
+		aio->pool.done = NULL;
+		pthread_mutex_unlock(&aio->pool.lock);
+	} else {
+		done = uring_reap(aio);
+		uring_start_pending(aio);
+		uring_flush(aio);
+	}
+
+	/* COMPLETE may submit REQ again */
+	for (; done; done = next) {
+		next = done->next;
+		done->complete(done);
+	}
+}
+
+void aio_free(aio_t *aio)
+{
+	storage_req_t *done, *next;
+
+	if (aio->engine == AIO_URING) {
+		done = uring_free(aio);
+		for (; aio->pending; aio->pending = next) {
+			next = aio->pending->next;
+			aio->pending->status = EFI_ABORTED;
+			aio->pending->next = done;
+			done = aio->pending;
+		}
+	} else {
+		/* The threads serve the queued requests before
+		   exiting. */
+		pool_stop(aio);
+		done = aio->pool.done;
+	}
+
+	/* No request can be submitted again from COMPLETE. */
+	aio->stopped = true;
+	for (; done; done = next) {
+		next = done->next;
+		done->complete(done);
+	}
+
+	free(aio);
+}
@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2026, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _AIO_H_
+#define _AIO_H_
+
+#include <stdbool.h>
+#include <efi.h>
+#include <efiapi.h>
+#include <storage.h>
+
+/* Asynchronous file I/O engine serving the storage_req_t requests of
+   a disk file.  io_uring is used when the kernel provides it,
+   otherwise a pool of threads issues pread()/pwrite() calls. */
+typedef struct aio aio_t;
+
+typedef enum aio_engine {
+	AIO_URING,
+	AIO_THREADS
+} aio_engine_t;
+
+typedef struct aio_config {
+	/* Largest number of requests in flight */
+	unsigned int depth;
+	/* Optional file descriptor opened with O_DIRECT, used for the
+	   requests whose buffer, offset and size are aligned on
+	   AIO_DIRECT_ALIGN.  -1 if unused. */
+	int direct_fd;
+	/* io_uring only: transfer the requests of up to
+	   AIO_FIXED_BUF_SIZE bytes through pre-registered buffers */
+	bool fixed_buffers;
+} aio_config_t;
+
+#define AIO_DIRECT_ALIGN	4096
+#define AIO_FIXED_BUF_SIZE	(256 * 1024)
+#define AIO_MAX_THREADS		16
+
+/* Create an engine for FD, a file of BLK_SZ bytes blocks.  ENGINE is
+   the preferred engine, AIO_URING falls back to AIO_THREADS. */
+aio_t *aio_new(int fd, UINT32 blk_sz, aio_engine_t engine,
+	       const aio_config_t *config);
+EFI_STATUS aio_submit(aio_t *aio, storage_req_t *req);
+/* Complete the finished requests, never blocks. */
+void aio_poll(aio_t *aio);
+/* Wait for the requests in flight and free AIO.  Every submitted
+   request is completed: the finished ones with their status, the
+   others with EFI_ABORTED. */
+void aio_free(aio_t *aio);
+const char *aio_engine_name(aio_t *aio);
+
+#endif	/* _AIO_H_ */
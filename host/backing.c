@@ -0,0 +1,529 @@
+/*
+ * Copyright (c) 2026, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define _GNU_SOURCE
+#define _LARGEFILE64_SOURCE
+#include <ewlib.h>
+#include <ewlog.h>
+#include <sparse_format.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include "backing.h"
+#include "fdutil.h"
+
+/* Chunked compressed image layout: the header, CHUNK_CNT + 1 chunk
+   offsets and the chunks data.  Chunk I is stored between offsets I
+   and I + 1: nothing for a zero chunk, the chunk itself if it does
+   not compress and a zlib stream otherwise. */
+#define COMPRESSED_MAGIC	"EWZCHNK1"
+
+typedef struct compressed_header {
+	char magic[8];
+	uint32_t chunk_sz;
+	uint32_t reserved;
+	uint64_t size;
+	uint64_t chunk_cnt;
+} compressed_header_t;
+
+/* Sparse image extent, DATA is the file offset of a RAW extent or
+   the fill value of a FILL extent */
+typedef struct extent {
+	uint64_t start;
+	uint64_t len;
+	uint16_t type;
+	uint64_t data;
+} extent_t;
+
+typedef struct cached_chunk {
+	uint64_t chunk;
+	uint64_t stamp;
+	unsigned char *data;
+} cached_chunk_t;
+
+struct backing {
+	backing_format_t format;
+	int fd;
+	uint64_t size;
+	/* BACKING_SPARSE */
+	extent_t *extents;
+	size_t nb_extents;
+	/* BACKING_COMPRESSED */
+	uint32_t chunk_sz;
+	uint64_t chunk_cnt;
+	uint64_t *offsets;
+	unsigned char *zbuf;
+	cached_chunk_t cache[BACKING_CACHE_CHUNKS];
+	uint64_t clock;
+};
+
+static const char *FORMAT_NAMES[] = {
+	[BACKING_RAW] = "raw",
+	[BACKING_SPARSE] = "Android sparse",
+	[BACKING_COMPRESSED] = "chunked compressed"
+};
+
+static EFI_STATUS open_sparse(backing_t *b, uint64_t file_size)
+{
+	sparse_header_t hdr;
+	chunk_header_t chdr;
+	uint64_t off, start = 0, data_sz;
+	uint32_t fill, i;
+	EFI_STATUS ret;
+	extent_t *ext;
+
+	ret = fd_pread_full(b->fd, &hdr, sizeof(hdr), 0, "disk image");
+	if (EFI_ERROR(ret))
+		return ret;
+
+	if (hdr.major_version != SPARSE_MAJOR_VERSION ||
+	    hdr.file_hdr_sz < sizeof(hdr) ||
+	    hdr.chunk_hdr_sz < sizeof(chdr) ||
+	    !hdr.blk_sz || hdr.blk_sz % 4 ||
+	    (uint64_t)hdr.total_chunks * hdr.chunk_hdr_sz > file_size)
+		goto err;
+
+	b->extents = calloc(hdr.total_chunks ? hdr.total_chunks : 1,
+			    sizeof(*b->extents));
+	if (!b->extents)
+		return EFI_OUT_OF_RESOURCES;
+
+	off = hdr.file_hdr_sz;
+	for (i = 0; i < hdr.total_chunks; i++) {
+		ret = fd_pread_full(b->fd, &chdr, sizeof(chdr), off,
+				    "disk image");
+		if (EFI_ERROR(ret))
+			return ret;
+
+		if (chdr.total_sz < hdr.chunk_hdr_sz ||
+		    off + chdr.total_sz > file_size)
+			goto err;
+
+		data_sz = chdr.total_sz - hdr.chunk_hdr_sz;
+		ext = &b->extents[b->nb_extents];
+		ext->start = start;
+		ext->len = (uint64_t)chdr.chunk_sz * hdr.blk_sz;
+		ext->type = chdr.chunk_type;
+
+		switch (chdr.chunk_type) {
+		case CHUNK_TYPE_RAW:
+			if (data_sz != ext->len)
+				goto err;
+			ext->data = off + hdr.chunk_hdr_sz;
+			break;
+		case CHUNK_TYPE_FILL:
+			if (data_sz != sizeof(fill))
+				goto err;
+			ret = fd_pread_full(b->fd, &fill, sizeof(fill),
+					    off + hdr.chunk_hdr_sz,
+					    "disk image");
+			if (EFI_ERROR(ret))
+				return ret;
+			ext->data = fill;
+			break;
+		case CHUNK_TYPE_DONT_CARE:
+			break;
+		case CHUNK_TYPE_CRC32:
+			ext->len = 0;
+			break;
+		default:
+			goto err;
+		}
+
+		off += chdr.total_sz;
+		start += ext->len;
+		if (ext->len)
+			b->nb_extents++;
+	}
+
+	if (start != (uint64_t)hdr.total_blks * hdr.blk_sz)
+		goto err;
+
+	b->size = start;
+	return EFI_SUCCESS;
+
+err:
+	ewerr("Invalid sparse disk image");
+	return EFI_VOLUME_CORRUPTED;
+}
+
+static EFI_STATUS open_compressed(backing_t *b, uint64_t file_size)
+{
+	compressed_header_t hdr;
+	EFI_STATUS ret;
+	uint64_t i, end;
+
+	ret = fd_pread_full(b->fd, &hdr, sizeof(hdr), 0, "disk image");
+	if (EFI_ERROR(ret))
+		return ret;
+
+	if (!hdr.chunk_sz || hdr.chunk_sz > 64 * 1024 * 1024 ||
+	    hdr.chunk_cnt != (hdr.size + hdr.chunk_sz - 1) / hdr.chunk_sz ||
+	    hdr.chunk_cnt >= file_size / sizeof(*b->offsets))
+		goto err;
+
+	b->size = hdr.size;
+	b->chunk_sz = hdr.chunk_sz;
+	b->chunk_cnt = hdr.chunk_cnt;
+	b->offsets = malloc((b->chunk_cnt + 1) * sizeof(*b->offsets));
+	b->zbuf = malloc(compressBound(b->chunk_sz));
+	if (!b->offsets || !b->zbuf)
+		return EFI_OUT_OF_RESOURCES;
+
+	ret = fd_pread_full(b->fd, b->offsets,
+			    (b->chunk_cnt + 1) * sizeof(*b->offsets),
+			    sizeof(hdr), "disk image");
+	if (EFI_ERROR(ret))
+		return ret;
+
+	end = sizeof(hdr) + (b->chunk_cnt + 1) * sizeof(*b->offsets);
+	for (i = 0; i <= b->chunk_cnt; end = b->offsets[i++])
+		if (b->offsets[i] < end || b->offsets[i] > file_size ||
+		    (i && b->offsets[i] - end > compressBound(b->chunk_sz)))
+			goto err;
+
+	for (i = 0; i < ARRAY_SIZE(b->cache); i++)
+		b->cache[i].chunk = UINT64_MAX;
+
+	return EFI_SUCCESS;
+
+err:
+	ewerr("Invalid compressed disk image");
+	return EFI_VOLUME_CORRUPTED;
+}
+
+backing_t *backing_open(const char *path)
+{
+	EFI_STATUS ret = EFI_SUCCESS;
+	char magic[8];
+	struct stat sb;
+	backing_t *b;
+
+	b = calloc(1, sizeof(*b));
+	if (!b)
+		return NULL;
+
+	b->fd = open(path, O_RDONLY);
+	if (b->fd == -1) {
+		ewerr("Failed to open %s disk image, %s",
+		      path, strerror(errno));
+		free(b);
+		return NULL;
+	}
+
+	if (fstat(b->fd, &sb) == -1 || !S_ISREG(sb.st_mode)) {
+		ewerr("%s disk image is not a regular file", path);
+		goto err;
+	}
+
+	b->size = sb.st_size;
+	if ((size_t)sb.st_size < sizeof(magic) ||
+	    EFI_ERROR(fd_pread_full(b->fd, magic, sizeof(magic), 0,
+				    "disk image")))
+		return b;
+
+	if (*(uint32_t *)magic == SPARSE_HEADER_MAGIC) {
+		b->format = BACKING_SPARSE;
+		ret = open_sparse(b, sb.st_size);
+	} else if (!memcmp(magic, COMPRESSED_MAGIC, sizeof(magic))) {
+		b->format = BACKING_COMPRESSED;
+		ret = open_compressed(b, sb.st_size);
+	}
+	if (EFI_ERROR(ret))
+		goto err;
+
+	return b;
+
+err:
+	backing_close(b);
+	return NULL;
+}
+
+void backing_close(backing_t *b)
+{
+	size_t i;
+
+	for (i = 0; i < ARRAY_SIZE(b->cache); i++)
+		free(b->cache[i].data);
+	free(b->zbuf);
+	free(b->offsets);
+	free(b->extents);
+	close(b->fd);
+	free(b);
+}
+
+uint64_t backing_size(backing_t *b)
+{
+	return b->size;
+}
+
+backing_format_t backing_format(backing_t *b)
+{
+	return b->format;
+}
+
+const char *backing_format_name(backing_t *b)
+{
+	return FORMAT_NAMES[b->format];
+}
+
+static void fill(void *buf, size_t len, uint32_t value, uint64_t phase)
+{
+	unsigned char *p = buf;
+	size_t i;
+
+	for (i = 0; i < len; i++)
+		p[i] = value >> (((phase + i) % 4) * 8);
+}
+
+static EFI_STATUS read_sparse(backing_t *b, uint64_t off, void *buf,
+			      size_t len)
+{
+	size_t lo = 0, hi = b->nb_extents, mid, n;
+	EFI_STATUS ret;
+	extent_t *ext;
+
+	/* Last extent starting at or before OFF */
+	while (hi - lo > 1) {
+		mid = (lo + hi) / 2;
+		if (b->extents[mid].start <= off)
+			lo = mid;
+		else
+			hi = mid;
+	}
+
+	for (ext = &b->extents[lo]; len; ext++, off += n) {
+		n = min(len, ext->start + ext->len - off);
+
+		switch (ext->type) {
+		case CHUNK_TYPE_RAW:
+			ret = fd_pread_full(b->fd, buf, n,
+					    ext->data + off - ext->start,
+					    "disk image");
+			if (EFI_ERROR(ret))
+				return ret;
+			break;
+		case CHUNK_TYPE_FILL:
+			fill(buf, n, ext->data, off - ext->start);
+			break;
+		default:
+			memset(buf, 0, n);
+		}
+
+		buf = (char *)buf + n;
+		len -= n;
+	}
+
+	return EFI_SUCCESS;
+}
+
+/* Return the decompressed CHUNK, from the cache or by replacing its
+   least recently used entry. */
+static unsigned char *get_chunk(backing_t *b, uint64_t chunk)
+{
+	cached_chunk_t *c = &b->cache[0];
+	uint64_t clen, zlen;
+	uLongf dlen;
+	size_t i;
+
+	for (i = 0; i < ARRAY_SIZE(b->cache); i++) {
+		if (b->cache[i].chunk == chunk) {
+			c = &b->cache[i];
+			c->stamp = ++b->clock;
+			return c->data;
+		}
+		if (b->cache[i].stamp < c->stamp)
+			c = &b->cache[i];
+	}
+
+	if (!c->data) {
+		c->data = malloc(b->chunk_sz);
+		if (!c->data)
+			return NULL;
+	}
+	c->chunk = UINT64_MAX;
+
+	clen = min(b->size - chunk * b->chunk_sz, (uint64_t)b->chunk_sz);
+	zlen = b->offsets[chunk + 1] - b->offsets[chunk];
+	if (!zlen)
+		memset(c->data, 0, clen);
+	else if (zlen == clen) {
+		if (EFI_ERROR(fd_pread_full(b->fd, c->data, clen,
+					    b->offsets[chunk], "disk image")))
+			return NULL;
+	} else {
+		if (EFI_ERROR(fd_pread_full(b->fd, b->zbuf, zlen,
+					    b->offsets[chunk], "disk image")))
+			return NULL;
+		dlen = clen;
+		if (uncompress(c->data, &dlen, b->zbuf, zlen) != Z_OK ||
+		    dlen != clen) {
+			ewerr("Failed to decompress disk image chunk %llu",
+			      (unsigned long long)chunk);
+			return NULL;
+		}
+	}
+
+	c->chunk = chunk;
+	c->stamp = ++b->clock;
+	return c->data;
+}
+
+static EFI_STATUS read_compressed(backing_t *b, uint64_t off, void *buf,
+				  size_t len)
+{
+	unsigned char *data;
+	size_t coff, n;
+
+	for (; len; len -= n, off += n, buf = (char *)buf + n) {
+		coff = off % b->chunk_sz;
+		n = min(len, (size_t)b->chunk_sz - coff);
+		data = get_chunk(b, off / b->chunk_sz);
+		if (!data)
+			return EFI_DEVICE_ERROR;
+		memcpy(buf, data + coff, n);
+	}
+
+	return EFI_SUCCESS;
+}
+
+EFI_STATUS backing_read(backing_t *b, uint64_t off, void *buf, size_t len)
+{
+	if (off > b->size || len > b->size - off)
+		return EFI_INVALID_PARAMETER;
+
+	switch (b->format) {
+	case BACKING_SPARSE:
+		return read_sparse(b, off, buf, len);
+	case BACKING_COMPRESSED:
+		return read_compressed(b, off, buf, len);
+	default:
+		return fd_pread_full(b->fd, buf, len, off, "disk image");
+	}
+}
+
+static bool is_zero(const unsigned char *buf, size_t len)
+{
+	return !len || (!buf[0] && !memcmp(buf, buf + 1, len - 1));
+}
+
+EFI_STATUS backing_compress(const char *raw, const char *path)
+{
+	compressed_header_t hdr = {
+		.magic = COMPRESSED_MAGIC,
+		.chunk_sz = BACKING_CHUNK_SIZE
+	};
+	unsigned char *chunk = NULL, *zbuf = NULL;
+	uint64_t *offsets = NULL, i;
+	EFI_STATUS ret = EFI_OUT_OF_RESOURCES;
+	backing_t *in;
+	size_t clen;
+	uLongf zlen;
+	int fd;
+
+	in = backing_open(raw);
+	if (!in)
+		return EFI_INVALID_PARAMETER;
+
+	fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd == -1) {
+		ewerr("Failed to create %s disk image, %s",
+		      path, strerror(errno));
+		backing_close(in);
+		return EFI_DEVICE_ERROR;
+	}
+
+	hdr.size = backing_size(in);
+	hdr.chunk_cnt = (hdr.size + hdr.chunk_sz - 1) / hdr.chunk_sz;
+	offsets = malloc((hdr.chunk_cnt + 1) * sizeof(*offsets));
+	chunk = malloc(hdr.chunk_sz);
+	zbuf = malloc(compressBound(hdr.chunk_sz));
+	if (!offsets || !chunk || !zbuf)
+		goto exit;
+
+	/* The offsets table is written once the chunks are */
+	offsets[0] = sizeof(hdr) + (hdr.chunk_cnt + 1) * sizeof(*offsets);
+	if (lseek64(fd, offsets[0], SEEK_SET) == -1) {
+		ret = EFI_DEVICE_ERROR;
+		goto exit;
+	}
+
+	for (i = 0; i < hdr.chunk_cnt; i++) {
+		clen = min(hdr.size - i * hdr.chunk_sz,
+			   (uint64_t)hdr.chunk_sz);
+		ret = backing_read(in, i * hdr.chunk_sz, chunk, clen);
+		if (EFI_ERROR(ret))
+			goto exit;
+
+		zlen = compressBound(hdr.chunk_sz);
+		if (is_zero(chunk, clen))
+			zlen = 0;
+		else if (compress(zbuf, &zlen, chunk, clen) != Z_OK ||
+			 zlen >= clen) {
+			memcpy(zbuf, chunk, clen);
+			zlen = clen;
+		}
+
+		ret = fd_write_full(fd, zbuf, zlen, "disk image");
+		if (EFI_ERROR(ret))
+			goto exit;
+		offsets[i + 1] = offsets[i] + zlen;
+	}
+
+	ret = EFI_DEVICE_ERROR;
+	if (lseek64(fd, 0, SEEK_SET) == -1)
+		goto exit;
+
+	ret = fd_write_full(fd, &hdr, sizeof(hdr), "disk image");
+	if (EFI_ERROR(ret))
+		goto exit;
+
+	ret = fd_write_full(fd, offsets,
+			    (hdr.chunk_cnt + 1) * sizeof(*offsets),
+			    "disk image");
+
+exit:
+	if (close(fd) && !EFI_ERROR(ret)) {
+		ewerr("Failed to close %s disk image, %s",
+		      path, strerror(errno));
+		ret = EFI_DEVICE_ERROR;
+	}
+	free(zbuf);
+	free(chunk);
+	free(offsets);
+	backing_close(in);
+	return ret;
+}
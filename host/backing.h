@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2026, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _BACKING_H_
+#define _BACKING_H_
+
+#include <stdint.h>
+#include <efi.h>
+#include <efiapi.h>
+
+/* Read-only disk image in one of the supported formats, detected
+   when it is opened:
+   - a raw image,
+   - an Android sparse image, read through its chunks index,
+   - a chunked compressed image: independently deflated chunks
+     located by an offsets table, the recently used chunks are kept
+     decompressed in a LRU cache. */
+typedef struct backing backing_t;
+
+typedef enum backing_format {
+	BACKING_RAW,
+	BACKING_SPARSE,
+	BACKING_COMPRESSED
+} backing_format_t;
+
+/* Uncompressed size of the chunks written by backing_compress() */
+#define BACKING_CHUNK_SIZE	(64 * 1024)
+/* Number of decompressed chunks kept in the cache */
+#define BACKING_CACHE_CHUNKS	64
+
+backing_t *backing_open(const char *path);
+void backing_close(backing_t *b);
+uint64_t backing_size(backing_t *b);
+backing_format_t backing_format(backing_t *b);
+const char *backing_format_name(backing_t *b);
+EFI_STATUS backing_read(backing_t *b, uint64_t off, void *buf, size_t len);
+
+/* Write the RAW image to PATH in the chunked compressed format. */
+EFI_STATUS backing_compress(const char *raw, const char *path);
+
+#endif	/* _BACKING_H_ */
@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2026, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <stdlib.h>
+#include <time.h>
+#include <ewperf.h>
+
+#include "boottime.h"
+
+#define CALIBRATION_DURATION	(20 * 1000 * 1000) /* nanoseconds */
+
+static UINT64 now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (UINT64)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+#if defined(__i386__) || defined(__x86_64__)
+static UINT64 host_clock(void)
+{
+	return __builtin_ia32_rdtsc();
+}
+#endif
+
+void boottime_set_clock(void)
+{
+#if defined(__i386__) || defined(__x86_64__)
+	ewperf_set_clock(host_clock);
+#else
+	ewperf_set_clock(now_ns);
+	ewperf_set_tsc_freq(1000000000);
+#endif
+}
+
+void boottime_calibrate_tsc(void)
+{
+	struct timespec delay = { 0, CALIBRATION_DURATION };
+	UINT64 start_ns, start_tsc, ns, tsc;
+
+	start_ns = now_ns();
+	start_tsc = ewperf_tsc();
+	nanosleep(&delay, NULL);
+	tsc = ewperf_tsc() - start_tsc;
+	ns = now_ns() - start_ns;
+
+	if (ns)
+		ewperf_set_tsc_freq(tsc * 1000000000 / ns);
+}
+
+static int cmp_duration(const void *a, const void *b)
+{
+	const ewperf_entry_t *e1 = *(const ewperf_entry_t **)a;
+	const ewperf_entry_t *e2 = *(const ewperf_entry_t **)b;
+	UINT64 d1 = e1->end - e1->start, d2 = e2->end - e2->start;
+
+	return d1 < d2 ? 1 : d1 > d2 ? -1 : 0;
+}
+
+static BOOLEAN is_init(const ewperf_entry_t *entry)
+{
+	return entry->kind == EWPERF_COMPONENT_INIT ||
+		entry->kind == EWPERF_DRIVER_INIT;
+}
+
+void boottime_report(FILE *out)
+{
+	const ewperf_entry_t *entries, **sorted;
+	UINT64 first = ~0ULL, last = 0, offset;
+	const char *unit;
+	EFI_STATUS ret;
+	UINTN nb, i;
+
+	ret = ewperf_get(&entries, &nb);
+	if (EFI_ERROR(ret) || !nb)
+		return;
+
+	sorted = malloc(nb * sizeof(*sorted));
+	if (!sorted)
+		return;
+
+	if (!ewperf_get_tsc_freq())
+		boottime_calibrate_tsc();
+	unit = ewperf_get_tsc_freq() ? "us" : "ticks";
+
+	for (i = 0; i < nb; i++) {
+		sorted[i] = &entries[i];
+		if (!is_init(&entries[i]))
+			continue;
+		if (entries[i].start < first)
+			first = entries[i].start;
+		if (entries[i].end > last)
+			last = entries[i].end;
+	}
+	qsort(sorted, nb, sizeof(*sorted), cmp_duration);
+
+	fprintf(out, "Boot-time breakdown, TSC frequency %llu Hz\n",
+		(unsigned long long)ewperf_get_tsc_freq());
+	if (last > first)
+		fprintf(out, "Total initialization: %llu %s\n",
+			(unsigned long long)ewperf_to_us(last - first), unit);
+	fprintf(out, "%12s %-8s %-16s %s\n", unit, "start", "kind", "name");
+	for (i = 0; i < nb; i++) {
+		offset = sorted[i]->start > first ?
+			sorted[i]->start - first : 0;
+		fprintf(out, "%12llu %-8llu %-16s %s\n",
+			(unsigned long long)ewperf_to_us(sorted[i]->end -
+							 sorted[i]->start),
+			(unsigned long long)ewperf_to_us(offset),
+			ewperf_kind_str(sorted[i]->kind), sorted[i]->name);
+	}
+
+	free(sorted);
+}
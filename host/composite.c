@@ -0,0 +1,684 @@
+/*
+ * Copyright (c) 2026, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define _GNU_SOURCE
+#define _LARGEFILE64_SOURCE
+#include <ewlib.h>
+#include <ewlog.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <libgen.h>
+#include <linux/falloc.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include "composite.h"
+#include "fdutil.h"
+
+#define GPT_SIGNATURE		"EFI PART"
+#define GPT_REVISION		0x00010000
+#define GPT_HEADER_LBA		1
+#define GPT_ENTRIES_LBA		2
+#define GPT_NAME_LENGTH		36
+#define MBR_SIGNATURE		0xaa55
+#define MBR_TYPE_GPT		0xee
+
+/* Linux file system data */
+static const EFI_GUID DEFAULT_TYPE = {
+	0x0fc63daf, 0x8483, 0x4772,
+	{ 0x8e, 0x79, 0x3d, 0x69, 0xd8, 0x47, 0x7d, 0xe4 }
+};
+
+typedef struct mbr_part {
+	uint8_t status;
+	uint8_t chs_first[3];
+	uint8_t type;
+	uint8_t chs_last[3];
+	uint32_t lba_first;
+	uint32_t sectors;
+} __attribute__((__packed__)) mbr_part_t;
+
+typedef struct mbr {
+	uint8_t boot_code[446];
+	mbr_part_t parts[4];
+	uint16_t signature;
+} __attribute__((__packed__)) mbr_t;
+
+typedef struct gpt_header {
+	char signature[8];
+	uint32_t revision;
+	uint32_t size;
+	uint32_t crc32;
+	uint32_t reserved;
+	uint64_t my_lba;
+	uint64_t alternate_lba;
+	uint64_t first_usable_lba;
+	uint64_t last_usable_lba;
+	EFI_GUID disk_guid;
+	uint64_t entries_lba;
+	uint32_t nb_entries;
+	uint32_t entry_size;
+	uint32_t entries_crc32;
+} __attribute__((__packed__)) gpt_header_t;
+
+typedef struct gpt_entry {
+	EFI_GUID type;
+	EFI_GUID unique;
+	uint64_t starting_lba;
+	uint64_t ending_lba;
+	uint64_t attributes;
+	uint16_t name[GPT_NAME_LENGTH];
+} __attribute__((__packed__)) gpt_entry_t;
+
+typedef enum region_type {
+	REGION_MEMORY,
+	REGION_FILE,
+	REGION_GAP
+} region_type_t;
+
+/* Byte range of the disk, sorted by START */
+typedef struct region {
+	uint64_t start;
+	uint64_t len;
+	region_type_t type;
+	/* REGION_MEMORY */
+	unsigned char *mem;
+	/* REGION_FILE */
+	int fd;
+	bool read_only;
+	uint64_t file_size;
+	char *label;
+} region_t;
+
+typedef struct part {
+	char *label;
+	EFI_GUID type;
+	char *path;
+	uint64_t size;
+} part_t;
+
+struct composite {
+	uint64_t size;
+	region_t regions[2 * COMPOSITE_MAX_PARTS + 3];
+	size_t nb_regions;
+	bool gap_warned;
+};
+
+static uint64_t parse_size(const char *str)
+{
+	uint64_t size;
+	char *end;
+
+	size = strtoull(str, &end, 0);
+	switch (*end) {
+	case 'G':
+		size *= 1024;
+		/* fall through */
+	case 'M':
+		size *= 1024;
+		/* fall through */
+	case 'K':
+		size *= 1024;
+		end++;
+	}
+
+	return *end ? 0 : size;
+}
+
+static bool parse_guid(const char *str, EFI_GUID *guid)
+{
+	unsigned int d4[8], i;
+	int n = 0;
+
+	if (sscanf(str, "%8x-%4hx-%4hx-%2x%2x-%2x%2x%2x%2x%2x%2x%n",
+		   &guid->Data1, &guid->Data2, &guid->Data3,
+		   &d4[0], &d4[1], &d4[2], &d4[3], &d4[4], &d4[5],
+		   &d4[6], &d4[7], &n) != 11 || str[n])
+		return false;
+
+	for (i = 0; i < ARRAY_SIZE(d4); i++)
+		guid->Data4[i] = d4[i];
+	return true;
+}
+
+/* Stable GUID derived from NAME and INDEX, so that a layout always
+   gives the same disk and partition GUIDs. */
+static EFI_GUID make_guid(const char *name, uint32_t index)
+{
+	uint32_t crc = crc32(0, (const Bytef *)name, strlen(name));
+	uint32_t crc2 = crc32(crc, (const Bytef *)&index, sizeof(index));
+	EFI_GUID guid;
+
+	guid.Data1 = crc;
+	guid.Data2 = index;
+	guid.Data3 = 0x4000 | (crc2 & 0x0fff);
+	guid.Data4[0] = 0x80 | ((crc2 >> 12) & 0x3f);
+	guid.Data4[1] = crc2 >> 18;
+	memcpy(&guid.Data4[2], &crc2, 4);
+	guid.Data4[6] = index >> 8;
+	guid.Data4[7] = index;
+	return guid;
+}
+
+static void free_parts(part_t *parts, size_t nb)
+{
+	size_t i;
+
+	for (i = 0; i < nb; i++) {
+		free(parts[i].label);
+		free(parts[i].path);
+	}
+	free(parts);
+}
+
+static char *join_path(const char *dir, const char *path)
+{
+	char *res;
+
+	if (*path == '/')
+		return strdup(path);
+
+	if (asprintf(&res, "%s/%s", dir, path) == -1)
+		return NULL;
+	return res;
+}
+
+static bool parse_part(char *line, const char *dir, part_t *part)
+{
+	char *label, *guid, *field;
+
+	label = strsep(&line, ",");
+	guid = strsep(&line, ",");
+	if (!*label || strlen(label) > GPT_NAME_LENGTH)
+		return false;
+
+	part->type = DEFAULT_TYPE;
+	if (guid && *guid && !parse_guid(guid, &part->type))
+		return false;
+
+	while ((field = strsep(&line, ","))) {
+		if (!strncmp(field, "size=", 5)) {
+			part->size = parse_size(field + 5);
+			if (!part->size)
+				return false;
+		} else if (*field && !part->path) {
+			part->path = join_path(dir, field);
+			if (!part->path)
+				return false;
+		} else if (*field)
+			return false;
+	}
+
+	part->label = strdup(label);
+	return part->label && (part->path || part->size);
+}
+
+static part_t *load_layout(const char *layout, size_t *nb_parts)
+{
+	char *line = NULL, *end, *copy, *dir;
+	size_t len = 0, nb = 0, lineno = 0;
+	part_t *parts;
+	FILE *file;
+
+	parts = calloc(COMPOSITE_MAX_PARTS, sizeof(*parts));
+	copy = strdup(layout);
+	if (!parts || !copy)
+		goto err;
+	dir = dirname(copy);
+
+	file = fopen(layout, "r");
+	if (!file) {
+		ewerr("Failed to open %s composite disk layout, %s",
+		      layout, strerror(errno));
+		goto err;
+	}
+
+	while (getline(&line, &len, file) != -1) {
+		lineno++;
+		end = line + strcspn(line, "\r\n");
+		*end = '\0';
+		if (!*line || *line == '#')
+			continue;
+
+		if (nb == COMPOSITE_MAX_PARTS) {
+			ewerr("Too many partitions in %s, at most %d",
+			      layout, COMPOSITE_MAX_PARTS);
+			goto close;
+		}
+
+		if (!parse_part(line, dir, &parts[nb++])) {
+			ewerr("Invalid partition at %s:%zu", layout, lineno);
+			goto close;
+		}
+	}
+
+	if (!nb) {
+		ewerr("No partition in %s composite disk layout", layout);
+		goto close;
+	}
+
+	free(line);
+	fclose(file);
+	free(copy);
+	*nb_parts = nb;
+	return parts;
+
+close:
+	free(line);
+	fclose(file);
+err:
+	free(copy);
+	if (parts)
+		free_parts(parts, nb);
+	return NULL;
+}
+
+static region_t *add_region(composite_t *c, region_type_t type,
+			    uint64_t start, uint64_t end)
+{
+	region_t *r = &c->regions[c->nb_regions++];
+
+	r->type = type;
+	r->start = start;
+	r->len = end - start;
+	r->fd = -1;
+	return r;
+}
+
+static EFI_STATUS open_part(region_t *r, part_t *part)
+{
+	struct stat sb;
+	char *dir;
+
+	r->label = part->label;
+	part->label = NULL;
+
+	if (!part->path) {
+		dir = getenv("TMPDIR");
+		r->fd = open(dir ? dir : "/tmp", O_RDWR | O_TMPFILE, 0600);
+		if (r->fd == -1) {
+			ewerr("Failed to create %s partition file, %s",
+			      r->label, strerror(errno));
+			return EFI_DEVICE_ERROR;
+		}
+		return EFI_SUCCESS;
+	}
+
+	r->fd = open(part->path, O_RDWR);
+	if (r->fd == -1 && (errno == EACCES || errno == EROFS)) {
+		r->fd = open(part->path, O_RDONLY);
+		r->read_only = true;
+	}
+	if (r->fd == -1 || fstat(r->fd, &sb) == -1) {
+		ewerr("Failed to open %s partition file, %s",
+		      part->path, strerror(errno));
+		return EFI_DEVICE_ERROR;
+	}
+
+	r->file_size = sb.st_size;
+	if (!part->size)
+		part->size = r->file_size;
+	/* A GPT entry cannot describe an empty partition */
+	if (!part->size) {
+		ewerr("%s partition file is empty and has no size",
+		      part->path);
+		return EFI_INVALID_PARAMETER;
+	}
+	if (r->file_size > part->size) {
+		ewerr("%s partition file is larger than its %llu bytes",
+		      part->path, (unsigned long long)part->size);
+		return EFI_BAD_BUFFER_SIZE;
+	}
+
+	return EFI_SUCCESS;
+}
+
+static void write_header(unsigned char *buf, uint64_t my_lba,
+			 uint64_t alternate_lba, uint64_t entries_lba,
+			 gpt_header_t *tmpl)
+{
+	gpt_header_t *hdr = (gpt_header_t *)buf;
+
+	*hdr = *tmpl;
+	hdr->my_lba = my_lba;
+	hdr->alternate_lba = alternate_lba;
+	hdr->entries_lba = entries_lba;
+	hdr->crc32 = crc32(0, (const Bytef *)hdr, sizeof(*hdr));
+}
+
+/* Lay the partitions out on COMPOSITE_ALIGN boundaries and synthesise
+   the protective MBR and both GUID Partition Tables. */
+static EFI_STATUS build(composite_t *c, const char *layout, part_t *parts,
+			size_t nb_parts, uint32_t blk_sz)
+{
+	uint64_t entries_blocks, first_usable, last_usable, blocks, lba, pos;
+	uint64_t align = COMPOSITE_ALIGN / blk_sz;
+	unsigned char *entries, *head, *tail;
+	gpt_header_t hdr = { 0 };
+	gpt_entry_t *entry;
+	mbr_t *mbr;
+	region_t *r;
+	EFI_STATUS ret;
+	size_t i, j;
+
+	entries_blocks = (COMPOSITE_MAX_PARTS * sizeof(*entry) + blk_sz - 1) /
+		blk_sz;
+	first_usable = GPT_ENTRIES_LBA + entries_blocks;
+
+	head = calloc(first_usable, blk_sz);
+	if (!head)
+		return EFI_OUT_OF_RESOURCES;
+
+	r = add_region(c, REGION_MEMORY, 0, first_usable * blk_sz);
+	r->mem = head;
+	entries = head + GPT_ENTRIES_LBA * blk_sz;
+	pos = first_usable;
+
+	lba = (first_usable + align - 1) / align * align;
+	for (i = 0; i < nb_parts; i++) {
+		if (lba > pos)
+			add_region(c, REGION_GAP, pos * blk_sz, lba * blk_sz);
+
+		r = add_region(c, REGION_FILE, lba * blk_sz, lba * blk_sz);
+		ret = open_part(r, &parts[i]);
+		if (EFI_ERROR(ret))
+			return ret;
+
+		blocks = (parts[i].size + blk_sz - 1) / blk_sz;
+		r->len = blocks * blk_sz;
+		pos = lba + blocks;
+
+		entry = (gpt_entry_t *)entries + i;
+		entry->type = parts[i].type;
+		entry->unique = make_guid(r->label, i + 1);
+		entry->starting_lba = lba;
+		entry->ending_lba = lba + blocks - 1;
+		for (j = 0; r->label[j]; j++)
+			entry->name[j] = r->label[j];
+
+		lba = (pos + align - 1) / align * align;
+	}
+
+	last_usable = lba - 1;
+	if (lba > pos)
+		add_region(c, REGION_GAP, pos * blk_sz, lba * blk_sz);
+
+	tail = calloc(entries_blocks + 1, blk_sz);
+	if (!tail)
+		return EFI_OUT_OF_RESOURCES;
+	r = add_region(c, REGION_MEMORY, lba * blk_sz,
+		       (lba + entries_blocks + 1) * blk_sz);
+	r->mem = tail;
+	c->size = r->start + r->len;
+
+	mbr = (mbr_t *)head;
+	mbr->parts[0].chs_first[1] = 0x02;
+	mbr->parts[0].type = MBR_TYPE_GPT;
+	memset(mbr->parts[0].chs_last, 0xff, sizeof(mbr->parts[0].chs_last));
+	mbr->parts[0].lba_first = GPT_HEADER_LBA;
+	mbr->parts[0].sectors = min(c->size / blk_sz - 1,
+				    (uint64_t)UINT32_MAX);
+	mbr->signature = MBR_SIGNATURE;
+
+	memcpy(hdr.signature, GPT_SIGNATURE, sizeof(hdr.signature));
+	hdr.revision = GPT_REVISION;
+	hdr.size = sizeof(hdr);
+	hdr.first_usable_lba = first_usable;
+	hdr.last_usable_lba = last_usable;
+	hdr.disk_guid = make_guid(layout, 0);
+	hdr.nb_entries = COMPOSITE_MAX_PARTS;
+	hdr.entry_size = sizeof(*entry);
+	hdr.entries_crc32 = crc32(0, entries,
+				  COMPOSITE_MAX_PARTS * sizeof(*entry));
+
+	write_header(head + GPT_HEADER_LBA * blk_sz, GPT_HEADER_LBA,
+		     c->size / blk_sz - 1, GPT_ENTRIES_LBA, &hdr);
+	memcpy(tail, entries, COMPOSITE_MAX_PARTS * sizeof(*entry));
+	write_header(tail + entries_blocks * blk_sz, c->size / blk_sz - 1,
+		     GPT_HEADER_LBA, last_usable + 1, &hdr);
+
+	return EFI_SUCCESS;
+}
+
+composite_t *composite_open(const char *layout, uint32_t blk_sz)
+{
+	EFI_STATUS ret;
+	composite_t *c;
+	part_t *parts;
+	size_t nb_parts;
+
+	if (!blk_sz || COMPOSITE_ALIGN % blk_sz)
+		return NULL;
+
+	parts = load_layout(layout, &nb_parts);
+	if (!parts)
+		return NULL;
+
+	c = calloc(1, sizeof(*c));
+	if (!c) {
+		free_parts(parts, nb_parts);
+		return NULL;
+	}
+
+	ret = build(c, layout, parts, nb_parts, blk_sz);
+	free_parts(parts, nb_parts);
+	if (EFI_ERROR(ret)) {
+		composite_close(c);
+		return NULL;
+	}
+
+	ewdbg("Composite disk %s: %zu partitions, %llu bytes", layout,
+	      nb_parts, (unsigned long long)c->size);
+	return c;
+}
+
+void composite_close(composite_t *c)
+{
+	region_t *r;
+	size_t i;
+
+	for (i = 0; i < c->nb_regions; i++) {
+		r = &c->regions[i];
+		free(r->mem);
+		free(r->label);
+		if (r->fd != -1)
+			close(r->fd);
+	}
+	free(c);
+}
+
+uint64_t composite_size(composite_t *c)
+{
+	return c->size;
+}
+
+static region_t *find_region(composite_t *c, uint64_t off)
+{
+	size_t lo = 0, hi = c->nb_regions, mid;
+
+	while (hi - lo > 1) {
+		mid = (lo + hi) / 2;
+		if (c->regions[mid].start <= off)
+			lo = mid;
+		else
+			hi = mid;
+	}
+
+	return &c->regions[lo];
+}
+
+static EFI_STATUS file_read(region_t *r, uint64_t off, void *buf,
+			    size_t len)
+{
+	EFI_STATUS ret;
+	size_t n = 0;
+
+	/* The partition is read as zeroes past the end of its file */
+	if (off < r->file_size)
+		n = min(len, r->file_size - off);
+
+	ret = fd_pread_full(r->fd, buf, n, off, r->label);
+	if (EFI_ERROR(ret))
+		return ret;
+
+	memset((char *)buf + n, 0, len - n);
+	return EFI_SUCCESS;
+}
+
+static EFI_STATUS file_write(region_t *r, uint64_t off, const void *buf,
+			     size_t len)
+{
+	EFI_STATUS ret;
+
+	if (r->read_only)
+		return EFI_WRITE_PROTECTED;
+
+	ret = fd_pwrite_full(r->fd, buf, len, off, r->label);
+	if (EFI_ERROR(ret))
+		return ret;
+
+	r->file_size = max(r->file_size, off + len);
+	return EFI_SUCCESS;
+}
+
+static EFI_STATUS file_zero(region_t *r, uint64_t off, uint64_t len)
+{
+	if (r->read_only)
+		return EFI_WRITE_PROTECTED;
+
+	if (off >= r->file_size)
+		return EFI_SUCCESS;
+
+	len = min(len, r->file_size - off);
+	if (!fallocate64(r->fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+			 off, len))
+		return EFI_SUCCESS;
+
+	return fd_write_zeroes(r->fd, off, len, r->label);
+}
+
+typedef enum access {
+	ACCESS_READ,
+	ACCESS_WRITE,
+	ACCESS_ZERO
+} access_t;
+
+static EFI_STATUS access_range(composite_t *c, access_t access,
+			       uint64_t off, void *buf, uint64_t len)
+{
+	EFI_STATUS ret = EFI_SUCCESS;
+	uint64_t roff, n;
+	region_t *r;
+
+	if (off > c->size || len > c->size - off)
+		return EFI_INVALID_PARAMETER;
+
+	for (r = find_region(c, off); len; r++) {
+		roff = off - r->start;
+		n = min(len, r->len - roff);
+
+		switch (r->type) {
+		case REGION_MEMORY:
+			if (access == ACCESS_READ)
+				memcpy(buf, r->mem + roff, n);
+			else if (access == ACCESS_WRITE)
+				memcpy(r->mem + roff, buf, n);
+			else
+				memset(r->mem + roff, 0, n);
+			break;
+		case REGION_FILE:
+			if (access == ACCESS_READ)
+				ret = file_read(r, roff, buf, n);
+			else if (access == ACCESS_WRITE)
+				ret = file_write(r, roff, buf, n);
+			else
+				ret = file_zero(r, roff, n);
+			break;
+		case REGION_GAP:
+			if (access == ACCESS_READ)
+				memset(buf, 0, n);
+			else if (access == ACCESS_WRITE && !c->gap_warned) {
+				ewdbg("Writes outside of the composite disk partitions are ignored");
+				c->gap_warned = true;
+			}
+			break;
+		}
+		if (EFI_ERROR(ret))
+			return ret;
+
+		if (buf)
+			buf = (char *)buf + n;
+		off += n;
+		len -= n;
+	}
+
+	return EFI_SUCCESS;
+}
+
+EFI_STATUS composite_read(composite_t *c, uint64_t off, void *buf,
+			  size_t len)
+{
+	return access_range(c, ACCESS_READ, off, buf, len);
+}
+
+EFI_STATUS composite_write(composite_t *c, uint64_t off, const void *buf,
+			   size_t len)
+{
+	return access_range(c, ACCESS_WRITE, off, (void *)buf, len);
+}
+
+EFI_STATUS composite_zero(composite_t *c, uint64_t off, uint64_t len)
+{
+	return access_range(c, ACCESS_ZERO, off, NULL, len);
+}
+
+EFI_STATUS composite_flush(composite_t *c)
+{
+	region_t *r;
+	size_t i;
+
+	for (i = 0; i < c->nb_regions; i++) {
+		r = &c->regions[i];
+		if (r->type != REGION_FILE || r->read_only)
+			continue;
+		if (fdatasync(r->fd)) {
+			ewerr("Failed to sync %s partition file, %s",
+			      r->label, strerror(errno));
+			return EFI_DEVICE_ERROR;
+		}
+	}
+
+	return EFI_SUCCESS;
+}
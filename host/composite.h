@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2026, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _COMPOSITE_H_
+#define _COMPOSITE_H_
+
+#include <stdint.h>
+#include <efi.h>
+#include <efiapi.h>
+
+/* Disk assembled from one host file per partition.  The GUID
+   Partition Tables are synthesised in memory from a layout file and
+   each partition block range is mapped onto its own file, so that
+   accessing a partition only touches that file.
+
+   Each line of the layout file describes a partition:
+       LABEL,[TYPE_GUID],[FILE][,size=N[K|M|G]]
+   TYPE_GUID defaults to the Linux file system data GUID.  The
+   partition is sized after FILE, relative to the layout file
+   directory, unless size= is given.  A partition without FILE is
+   backed by a temporary file.  Empty lines and lines starting with
+   '#' are ignored. */
+typedef struct composite composite_t;
+
+#define COMPOSITE_MAX_PARTS	128
+/* Partitions start on this boundary */
+#define COMPOSITE_ALIGN		(1024 * 1024)
+
+composite_t *composite_open(const char *layout, uint32_t blk_sz);
+void composite_close(composite_t *c);
+uint64_t composite_size(composite_t *c);
+
+/* The writes to the partition tables are kept in memory until the
+   composite disk is closed, the writes outside of the partitions and
+   the partition tables are ignored. */
+EFI_STATUS composite_read(composite_t *c, uint64_t off, void *buf,
+			  size_t len);
+EFI_STATUS composite_write(composite_t *c, uint64_t off, const void *buf,
+			   size_t len);
+EFI_STATUS composite_zero(composite_t *c, uint64_t off, uint64_t len);
+/* Sync the partition files */
+EFI_STATUS composite_flush(composite_t *c);
+
+#endif	/* _COMPOSITE_H_ */
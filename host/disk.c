@@ -29,100 +29,691 @@
  * OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#define _GNU_SOURCE
 #define _LARGEFILE64_SOURCE
+#include <ewlib.h>
 #include <ewlog.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <linux/falloc.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <unistd.h>
 #include <storage.h>
 #include <sdio.h>
 
+#include "aio.h"
+#include "backing.h"
 #include "disk.h"
+#include "fdutil.h"
+#include "overlay.h"
+#include "composite.h"
+#include "timing.h"
 
-static const char *DISK_PATH = "./disk.img";
-static const UINT32 DISK_BLK_SZ = 512;
-static const UINT64 DISK_SIZE = (uint64_t)12 * 1024 * 1024 * 1024;
+#define DISK_MAX_IOV	64
+#define DISK_AIO_DEPTH	32
 
-static int fd = -1;
+/* Disk used when none is configured with disk_add() */
+static const disk_config_t DEFAULT_DISK = {
+	.path = "./disk.img",
+	.size = (UINT64)12 * 1024 * 1024 * 1024,
+	.blk_sz = 512,
+	.type = STORAGE_EMMC
+};
 
-static EFI_STATUS _init(storage_t *s)
+typedef struct timed_req timed_req_t;
+
+typedef struct disk {
+	storage_t storage;
+	disk_config_t config;
+	EFI_HANDLE handle;
+	int fd;
+	/* File system block size, the granularity of the discards */
+	blksize_t fs_blk_sz;
+	aio_t *aio;
+	int direct_fd;
+	/* mmap mode: MAP serves the reads and writes, MAP_RO is handed
+	   out by the map() operation so that callers cannot alter the
+	   disk. */
+	unsigned char *map;
+	const unsigned char *map_ro;
+	size_t map_size;
+	overlay_t *overlay;
+	composite_t *composite;
+	/* Timing model: the operations of UNTIMED are run, then delayed
+	   by TIMING.  DONE lists the asynchronous requests whose
+	   completion is held back until their deadline. */
+	timing_t *timing;
+	storage_t untimed;
+	timed_req_t *done;
+	/* Progress through the file system capabilities */
+	size_t zeroes_mode;
+	bool punch_unsupported;
+	bool copy_unsupported;
+} disk_t;
+
+static disk_config_t configs[DISK_MAX];
+static size_t nb_configs;
+
+static disk_t *disks[DISK_MAX];
+static size_t nb_disks;
+
+/* Asynchronous I/O settings, see disk_set_aio() */
+static bool aio_enabled = true;
+static aio_engine_t aio_engine = AIO_URING;
+static unsigned int aio_depth = DISK_AIO_DEPTH;
+static bool aio_direct;
+static bool aio_fixed_buffers;
+
+static bool mmap_enabled;
+
+/* Overlay mode, see disk_set_overlay() */
+static const char *overlay_base;
+static const char *overlay_delta;
+static const char *overlay_snapshot_path;
+static bool overlay_reset;
+static bool overlay_commit_on_exit;
+
+/* Timing model, see disk_set_timing() */
+static bool timing_enabled;
+static const timing_profile_t *timing_profile;
+static bool timing_virtual;
+static unsigned int timing_seed;
+
+EFI_STATUS disk_add(const disk_config_t *config)
+{
+	if (!config || !config->path ||
+	    (config->blk_sz != 512 && config->blk_sz != 4096) ||
+	    config->size % config->blk_sz || config->type >= STORAGE_ALL)
+		return EFI_INVALID_PARAMETER;
+
+	if (nb_configs == ARRAY_SIZE(configs))
+		return EFI_OUT_OF_RESOURCES;
+
+	configs[nb_configs++] = *config;
+	return EFI_SUCCESS;
+}
+
+void disk_set_aio(bool enabled, aio_engine_t engine, unsigned int depth,
+		  bool direct, bool fixed_buffers)
+{
+	aio_enabled = enabled;
+	aio_engine = engine;
+	aio_depth = depth ? depth : DISK_AIO_DEPTH;
+	aio_direct = direct;
+	aio_fixed_buffers = fixed_buffers;
+}
+
+void disk_set_mmap(bool enabled)
+{
+	mmap_enabled = enabled;
+}
+
+void disk_set_overlay(const char *base, const char *delta, bool reset,
+		      const char *snapshot, bool commit)
+{
+	overlay_base = base;
+	overlay_delta = delta;
+	overlay_reset = reset;
+	overlay_snapshot_path = snapshot;
+	overlay_commit_on_exit = commit;
+}
+
+void disk_set_timing(bool enabled, const timing_profile_t *profile,
+		     bool virtual_clock, unsigned int seed)
+{
+	timing_enabled = enabled;
+	timing_profile = profile;
+	timing_virtual = virtual_clock;
+	timing_seed = seed;
+}
+
+EFI_STATUS disk_compress_image(const char *raw, const char *path)
+{
+	return backing_compress(raw, path);
+}
+
+static EFI_STATUS open_disk(disk_t *d)
 {
+	const char *path = d->config.path;
+	storage_t *s = &d->storage;
 	char c = 0;
 	ssize_t size;
 	off64_t off;
 	int ret;
 	struct stat sb;
 
-	s->blk_sz = DISK_BLK_SZ;
+	s->blk_sz = d->config.blk_sz;
 
-	fd = open(DISK_PATH, O_RDWR, 0644);
-	if (fd >= 0) {
-		ret = fstat(fd, &sb);
+	d->fd = open(path, O_RDWR, 0644);
+	if (d->fd >= 0) {
+		ret = fstat(d->fd, &sb);
 		if (ret == -1) {
 			ewerr("Failed to fstat %s disk file, %s",
-			      DISK_PATH, strerror(errno));
+			      path, strerror(errno));
 			return EFI_DEVICE_ERROR;
 		}
 
 		if (!S_ISREG(sb.st_mode))
 			return EFI_DEVICE_ERROR;
 
-		s->blk_cnt = sb.st_size / DISK_BLK_SZ;
-		return EFI_SUCCESS;
+		s->blk_cnt = sb.st_size / s->blk_sz;
+		goto set_erase_granularity;
 	}
 	if (errno != ENOENT) {
 		ewerr("Failed to open %s disk file, %s",
-		      DISK_PATH, strerror(errno));
+		      path, strerror(errno));
 		return EFI_DEVICE_ERROR;
 	}
 
-	s->blk_cnt = DISK_SIZE / DISK_BLK_SZ;
+	s->blk_cnt = d->config.size / s->blk_sz;
 
-	fd = open(DISK_PATH, O_RDWR | O_CREAT, 0644);
-	if (fd == -1) {
+	d->fd = open(path, O_RDWR | O_CREAT, 0644);
+	if (d->fd == -1) {
 		ewerr("Failed to create %s disk file, %s",
-		      DISK_PATH, strerror(errno));
+		      path, strerror(errno));
 		return EFI_DEVICE_ERROR;
 	}
 
-	off = lseek64(fd, DISK_SIZE - 1, SEEK_SET);
-	if (off != DISK_SIZE - 1) {
+	off = lseek64(d->fd, d->config.size - 1, SEEK_SET);
+	if (off != (off64_t)d->config.size - 1) {
 		ewerr("Failed to seek till the end of disk, %s",
 		      strerror(errno));
 		return EFI_DEVICE_ERROR;
 	}
 
-	size = write(fd, &c, sizeof(c));
+	size = write(d->fd, &c, sizeof(c));
 	if (size != sizeof(c)) {
 		ewerr("Failed to initialize disk file, %s",
 		      strerror(errno));
 		return EFI_DEVICE_ERROR;
 	}
 
+	ret = fstat(d->fd, &sb);
+	if (ret == -1) {
+		ewerr("Failed to fstat %s disk file, %s",
+		      path, strerror(errno));
+		return EFI_DEVICE_ERROR;
+	}
+
+set_erase_granularity:
+	d->fs_blk_sz = sb.st_blksize;
+	if (d->fs_blk_sz < s->blk_sz || d->fs_blk_sz % s->blk_sz)
+		d->fs_blk_sz = s->blk_sz;
+	s->erase_granularity = d->fs_blk_sz / s->blk_sz;
+
+	return EFI_SUCCESS;
+}
+
+static EFI_STATUS _submit(storage_t *s, storage_req_t *req)
+{
+	disk_t *d;
+
+	if (!s || !req || req->lba + req->count > s->blk_cnt)
+		return EFI_INVALID_PARAMETER;
+
+	d = s->priv;
+	return aio_submit(d->aio, req);
+}
+
+static void _poll(storage_t *s)
+{
+	disk_t *d = s->priv;
+
+	aio_poll(d->aio);
+}
+
+/* The synchronous operations keep using the buffered file descriptor
+   while the asynchronous requests go through the AIO engine, with the
+   O_DIRECT file descriptor when they are suitably aligned.  A failure
+   leaves the disk synchronous. */
+static void setup_aio(disk_t *d)
+{
+	aio_config_t config = {
+		.depth = aio_depth,
+		.direct_fd = -1,
+		.fixed_buffers = aio_fixed_buffers
+	};
+
+	if (aio_direct) {
+		d->direct_fd = open(d->config.path, O_RDWR | O_DIRECT);
+		if (d->direct_fd == -1)
+			ewerr("Failed to open %s disk file with O_DIRECT, %s",
+			      d->config.path, strerror(errno));
+		config.direct_fd = d->direct_fd;
+	}
+
+	d->aio = aio_new(d->fd, d->storage.blk_sz, aio_engine, &config);
+	if (!d->aio) {
+		ewerr("Failed to set up the disk asynchronous I/O");
+		if (d->direct_fd != -1)
+			close(d->direct_fd);
+		d->direct_fd = -1;
+		return;
+	}
+
+	ewdbg("%s disk asynchronous I/O: %s, queue depth %u%s",
+	      d->config.path, aio_engine_name(d->aio), config.depth,
+	      d->direct_fd != -1 ? ", O_DIRECT" : "");
+	d->storage.submit = _submit;
+	d->storage.poll = _poll;
+}
+
+static void unmap_disk(disk_t *d)
+{
+	if (d->map)
+		munmap(d->map, d->map_size);
+	if (d->map_ro)
+		munmap((void *)d->map_ro, d->map_size);
+	d->map = NULL;
+	d->map_ro = NULL;
+}
+
+static EFI_STATUS map_disk(disk_t *d)
+{
+	void *addr;
+
+	d->map_size = d->storage.blk_cnt * d->storage.blk_sz;
+	addr = mmap(NULL, d->map_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+		    d->fd, 0);
+	if (addr == MAP_FAILED)
+		goto err;
+	d->map = addr;
+
+	addr = mmap(NULL, d->map_size, PROT_READ, MAP_SHARED, d->fd, 0);
+	if (addr == MAP_FAILED)
+		goto err;
+	d->map_ro = addr;
+
+	return EFI_SUCCESS;
+
+err:
+	ewerr("Failed to map %s disk file, %s", d->config.path,
+	      strerror(errno));
+	unmap_disk(d);
+	return EFI_DEVICE_ERROR;
+}
+
+/* All the accesses go through the overlay, which neither maps nor
+   queues them. */
+static EFI_STATUS open_overlay(disk_t *d)
+{
+	storage_t *s = &d->storage;
+	EFI_STATUS ret;
+
+	d->overlay = overlay_open(overlay_base, overlay_delta);
+	if (!d->overlay)
+		return EFI_DEVICE_ERROR;
+
+	if (overlay_reset) {
+		ret = overlay_discard(d->overlay);
+		if (EFI_ERROR(ret)) {
+			overlay_close(d->overlay);
+			d->overlay = NULL;
+			return ret;
+		}
+	}
+
+	s->blk_sz = d->config.blk_sz;
+	s->blk_cnt = overlay_size(d->overlay) / s->blk_sz;
+	s->erase_granularity = OVERLAY_CHUNK_SIZE / s->blk_sz;
+	return EFI_SUCCESS;
+}
+
+static void close_overlay(disk_t *d)
+{
+	EFI_STATUS ret;
+
+	if (overlay_snapshot_path) {
+		ret = overlay_snapshot(d->overlay, overlay_snapshot_path);
+		if (EFI_ERROR(ret))
+			ewerr("Failed to save the %s disk overlay snapshot",
+			      overlay_snapshot_path);
+	}
+
+	if (overlay_commit_on_exit) {
+		ret = overlay_commit(d->overlay);
+		if (EFI_ERROR(ret))
+			ewerr("Failed to commit the disk overlay");
+	}
+
+	overlay_close(d->overlay);
+	d->overlay = NULL;
+}
+
+/* Like the overlay, the composite disk neither maps nor queues the
+   accesses. */
+static EFI_STATUS open_composite(disk_t *d)
+{
+	storage_t *s = &d->storage;
+
+	d->composite = composite_open(d->config.path, d->config.blk_sz);
+	if (!d->composite)
+		return EFI_DEVICE_ERROR;
+
+	s->blk_sz = d->config.blk_sz;
+	s->blk_cnt = composite_size(d->composite) / s->blk_sz;
+	s->erase_granularity = 1;
+	return EFI_SUCCESS;
+}
+
+/* Asynchronous request forwarded to the untimed submit() */
+struct timed_req {
+	storage_req_t req;
+	storage_req_t *orig;
+	disk_t *disk;
+	UINT64 deadline;
+	timed_req_t *next;
+};
+
+/* Run OP through the timing model once the backend is done with it */
+static void charge(disk_t *d, timing_op_t op, UINT64 bytes)
+{
+	timing_wait(d->timing, timing_schedule(d->timing, op, bytes));
+}
+
+static EFI_LBA timed_read(storage_t *s, EFI_LBA start, EFI_LBA count,
+			  void *buf)
+{
+	disk_t *d = s->priv;
+	EFI_LBA ret;
+
+	ret = d->untimed.read(s, start, count, buf);
+	if (ret == count)
+		charge(d, TIMING_READ, count * s->blk_sz);
+	return ret;
+}
+
+static EFI_LBA timed_write(storage_t *s, EFI_LBA start, EFI_LBA count,
+			   const void *buf)
+{
+	disk_t *d = s->priv;
+	EFI_LBA ret;
+
+	ret = d->untimed.write(s, start, count, buf);
+	if (ret == count)
+		charge(d, TIMING_WRITE, count * s->blk_sz);
+	return ret;
+}
+
+static EFI_LBA timed_readv(storage_t *s, EFI_LBA start, EFI_LBA count,
+			   const storage_seg_t *segs, UINTN nb_segs)
+{
+	disk_t *d = s->priv;
+	EFI_LBA ret;
+
+	ret = d->untimed.readv(s, start, count, segs, nb_segs);
+	if (ret == count)
+		charge(d, TIMING_READ, count * s->blk_sz);
+	return ret;
+}
+
+static EFI_LBA timed_writev(storage_t *s, EFI_LBA start, EFI_LBA count,
+			    const storage_seg_t *segs, UINTN nb_segs)
+{
+	disk_t *d = s->priv;
+	EFI_LBA ret;
+
+	ret = d->untimed.writev(s, start, count, segs, nb_segs);
+	if (ret == count)
+		charge(d, TIMING_WRITE, count * s->blk_sz);
+	return ret;
+}
+
+static EFI_STATUS timed_erase(storage_t *s, EFI_LBA start, UINTN size)
+{
+	disk_t *d = s->priv;
+	EFI_STATUS ret;
+
+	ret = d->untimed.erase(s, start, size);
+	if (!EFI_ERROR(ret))
+		charge(d, TIMING_ERASE, 0);
+	return ret;
+}
+
+static EFI_STATUS timed_write_zeroes(storage_t *s, EFI_LBA start,
+				     EFI_LBA count)
+{
+	disk_t *d = s->priv;
+	EFI_STATUS ret;
+
+	ret = d->untimed.write_zeroes(s, start, count);
+	if (!EFI_ERROR(ret))
+		charge(d, TIMING_ERASE, 0);
+	return ret;
+}
+
+/* The device reads and writes the blocks internally: the copy is
+   charged as a read and a write of the whole range. */
+static EFI_STATUS timed_copy(storage_t *s, EFI_LBA src, EFI_LBA dst,
+			     EFI_LBA count)
+{
+	disk_t *d = s->priv;
+	EFI_STATUS ret;
+
+	ret = d->untimed.copy(s, src, dst, count);
+	if (!EFI_ERROR(ret)) {
+		charge(d, TIMING_READ, count * s->blk_sz);
+		charge(d, TIMING_WRITE, count * s->blk_sz);
+	}
+	return ret;
+}
+
+static EFI_STATUS timed_flush(storage_t *s)
+{
+	disk_t *d = s->priv;
+	EFI_STATUS ret;
+
+	ret = d->untimed.flush(s);
+	if (!EFI_ERROR(ret))
+		charge(d, TIMING_FLUSH, 0);
+	return ret;
+}
+
+static void timed_complete(storage_req_t *req)
+{
+	timed_req_t *tr = (timed_req_t *)req;
+
+	tr->next = tr->disk->done;
+	tr->disk->done = tr;
+}
+
+/* The request is timed from its submission, so that the requests in
+   flight overlap as the device queue depth permits. */
+static EFI_STATUS timed_submit(storage_t *s, storage_req_t *req)
+{
+	disk_t *d = s->priv;
+	timed_req_t *tr;
+	EFI_STATUS ret;
+
+	if (!req || req->lba + req->count > s->blk_cnt)
+		return EFI_INVALID_PARAMETER;
+
+	tr = malloc(sizeof(*tr));
+	if (!tr)
+		return EFI_OUT_OF_RESOURCES;
+
+	tr->req = *req;
+	tr->req.complete = timed_complete;
+	tr->orig = req;
+	tr->disk = d;
+	tr->deadline = timing_schedule(d->timing, req->op == STORAGE_OP_WRITE ?
+				       TIMING_WRITE : TIMING_READ,
+				       req->count * s->blk_sz);
+
+	ret = d->untimed.submit(s, &tr->req);
+	if (EFI_ERROR(ret))
+		free(tr);
+	return ret;
+}
+
+/* In real time, the finished requests are held back until their
+   deadline.  With a virtual clock, the clock moves to it. */
+static void timed_poll(storage_t *s)
+{
+	disk_t *d = s->priv;
+	timed_req_t *tr, **prev;
+	storage_req_t *orig;
+
+	d->untimed.poll(s);
+
+	for (prev = &d->done; (tr = *prev);) {
+		if (!timing_reached(d->timing, tr->deadline)) {
+			prev = &tr->next;
+			continue;
+		}
+
+		*prev = tr->next;
+		orig = tr->orig;
+		orig->status = tr->req.status;
+		free(tr);
+		orig->complete(orig);
+	}
+}
+
+/* Disks of a type without profile, like the virtual media which
+   stands for memory, are not modelled. */
+static void setup_timing(disk_t *d)
+{
+	static const char *TYPE_PROFILES[] = {
+		[STORAGE_EMMC] = "emmc",
+		[STORAGE_UFS] = "ufs",
+		[STORAGE_NVME] = "nvme"
+	};
+	const timing_profile_t *profile = timing_profile;
+	storage_t *s = &d->storage;
+
+	if (!profile && d->config.type < ARRAY_SIZE(TYPE_PROFILES) &&
+	    TYPE_PROFILES[d->config.type])
+		profile = timing_get_profile(TYPE_PROFILES[d->config.type]);
+	if (!profile)
+		return;
+
+	d->timing = timing_new(profile, timing_virtual,
+			       timing_seed + nb_disks);
+	if (!d->timing) {
+		ewerr("Failed to set up the %s disk timing model",
+		      d->config.path);
+		return;
+	}
+
+	ewdbg("%s disk timing model: %s, %s clock", d->config.path,
+	      profile->name, timing_virtual ? "virtual" : "real");
+	d->untimed = *s;
+	s->read = timed_read;
+	s->write = timed_write;
+	s->readv = timed_readv;
+	s->writev = timed_writev;
+	s->erase = timed_erase;
+	s->write_zeroes = timed_write_zeroes;
+	/* Without copy command, the media layer copies through timed
+	   reads and writes. */
+	s->copy = profile->native_copy && s->copy ? timed_copy : NULL;
+	s->flush = timed_flush;
+	/* Accesses through the mapping cannot be timed */
+	s->map = NULL;
+	if (s->submit) {
+		s->submit = timed_submit;
+		s->poll = timed_poll;
+	}
+}
+
+/* The overlay, if any, stands for the first disk. */
+static EFI_STATUS open_backend(disk_t *d)
+{
+	EFI_STATUS ret;
+
+	if (overlay_base && d == disks[0])
+		return open_overlay(d);
+
+	if (d->config.composite)
+		return open_composite(d);
+
+	ret = open_disk(d);
+	if (EFI_ERROR(ret))
+		return ret;
+
+	/* Requests are plain memory copies in mmap mode, they are not
+	   worth queuing. */
+	if (mmap_enabled && !EFI_ERROR(map_disk(d)))
+		return EFI_SUCCESS;
+
+	if (aio_enabled)
+		setup_aio(d);
+
+	return EFI_SUCCESS;
+}
+
+static EFI_STATUS _init(storage_t *s)
+{
+	disk_t *d = s->priv;
+	EFI_STATUS ret;
+
+	ret = open_backend(d);
+	if (EFI_ERROR(ret))
+		return ret;
+
+	if (timing_enabled)
+		setup_timing(d);
+
 	return EFI_SUCCESS;
 }
 
 static EFI_LBA read_or_write(storage_t *s, EFI_LBA start, EFI_LBA count,
 			     void *buf, bool do_read)
 {
+	EFI_STATUS status;
 	ssize_t ret;
 	off64_t off;
 	size_t remaining, total;
 	char *b;
+	disk_t *d;
 
 	if (!s || !buf || start + count > s->blk_cnt)
 		return EFI_INVALID_PARAMETER;
 
-	if (fd == -1)
+	d = s->priv;
+	if (d->overlay) {
+		if (do_read)
+			status = overlay_read(d->overlay, start * s->blk_sz,
+					      buf, count * s->blk_sz);
+		else
+			status = overlay_write(d->overlay, start * s->blk_sz,
+					       buf, count * s->blk_sz);
+		return EFI_ERROR(status) ? 0 : count;
+	}
+
+	if (d->composite) {
+		if (do_read)
+			status = composite_read(d->composite,
+						start * s->blk_sz, buf,
+						count * s->blk_sz);
+		else
+			status = composite_write(d->composite,
+						 start * s->blk_sz, buf,
+						 count * s->blk_sz);
+		return EFI_ERROR(status) ? 0 : count;
+	}
+
+	if (d->fd == -1)
 		return EFI_NOT_STARTED;
 
-	off = lseek64(fd, start * s->blk_sz, SEEK_SET);
+	if (d->map) {
+		off = start * s->blk_sz;
+		if (do_read)
+			memcpy(buf, d->map + off, count * s->blk_sz);
+		else
+			memcpy(d->map + off, buf, count * s->blk_sz);
+		return count;
+	}
+
+	off = lseek64(d->fd, start * s->blk_sz, SEEK_SET);
 	if (off != (off64_t)start * s->blk_sz) {
 		ewerr("Failed to seek in the disk file, %s",
 		      strerror(errno));
@@ -133,9 +724,9 @@ static EFI_LBA read_or_write(storage_t *s, EFI_LBA start, EFI_LBA count,
 	total = 0;
 	for (remaining = count * s->blk_sz; remaining > 0; remaining -= ret) {
 		if (do_read)
-			ret = read(fd, b, remaining);
+			ret = read(d->fd, b, remaining);
 		else
-			ret = write(fd, b, remaining);
+			ret = write(d->fd, b, remaining);
 
 		if (do_read && ret == 0) {
 			ewerr("End of file detected");
@@ -166,37 +757,451 @@ static EFI_LBA _write(storage_t *s, EFI_LBA start, EFI_LBA count,
 	return read_or_write(s, start, count, (void *)buf, false);
 }
 
-static storage_t disk_storage = {
+static EFI_LBA readv_or_writev(storage_t *s, EFI_LBA start, EFI_LBA count,
+			       const storage_seg_t *segs, UINTN nb_segs,
+			       bool do_read)
+{
+	struct iovec iov[DISK_MAX_IOV];
+	EFI_STATUS status;
+	ssize_t ret;
+	off64_t off;
+	size_t total;
+	UINTN i, n;
+	disk_t *d;
+
+	if (!s || !segs || start + count > s->blk_cnt)
+		return 0;
+
+	d = s->priv;
+	off = start * s->blk_sz;
+	if (d->overlay) {
+		for (i = 0; i < nb_segs; off += segs[i++].len) {
+			if (do_read)
+				status = overlay_read(d->overlay, off,
+						      segs[i].buf,
+						      segs[i].len);
+			else
+				status = overlay_write(d->overlay, off,
+						       segs[i].buf,
+						       segs[i].len);
+			if (EFI_ERROR(status))
+				return (off - start * s->blk_sz) / s->blk_sz;
+		}
+		return count;
+	}
+
+	if (d->composite) {
+		for (i = 0; i < nb_segs; off += segs[i++].len) {
+			if (do_read)
+				status = composite_read(d->composite, off,
+							segs[i].buf,
+							segs[i].len);
+			else
+				status = composite_write(d->composite, off,
+							 segs[i].buf,
+							 segs[i].len);
+			if (EFI_ERROR(status))
+				return (off - start * s->blk_sz) / s->blk_sz;
+		}
+		return count;
+	}
+
+	if (d->fd == -1)
+		return 0;
+
+	if (d->map) {
+		for (i = 0; i < nb_segs; off += segs[i++].len) {
+			if (do_read)
+				memcpy(segs[i].buf, d->map + off, segs[i].len);
+			else
+				memcpy(d->map + off, segs[i].buf, segs[i].len);
+		}
+		return count;
+	}
+
+	total = 0;
+	for (; nb_segs; segs += n, nb_segs -= n) {
+		n = nb_segs < DISK_MAX_IOV ? nb_segs : DISK_MAX_IOV;
+		for (i = 0; i < n; i++) {
+			iov[i].iov_base = segs[i].buf;
+			iov[i].iov_len = segs[i].len;
+		}
+
+		for (i = 0; i < n; ) {
+			if (do_read)
+				ret = preadv64(d->fd, iov + i, n - i, off);
+			else
+				ret = pwritev64(d->fd, iov + i, n - i, off);
+
+			if (do_read && ret == 0) {
+				ewerr("End of file detected");
+				return total / s->blk_sz;
+			}
+			if (ret == -1) {
+				ewerr("Failed to %s disk file, %s",
+				      do_read ? "read from" : "write to",
+				      strerror(errno));
+				return total / s->blk_sz;
+			}
+			total += ret;
+			off += ret;
+
+			/* Skip the completed vectors and resume the
+			   partially transferred one. */
+			for (; i < n && (size_t)ret >= iov[i].iov_len; i++)
+				ret -= iov[i].iov_len;
+			if (i < n) {
+				iov[i].iov_base = (char *)iov[i].iov_base + ret;
+				iov[i].iov_len -= ret;
+			}
+		}
+	}
+
+	return total / s->blk_sz;
+}
+
+static EFI_LBA _readv(storage_t *s, EFI_LBA start, EFI_LBA count,
+		      const storage_seg_t *segs, UINTN nb_segs)
+{
+	return readv_or_writev(s, start, count, segs, nb_segs, true);
+}
+
+static EFI_LBA _writev(storage_t *s, EFI_LBA start, EFI_LBA count,
+		       const storage_seg_t *segs, UINTN nb_segs)
+{
+	return readv_or_writev(s, start, count, segs, nb_segs, false);
+}
+
+/* Zero the range in the file system: with ZERO_RANGE which keeps the
+   blocks allocated or, if the file system does not support it, by
+   punching a hole.  EFI_UNSUPPORTED makes the media layer fall back
+   to writing zeroes. */
+static EFI_STATUS _write_zeroes(storage_t *s, EFI_LBA start, EFI_LBA count)
+{
+	static const int MODES[] = {
+		FALLOC_FL_ZERO_RANGE | FALLOC_FL_KEEP_SIZE,
+		FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE
+	};
+	off64_t off, len;
+	disk_t *d;
+
+	if (!s || start + count > s->blk_cnt)
+		return EFI_INVALID_PARAMETER;
+
+	d = s->priv;
+	if (d->overlay)
+		return overlay_zero(d->overlay, start * s->blk_sz,
+				    count * s->blk_sz);
+
+	if (d->composite)
+		return composite_zero(d->composite, start * s->blk_sz,
+				      count * s->blk_sz);
+
+	if (d->fd == -1)
+		return EFI_NOT_STARTED;
+
+	off = start * s->blk_sz;
+	len = count * s->blk_sz;
+	for (; d->zeroes_mode < ARRAY_SIZE(MODES); d->zeroes_mode++) {
+		if (!fallocate64(d->fd, MODES[d->zeroes_mode], off, len))
+			return EFI_SUCCESS;
+
+		if (errno != EOPNOTSUPP) {
+			ewerr("Failed to zero disk file range, %s",
+			      strerror(errno));
+			return EFI_DEVICE_ERROR;
+		}
+	}
+
+	return EFI_UNSUPPORTED;
+}
+
+static EFI_STATUS zero_range(disk_t *d, off64_t off, off64_t len)
+{
+	if (d->map) {
+		memset(d->map + off, 0, len);
+		return EFI_SUCCESS;
+	}
+
+	return fd_write_zeroes(d->fd, off, len, "disk file");
+}
+
+/* Discard the range: the file system blocks it fully covers are
+   released by punching a hole, which reads back as zeroes, and the
+   unaligned edges are zeroed.  If the file system cannot punch
+   holes, the whole range is zeroed. */
+static EFI_STATUS _erase(storage_t *s, EFI_LBA start, UINTN size)
+{
+	off64_t off, end, hole_start, hole_end;
+	EFI_STATUS ret;
+	disk_t *d;
+
+	if (!s || size % s->blk_sz || start + size / s->blk_sz > s->blk_cnt)
+		return EFI_INVALID_PARAMETER;
+
+	d = s->priv;
+	if (d->overlay)
+		return overlay_zero(d->overlay, start * s->blk_sz, size);
+
+	if (d->composite)
+		return composite_zero(d->composite, start * s->blk_sz, size);
+
+	if (d->fd == -1)
+		return EFI_NOT_STARTED;
+
+	off = start * s->blk_sz;
+	end = off + size;
+	hole_start = (off + d->fs_blk_sz - 1) / d->fs_blk_sz * d->fs_blk_sz;
+	hole_end = end / d->fs_blk_sz * d->fs_blk_sz;
+	if (d->punch_unsupported || hole_start >= hole_end)
+		return zero_range(d, off, size);
+
+	if (fallocate64(d->fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+			hole_start, hole_end - hole_start)) {
+		if (errno != EOPNOTSUPP) {
+			ewerr("Failed to punch a hole in the disk file, %s",
+			      strerror(errno));
+			return EFI_DEVICE_ERROR;
+		}
+		d->punch_unsupported = true;
+		return zero_range(d, off, size);
+	}
+
+	ret = zero_range(d, off, hole_start - off);
+	if (EFI_ERROR(ret))
+		return ret;
+
+	return zero_range(d, hole_end, end - hole_end);
+}
+
+/* Copy the range inside the file system, which may share the blocks
+   or use a server side copy.  EFI_UNSUPPORTED makes the media layer
+   copy through memory. */
+static EFI_STATUS _copy(storage_t *s, EFI_LBA src, EFI_LBA dst,
+			EFI_LBA count)
+{
+	loff_t in, out;
+	size_t len;
+	ssize_t ret;
+	disk_t *d;
+
+	if (!s || src + count > s->blk_cnt || dst + count > s->blk_cnt)
+		return EFI_INVALID_PARAMETER;
+
+	d = s->priv;
+	if (d->overlay || d->composite)
+		return EFI_UNSUPPORTED;
+
+	if (d->fd == -1)
+		return EFI_NOT_STARTED;
+
+	if (d->copy_unsupported)
+		return EFI_UNSUPPORTED;
+
+	in = src * s->blk_sz;
+	out = dst * s->blk_sz;
+	for (len = count * s->blk_sz; len; len -= ret) {
+		ret = copy_file_range(d->fd, &in, d->fd, &out, len, 0);
+		if (ret > 0)
+			continue;
+
+		if (ret == -1 && errno == EINTR) {
+			ret = 0;
+			continue;
+		}
+
+		if (ret == -1 && (errno == ENOSYS || errno == EXDEV ||
+				  errno == EOPNOTSUPP || errno == EINVAL)) {
+			d->copy_unsupported = true;
+			return EFI_UNSUPPORTED;
+		}
+
+		ewerr("Failed to copy disk file range, %s",
+		      ret ? strerror(errno) : "unexpected end of file");
+		return EFI_DEVICE_ERROR;
+	}
+
+	return EFI_SUCCESS;
+}
+
+static EFI_STATUS _flush(storage_t *s)
+{
+	disk_t *d;
+
+	if (!s)
+		return EFI_INVALID_PARAMETER;
+
+	d = s->priv;
+	if (d->overlay)
+		return overlay_flush(d->overlay);
+
+	if (d->composite)
+		return composite_flush(d->composite);
+
+	if (!d->map)
+		return EFI_SUCCESS;
+
+	if (msync(d->map, d->map_size, MS_SYNC)) {
+		ewerr("Failed to sync the disk file mapping, %s",
+		      strerror(errno));
+		return EFI_DEVICE_ERROR;
+	}
+
+	return EFI_SUCCESS;
+}
+
+static EFI_STATUS _map(storage_t *s, EFI_LBA start, EFI_LBA count,
+		       const void **addr)
+{
+	disk_t *d;
+
+	if (!s || !addr || start + count > s->blk_cnt)
+		return EFI_INVALID_PARAMETER;
+
+	d = s->priv;
+	if (!d->map_ro)
+		return EFI_UNSUPPORTED;
+
+	*addr = d->map_ro + start * s->blk_sz;
+	return EFI_SUCCESS;
+}
+
+static const storage_t DISK_STORAGE = {
 	.init = _init,
 	.read = _read,
 	.write = _write,
-	.erase = NULL,
-	.pci_function = 0,
-	.pci_device = 0
+	.readv = _readv,
+	.writev = _writev,
+	.write_zeroes = _write_zeroes,
+	.copy = _copy,
+	.flush = _flush,
+	.map = _map,
+	.erase = _erase
 };
 
-static EFI_HANDLE handle;
+/* Release the resources of the D disk, whose storage is either not
+   initialized or already freed. */
+static void free_disk(disk_t *d)
+{
+	timed_req_t *tr;
 
-static EFI_STATUS disk_init(EFI_SYSTEM_TABLE *st)
+	if (d->aio)
+		aio_free(d->aio);
+
+	if (d->direct_fd != -1)
+		close(d->direct_fd);
+
+	unmap_disk(d);
+
+	if (d->overlay)
+		close_overlay(d);
+
+	if (d->composite)
+		composite_close(d->composite);
+
+	while ((tr = d->done)) {
+		d->done = tr->next;
+		free(tr);
+	}
+
+	if (d->timing)
+		timing_free(d->timing);
+
+	if (d->fd != -1)
+		close(d->fd);
+
+	free(d);
+}
+
+/* The SD host I/O protocol only makes sense for eMMC disks. */
+static EFI_STATUS add_disk(EFI_SYSTEM_TABLE *st, const disk_config_t *config)
 {
+	EFI_STATUS ret;
+	disk_t *d;
+
+	d = calloc(1, sizeof(*d));
+	if (!d)
+		return EFI_OUT_OF_RESOURCES;
+
+	d->storage = DISK_STORAGE;
+	d->storage.priv = d;
+	d->storage.type = config->type;
+	d->storage.pci_device = config->pci_device;
+	d->storage.pci_function = config->pci_function;
+	d->config = *config;
+	d->fd = -1;
+	d->direct_fd = -1;
+	disks[nb_disks] = d;
+
+	ret = storage_init(st, &d->storage, &d->handle);
+	if (EFI_ERROR(ret)) {
+		ewerr("Failed to initialize %s disk", config->path);
+		disks[nb_disks] = NULL;
+		free_disk(d);
+		return ret;
+	}
+
+	if (config->type == STORAGE_EMMC) {
+		ret = sdio_init(st, d->handle, &d->storage);
+		if (EFI_ERROR(ret)) {
+			storage_free(st, d->handle);
+			disks[nb_disks] = NULL;
+			free_disk(d);
+			return ret;
+		}
+	}
+
+	ewdbg("%s disk: %llu blocks of %u bytes", config->path,
+	      (unsigned long long)d->storage.blk_cnt, d->storage.blk_sz);
+	nb_disks++;
+	return EFI_SUCCESS;
+}
 
+static EFI_STATUS remove_disk(EFI_SYSTEM_TABLE *st, disk_t *d)
+{
 	EFI_STATUS ret;
 
+	if (d->config.type == STORAGE_EMMC) {
+		ret = sdio_free(st, d->handle);
+		if (EFI_ERROR(ret))
+			return ret;
+	}
+
+	/* The media layer may still flush its block cache. */
+	ret = storage_free(st, d->handle);
+	if (EFI_ERROR(ret))
+		return ret;
+
+	free_disk(d);
+	return EFI_SUCCESS;
+}
+
+static EFI_STATUS disk_exit(EFI_SYSTEM_TABLE *st);
+
+static EFI_STATUS disk_init(EFI_SYSTEM_TABLE *st)
+{
+	EFI_STATUS ret;
+	size_t i;
+
 	if (!st)
 		return EFI_INVALID_PARAMETER;
 
-	if (handle)
+	if (nb_disks)
 		return EFI_ALREADY_STARTED;
 
-	ret = storage_init(st, &disk_storage, &handle);
-	if (EFI_ERROR(ret))
-		return ret;
+	if (!nb_configs)
+		configs[nb_configs++] = DEFAULT_DISK;
 
-	ret = sdio_init(st, handle, &disk_storage);
-	if (EFI_ERROR(ret))
-		storage_free(st, handle);
+	for (i = 0; i < nb_configs; i++) {
+		ret = add_disk(st, &configs[i]);
+		if (EFI_ERROR(ret)) {
+			if (nb_disks)
+				disk_exit(st);
+			return ret;
+		}
+	}
 
-	return ret;
+	return EFI_SUCCESS;
 }
 
 static EFI_STATUS disk_exit(EFI_SYSTEM_TABLE *st)
@@ -206,27 +1211,22 @@ static EFI_STATUS disk_exit(EFI_SYSTEM_TABLE *st)
 	if (!st)
 		return EFI_INVALID_PARAMETER;
 
-	if (!handle)
+	if (!nb_disks)
 		return EFI_NOT_STARTED;
 
-	if (fd != -1)
-		close(fd);
-
-	ret = sdio_free(st, handle);
-	if (EFI_ERROR(ret))
-		return ret;
-
-	ret = storage_free(st, handle);
-	if (EFI_ERROR(ret))
-		return ret;
+	for (; nb_disks; nb_disks--) {
+		ret = remove_disk(st, disks[nb_disks - 1]);
+		if (EFI_ERROR(ret))
+			return ret;
+		disks[nb_disks - 1] = NULL;
+	}
 
-	handle = NULL;
 	return EFI_SUCCESS;
 }
 
 ewdrv_t disk_drv = {
 	.name = "disk",
-	.description = "Emulate eMMC storage",
+	.description = "Emulate eMMC, UFS, NVMe or virtual storage",
 	.init = disk_init,
 	.exit = disk_exit
 };
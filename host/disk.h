@@ -32,8 +32,63 @@
 #ifndef _DISK_H_
 #define _DISK_H_
 
+#include <stdbool.h>
 #include <ewdrv.h>
+#include <storage.h>
+
+#include "aio.h"
+#include "timing.h"
 
 extern ewdrv_t disk_drv;
 
+#define DISK_MAX	8
+
+typedef struct disk_config {
+	/* Disk file, created with SIZE bytes if it does not exist, or
+	   composite disk layout file, see composite.h */
+	const char *path;
+	bool composite;
+	UINT64 size;
+	/* 512 or 4096 */
+	UINT32 blk_sz;
+	enum storage_type type;
+	UINT8 pci_device;
+	UINT8 pci_function;
+} disk_config_t;
+
+/* Emulate one more disk, each gets its own storage handle.  Without
+   any call, a single 12 GiB eMMC disk is backed by ./disk.img.  Must
+   be called before the driver initialization. */
+EFI_STATUS disk_add(const disk_config_t *config);
+
+/* When ENABLED, serve the asynchronous storage requests with the
+   ENGINE AIO engine, up to DEPTH of them in flight, zero for the
+   default.  DIRECT enables O_DIRECT for the aligned requests and
+   FIXED_BUFFERS the io_uring pre-registered buffers.  Must be called
+   before the driver initialization. */
+void disk_set_aio(bool enabled, aio_engine_t engine, unsigned int depth,
+		  bool direct, bool fixed_buffers);
+/* Serve the reads and writes as memory copies against a shared
+   mapping of the disk file, msync() it on flush and let the Mapped
+   Block I/O Protocol hand out pointers into it. */
+void disk_set_mmap(bool enabled);
+/* Use the BASE image, raw, Android sparse or chunked compressed,
+   read-only, as the first disk, under a copy-on-write overlay whose
+   changes are stored in the DELTA file, or in memory if DELTA is
+   NULL.  RESET discards the changes of the previous runs.  At exit,
+   the changes are saved to the SNAPSHOT file if not NULL, then
+   written to BASE if COMMIT is set. */
+void disk_set_overlay(const char *base, const char *delta, bool reset,
+		      const char *snapshot, bool commit);
+/* When ENABLED, run the disk commands through a timing model so that
+   the host disks behave like the emulated devices: PROFILE for all
+   the disks or, if NULL, the profile of each disk type.  VIRTUAL_CLOCK
+   moves the ewperf clock forward instead of waiting and SEED makes
+   the latency outliers reproducible. */
+void disk_set_timing(bool enabled, const timing_profile_t *profile,
+		     bool virtual_clock, unsigned int seed);
+/* Write the RAW, or sparse, image to PATH in the chunked compressed
+   format. */
+EFI_STATUS disk_compress_image(const char *raw, const char *path);
+
 #endif	/* _DISK_H_ */
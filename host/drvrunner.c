@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2026, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <stdlib.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <ewlog.h>
+
+#include "drvrunner.h"
+
+typedef struct job {
+	pthread_t thread;
+	ewdrv_t *drv;
+	EFI_SYSTEM_TABLE *st;
+	EFI_STATUS ret;
+	bool done;
+} job_t;
+
+static pthread_mutex_t drv_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void lock(void)
+{
+	pthread_mutex_lock(&drv_lock);
+}
+
+static void unlock(void)
+{
+	pthread_mutex_unlock(&drv_lock);
+}
+
+static void *run(void *arg)
+{
+	job_t *job = arg;
+	EFI_STATUS ret;
+
+	lock();
+	ret = job->drv->init(job->st);
+	unlock();
+
+	job->ret = ret;
+	__atomic_store_n(&job->done, true, __ATOMIC_RELEASE);
+
+	return NULL;
+}
+
+static EFI_STATUS start(ewdrv_t *drv, EFI_SYSTEM_TABLE *st, void **job_p)
+{
+	job_t *job;
+	int ret;
+
+	job = calloc(1, sizeof(*job));
+	if (!job)
+		return EFI_OUT_OF_RESOURCES;
+
+	job->drv = drv;
+	job->st = st;
+
+	ret = pthread_create(&job->thread, NULL, run, job);
+	if (ret) {
+		ewerr("Failed to create the '%s' driver thread", drv->name);
+		free(job);
+		return EFI_OUT_OF_RESOURCES;
+	}
+
+	*job_p = job;
+	return EFI_SUCCESS;
+}
+
+static EFI_STATUS check(void *arg)
+{
+	job_t *job = arg;
+	EFI_STATUS ret;
+
+	if (!__atomic_load_n(&job->done, __ATOMIC_ACQUIRE))
+		return EFI_NOT_READY;
+
+	pthread_join(job->thread, NULL);
+	ret = job->ret;
+	free(job);
+
+	return ret;
+}
+
+ewdrv_runner_t drvrunner = {
+	.start = start,
+	.check = check,
+	.lock = lock,
+	.unlock = unlock
+};
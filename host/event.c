@@ -32,15 +32,23 @@
 #include <stdlib.h>
 #include <pthread.h>
 #include <ewlog.h>
+#include <errno.h>
 #include <string.h>
+#include <time.h>
+#include <storage.h>
 
 #include "event.h"
 
+/* Interval at which storage completions are polled while asynchronous
+   requests are in flight. */
+#define STORAGE_POLL_INTERVAL_NS	100000
+
 typedef struct event {
 	UINT32 type;
 	EFI_TPL tpl;
 	EFI_EVENT_NOTIFY notify;
 	VOID *context;
+	BOOLEAN signaled;
 	pthread_mutex_t lock;
 	pthread_cond_t cond;
 } event_t;
@@ -77,6 +85,7 @@ create_event(UINT32 Type,
 	event->tpl = NotifyTpl;
 	event->notify = NotifyFunction;
 	event->context = NotifyContext;
+	event->signaled = FALSE;
 	if (event->type != EVT_NOTIFY_SIGNAL) {
 		ret = pthread_mutex_init(&event->lock, NULL);
 		if (ret)
@@ -113,6 +122,8 @@ wait_for_event(UINTN NumberOfEvents,
 	event_t *event;
 	int ret;
 	pthread_t thread_notify;
+	struct timespec deadline;
+	BOOLEAN pending;
 
 	if (!Event || !Index)
 		return EFI_INVALID_PARAMETER;
@@ -128,7 +139,7 @@ wait_for_event(UINTN NumberOfEvents,
 	if (ret)
 		return EFI_DEVICE_ERROR;
 
-	if (event->type == EVT_NOTIFY_WAIT) {
+	if (!event->signaled && event->type == EVT_NOTIFY_WAIT) {
 		ret = pthread_create(&thread_notify, NULL, call_notify, event);
 		if (ret) {
 			pthread_mutex_unlock(&event->lock);
@@ -139,13 +150,35 @@ wait_for_event(UINTN NumberOfEvents,
 			ewdbg("Fail to detach notify thread");
 	}
 
-        ret = pthread_cond_wait(&event->cond, &event->lock);
-	if (ret) {
+	while (!event->signaled) {
+		/* Storage completions signal events: poll unlocked. */
 		pthread_mutex_unlock(&event->lock);
-		return EFI_DEVICE_ERROR;
+		pending = storage_poll() == EFI_NOT_READY;
+		pthread_mutex_lock(&event->lock);
+		if (event->signaled)
+			break;
+
+		if (pending) {
+			clock_gettime(CLOCK_REALTIME, &deadline);
+			deadline.tv_nsec += STORAGE_POLL_INTERVAL_NS;
+			if (deadline.tv_nsec >= 1000000000) {
+				deadline.tv_sec++;
+				deadline.tv_nsec -= 1000000000;
+			}
+			ret = pthread_cond_timedwait(&event->cond, &event->lock,
+						     &deadline);
+			if (ret == ETIMEDOUT)
+				ret = 0;
+		} else
+			ret = pthread_cond_wait(&event->cond, &event->lock);
+		if (ret) {
+			pthread_mutex_unlock(&event->lock);
+			return EFI_DEVICE_ERROR;
+		}
 	}
+	event->signaled = FALSE;
 
-        ret = pthread_mutex_unlock(&event->lock);
+	ret = pthread_mutex_unlock(&event->lock);
 	if (ret)
 		return EFI_DEVICE_ERROR;
 
@@ -172,7 +205,8 @@ signal_event(EFI_EVENT Event)
 	if (ret)
 		return EFI_DEVICE_ERROR;
 
-	ret = pthread_cond_signal(&event->cond);
+	event->signaled = TRUE;
+	ret = pthread_cond_broadcast(&event->cond);
 	if (ret) {
 		pthread_mutex_unlock(&event->lock);
 		return EFI_DEVICE_ERROR;
@@ -193,9 +227,40 @@ close_event(EFI_EVENT Event)
 }
 
 static EFIAPI EFI_STATUS
-check_event(__attribute__((__unused__)) EFI_EVENT Event)
+check_event(EFI_EVENT Event)
 {
-	return EFI_UNSUPPORTED;
+	event_t *event = (event_t *)Event;
+	EFI_STATUS status;
+	int ret;
+
+	if (!Event || event->type == EVT_NOTIFY_SIGNAL)
+		return EFI_INVALID_PARAMETER;
+
+	storage_poll();
+
+	ret = pthread_mutex_lock(&event->lock);
+	if (ret)
+		return EFI_DEVICE_ERROR;
+
+	/* Give the producer a chance to signal the event, as
+	   wait_for_event() does.  The notify function may signal the
+	   event so it is called unlocked. */
+	if (!event->signaled && event->type == EVT_NOTIFY_WAIT) {
+		pthread_mutex_unlock(&event->lock);
+		event->notify(Event, event->context);
+		ret = pthread_mutex_lock(&event->lock);
+		if (ret)
+			return EFI_DEVICE_ERROR;
+	}
+
+	status = event->signaled ? EFI_SUCCESS : EFI_NOT_READY;
+	event->signaled = FALSE;
+
+	ret = pthread_mutex_unlock(&event->lock);
+	if (ret)
+		return EFI_DEVICE_ERROR;
+
+	return status;
 }
 
 static EFI_CREATE_EVENT saved_create_event;
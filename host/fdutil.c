@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2026, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define _GNU_SOURCE
+#define _LARGEFILE64_SOURCE
+#include <ewlib.h>
+#include <ewlog.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "fdutil.h"
+
+EFI_STATUS fd_pread_full(int fd, void *buf, size_t len, uint64_t off,
+			 const char *what)
+{
+	ssize_t ret;
+
+	for (; len; len -= ret, off += ret, buf = (char *)buf + ret) {
+		ret = pread64(fd, buf, len, off);
+		if (ret > 0)
+			continue;
+		if (ret == -1 && errno == EINTR) {
+			ret = 0;
+			continue;
+		}
+		ewerr("Failed to read %s, %s", what,
+		      ret ? strerror(errno) : "unexpected end of file");
+		return EFI_DEVICE_ERROR;
+	}
+
+	return EFI_SUCCESS;
+}
+
+EFI_STATUS fd_pwrite_full(int fd, const void *buf, size_t len, uint64_t off,
+			  const char *what)
+{
+	ssize_t ret;
+
+	for (; len; len -= ret, off += ret, buf = (const char *)buf + ret) {
+		ret = pwrite64(fd, buf, len, off);
+		if (ret > 0)
+			continue;
+		if (ret == -1 && errno == EINTR) {
+			ret = 0;
+			continue;
+		}
+		ewerr("Failed to write %s, %s", what, strerror(errno));
+		return EFI_DEVICE_ERROR;
+	}
+
+	return EFI_SUCCESS;
+}
+
+EFI_STATUS fd_write_full(int fd, const void *buf, size_t len,
+			 const char *what)
+{
+	ssize_t ret;
+
+	for (; len; len -= ret, buf = (const char *)buf + ret) {
+		ret = write(fd, buf, len);
+		if (ret > 0)
+			continue;
+		if (ret == -1 && errno == EINTR) {
+			ret = 0;
+			continue;
+		}
+		ewerr("Failed to write %s, %s", what, strerror(errno));
+		return EFI_DEVICE_ERROR;
+	}
+
+	return EFI_SUCCESS;
+}
+
+EFI_STATUS fd_write_zeroes(int fd, uint64_t off, uint64_t len,
+			   const char *what)
+{
+	static const unsigned char zeroes[4096];
+	EFI_STATUS ret;
+	size_t n;
+
+	for (; len; len -= n, off += n) {
+		n = min(len, (uint64_t)sizeof(zeroes));
+		ret = fd_pwrite_full(fd, zeroes, n, off, what);
+		if (EFI_ERROR(ret))
+			return ret;
+	}
+
+	return EFI_SUCCESS;
+}
@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2026, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _FDUTIL_H_
+#define _FDUTIL_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <efi.h>
+#include <efiapi.h>
+
+/* Transfer exactly LEN bytes, retrying on interruptions and short
+   transfers.  A failure, including an unexpected end of file, is
+   reported with WHAT as the name of the file. */
+EFI_STATUS fd_pread_full(int fd, void *buf, size_t len, uint64_t off,
+			 const char *what);
+EFI_STATUS fd_pwrite_full(int fd, const void *buf, size_t len, uint64_t off,
+			  const char *what);
+/* From the current file offset */
+EFI_STATUS fd_write_full(int fd, const void *buf, size_t len,
+			 const char *what);
+/* Write LEN zero bytes at OFF */
+EFI_STATUS fd_write_zeroes(int fd, uint64_t off, uint64_t len,
+			   const char *what);
+
+#endif	/* _FDUTIL_H_ */
@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2026, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <ewlog.h>
+#include <ewperf.h>
+
+#include "boottime.h"
+#include "fdutil.h"
+#include "fpdt.h"
+
+static const char *path;
+static BOOLEAN written;
+static EFI_SYSTEM_TABLE *saved_st;
+static EFI_EXIT_BOOT_SERVICES saved_exit_boot_services;
+
+void fpdt_set_path(const char *p)
+{
+	path = p;
+}
+
+static EFI_STATUS write_fbpt(void)
+{
+	EFI_STATUS ret;
+	UINTN size;
+	void *fbpt;
+	int fd;
+
+	ret = ewperf_build_fbpt(&fbpt, &size);
+	if (EFI_ERROR(ret))
+		return ret;
+
+	fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd == -1) {
+		ewerr("Failed to open %s, %s", path, strerror(errno));
+		ret = EFI_DEVICE_ERROR;
+		goto out;
+	}
+
+	ret = fd_write_full(fd, fbpt, size, path);
+	close(fd);
+	if (!EFI_ERROR(ret))
+		written = TRUE;
+
+out:
+	free(fbpt);
+	return ret;
+}
+
+static EFIAPI EFI_STATUS
+exit_boot_services(EFI_HANDLE ImageHandle, UINTN MapKey)
+{
+	EFI_STATUS ret;
+
+	ewperf_boot_step(EWPERF_EXIT_BOOT_SERVICES_ENTRY);
+	ret = uefi_call_wrapper(saved_exit_boot_services, 2,
+				ImageHandle, MapKey);
+	if (EFI_ERROR(ret))
+		return ret;
+	ewperf_boot_step(EWPERF_EXIT_BOOT_SERVICES_EXIT);
+
+	write_fbpt();
+
+	return ret;
+}
+
+static EFI_STATUS fpdt_init(EFI_SYSTEM_TABLE *st)
+{
+	if (!st)
+		return EFI_INVALID_PARAMETER;
+
+	/* The table is only written when a path has been given with
+	   the --fpdt option. */
+	if (!path)
+		return EFI_SUCCESS;
+
+	if (!ewperf_get_tsc_freq())
+		boottime_calibrate_tsc();
+
+	saved_st = st;
+	saved_exit_boot_services = st->BootServices->ExitBootServices;
+	st->BootServices->ExitBootServices = exit_boot_services;
+
+	return EFI_SUCCESS;
+}
+
+static EFI_STATUS fpdt_exit(EFI_SYSTEM_TABLE *st)
+{
+	if (!st)
+		return EFI_INVALID_PARAMETER;
+
+	if (!saved_st)
+		return EFI_SUCCESS;
+
+	st->BootServices->ExitBootServices = saved_exit_boot_services;
+	saved_st = NULL;
+
+	/* The EFI binary did not call ExitBootServices() */
+	if (!written)
+		return write_fbpt();
+
+	return EFI_SUCCESS;
+}
+
+ewdrv_t fpdt_drv = {
+	.name = "fpdt",
+	.description = "Write the boot performance records to a file",
+	.init = fpdt_init,
+	.exit = fpdt_exit
+};
@@ -70,6 +70,15 @@ get_time(EFI_TIME *Time,
 	return EFI_SUCCESS;
 }
 
+/* The platform dependant ndelay() (cf. external.h), used by the
+   driver scheduler to idle between two polling rounds. */
+void ndelay(unsigned int n)
+{
+	struct timespec delay = { n / 1000000000, n % 1000000000 };
+
+	nanosleep(&delay, NULL);
+}
+
 static EFI_STATUS time_init(EFI_SYSTEM_TABLE *st)
 {
 	if (!st)
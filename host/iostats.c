@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2026, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <ewlib.h>
+#include <ewperf.h>
+#include <protocol/MediaStats.h>
+
+#include "iostats.h"
+
+static const char *OP_NAMES[] = {
+	[MediaStatsRead] = "read",
+	[MediaStatsWrite] = "write",
+	[MediaStatsErase] = "erase",
+	[MediaStatsFlush] = "flush"
+};
+
+/* Format the 2^SHIFT power with a binary unit suffix */
+static const char *pow2_str(char *buf, size_t size, unsigned shift)
+{
+	static const char *SUFFIXES[] = { "", "K", "M", "G" };
+
+	if (shift / 10 >= ARRAY_SIZE(SUFFIXES))
+		snprintf(buf, size, "2^%u", shift);
+	else
+		snprintf(buf, size, "%llu%s", 1ULL << (shift % 10),
+			 SUFFIXES[shift / 10]);
+
+	return buf;
+}
+
+static void print_histogram(FILE *out, const char *name, const char *unit,
+			    const UINT64 *buckets, unsigned nb_buckets)
+{
+	char low[16], high[16];
+	unsigned i;
+
+	fprintf(out, "    %s:\n", name);
+	for (i = 0; i < nb_buckets; i++) {
+		if (!buckets[i])
+			continue;
+
+		if (i == nb_buckets - 1)
+			fprintf(out, "      >= %s%s", pow2_str(low, sizeof(low), i),
+				unit);
+		else
+			fprintf(out, "      [%s, %s[%s",
+				i ? pow2_str(low, sizeof(low), i) : "0",
+				pow2_str(high, sizeof(high), i + 1), unit);
+		fprintf(out, ": %llu\n", (unsigned long long)buckets[i]);
+	}
+}
+
+static void print_op(FILE *out, const char *name,
+		     const EFIWRAPPER_MEDIA_OP_STATS *op)
+{
+	fprintf(out, "  %s: %llu requests, %llu errors, %llu bytes", name,
+		(unsigned long long)op->Count,
+		(unsigned long long)op->Errors,
+		(unsigned long long)op->Bytes);
+	if (ewperf_get_tsc_freq())
+		fprintf(out, ", latency avg %llu us max %llu us",
+			(unsigned long long)(op->TotalLatency / op->Count),
+			(unsigned long long)op->MaxLatency);
+	fprintf(out, "\n");
+	if (op->Bytes)
+		print_histogram(out, "size", "B", op->SizeHistogram,
+				EFIWRAPPER_MEDIA_STATS_SIZE_BUCKETS);
+	if (ewperf_get_tsc_freq())
+		print_histogram(out, "latency", "us", op->LatencyHistogram,
+				EFIWRAPPER_MEDIA_STATS_LATENCY_BUCKETS);
+}
+
+void iostats_report(EFI_SYSTEM_TABLE *st, FILE *out)
+{
+	EFI_GUID media_stats_guid = EFIWRAPPER_MEDIA_STATS_PROTOCOL_GUID;
+	EFI_GUID blockio_guid = BLOCK_IO_PROTOCOL;
+	EFIWRAPPER_MEDIA_STATS_PROTOCOL *media_stats;
+	EFIWRAPPER_MEDIA_STATS stats;
+	EFI_BLOCK_IO *blockio;
+	EFI_HANDLE *handles;
+	UINTN nb_handles, i, op;
+	EFI_STATUS ret;
+
+	ret = uefi_call_wrapper(st->BootServices->LocateHandleBuffer, 5,
+				ByProtocol, &media_stats_guid, NULL,
+				&nb_handles, &handles);
+	if (EFI_ERROR(ret))
+		return;
+
+	for (i = 0; i < nb_handles; i++) {
+		ret = uefi_call_wrapper(st->BootServices->HandleProtocol, 3,
+					handles[i], &media_stats_guid,
+					(VOID **)&media_stats);
+		if (EFI_ERROR(ret))
+			continue;
+
+		ret = uefi_call_wrapper(media_stats->GetStats, 2,
+					media_stats, &stats);
+		if (EFI_ERROR(ret))
+			continue;
+
+		ret = uefi_call_wrapper(st->BootServices->HandleProtocol, 3,
+					handles[i], &blockio_guid,
+					(VOID **)&blockio);
+		if (EFI_ERROR(ret))
+			fprintf(out, "I/O statistics of media %p\n", handles[i]);
+		else
+			fprintf(out, "I/O statistics of media %u, %u bytes "
+				"blocks, %llu blocks\n",
+				blockio->Media->MediaId,
+				blockio->Media->BlockSize,
+				(unsigned long long)blockio->Media->LastBlock + 1);
+
+		for (op = 0; op < MediaStatsOpMax; op++)
+			if (stats.Op[op].Count)
+				print_op(out, OP_NAMES[op], &stats.Op[op]);
+	}
+
+	uefi_call_wrapper(st->BootServices->FreePool, 1, handles);
+}
@@ -41,6 +41,7 @@
 #include <libgen.h>
 #include <ewlog.h>
 #include <ewlib.h>
+#include <ewperf.h>
 #include <setjmp.h>
 #include <string.h>
 #include <errno.h>
@@ -57,6 +58,12 @@
 #include "image.h"
 #include "host_time.h"
 #include "terminal_curses.h"
+#include "serial.h"
+#include "drvrunner.h"
+#include "boottime.h"
+#include "fpdt.h"
+#include "iostats.h"
+#include "trace.h"
 
 static ewdrv_t *host_drivers[] = {
 	&disk_drv,
@@ -67,6 +74,8 @@ static ewdrv_t *host_drivers[] = {
 	&image_drv,
 	&time_drv,
 	&terminal_curses_drv,
+	&serial_drv,
+	&fpdt_drv,
 	NULL
 };
 ewdrv_t **ew_drivers = host_drivers;
@@ -75,6 +84,10 @@ typedef EFI_STATUS (*efi_main_t)(EFI_HANDLE image, EFI_SYSTEM_TABLE *st);
 static jmp_buf jmp;
 static EFI_STATUS reset_status;
 static char *cmdname;
+static bool boot_time;
+static bool io_stats;
+static const char *replay_path;
+static trace_replay_config_t replay_config;
 
 static EFIAPI EFI_STATUS
 reset_system(__attribute__((__unused__)) EFI_RESET_TYPE ResetType,
@@ -186,6 +199,7 @@ static EFI_STATUS load_and_execute(const char *path,
 	UINTN size;
 	int setjmpret;
 
+	ewperf_boot_step(EWPERF_LOAD_IMAGE);
 	ret = load_file(path, &data, &size);
 	if (EFI_ERROR(ret))
 		return ret;
@@ -207,6 +221,7 @@ static EFI_STATUS load_and_execute(const char *path,
 		goto exit;
 
 	setjmpret = setjmp(jmp);
+	ewperf_boot_step(EWPERF_START_IMAGE);
 	if (setjmpret == 0)
 		ret = uefi_call_wrapper(st->BootServices->StartImage, 3,
 					image, NULL, NULL);
@@ -224,10 +239,58 @@ static void usage(int ret) __attribute__ ((noreturn));
 static void usage(int ret)
 {
 	printf("Usage: %s [OPTIONS] <EFI binary> [ARGS]\n", cmdname);
+	printf("       %s [OPTIONS] --replay=TRACE[,...]\n", cmdname);
 	printf(" OPTIONS:\n");
 	printf(" -h,--help                      Print this help\n");
 	printf(" --list-drivers                 List available drivers\n");
 	printf(" --disable-drivers=DRV1,DRV2    Disable drivers DRV1 and DRV2\n");
+	printf(" --serial=stdin|pty|PATH        Read serial and console input from\n");
+	printf("                                stdin, a new pseudo-terminal or PATH\n");
+	printf(" --boot-time                    Print the components and drivers\n");
+	printf("                                boot-time breakdown at exit\n");
+	printf(" --fpdt=PATH                    Write the Firmware Basic Boot\n");
+	printf("                                Performance Table to PATH\n");
+	printf(" --io-stats                     Print the storage I/O statistics\n");
+	printf("                                at exit\n");
+	printf(" --trace=PATH                   Record the storage requests to the\n");
+	printf("                                PATH I/O trace\n");
+	printf(" --replay=TRACE[,device=N][,target=N][,fast][,write]\n");
+	printf("                                Replay the requests of the N-th\n");
+	printf("                                device of TRACE on the N-th storage\n");
+	printf("                                device, back to back, with the\n");
+	printf("                                writes and erases, report their\n");
+	printf("                                throughput and latency and exit\n");
+	printf(" --disk=PATH[,size=N[K|M|G]][,blk=512|4096][,type=TYPE][,pci=DEV.FUNC][,composite]\n");
+	printf("                                Emulate a disk backed by PATH, of\n");
+	printf("                                emmc (default), ufs, nvme or virtual\n");
+	printf("                                TYPE, can be repeated.  With\n");
+	printf("                                composite, PATH is a partition\n");
+	printf("                                layout and the GPT is synthesised\n");
+	printf(" --disk-config=FILE             Emulate the disks listed in FILE, one\n");
+	printf("                                --disk specification per line\n");
+	printf(" --disk-aio=ENGINE[,qd=N][,direct][,fixed]\n");
+	printf("                                Disk asynchronous I/O engine: uring\n");
+	printf("                                (default), threads or none, queue\n");
+	printf("                                depth, O_DIRECT and io_uring fixed\n");
+	printf("                                buffers\n");
+	printf(" --disk-mmap                    Map the disk file in memory\n");
+	printf(" --disk-overlay=BASE[,delta=PATH][,reset][,snapshot=PATH][,commit]\n");
+	printf("                                Use the BASE image under a\n");
+	printf("                                copy-on-write overlay stored in\n");
+	printf("                                PATH or in memory, discard it first,\n");
+	printf("                                save it and write it to BASE at exit\n");
+	printf(" --disk-timing=PROFILE[,virtual][,seed=N][,OPTION=VALUE...]\n");
+	printf("                                Delay the disk commands like an\n");
+	printf("                                emmc, ufs or nvme PROFILE device, or\n");
+	printf("                                auto to follow the disk type, or\n");
+	printf("                                account for them on a virtual\n");
+	printf("                                clock.  OPTION refines PROFILE: qd,\n");
+	printf("                                OP-lat in us, OP-bw in MB/s where OP\n");
+	printf("                                is read, write, erase or flush, and\n");
+	printf("                                outliers=PPM:US\n");
+	printf(" --compress-image=IN,OUT        Write the raw or sparse IN disk image\n");
+	printf("                                to OUT in the chunked compressed\n");
+	printf("                                format and exit\n");
 	exit(ret);
 }
 
@@ -289,6 +352,386 @@ static void disable_drivers(char *names)
 	}
 }
 
+static void set_serial(char *src)
+{
+	if (!*src)
+		error("--serial requires 'stdin', 'pty' or a path\n");
+
+	serial_set_source(src);
+}
+
+static void set_fpdt(char *path)
+{
+	if (!*path)
+		error("--fpdt requires a path\n");
+
+	fpdt_set_path(path);
+}
+
+static void set_boot_time(__attribute__((__unused__)) char *arg)
+{
+	boot_time = true;
+}
+
+static void set_io_stats(__attribute__((__unused__)) char *arg)
+{
+	io_stats = true;
+	/* Latencies are converted to microseconds as they are
+	   recorded */
+	if (!ewperf_get_tsc_freq())
+		boottime_calibrate_tsc();
+}
+
+static void set_trace(char *path)
+{
+	EFI_STATUS ret;
+
+	if (!*path)
+		error("--trace requires a path\n");
+
+	/* Timestamps are converted to nanoseconds as they are
+	   recorded */
+	if (!ewperf_get_tsc_freq())
+		boottime_calibrate_tsc();
+
+	ret = trace_start(path);
+	if (EFI_ERROR(ret))
+		error("Failed to start the I/O trace\n");
+}
+
+static void set_replay(char *spec)
+{
+	char *saveptr, *opt, *end;
+	unsigned long value;
+
+	replay_path = strtok_r(spec, ",", &saveptr);
+	if (!replay_path)
+		error("--replay requires a trace\n");
+
+	while ((opt = strtok_r(NULL, ",", &saveptr))) {
+		if (!strncmp(opt, "device=", 7)) {
+			value = strtoul(opt + 7, &end, 10);
+			if (*end || value > UINT8_MAX)
+				error("Invalid '%s' trace device\n", opt + 7);
+			replay_config.device = value;
+		} else if (!strncmp(opt, "target=", 7)) {
+			value = strtoul(opt + 7, &end, 10);
+			if (*end)
+				error("Invalid '%s' replay target\n", opt + 7);
+			replay_config.target = value;
+		} else if (!strcmp(opt, "fast"))
+			replay_config.fast = true;
+		else if (!strcmp(opt, "write"))
+			replay_config.writes = true;
+		else
+			error("Unknown '%s' replay option\n", opt);
+	}
+}
+
+static void set_disk_aio(char *spec)
+{
+	static const char *ENGINES[] = {
+		[AIO_URING] = "uring",
+		[AIO_THREADS] = "threads"
+	};
+	char *saveptr, *opt, *end;
+	bool enabled = true, direct = false, fixed = false;
+	aio_engine_t engine = AIO_URING;
+	unsigned long depth = 0;
+	size_t i;
+
+	opt = strtok_r(spec, ",", &saveptr);
+	if (!opt)
+		error("--disk-aio requires an engine\n");
+
+	if (!strcmp(opt, "none"))
+		enabled = false;
+	else {
+		for (i = 0; i < ARRAY_SIZE(ENGINES); i++)
+			if (!strcmp(opt, ENGINES[i]))
+				break;
+		if (i == ARRAY_SIZE(ENGINES))
+			error("Unknown '%s' disk AIO engine\n", opt);
+		engine = i;
+	}
+
+	while ((opt = strtok_r(NULL, ",", &saveptr))) {
+		if (!strncmp(opt, "qd=", 3)) {
+			depth = strtoul(opt + 3, &end, 10);
+			if (*end || !depth || depth > 4096)
+				error("Invalid '%s' disk queue depth\n", opt + 3);
+		} else if (!strcmp(opt, "direct"))
+			direct = true;
+		else if (!strcmp(opt, "fixed"))
+			fixed = true;
+		else
+			error("Unknown '%s' disk AIO option\n", opt);
+	}
+
+	disk_set_aio(enabled, engine, depth, direct, fixed);
+}
+
+static UINT64 parse_size(const char *str)
+{
+	UINT64 size;
+	char *end;
+
+	size = strtoull(str, &end, 0);
+	switch (*end) {
+	case 'G':
+		size *= 1024;
+		/* fall through */
+	case 'M':
+		size *= 1024;
+		/* fall through */
+	case 'K':
+		size *= 1024;
+		end++;
+	}
+
+	if (*end || !size)
+		error("Invalid '%s' disk size\n", str);
+
+	return size;
+}
+
+static void add_disk(char *spec)
+{
+	static const char *TYPES[] = {
+		[STORAGE_EMMC] = "emmc",
+		[STORAGE_UFS] = "ufs",
+		[STORAGE_NVME] = "nvme",
+		[STORAGE_VIRTUAL] = "virtual"
+	};
+	disk_config_t config = {
+		.size = (UINT64)12 * 1024 * 1024 * 1024,
+		.blk_sz = 512,
+		.type = STORAGE_EMMC
+	};
+	char *saveptr, *opt, *end;
+	unsigned long dev, func;
+	size_t i;
+
+	config.path = strtok_r(spec, ",", &saveptr);
+	if (!config.path)
+		error("--disk requires a path\n");
+
+	while ((opt = strtok_r(NULL, ",", &saveptr))) {
+		if (!strncmp(opt, "size=", 5))
+			config.size = parse_size(opt + 5);
+		else if (!strncmp(opt, "blk=", 4)) {
+			config.blk_sz = strtoul(opt + 4, &end, 10);
+			if (*end || (config.blk_sz != 512 && config.blk_sz != 4096))
+				error("Invalid '%s' disk block size\n", opt + 4);
+		} else if (!strncmp(opt, "type=", 5)) {
+			for (i = 0; i < ARRAY_SIZE(TYPES); i++)
+				if (TYPES[i] && !strcmp(opt + 5, TYPES[i]))
+					break;
+			if (i == ARRAY_SIZE(TYPES))
+				error("Unknown '%s' disk type\n", opt + 5);
+			config.type = i;
+		} else if (!strncmp(opt, "pci=", 4)) {
+			dev = strtoul(opt + 4, &end, 16);
+			if (*end != '.')
+				error("Invalid '%s' disk PCI address\n", opt + 4);
+			func = strtoul(end + 1, &end, 16);
+			if (*end || dev > 0x1f || func > 7)
+				error("Invalid '%s' disk PCI address\n", opt + 4);
+			config.pci_device = dev;
+			config.pci_function = func;
+		} else if (!strcmp(opt, "composite"))
+			config.composite = true;
+		else
+			error("Unknown '%s' disk option\n", opt);
+	}
+
+	if (config.size % config.blk_sz)
+		error("%s disk size is not a multiple of its block size\n",
+		      config.path);
+
+	if (EFI_ERROR(disk_add(&config)))
+		error("Too many disks, at most %d are supported\n", DISK_MAX);
+}
+
+/* Each line of the configuration file is a --disk specification,
+   empty lines and lines starting with '#' are ignored.  The lines are
+   kept since the disk configurations point to them. */
+static void load_disk_config(char *path)
+{
+	char *line = NULL, *end;
+	size_t len = 0;
+	FILE *file;
+
+	file = fopen(path, "r");
+	if (!file)
+		error("Failed to open %s disk configuration file, %s\n",
+		      path, strerror(errno));
+
+	while (getline(&line, &len, file) != -1) {
+		end = line + strcspn(line, "\r\n");
+		*end = '\0';
+		if (*line && *line != '#')
+			add_disk(line);
+		else
+			free(line);
+		line = NULL;
+		len = 0;
+	}
+
+	free(line);
+	fclose(file);
+}
+
+static void set_disk_mmap(__attribute__((__unused__)) char *arg)
+{
+	disk_set_mmap(true);
+}
+
+static void set_disk_overlay(char *spec)
+{
+	char *saveptr, *opt, *base, *delta = NULL, *snapshot = NULL;
+	bool reset = false, commit = false;
+
+	base = strtok_r(spec, ",", &saveptr);
+	if (!base)
+		error("--disk-overlay requires a base image\n");
+
+	while ((opt = strtok_r(NULL, ",", &saveptr))) {
+		if (!strncmp(opt, "delta=", 6) && opt[6])
+			delta = opt + 6;
+		else if (!strncmp(opt, "snapshot=", 9) && opt[9])
+			snapshot = opt + 9;
+		else if (!strcmp(opt, "reset"))
+			reset = true;
+		else if (!strcmp(opt, "commit"))
+			commit = true;
+		else
+			error("Unknown '%s' disk overlay option\n", opt);
+	}
+
+	disk_set_overlay(base, delta, reset, snapshot, commit);
+}
+
+static UINT32 parse_timing_value(const char *str)
+{
+	unsigned long value;
+	char *end;
+
+	value = strtoul(str, &end, 10);
+	if (*end || value > UINT32_MAX)
+		error("Invalid '%s' disk timing value\n", str);
+
+	return value;
+}
+
+static void set_disk_timing(char *spec)
+{
+	static const char *OPS[] = {
+		[TIMING_READ] = "read",
+		[TIMING_WRITE] = "write",
+		[TIMING_ERASE] = "erase",
+		[TIMING_FLUSH] = "flush"
+	};
+	static timing_profile_t profile;
+	const timing_profile_t *builtin = NULL;
+	char *saveptr, *opt, *value, *end;
+	bool virtual_clock = false;
+	unsigned int seed = 0;
+	size_t i, len;
+
+	opt = strtok_r(spec, ",", &saveptr);
+	if (!opt)
+		error("--disk-timing requires a profile\n");
+
+	if (strcmp(opt, "auto")) {
+		builtin = timing_get_profile(opt);
+		if (!builtin)
+			error("Unknown '%s' disk timing profile\n", opt);
+		profile = *builtin;
+	}
+
+	while ((opt = strtok_r(NULL, ",", &saveptr))) {
+		if (!strcmp(opt, "virtual")) {
+			virtual_clock = true;
+			continue;
+		}
+
+		value = strchr(opt, '=');
+		if (!value)
+			error("Unknown '%s' disk timing option\n", opt);
+		*value++ = '\0';
+
+		if (!strcmp(opt, "seed")) {
+			seed = parse_timing_value(value);
+			continue;
+		}
+
+		/* The other options refine a built-in profile */
+		if (!builtin)
+			error("'%s' disk timing option requires a profile\n",
+			      opt);
+
+		if (!strcmp(opt, "qd")) {
+			profile.queue_depth = parse_timing_value(value);
+			if (!profile.queue_depth || profile.queue_depth > 4096)
+				error("Invalid '%s' disk timing queue depth\n",
+				      value);
+			continue;
+		}
+
+		if (!strcmp(opt, "outliers")) {
+			profile.outlier_rate = strtoul(value, &end, 10);
+			if (*end != ':')
+				error("Invalid '%s' disk timing outliers\n",
+				      value);
+			profile.outlier_latency = parse_timing_value(end + 1);
+			continue;
+		}
+
+		for (i = 0; i < ARRAY_SIZE(OPS); i++) {
+			len = strlen(OPS[i]);
+			if (strncmp(opt, OPS[i], len))
+				continue;
+			if (!strcmp(opt + len, "-lat")) {
+				profile.latency[i] = parse_timing_value(value);
+				break;
+			}
+			if (!strcmp(opt + len, "-bw")) {
+				profile.bandwidth[i] = parse_timing_value(value);
+				break;
+			}
+		}
+		if (i == ARRAY_SIZE(OPS))
+			error("Unknown '%s' disk timing option\n", opt);
+	}
+
+	/* The virtual clock is converted in TSC ticks */
+	if (virtual_clock && !ewperf_get_tsc_freq())
+		boottime_calibrate_tsc();
+
+	disk_set_timing(true, builtin ? &profile : NULL, virtual_clock, seed);
+}
+
+static void compress_image(char *spec) __attribute__ ((noreturn));
+static void compress_image(char *spec)
+{
+	char *saveptr, *raw, *path;
+	EFI_STATUS ret;
+
+	raw = strtok_r(spec, ",", &saveptr);
+	path = strtok_r(NULL, ",", &saveptr);
+	if (!raw || !path || strtok_r(NULL, ",", &saveptr))
+		error("--compress-image requires an input and an output image\n");
+
+	ret = disk_compress_image(raw, path);
+	if (EFI_ERROR(ret)) {
+		ewerr("Failed to compress %s disk image", raw);
+		exit(EXIT_FAILURE);
+	}
+
+	exit(EXIT_SUCCESS);
+}
+
 static struct option {
 	const char *name;
 	bool has_argument;
@@ -297,7 +740,20 @@ static struct option {
 	{ "-h", false, help },
 	{ "--help", false, help },
 	{ "--list-drivers", false, list_drivers },
-	{ "--disable-drivers", true, disable_drivers }
+	{ "--disable-drivers", true, disable_drivers },
+	{ "--serial", true, set_serial },
+	{ "--boot-time", false, set_boot_time },
+	{ "--fpdt", true, set_fpdt },
+	{ "--io-stats", false, set_io_stats },
+	{ "--trace", true, set_trace },
+	{ "--replay", true, set_replay },
+	{ "--disk", true, add_disk },
+	{ "--disk-config", true, load_disk_config },
+	{ "--disk-aio", true, set_disk_aio },
+	{ "--disk-mmap", false, set_disk_mmap },
+	{ "--disk-overlay", true, set_disk_overlay },
+	{ "--disk-timing", true, set_disk_timing },
+	{ "--compress-image", true, compress_image }
 };
 
 static struct option *get_option(char *name, char **arg)
@@ -354,9 +810,10 @@ int main(int argc, char **argv)
 	EFI_STATUS ret;
 
 	cmdname = basename(argv[0]);
+	boottime_set_clock();
 
 	parse_options(&argc, &argv);
-	if (argc < 2)
+	if (argc < 2 && !replay_path)
 		error("Not enough parameter\n");
 
 	ret = efiwrapper_init(argc - 1, argv + 1, &st, &image);
@@ -365,24 +822,43 @@ int main(int argc, char **argv)
 		return EXIT_FAILURE;
 	}
 
+	ret = ewdrv_set_runner(&drvrunner);
+	if (EFI_ERROR(ret))
+		ewdbg("Drivers will be initialized sequentially");
+
 	ret = ewdrv_init(st);
 	if (ret) {
 		ewerr("drivers initialization failed");
 		return EXIT_FAILURE;
 	}
 
-	ret = load_and_execute(argv[1], image, st);
-	if (EFI_ERROR(ret))
-		ewerr("%s load and execute failed, ret=0x%zx",
-		      argv[1], (size_t)ret);
+	if (replay_path) {
+		ret = trace_replay(st, replay_path, &replay_config, stdout);
+		if (EFI_ERROR(ret))
+			ewerr("%s trace replay failed", replay_path);
+	} else {
+		ret = load_and_execute(argv[1], image, st);
+		if (EFI_ERROR(ret))
+			ewerr("%s load and execute failed, ret=0x%zx",
+			      argv[1], (size_t)ret);
+	}
+
+	if (io_stats)
+		iostats_report(st, stderr);
 
 	ret = ewdrv_exit(st);
 	if (ret)
 		ewerr("drivers release failed");
 
+	/* The storage devices flush their cache on release */
+	trace_stop();
+
 	ret = efiwrapper_free(image);
 	if (EFI_ERROR(ret))
 		ewerr("efiwrapper library exit failed");
 
+	if (boot_time)
+		boottime_report(stderr);
+
 	return EFI_ERROR(ret) ? EXIT_FAILURE : EXIT_SUCCESS;
 }
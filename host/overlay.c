@@ -0,0 +1,529 @@
+/*
+ * Copyright (c) 2026, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define _GNU_SOURCE
+#define _LARGEFILE64_SOURCE
+#include <ewlib.h>
+#include <ewlog.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/falloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "backing.h"
+#include "fdutil.h"
+#include "overlay.h"
+
+/* Delta file layout: the header, the chunk index and, starting at
+   the first chunk aligned offset, the chunks data in allocation
+   order. */
+#define OVERLAY_MAGIC	"EWOVLAY1"
+
+struct overlay_header {
+	char magic[8];
+	uint32_t chunk_sz;
+	uint32_t reserved;
+	uint64_t base_size;
+	uint64_t chunk_cnt;
+};
+
+/* Chunk index entries other than these are delta file offsets */
+#define CHUNK_BASE	0
+#define CHUNK_ZERO	1
+
+static const unsigned char ZEROES[OVERLAY_CHUNK_SIZE];
+
+struct overlay {
+	char *base_path;
+	backing_t *base;
+	int delta_fd;
+	uint64_t size;
+	uint64_t chunk_cnt;
+	uint64_t *index;
+	uint64_t data_start;
+	uint64_t data_end;
+	bool dirty;
+	/* Read-modify-write buffer of the partial chunk writes */
+	unsigned char *buf;
+};
+
+static size_t chunk_len(overlay_t *o, uint64_t chunk)
+{
+	uint64_t start = chunk * OVERLAY_CHUNK_SIZE;
+
+	return min(o->size - start, (uint64_t)OVERLAY_CHUNK_SIZE);
+}
+
+static EFI_STATUS write_index(overlay_t *o)
+{
+	struct overlay_header hdr = {
+		.magic = OVERLAY_MAGIC,
+		.chunk_sz = OVERLAY_CHUNK_SIZE,
+		.base_size = o->size,
+		.chunk_cnt = o->chunk_cnt
+	};
+	EFI_STATUS ret;
+
+	if (!o->dirty)
+		return EFI_SUCCESS;
+
+	ret = fd_pwrite_full(o->delta_fd, &hdr, sizeof(hdr), 0, "overlay file");
+	if (EFI_ERROR(ret))
+		return ret;
+
+	ret = fd_pwrite_full(o->delta_fd, o->index,
+			     o->chunk_cnt * sizeof(*o->index), sizeof(hdr),
+			     "overlay file");
+	if (EFI_ERROR(ret))
+		return ret;
+
+	o->dirty = false;
+	return EFI_SUCCESS;
+}
+
+static EFI_STATUS load_index(overlay_t *o)
+{
+	struct overlay_header hdr;
+	EFI_STATUS ret;
+	uint64_t i;
+
+	ret = fd_pread_full(o->delta_fd, &hdr, sizeof(hdr), 0, "overlay file");
+	if (EFI_ERROR(ret))
+		return ret;
+
+	if (memcmp(hdr.magic, OVERLAY_MAGIC, sizeof(hdr.magic)) ||
+	    hdr.chunk_sz != OVERLAY_CHUNK_SIZE ||
+	    hdr.chunk_cnt != o->chunk_cnt) {
+		ewerr("Invalid overlay delta file");
+		return EFI_VOLUME_CORRUPTED;
+	}
+
+	if (hdr.base_size != o->size) {
+		ewerr("Overlay delta file does not match the base image");
+		return EFI_INCOMPATIBLE_VERSION;
+	}
+
+	ret = fd_pread_full(o->delta_fd, o->index,
+			    o->chunk_cnt * sizeof(*o->index), sizeof(hdr),
+			    "overlay file");
+	if (EFI_ERROR(ret))
+		return ret;
+
+	for (i = 0; i < o->chunk_cnt; i++) {
+		if (o->index[i] <= CHUNK_ZERO)
+			continue;
+		if (o->index[i] < o->data_start ||
+		    o->index[i] % OVERLAY_CHUNK_SIZE) {
+			ewerr("Invalid overlay delta file index");
+			return EFI_VOLUME_CORRUPTED;
+		}
+		o->data_end = max(o->data_end,
+				  o->index[i] + OVERLAY_CHUNK_SIZE);
+	}
+
+	return EFI_SUCCESS;
+}
+
+static int open_delta(const char *delta, bool *created)
+{
+	char *dir;
+	int fd;
+
+	*created = true;
+	if (!delta) {
+		dir = getenv("TMPDIR");
+		fd = open(dir ? dir : "/tmp", O_RDWR | O_TMPFILE, 0600);
+		if (fd == -1)
+			ewerr("Failed to create the overlay delta file, %s",
+			      strerror(errno));
+		return fd;
+	}
+
+	fd = open(delta, O_RDWR | O_CREAT | O_EXCL, 0644);
+	if (fd == -1 && errno == EEXIST) {
+		*created = false;
+		fd = open(delta, O_RDWR);
+	}
+	if (fd == -1)
+		ewerr("Failed to open %s overlay delta file, %s",
+		      delta, strerror(errno));
+	return fd;
+}
+
+overlay_t *overlay_open(const char *base, const char *delta)
+{
+	EFI_STATUS ret;
+	overlay_t *o;
+	bool created;
+
+	o = calloc(1, sizeof(*o));
+	if (!o)
+		return NULL;
+	o->delta_fd = -1;
+
+	o->base_path = strdup(base);
+	o->buf = malloc(OVERLAY_CHUNK_SIZE);
+	if (!o->base_path || !o->buf)
+		goto err;
+
+	o->base = backing_open(base);
+	if (!o->base)
+		goto err;
+
+	o->size = backing_size(o->base);
+	o->chunk_cnt = (o->size + OVERLAY_CHUNK_SIZE - 1) / OVERLAY_CHUNK_SIZE;
+	o->index = calloc(o->chunk_cnt ? o->chunk_cnt : 1, sizeof(*o->index));
+	if (!o->index)
+		goto err;
+
+	o->data_start = sizeof(struct overlay_header) +
+		o->chunk_cnt * sizeof(*o->index);
+	o->data_start = (o->data_start + OVERLAY_CHUNK_SIZE - 1) &
+		~((uint64_t)OVERLAY_CHUNK_SIZE - 1);
+	o->data_end = o->data_start;
+
+	o->delta_fd = open_delta(delta, &created);
+	if (o->delta_fd == -1)
+		goto err;
+
+	if (created) {
+		o->dirty = true;
+		ret = write_index(o);
+	} else
+		ret = load_index(o);
+	if (EFI_ERROR(ret))
+		goto err;
+
+	ewdbg("Overlay of %s, %s image: %llu bytes of changes",
+	      base, backing_format_name(o->base),
+	      (unsigned long long)(o->data_end - o->data_start));
+	return o;
+
+err:
+	if (o->delta_fd != -1)
+		close(o->delta_fd);
+	if (o->base)
+		backing_close(o->base);
+	free(o->index);
+	free(o->buf);
+	free(o->base_path);
+	free(o);
+	return NULL;
+}
+
+void overlay_close(overlay_t *o)
+{
+	write_index(o);
+	close(o->delta_fd);
+	backing_close(o->base);
+	free(o->index);
+	free(o->buf);
+	free(o->base_path);
+	free(o);
+}
+
+uint64_t overlay_size(overlay_t *o)
+{
+	return o->size;
+}
+
+static EFI_STATUS chunk_read(overlay_t *o, uint64_t chunk, size_t off,
+			     void *buf, size_t len)
+{
+	uint64_t entry = o->index[chunk];
+
+	if (entry == CHUNK_ZERO) {
+		memset(buf, 0, len);
+		return EFI_SUCCESS;
+	}
+
+	if (entry == CHUNK_BASE)
+		return backing_read(o->base, chunk * OVERLAY_CHUNK_SIZE + off,
+				    buf, len);
+
+	return fd_pread_full(o->delta_fd, buf, len, entry + off,
+			     "overlay file");
+}
+
+/* Copy the chunk to the end of the delta file on its first write,
+   the whole chunk is written at once so that the delta file is not
+   left with a partially initialized chunk. */
+static EFI_STATUS chunk_write(overlay_t *o, uint64_t chunk, size_t off,
+			      const void *buf, size_t len)
+{
+	size_t clen = chunk_len(o, chunk);
+	EFI_STATUS ret;
+
+	if (o->index[chunk] > CHUNK_ZERO)
+		return fd_pwrite_full(o->delta_fd, buf, len,
+				      o->index[chunk] + off, "overlay file");
+
+	if (len != clen) {
+		ret = chunk_read(o, chunk, 0, o->buf, clen);
+		if (EFI_ERROR(ret))
+			return ret;
+		memcpy(o->buf + off, buf, len);
+		buf = o->buf;
+	}
+
+	ret = fd_pwrite_full(o->delta_fd, buf, clen, o->data_end,
+			     "overlay file");
+	if (EFI_ERROR(ret))
+		return ret;
+
+	o->index[chunk] = o->data_end;
+	o->data_end += OVERLAY_CHUNK_SIZE;
+	o->dirty = true;
+	return EFI_SUCCESS;
+}
+
+EFI_STATUS overlay_read(overlay_t *o, uint64_t off, void *buf, size_t len)
+{
+	EFI_STATUS ret;
+	size_t coff, n;
+
+	if (off > o->size || len > o->size - off)
+		return EFI_INVALID_PARAMETER;
+
+	for (; len; len -= n, off += n, buf = (char *)buf + n) {
+		coff = off % OVERLAY_CHUNK_SIZE;
+		n = min(len, (size_t)OVERLAY_CHUNK_SIZE - coff);
+		ret = chunk_read(o, off / OVERLAY_CHUNK_SIZE, coff, buf, n);
+		if (EFI_ERROR(ret))
+			return ret;
+	}
+
+	return EFI_SUCCESS;
+}
+
+EFI_STATUS overlay_write(overlay_t *o, uint64_t off, const void *buf,
+			 size_t len)
+{
+	EFI_STATUS ret;
+	size_t coff, n;
+
+	if (off > o->size || len > o->size - off)
+		return EFI_INVALID_PARAMETER;
+
+	for (; len; len -= n, off += n, buf = (const char *)buf + n) {
+		coff = off % OVERLAY_CHUNK_SIZE;
+		n = min(len, (size_t)OVERLAY_CHUNK_SIZE - coff);
+		ret = chunk_write(o, off / OVERLAY_CHUNK_SIZE, coff, buf, n);
+		if (EFI_ERROR(ret))
+			return ret;
+	}
+
+	return EFI_SUCCESS;
+}
+
+/* Whole chunks not stored in the delta file yet are zeroed in the
+   index only, the others keep their delta file space and have it
+   released by punching a hole. */
+EFI_STATUS overlay_zero(overlay_t *o, uint64_t off, uint64_t len)
+{
+	EFI_STATUS ret;
+	uint64_t chunk;
+	size_t coff, n;
+
+	if (off > o->size || len > o->size - off)
+		return EFI_INVALID_PARAMETER;
+
+	for (; len; len -= n, off += n) {
+		chunk = off / OVERLAY_CHUNK_SIZE;
+		coff = off % OVERLAY_CHUNK_SIZE;
+		n = min(len, (uint64_t)OVERLAY_CHUNK_SIZE - coff);
+
+		if (o->index[chunk] > CHUNK_ZERO &&
+		    !fallocate64(o->delta_fd, FALLOC_FL_PUNCH_HOLE |
+				 FALLOC_FL_KEEP_SIZE,
+				 o->index[chunk] + coff, n))
+			continue;
+
+		if (o->index[chunk] > CHUNK_ZERO || n != chunk_len(o, chunk)) {
+			ret = chunk_write(o, chunk, coff, ZEROES, n);
+			if (EFI_ERROR(ret))
+				return ret;
+			continue;
+		}
+
+		if (o->index[chunk] != CHUNK_ZERO) {
+			o->index[chunk] = CHUNK_ZERO;
+			o->dirty = true;
+		}
+	}
+
+	return EFI_SUCCESS;
+}
+
+EFI_STATUS overlay_flush(overlay_t *o)
+{
+	EFI_STATUS ret;
+
+	ret = write_index(o);
+	if (EFI_ERROR(ret))
+		return ret;
+
+	if (fdatasync(o->delta_fd)) {
+		ewerr("Failed to sync the overlay delta file, %s",
+		      strerror(errno));
+		return EFI_DEVICE_ERROR;
+	}
+
+	return EFI_SUCCESS;
+}
+
+/* The delta file only holds the modified chunks, copying it is
+   cheap and shares the blocks on file systems supporting it. */
+EFI_STATUS overlay_snapshot(overlay_t *o, const char *path)
+{
+	EFI_STATUS ret = EFI_SUCCESS;
+	loff_t in = 0, out = 0;
+	ssize_t n;
+	int fd;
+
+	ret = write_index(o);
+	if (EFI_ERROR(ret))
+		return ret;
+
+	fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd == -1) {
+		ewerr("Failed to create %s overlay snapshot, %s",
+		      path, strerror(errno));
+		return EFI_DEVICE_ERROR;
+	}
+
+	while (in < (loff_t)o->data_end) {
+		n = copy_file_range(o->delta_fd, &in, fd, &out,
+				    o->data_end - in, 0);
+		if (n > 0)
+			continue;
+		if (n == -1 && errno == EINTR)
+			continue;
+		if (n == 0 || (errno != ENOSYS && errno != EXDEV &&
+			       errno != EOPNOTSUPP && errno != EINVAL)) {
+			ewerr("Failed to copy the overlay delta file, %s",
+			      n ? strerror(errno) : "unexpected end of file");
+			ret = EFI_DEVICE_ERROR;
+			break;
+		}
+
+		/* No in-kernel copy, go through the chunk buffer */
+		n = min(o->data_end - in, (uint64_t)OVERLAY_CHUNK_SIZE);
+		ret = fd_pread_full(o->delta_fd, o->buf, n, in,
+				    "overlay file");
+		if (EFI_ERROR(ret))
+			break;
+		ret = fd_pwrite_full(fd, o->buf, n, out, "overlay snapshot");
+		if (EFI_ERROR(ret))
+			break;
+		in += n;
+		out += n;
+	}
+
+	if (close(fd) && !EFI_ERROR(ret)) {
+		ewerr("Failed to close %s overlay snapshot, %s",
+		      path, strerror(errno));
+		ret = EFI_DEVICE_ERROR;
+	}
+
+	return ret;
+}
+
+EFI_STATUS overlay_discard(overlay_t *o)
+{
+	memset(o->index, 0, o->chunk_cnt * sizeof(*o->index));
+	o->data_end = o->data_start;
+	o->dirty = true;
+
+	if (ftruncate64(o->delta_fd, o->data_start)) {
+		ewerr("Failed to truncate the overlay delta file, %s",
+		      strerror(errno));
+		return EFI_DEVICE_ERROR;
+	}
+
+	return write_index(o);
+}
+
+EFI_STATUS overlay_commit(overlay_t *o)
+{
+	EFI_STATUS ret = EFI_SUCCESS;
+	uint64_t chunk, off;
+	size_t len;
+	int fd;
+
+	if (backing_format(o->base) != BACKING_RAW) {
+		ewerr("Cannot commit the overlay to the %s %s image",
+		      backing_format_name(o->base), o->base_path);
+		return EFI_UNSUPPORTED;
+	}
+
+	fd = open(o->base_path, O_WRONLY);
+	if (fd == -1) {
+		ewerr("Failed to open %s overlay base image for writing, %s",
+		      o->base_path, strerror(errno));
+		return EFI_WRITE_PROTECTED;
+	}
+
+	for (chunk = 0; chunk < o->chunk_cnt; chunk++) {
+		if (o->index[chunk] == CHUNK_BASE)
+			continue;
+
+		off = chunk * OVERLAY_CHUNK_SIZE;
+		len = chunk_len(o, chunk);
+		if (o->index[chunk] == CHUNK_ZERO &&
+		    !fallocate64(fd, FALLOC_FL_PUNCH_HOLE |
+				 FALLOC_FL_KEEP_SIZE, off, len))
+			continue;
+
+		ret = chunk_read(o, chunk, 0, o->buf, len);
+		if (EFI_ERROR(ret))
+			break;
+		ret = fd_pwrite_full(fd, o->buf, len, off,
+				     "overlay base image");
+		if (EFI_ERROR(ret))
+			break;
+	}
+
+	if (!EFI_ERROR(ret) && fsync(fd)) {
+		ewerr("Failed to sync %s overlay base image, %s",
+		      o->base_path, strerror(errno));
+		ret = EFI_DEVICE_ERROR;
+	}
+	close(fd);
+
+	if (EFI_ERROR(ret))
+		return ret;
+
+	return overlay_discard(o);
+}
@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2026, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _OVERLAY_H_
+#define _OVERLAY_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <efi.h>
+#include <efiapi.h>
+
+/* Copy-on-write overlay of a read-only base image.  The modified
+   chunks are stored in a delta file indexed by chunk: a chunk is
+   either read from the base image, known to be zero or stored at
+   some offset of the delta file.  Resetting the overlay to the base
+   image only costs a truncation of the delta file. */
+typedef struct overlay overlay_t;
+
+#define OVERLAY_CHUNK_SIZE	(64 * 1024)
+
+/* Open the BASE image read-only, in any of the backing_t formats, and
+   the DELTA file, created if it does not exist yet.  A NULL DELTA stores the delta in an unlinked
+   temporary file which is lost on close. */
+overlay_t *overlay_open(const char *base, const char *delta);
+/* Write back the delta index and close O. */
+void overlay_close(overlay_t *o);
+uint64_t overlay_size(overlay_t *o);
+
+EFI_STATUS overlay_read(overlay_t *o, uint64_t off, void *buf, size_t len);
+EFI_STATUS overlay_write(overlay_t *o, uint64_t off, const void *buf,
+			 size_t len);
+EFI_STATUS overlay_zero(overlay_t *o, uint64_t off, uint64_t len);
+/* Write back the delta index and sync the delta file. */
+EFI_STATUS overlay_flush(overlay_t *o);
+
+/* Save the current delta to PATH, which can later be opened as the
+   delta of the same base image. */
+EFI_STATUS overlay_snapshot(overlay_t *o, const char *path);
+/* Drop all the changes: the overlay reads as the base image again. */
+EFI_STATUS overlay_discard(overlay_t *o);
+/* Write the changes to the base image, which must be a raw image, and
+   discard them. */
+EFI_STATUS overlay_commit(overlay_t *o);
+
+#endif	/* _OVERLAY_H_ */
@@ -0,0 +1,533 @@
+/*
+ * Copyright (c) 2026, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define _GNU_SOURCE
+#include <efi.h>
+#include <efiapi.h>
+#include <ewlog.h>
+#include <ewlib.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "serial.h"
+
+/* Size of the input ring buffer.  Must be a power of two. */
+#define RING_SIZE	4096
+
+static struct {
+	unsigned char data[RING_SIZE];
+	size_t head;		/* Next byte to read */
+	size_t tail;		/* Next byte to write */
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+} ring = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+	.cond = PTHREAD_COND_INITIALIZER
+};
+
+static const char *source;
+static int fd = -1;
+static int wakeup[2] = { -1, -1 };
+static bool restore_termios;
+static struct termios saved_termios;
+static pthread_t reader;
+static EFI_SYSTEM_TABLE *saved_st;
+
+static size_t ring_count(void)
+{
+	return ring.tail - ring.head;
+}
+
+static void ring_put(const unsigned char *buf, size_t size)
+{
+	size_t i;
+
+	pthread_mutex_lock(&ring.lock);
+	for (i = 0; i < size; i++) {
+		/* Drop the oldest byte on overflow. */
+		if (ring_count() == RING_SIZE)
+			ring.head++;
+		ring.data[ring.tail++ & (RING_SIZE - 1)] = buf[i];
+	}
+	pthread_cond_broadcast(&ring.cond);
+	pthread_mutex_unlock(&ring.lock);
+}
+
+/* Must be called with the ring lock held. */
+static size_t ring_get(unsigned char *buf, size_t size)
+{
+	size_t i;
+
+	for (i = 0; i < size && ring_count(); i++)
+		buf[i] = ring.data[ring.head++ & (RING_SIZE - 1)];
+
+	return i;
+}
+
+/* Must be called with the ring lock held. */
+static bool ring_peek(size_t index, unsigned char *c)
+{
+	if (index >= ring_count())
+		return false;
+
+	*c = ring.data[(ring.head + index) & (RING_SIZE - 1)];
+	return true;
+}
+
+static void signal_wait_for_key(void)
+{
+	if (saved_st && saved_st->ConIn && saved_st->ConIn->WaitForKey)
+		uefi_call_wrapper(saved_st->BootServices->SignalEvent, 1,
+				  saved_st->ConIn->WaitForKey);
+}
+
+static void *reader_routine(__attribute__((__unused__)) void *arg)
+{
+	struct pollfd fds[2] = {
+		{ .fd = fd, .events = POLLIN },
+		{ .fd = wakeup[0], .events = POLLIN }
+	};
+	unsigned char buf[256];
+	ssize_t count;
+	int ret;
+
+	for (;;) {
+		ret = poll(fds, ARRAY_SIZE(fds), -1);
+		if (ret == -1) {
+			if (errno == EINTR)
+				continue;
+			ewerr("serial: poll failed, %s", strerror(errno));
+			break;
+		}
+
+		if (fds[1].revents)
+			break;
+
+		if (fds[0].revents & (POLLERR | POLLNVAL))
+			break;
+
+		count = read(fd, buf, sizeof(buf));
+		if (count == -1) {
+			if (errno == EINTR || errno == EAGAIN)
+				continue;
+			/* The pty slave side has been closed, wait for
+			   someone to re-open it. */
+			if (errno == EIO) {
+				poll(&fds[1], 1, 100);
+				if (fds[1].revents)
+					break;
+				continue;
+			}
+			ewerr("serial: read failed, %s", strerror(errno));
+			break;
+		}
+		if (count == 0) {
+			/* End of file: nothing more to read but keep
+			   the already buffered bytes available. */
+			poll(&fds[1], 1, -1);
+			break;
+		}
+
+		ring_put(buf, count);
+		signal_wait_for_key();
+	}
+
+	return NULL;
+}
+
+static EFIAPI EFI_STATUS
+serial_read(SERIAL_IO_INTERFACE *This, UINTN *BufferSize, VOID *Buffer)
+{
+	struct timespec deadline;
+	UINTN total = 0;
+	UINT64 ns;
+	int ret = 0;
+
+	if (!This || !BufferSize || !Buffer)
+		return EFI_INVALID_PARAMETER;
+
+	clock_gettime(CLOCK_REALTIME, &deadline);
+	ns = (UINT64)This->Mode->Timeout * 1000 + deadline.tv_nsec;
+	deadline.tv_sec += ns / 1000000000;
+	deadline.tv_nsec = ns % 1000000000;
+
+	pthread_mutex_lock(&ring.lock);
+	for (;;) {
+		total += ring_get((unsigned char *)Buffer + total,
+				  *BufferSize - total);
+		if (total == *BufferSize || ret == ETIMEDOUT)
+			break;
+		ret = pthread_cond_timedwait(&ring.cond, &ring.lock, &deadline);
+	}
+	pthread_mutex_unlock(&ring.lock);
+
+	*BufferSize = total;
+	return ret == ETIMEDOUT ? EFI_TIMEOUT : EFI_SUCCESS;
+}
+
+static EFIAPI EFI_STATUS
+serial_get_control(SERIAL_IO_INTERFACE *This, UINT32 *Control)
+{
+	if (!This || !Control)
+		return EFI_INVALID_PARAMETER;
+
+	pthread_mutex_lock(&ring.lock);
+	*Control = ring_count() ? 0 : EFI_SERIAL_INPUT_BUFFER_EMPTY;
+	pthread_mutex_unlock(&ring.lock);
+
+	return EFI_SUCCESS;
+}
+
+static const struct escape_sequence {
+	const char *seq;
+	UINT16 scan;
+} ESCAPE_SEQUENCES[] = {
+	{ "[A", SCAN_UP },
+	{ "[B", SCAN_DOWN },
+	{ "[C", SCAN_RIGHT },
+	{ "[D", SCAN_LEFT },
+	{ "[H", SCAN_HOME },
+	{ "[F", SCAN_END },
+	{ "[1~", SCAN_HOME },
+	{ "[2~", SCAN_INSERT },
+	{ "[3~", SCAN_DELETE },
+	{ "[4~", SCAN_END },
+	{ "[5~", SCAN_PAGE_UP },
+	{ "[6~", SCAN_PAGE_DOWN },
+	{ "OP", SCAN_F1 },
+	{ "OQ", SCAN_F2 },
+	{ "OR", SCAN_F3 },
+	{ "OS", SCAN_F4 },
+	{ "[15~", SCAN_F5 },
+	{ "[17~", SCAN_F6 },
+	{ "[18~", SCAN_F7 },
+	{ "[19~", SCAN_F8 },
+	{ "[20~", SCAN_F9 },
+	{ "[21~", SCAN_F10 },
+	{ "[23~", SCAN_F11 },
+	{ "[24~", SCAN_F12 }
+};
+
+/* Must be called with the ring lock held and ring[0] == ESC. */
+static UINT16 decode_escape(void)
+{
+	const struct escape_sequence *esc;
+	unsigned char c;
+	size_t i, j;
+
+	for (i = 0; i < ARRAY_SIZE(ESCAPE_SEQUENCES); i++) {
+		esc = &ESCAPE_SEQUENCES[i];
+		for (j = 0; esc->seq[j]; j++)
+			if (!ring_peek(j + 1, &c) || c != esc->seq[j])
+				break;
+		if (esc->seq[j])
+			continue;
+
+		ring.head += j + 1;
+		return esc->scan;
+	}
+
+	ring.head++;
+	return SCAN_ESC;
+}
+
+static EFIAPI EFI_STATUS
+read_key(struct _SIMPLE_INPUT_INTERFACE *This, EFI_INPUT_KEY *Key)
+{
+	unsigned char c;
+	bool more;
+
+	if (!This || !Key)
+		return EFI_INVALID_PARAMETER;
+
+	pthread_mutex_lock(&ring.lock);
+	if (!ring_peek(0, &c)) {
+		pthread_mutex_unlock(&ring.lock);
+		return EFI_NOT_READY;
+	}
+
+	Key->ScanCode = SCAN_NULL;
+	Key->UnicodeChar = CHAR_NULL;
+	if (c == 0x1b)
+		Key->ScanCode = decode_escape();
+	else {
+		ring.head++;
+		if (c == '\n')
+			c = CHAR_CARRIAGE_RETURN;
+		else if (c == 0x7f)
+			c = CHAR_BACKSPACE;
+		Key->UnicodeChar = c;
+	}
+	more = ring_count() != 0;
+	pthread_mutex_unlock(&ring.lock);
+
+	/* Keep WaitForKey signaled while keystrokes are pending. */
+	if (more)
+		signal_wait_for_key();
+
+	return EFI_SUCCESS;
+}
+
+static EFIAPI EFI_STATUS
+reset_input(__attribute__((__unused__)) struct _SIMPLE_INPUT_INTERFACE *This,
+	    __attribute__((__unused__)) BOOLEAN ExtendedVerification)
+{
+	pthread_mutex_lock(&ring.lock);
+	ring.head = ring.tail;
+	pthread_mutex_unlock(&ring.lock);
+
+	return EFI_SUCCESS;
+}
+
+static EFI_STATUS open_source(void)
+{
+	struct termios t;
+	int ret;
+
+	if (!strcmp(source, "stdin")) {
+		fd = dup(STDIN_FILENO);
+		if (fd == -1)
+			return EFI_DEVICE_ERROR;
+
+		/* Disable line buffering and echo so that each
+		   keystroke is delivered as soon as it is typed. */
+		if (isatty(fd) && !tcgetattr(fd, &saved_termios)) {
+			t = saved_termios;
+			t.c_lflag &= ~(ICANON | ECHO);
+			t.c_cc[VMIN] = 1;
+			t.c_cc[VTIME] = 0;
+			if (!tcsetattr(fd, TCSANOW, &t))
+				restore_termios = true;
+		}
+		return EFI_SUCCESS;
+	}
+
+	if (!strcmp(source, "pty")) {
+		fd = posix_openpt(O_RDWR | O_NOCTTY);
+		if (fd == -1)
+			return EFI_DEVICE_ERROR;
+
+		ret = grantpt(fd);
+		if (!ret)
+			ret = unlockpt(fd);
+		if (!ret && !tcgetattr(fd, &t)) {
+			cfmakeraw(&t);
+			ret = tcsetattr(fd, TCSANOW, &t);
+		}
+		if (ret) {
+			close(fd);
+			fd = -1;
+			return EFI_DEVICE_ERROR;
+		}
+
+		printf("serial: input available on %s\n", ptsname(fd));
+		return EFI_SUCCESS;
+	}
+
+	fd = open(source, O_RDONLY | O_NOCTTY);
+	if (fd == -1) {
+		ewerr("serial: failed to open %s, %s", source, strerror(errno));
+		return EFI_DEVICE_ERROR;
+	}
+
+	return EFI_SUCCESS;
+}
+
+static void close_source(void)
+{
+	if (restore_termios)
+		tcsetattr(fd, TCSANOW, &saved_termios);
+	restore_termios = false;
+
+	close(fd);
+	fd = -1;
+}
+
+static EFI_GUID serialio_guid = SERIAL_IO_PROTOCOL;
+static SERIAL_IO_INTERFACE *serialio;
+static SERIAL_IO_INTERFACE saved_serialio;
+static SIMPLE_INPUT_INTERFACE saved_conin;
+
+static EFI_STATUS hook_serialio(EFI_SYSTEM_TABLE *st)
+{
+	EFI_STATUS ret;
+	EFI_HANDLE *handles;
+	UINTN nb_handles;
+
+	ret = uefi_call_wrapper(st->BootServices->LocateHandleBuffer, 5,
+				ByProtocol, &serialio_guid, NULL,
+				&nb_handles, &handles);
+	if (EFI_ERROR(ret))
+		return ret;
+
+	ret = uefi_call_wrapper(st->BootServices->HandleProtocol, 3,
+				handles[0], &serialio_guid, (VOID **)&serialio);
+	free(handles);
+	if (EFI_ERROR(ret))
+		return ret;
+
+	memcpy(&saved_serialio, serialio, sizeof(saved_serialio));
+	serialio->Read = serial_read;
+	serialio->GetControl = serial_get_control;
+	if (!serialio->Mode->Timeout)
+		serialio->Mode->Timeout = 1000000;
+
+	return EFI_SUCCESS;
+}
+
+static EFI_STATUS hook_conin(EFI_SYSTEM_TABLE *st)
+{
+	EFI_STATUS ret;
+
+	if (!st->ConIn)
+		return EFI_NOT_FOUND;
+
+	memcpy(&saved_conin, st->ConIn, sizeof(saved_conin));
+
+	ret = uefi_call_wrapper(st->BootServices->CreateEvent, 5,
+				0, TPL_NOTIFY, NULL, NULL,
+				&st->ConIn->WaitForKey);
+	if (EFI_ERROR(ret)) {
+		ewerr("serial: failed to create the WaitForKey event");
+		return ret;
+	}
+
+	st->ConIn->Reset = reset_input;
+	st->ConIn->ReadKeyStroke = read_key;
+
+	return EFI_SUCCESS;
+}
+
+static void unhook(EFI_SYSTEM_TABLE *st)
+{
+	if (st->ConIn && st->ConIn->ReadKeyStroke == read_key) {
+		uefi_call_wrapper(st->BootServices->CloseEvent, 1,
+				  st->ConIn->WaitForKey);
+		memcpy(st->ConIn, &saved_conin, sizeof(saved_conin));
+	}
+
+	if (serialio) {
+		memcpy(serialio, &saved_serialio, sizeof(*serialio));
+		serialio = NULL;
+	}
+}
+
+void serial_set_source(const char *src)
+{
+	source = src;
+}
+
+static EFI_STATUS serial_init(EFI_SYSTEM_TABLE *st)
+{
+	EFI_STATUS ret;
+
+	if (!st)
+		return EFI_INVALID_PARAMETER;
+
+	/* Input is only read when a source has been selected with the
+	   --serial option. */
+	if (!source)
+		return EFI_SUCCESS;
+
+	ret = open_source();
+	if (EFI_ERROR(ret))
+		return ret;
+
+	if (pipe(wakeup)) {
+		close_source();
+		return EFI_DEVICE_ERROR;
+	}
+
+	saved_st = st;
+	ret = hook_serialio(st);
+	if (EFI_ERROR(ret)) {
+		ewerr("serial: failed to hook the Serial IO protocol");
+		goto err;
+	}
+
+	ret = hook_conin(st);
+	if (EFI_ERROR(ret))
+		goto err;
+
+	if (pthread_create(&reader, NULL, reader_routine, NULL)) {
+		ewerr("serial: failed to start the reader thread");
+		ret = EFI_DEVICE_ERROR;
+		goto err;
+	}
+
+	return EFI_SUCCESS;
+
+err:
+	unhook(st);
+	saved_st = NULL;
+	close(wakeup[0]);
+	close(wakeup[1]);
+	close_source();
+	return ret;
+}
+
+static EFI_STATUS serial_exit(EFI_SYSTEM_TABLE *st)
+{
+	char c = 0;
+
+	if (!st)
+		return EFI_INVALID_PARAMETER;
+
+	if (!saved_st)
+		return EFI_SUCCESS;
+
+	if (write(wakeup[1], &c, sizeof(c)) == sizeof(c))
+		pthread_join(reader, NULL);
+
+	unhook(st);
+	saved_st = NULL;
+	close(wakeup[0]);
+	close(wakeup[1]);
+	close_source();
+
+	return EFI_SUCCESS;
+}
+
+ewdrv_t serial_drv = {
+	.name = "serial",
+	.description = "Serial and console input from stdin, a pty or a file",
+	.init = serial_init,
+	.exit = serial_exit,
+	/* ConIn is provided by the terminal driver and WaitForKey
+	   relies on the event driver. */
+	.depends = (const char * const []){ "event", "terminal_curses", NULL }
+};
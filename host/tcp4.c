@@ -596,5 +596,6 @@ ewdrv_t tcp4_drv = {
 	.name = "tcp4",
 	.description = "TCP/IP protocol",
 	.init = tcp4_init,
-	.exit = tcp4_exit
+	.exit = tcp4_exit,
+	.depends = (const char * const []){ "event", NULL }
 };
@@ -16,7 +16,7 @@
 
 static SCREEN *screen;
 
-EFI_STATUS terminal_curses_init(EFI_SYSTEM_TABLE *st)
+static EFI_STATUS setup_screen(void)
 {
 	int ret;
 
@@ -49,6 +49,21 @@ EFI_STATUS terminal_curses_init(EFI_SYSTEM_TABLE *st)
 	if (ret == ERR)
 		ewdbg("Warning colors will not be available");
 
+	return EFI_SUCCESS;
+}
+
+EFI_STATUS terminal_curses_init(EFI_SYSTEM_TABLE *st)
+{
+	EFI_STATUS ret;
+
+	/* The terminal setup does not involve the system table and
+	   can run while other drivers are initialized. */
+	ewdrv_unlock();
+	ret = setup_screen();
+	ewdrv_lock();
+	if (EFI_ERROR(ret))
+		return ret;
+
 	return terminal_conin_init(st) & terminal_conout_init(st);
 }
 
@@ -67,5 +82,6 @@ ewdrv_t terminal_curses_drv = {
 	.name = "terminal_curses",
 	.description = "Terminal input output support based on ncurses",
 	.init = terminal_curses_init,
-	.exit = terminal_curses_exit
+	.exit = terminal_curses_exit,
+	.concurrent = TRUE
 };
@@ -0,0 +1,242 @@
+/*
+ * Copyright (c) 2026, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <ewlib.h>
+#include <ewlog.h>
+#include <ewperf.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "timing.h"
+
+#define NS_PER_US	1000
+#define NS_PER_SEC	1000000000ULL
+
+/* Typical figures, small random accesses for the latencies and large
+   sequential accesses for the bandwidths */
+static const timing_profile_t PROFILES[] = {
+	{
+		.name = "emmc",
+		.latency = {
+			[TIMING_READ] = 150,
+			[TIMING_WRITE] = 400,
+			[TIMING_ERASE] = 2000,
+			[TIMING_FLUSH] = 1000
+		},
+		.bandwidth = {
+			[TIMING_READ] = 300,
+			[TIMING_WRITE] = 120
+		},
+		.queue_depth = 1,
+		.outlier_rate = 1000,
+		.outlier_latency = 20000
+	}, {
+		.name = "ufs",
+		.latency = {
+			[TIMING_READ] = 80,
+			[TIMING_WRITE] = 100,
+			[TIMING_ERASE] = 500,
+			[TIMING_FLUSH] = 300
+		},
+		.bandwidth = {
+			[TIMING_READ] = 1500,
+			[TIMING_WRITE] = 700
+		},
+		.queue_depth = 32,
+		.outlier_rate = 500,
+		.outlier_latency = 5000
+	}, {
+		.name = "nvme",
+		.latency = {
+			[TIMING_READ] = 25,
+			[TIMING_WRITE] = 30,
+			[TIMING_ERASE] = 100,
+			[TIMING_FLUSH] = 100
+		},
+		.bandwidth = {
+			[TIMING_READ] = 3000,
+			[TIMING_WRITE] = 2000
+		},
+		.queue_depth = 64,
+		.outlier_rate = 100,
+		.outlier_latency = 1000,
+		.native_copy = true
+	}
+};
+
+/* Shared by all the devices, in nanoseconds */
+static UINT64 virtual_offset;
+
+struct timing {
+	timing_profile_t profile;
+	bool virtual_clock;
+	unsigned int seed;
+	/* Time each device slot becomes free */
+	UINT64 *slots;
+	/* Time the link becomes free */
+	UINT64 link;
+	/* Statistics */
+	UINT64 commands;
+	UINT64 outliers;
+	UINT64 busy;
+};
+
+const timing_profile_t *timing_get_profile(const char *name)
+{
+	size_t i;
+
+	for (i = 0; i < ARRAY_SIZE(PROFILES); i++)
+		if (!strcmp(name, PROFILES[i].name))
+			return &PROFILES[i];
+
+	return NULL;
+}
+
+timing_t *timing_new(const timing_profile_t *profile, bool virtual_clock,
+		     unsigned int seed)
+{
+	timing_t *t;
+
+	if (!profile || !profile->queue_depth)
+		return NULL;
+
+	if (virtual_clock && !ewperf_get_tsc_freq()) {
+		ewerr("The virtual clock requires the TSC frequency");
+		return NULL;
+	}
+
+	t = calloc(1, sizeof(*t));
+	if (!t)
+		return NULL;
+
+	t->slots = calloc(profile->queue_depth, sizeof(*t->slots));
+	if (!t->slots) {
+		free(t);
+		return NULL;
+	}
+
+	t->profile = *profile;
+	t->virtual_clock = virtual_clock;
+	t->seed = seed;
+	return t;
+}
+
+void timing_free(timing_t *t)
+{
+	ewdbg("%s timing model: %llu commands, %llu outliers, %llu us busy",
+	      t->profile.name, (unsigned long long)t->commands,
+	      (unsigned long long)t->outliers,
+	      (unsigned long long)t->busy / NS_PER_US);
+	free(t->slots);
+	free(t);
+}
+
+UINT64 timing_now(timing_t *t)
+{
+	struct timespec ts;
+	UINT64 now;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	now = (UINT64)ts.tv_sec * NS_PER_SEC + ts.tv_nsec;
+	if (t->virtual_clock)
+		now += __atomic_load_n(&virtual_offset, __ATOMIC_RELAXED);
+
+	return now;
+}
+
+UINT64 timing_schedule(timing_t *t, timing_op_t op, UINT64 bytes)
+{
+	timing_profile_t *p = &t->profile;
+	UINT64 now, start, end;
+	UINT32 i, slot = 0;
+
+	now = timing_now(t);
+	for (i = 1; i < p->queue_depth; i++)
+		if (t->slots[i] < t->slots[slot])
+			slot = i;
+
+	/* A flush waits for all the commands in flight */
+	start = t->slots[slot];
+	if (op == TIMING_FLUSH)
+		for (i = 0; i < p->queue_depth; i++)
+			start = max(start, t->slots[i]);
+	start = max(start, now);
+
+	end = start + (UINT64)p->latency[op] * NS_PER_US;
+	if (p->outlier_rate &&
+	    (UINT32)rand_r(&t->seed) % 1000000 < p->outlier_rate) {
+		end += (UINT64)p->outlier_latency * NS_PER_US;
+		t->outliers++;
+	}
+
+	if (bytes && p->bandwidth[op]) {
+		end = max(end, t->link);
+		/* One MB/s is one byte per microsecond */
+		end += bytes * NS_PER_US / p->bandwidth[op];
+		t->link = end;
+	}
+
+	t->slots[slot] = end;
+	t->commands++;
+	t->busy += end - start;
+	return end;
+}
+
+void timing_wait(timing_t *t, UINT64 deadline)
+{
+	struct timespec ts;
+	UINT64 now;
+
+	now = timing_now(t);
+	if (deadline <= now)
+		return;
+
+	if (t->virtual_clock) {
+		__atomic_add_fetch(&virtual_offset, deadline - now,
+				   __ATOMIC_RELAXED);
+		ewperf_advance_ns(deadline - now);
+		return;
+	}
+
+	ts.tv_sec = deadline / NS_PER_SEC;
+	ts.tv_nsec = deadline % NS_PER_SEC;
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) ==
+	       EINTR)
+		;
+}
+
+bool timing_reached(timing_t *t, UINT64 deadline)
+{
+	if (t->virtual_clock)
+		timing_wait(t, deadline);
+
+	return timing_now(t) >= deadline;
+}
@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2026, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _TIMING_H_
+#define _TIMING_H_
+
+#include <stdbool.h>
+#include <efi.h>
+#include <efiapi.h>
+
+/* Latency and bandwidth model of a storage device.  Each command
+   waits for one of the QUEUE_DEPTH device slots, takes the LATENCY
+   of its operation, then transfers its data over a link shared by
+   all the slots at the BANDWIDTH of its operation.  One command in
+   OUTLIER_RATE millionths takes OUTLIER_LATENCY more, as when the
+   device runs its garbage collection.
+
+   The model either delays the commands in real time or, with a
+   virtual clock, moves the ewperf clock forward by the time the
+   device would have taken so that boot-time measurements account for
+   it without slowing the run down. */
+typedef struct timing timing_t;
+
+typedef enum timing_op {
+	TIMING_READ,
+	TIMING_WRITE,
+	TIMING_ERASE,
+	TIMING_FLUSH,
+	TIMING_NB_OPS
+} timing_op_t;
+
+typedef struct timing_profile {
+	const char *name;
+	/* Microseconds */
+	UINT32 latency[TIMING_NB_OPS];
+	/* MB/s, zero for unlimited */
+	UINT32 bandwidth[TIMING_NB_OPS];
+	UINT32 queue_depth;
+	UINT32 outlier_rate;
+	/* Microseconds */
+	UINT32 outlier_latency;
+	/* The device has a copy command, as the NVMe one.  Otherwise
+	   the copies go through memory. */
+	bool native_copy;
+} timing_profile_t;
+
+/* Built-in "emmc", "ufs" and "nvme" profiles, NULL if NAME is
+   unknown */
+const timing_profile_t *timing_get_profile(const char *name);
+
+/* SEED makes the outliers reproducible */
+timing_t *timing_new(const timing_profile_t *profile, bool virtual_clock,
+		     unsigned int seed);
+void timing_free(timing_t *t);
+
+/* Nanoseconds, the virtual clock is ahead of CLOCK_MONOTONIC */
+UINT64 timing_now(timing_t *t);
+/* Queue an OP command of BYTES bytes and return when it completes */
+UINT64 timing_schedule(timing_t *t, timing_op_t op, UINT64 bytes);
+/* Sleep until DEADLINE, or move the virtual clock to it */
+void timing_wait(timing_t *t, UINT64 deadline);
+/* Whether DEADLINE is past, never sleeps but moves the virtual clock
+   to DEADLINE */
+bool timing_reached(timing_t *t, UINT64 deadline);
+
+#endif	/* _TIMING_H_ */
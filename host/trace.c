@@ -0,0 +1,418 @@
+/*
+ * Copyright (c) 2026, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <ewlib.h>
+#include <ewlog.h>
+#include <ewperf.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <storage.h>
+#include <protocol/EraseBlock.h>
+#include <protocol/MediaStats.h>
+
+#include "trace.h"
+
+#define TRACE_MAX_DEVICES	256
+#define NS_PER_SEC		1000000000ULL
+
+static const char *OP_NAMES[] = {
+	[STORAGE_TRACE_READ] = "read",
+	[STORAGE_TRACE_WRITE] = "write",
+	[STORAGE_TRACE_ERASE] = "erase",
+	[STORAGE_TRACE_FLUSH] = "flush"
+};
+
+static FILE *trace_file;
+static UINT64 trace_origin;
+static storage_t *devices[TRACE_MAX_DEVICES];
+static size_t nb_devices;
+
+static UINT8 log2_blk_sz(UINT32 blk_sz)
+{
+	UINT8 shift = 0;
+
+	while (blk_sz > 1U << shift)
+		shift++;
+
+	return shift;
+}
+
+static void record(storage_t *storage, enum storage_trace_op op,
+		   EFI_LBA lba, EFI_LBA count, UINT64 start, UINT64 end,
+		   EFI_STATUS status)
+{
+	trace_record_t rec = {
+		.lba = lba,
+		.count = count,
+		.op = op,
+		.error = EFI_ERROR(status) ? 1 : 0,
+		.blk_shift = log2_blk_sz(storage->blk_sz)
+	};
+	size_t i;
+
+	for (i = 0; i < nb_devices; i++)
+		if (devices[i] == storage)
+			break;
+	if (i == nb_devices) {
+		if (nb_devices == ARRAY_SIZE(devices))
+			return;
+		devices[nb_devices++] = storage;
+	}
+	rec.device = i;
+
+	/* Requests in flight when the capture started */
+	start = max(start, trace_origin);
+	rec.timestamp = ewperf_to_ns(start - trace_origin);
+	rec.latency = ewperf_to_ns(end - start);
+
+	if (fwrite(&rec, sizeof(rec), 1, trace_file) != 1) {
+		ewerr("Failed to write the I/O trace, %s", strerror(errno));
+		trace_stop();
+	}
+}
+
+EFI_STATUS trace_start(const char *path)
+{
+	trace_header_t hdr = {
+		.record_size = sizeof(trace_record_t)
+	};
+
+	if (trace_file)
+		return EFI_ALREADY_STARTED;
+
+	if (!ewperf_get_tsc_freq())
+		return EFI_NOT_READY;
+
+	trace_file = fopen(path, "w");
+	if (!trace_file) {
+		ewerr("Failed to create %s I/O trace, %s", path,
+		      strerror(errno));
+		return EFI_DEVICE_ERROR;
+	}
+
+	memcpy(hdr.magic, TRACE_MAGIC, sizeof(hdr.magic));
+	if (fwrite(&hdr, sizeof(hdr), 1, trace_file) != 1) {
+		ewerr("Failed to write %s I/O trace, %s", path,
+		      strerror(errno));
+		fclose(trace_file);
+		trace_file = NULL;
+		return EFI_DEVICE_ERROR;
+	}
+
+	nb_devices = 0;
+	trace_origin = ewperf_tsc();
+	storage_set_trace(record);
+	return EFI_SUCCESS;
+}
+
+void trace_stop(void)
+{
+	if (!trace_file)
+		return;
+
+	storage_set_trace(NULL);
+	if (fclose(trace_file))
+		ewerr("Failed to write the I/O trace, %s", strerror(errno));
+	trace_file = NULL;
+}
+
+typedef struct op_stats {
+	UINT64 count;
+	UINT64 errors;
+	UINT64 bytes;
+	UINT64 total_latency;
+	/* Latency of each request, in nanoseconds */
+	UINT64 *latencies;
+	size_t capacity;
+} op_stats_t;
+
+typedef struct replay {
+	EFI_BLOCK_IO *blockio;
+	EFI_ERASE_BLOCK_PROTOCOL *erase;
+	void *buf;
+	size_t buf_size;
+	op_stats_t stats[ARRAY_SIZE(OP_NAMES)];
+	UINT64 skipped;
+} replay_t;
+
+static UINT64 now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (UINT64)ts.tv_sec * NS_PER_SEC + ts.tv_nsec;
+}
+
+static void sleep_until(UINT64 deadline)
+{
+	struct timespec ts = {
+		.tv_sec = deadline / NS_PER_SEC,
+		.tv_nsec = deadline % NS_PER_SEC
+	};
+
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) ==
+	       EINTR)
+		;
+}
+
+/* The storage devices carry the efiwrapper Media Statistics Protocol,
+   the partitions do not. */
+static EFI_STATUS open_target(EFI_SYSTEM_TABLE *st, UINTN target,
+			      replay_t *r)
+{
+	EFI_GUID media_stats_guid = EFIWRAPPER_MEDIA_STATS_PROTOCOL_GUID;
+	EFI_GUID erase_guid = EFI_ERASE_BLOCK_PROTOCOL_GUID;
+	EFI_GUID blockio_guid = BLOCK_IO_PROTOCOL;
+	EFI_HANDLE *handles;
+	UINTN nb_handles;
+	EFI_STATUS ret;
+
+	ret = uefi_call_wrapper(st->BootServices->LocateHandleBuffer, 5,
+				ByProtocol, &media_stats_guid, NULL,
+				&nb_handles, &handles);
+	if (EFI_ERROR(ret) || target >= nb_handles) {
+		ewerr("No storage device %zu to replay the trace on",
+		      (size_t)target);
+		if (!EFI_ERROR(ret))
+			uefi_call_wrapper(st->BootServices->FreePool, 1,
+					  handles);
+		return EFI_NOT_FOUND;
+	}
+
+	ret = uefi_call_wrapper(st->BootServices->HandleProtocol, 3,
+				handles[target], &blockio_guid,
+				(VOID **)&r->blockio);
+	if (!EFI_ERROR(ret) &&
+	    EFI_ERROR(uefi_call_wrapper(st->BootServices->HandleProtocol, 3,
+					handles[target], &erase_guid,
+					(VOID **)&r->erase)))
+		r->erase = NULL;
+
+	uefi_call_wrapper(st->BootServices->FreePool, 1, handles);
+	return ret;
+}
+
+static EFI_STATUS add_latency(op_stats_t *stats, UINT64 latency)
+{
+	UINT64 *latencies;
+	size_t capacity;
+
+	if (stats->count == stats->capacity) {
+		capacity = max(stats->capacity * 2, (size_t)1024);
+		latencies = realloc(stats->latencies,
+				    capacity * sizeof(*latencies));
+		if (!latencies)
+			return EFI_OUT_OF_RESOURCES;
+		stats->latencies = latencies;
+		stats->capacity = capacity;
+	}
+
+	stats->latencies[stats->count++] = latency;
+	stats->total_latency += latency;
+	return EFI_SUCCESS;
+}
+
+/* Issue the request of REC, converted in target blocks, and account
+   its latency */
+static EFI_STATUS replay_one(replay_t *r, const trace_record_t *rec)
+{
+	EFI_BLOCK_IO_MEDIA *media = r->blockio->Media;
+	UINT64 off, end, start, latency;
+	EFI_LBA lba, count;
+	op_stats_t *stats;
+	EFI_STATUS ret;
+	size_t size;
+	void *buf;
+
+	off = rec->lba << rec->blk_shift;
+	end = off + ((UINT64)rec->count << rec->blk_shift);
+	lba = off / media->BlockSize;
+	count = (end + media->BlockSize - 1) / media->BlockSize - lba;
+	size = count * media->BlockSize;
+
+	if (lba + count > media->LastBlock + 1) {
+		r->skipped++;
+		return EFI_SUCCESS;
+	}
+
+	if (size > r->buf_size) {
+		buf = realloc(r->buf, size);
+		if (!buf)
+			return EFI_OUT_OF_RESOURCES;
+		r->buf = buf;
+		r->buf_size = size;
+	}
+
+	start = now_ns();
+	switch (rec->op) {
+	case STORAGE_TRACE_READ:
+		ret = uefi_call_wrapper(r->blockio->ReadBlocks, 5, r->blockio,
+					media->MediaId, lba, size, r->buf);
+		break;
+	case STORAGE_TRACE_WRITE:
+		ret = uefi_call_wrapper(r->blockio->WriteBlocks, 5,
+					r->blockio, media->MediaId, lba,
+					size, r->buf);
+		break;
+	case STORAGE_TRACE_ERASE:
+		if (!r->erase) {
+			r->skipped++;
+			return EFI_SUCCESS;
+		}
+		ret = uefi_call_wrapper(r->erase->EraseBlocks, 5, r->erase,
+					media->MediaId, lba, NULL, size);
+		break;
+	default:
+		ret = uefi_call_wrapper(r->blockio->FlushBlocks, 1,
+					r->blockio);
+		size = 0;
+	}
+	latency = now_ns() - start;
+
+	stats = &r->stats[rec->op];
+	if (EFI_ERROR(ret))
+		stats->errors++;
+	else
+		stats->bytes += size;
+	return add_latency(stats, latency);
+}
+
+static int cmp_latency(const void *a, const void *b)
+{
+	UINT64 l1 = *(const UINT64 *)a, l2 = *(const UINT64 *)b;
+
+	return l1 < l2 ? -1 : l1 > l2 ? 1 : 0;
+}
+
+static UINT64 percentile(const op_stats_t *stats, unsigned int p)
+{
+	return stats->latencies[(stats->count - 1) * p / 100] / 1000;
+}
+
+static void report(replay_t *r, UINT64 duration, FILE *out)
+{
+	op_stats_t *stats;
+	size_t op;
+
+	fprintf(out, "Trace replay: %llu us, %llu skipped requests\n",
+		(unsigned long long)duration / 1000,
+		(unsigned long long)r->skipped);
+
+	for (op = 0; op < ARRAY_SIZE(r->stats); op++) {
+		stats = &r->stats[op];
+		if (!stats->count)
+			continue;
+
+		qsort(stats->latencies, stats->count,
+		      sizeof(*stats->latencies), cmp_latency);
+		fprintf(out, "  %s: %llu requests, %llu errors, %llu bytes, "
+			"%llu KB/s\n", OP_NAMES[op],
+			(unsigned long long)stats->count,
+			(unsigned long long)stats->errors,
+			(unsigned long long)stats->bytes,
+			(unsigned long long)(duration ?
+				stats->bytes * 1000000 / duration : 0));
+		fprintf(out, "    latency avg %llu us, p50 %llu us, "
+			"p99 %llu us, max %llu us\n",
+			(unsigned long long)(stats->total_latency /
+					     stats->count / 1000),
+			(unsigned long long)percentile(stats, 50),
+			(unsigned long long)percentile(stats, 99),
+			(unsigned long long)percentile(stats, 100));
+	}
+}
+
+EFI_STATUS trace_replay(EFI_SYSTEM_TABLE *st, const char *path,
+			const trace_replay_config_t *config, FILE *out)
+{
+	replay_t r = { 0 };
+	trace_header_t hdr;
+	trace_record_t rec;
+	UINT64 start;
+	EFI_STATUS ret;
+	FILE *file;
+	size_t i;
+
+	file = fopen(path, "r");
+	if (!file) {
+		ewerr("Failed to open %s I/O trace, %s", path,
+		      strerror(errno));
+		return EFI_NOT_FOUND;
+	}
+
+	if (fread(&hdr, sizeof(hdr), 1, file) != 1 ||
+	    memcmp(hdr.magic, TRACE_MAGIC, sizeof(hdr.magic)) ||
+	    hdr.record_size != sizeof(rec)) {
+		ewerr("%s is not a supported I/O trace", path);
+		ret = EFI_UNSUPPORTED;
+		goto out;
+	}
+
+	ret = open_target(st, config->target, &r);
+	if (EFI_ERROR(ret))
+		goto out;
+
+	start = now_ns();
+	while (fread(&rec, sizeof(rec), 1, file) == 1) {
+		if (rec.device != config->device)
+			continue;
+
+		if (rec.op >= ARRAY_SIZE(OP_NAMES) ||
+		    (!config->writes && (rec.op == STORAGE_TRACE_WRITE ||
+					 rec.op == STORAGE_TRACE_ERASE))) {
+			r.skipped++;
+			continue;
+		}
+
+		/* Late requests are issued right away */
+		if (!config->fast)
+			sleep_until(start + rec.timestamp);
+
+		ret = replay_one(&r, &rec);
+		if (EFI_ERROR(ret))
+			goto out;
+	}
+
+	if (ferror(file)) {
+		ewerr("Failed to read %s I/O trace", path);
+		ret = EFI_DEVICE_ERROR;
+		goto out;
+	}
+
+	report(&r, now_ns() - start, out);
+
+out:
+	for (i = 0; i < ARRAY_SIZE(r.stats); i++)
+		free(r.stats[i].latencies);
+	free(r.buf);
+	fclose(file);
+	return ret;
+}
@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2026, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _TRACE_H_
+#define _TRACE_H_
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <efi.h>
+#include <efiapi.h>
+
+/* Block I/O trace file: a header followed by one record per storage
+   request, in completion order.  Devices are numbered in the order
+   of their first request. */
+#define TRACE_MAGIC		"EWTRACE1"
+
+typedef struct trace_header {
+	char magic[8];
+	UINT32 record_size;
+	UINT32 reserved;
+} __attribute__((packed)) trace_header_t;
+
+typedef struct trace_record {
+	/* Nanoseconds, submission time since the capture start */
+	UINT64 timestamp;
+	UINT64 latency;
+	UINT64 lba;
+	UINT32 count;
+	/* enum storage_trace_op */
+	UINT8 op;
+	UINT8 device;
+	/* Non-zero if the request failed */
+	UINT8 error;
+	/* Log2 of the device block size */
+	UINT8 blk_shift;
+} __attribute__((packed)) trace_record_t;
+
+/* Record the storage requests to PATH until trace_stop().  The TSC
+   frequency must be known. */
+EFI_STATUS trace_start(const char *path);
+void trace_stop(void);
+
+typedef struct trace_replay_config {
+	/* Trace device whose requests are replayed */
+	UINT8 device;
+	/* Index of the storage device they are replayed on */
+	UINTN target;
+	/* Issue the requests back to back instead of at their trace
+	   time */
+	bool fast;
+	/* Also replay the writes and erases, which overwrite the
+	   target content */
+	bool writes;
+} trace_replay_config_t;
+
+/* Replay the PATH trace synchronously and print the throughput and
+   latency of each operation to OUT */
+EFI_STATUS trace_replay(EFI_SYSTEM_TABLE *st, const char *path,
+			const trace_replay_config_t *config, FILE *out);
+
+#endif	/* _TRACE_H_ */
@@ -41,11 +41,63 @@ typedef struct ewdrv {
 	EFI_STATUS (*init)(EFI_SYSTEM_TABLE *st); /* Mandatory */
 	EFI_STATUS (*exit)(EFI_SYSTEM_TABLE *st);
 	void *priv;
+	/* NULL terminated list of the name of the drivers which must
+	   be initialized before this one.  Names of drivers which are
+	   not part of EW_DRIVERS are ignored. */
+	const char * const *depends;
+	/* If set, INIT only starts the initialization and POLL is
+	   called until it returns something else than EFI_NOT_READY
+	   which is the status of the initialization.  Other drivers
+	   are initialized in between.  The NVMe and UFS drivers
+	   enable their controller in INIT and wait for it to be
+	   ready in POLL. */
+	EFI_STATUS (*poll)(EFI_SYSTEM_TABLE *st);
+	/* INIT can be run on another thread if a runner has been
+	   registered (cf. ewdrv_set_runner()).  INIT is always called
+	   with the driver lock held: it can release it with
+	   ewdrv_unlock() around long operations which do not access
+	   the system table. */
+	BOOLEAN concurrent;
+	/* A lazy driver is only initialized the first time one of the
+	   PROVIDES protocols (NULL terminated list) is looked up with
+	   LocateHandle(), LocateHandleBuffer(), LocateProtocol() or
+	   HandleProtocol(), or at boot if the boot storage type is
+	   part of the STORAGES mask (cf. EWDRV_STORAGE()). */
+	BOOLEAN lazy;
+	const EFI_GUID * const *provides;
+	UINT32 storages;
 } ewdrv_t;
 
+#define EWDRV_STORAGE(type)	(1U << (type))
+
 /* NULL terminated driver list */
 extern ewdrv_t **ew_drivers;
 
+/* Optional support to run driver initialization on other
+   threads. */
+typedef struct ewdrv_runner {
+	/* Start DRV->init(ST) on another thread */
+	EFI_STATUS (*start)(ewdrv_t *drv, EFI_SYSTEM_TABLE *st,
+			    void **job_p);
+	/* Return EFI_NOT_READY if JOB is still running.  Otherwise,
+	   release JOB and return the status of the driver
+	   initialization. */
+	EFI_STATUS (*check)(void *job);
+	void (*lock)(void);
+	void (*unlock)(void);
+} ewdrv_runner_t;
+
+EFI_STATUS ewdrv_set_runner(ewdrv_runner_t *runner);
+void ewdrv_lock(void);
+void ewdrv_unlock(void);
+
+/* Wait a little between two rounds of polling: used by the driver
+   scheduler and by WaitForEvent(). */
+void ewdrv_idle(void);
+
+/* Initialize the lazy drivers providing PROTOCOL */
+void ewdrv_provide(EFI_GUID *protocol);
+
 EFI_STATUS ewdrv_init(EFI_SYSTEM_TABLE *st);
 EFI_STATUS ewdrv_exit(EFI_SYSTEM_TABLE *st);
 
@@ -0,0 +1,170 @@
+/*
+ * Copyright (c) 2026, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef _EWPERF_H_
+#define _EWPERF_H_
+
+#include <efi.h>
+#include <efiapi.h>
+
+/* Boot-time measurement of the library components and drivers.
+   Timestamps are values of the clock set by the platform, usually the
+   Time Stamp Counter. */
+
+typedef enum ewperf_kind {
+	EWPERF_COMPONENT_INIT,
+	EWPERF_COMPONENT_FREE,
+	EWPERF_DRIVER_INIT,
+	EWPERF_DRIVER_EXIT,
+	EWPERF_MARKER,		/* START equals END */
+	EWPERF_PHASE
+} ewperf_kind_t;
+
+typedef struct ewperf_entry {
+	ewperf_kind_t kind;
+	const char *name;	/* Must remain valid */
+	UINT64 start;
+	UINT64 end;
+} ewperf_entry_t;
+
+/* Timestamp source.  The platform, or the host, sets it before
+   efiwrapper_init() along with its frequency (cf.
+   ewperf_set_tsc_freq()).  Until then, timestamps only count the ticks
+   of ewperf_advance_ns(). */
+typedef UINT64 (*ewperf_clock_t)(void);
+void ewperf_set_clock(ewperf_clock_t clock);
+
+/* Current timestamp: the clock value plus the ticks added by
+   ewperf_advance_ns() */
+UINT64 ewperf_tsc(void);
+
+/* Move the clock NS nanoseconds forward without waiting, so that the
+   time spent in an emulated device shows in the measurements.  The
+   TSC frequency must be known. */
+void ewperf_advance_ns(UINT64 ns);
+
+/* Record the [START, END] interval of NAME.  Entries beyond the
+   internal table capacity are dropped. */
+void ewperf_record(ewperf_kind_t kind, const char *name,
+		   UINT64 start, UINT64 end);
+
+/* Return the recorded entries in recording order */
+EFI_STATUS ewperf_get(const ewperf_entry_t **entries_p, UINTN *nb_p);
+
+const char *ewperf_kind_str(ewperf_kind_t kind);
+
+/* Record a NAME marker at the current time.  NAME is copied. */
+EFI_STATUS ewperf_mark(const char *name);
+
+/* Well known boot steps of the Firmware Basic Boot Performance
+   Record.  Only the first timestamp of each step is kept. */
+typedef enum ewperf_boot_step {
+	EWPERF_RESET_END,
+	EWPERF_LOAD_IMAGE,
+	EWPERF_START_IMAGE,
+	EWPERF_EXIT_BOOT_SERVICES_ENTRY,
+	EWPERF_EXIT_BOOT_SERVICES_EXIT,
+	EWPERF_NB_BOOT_STEPS
+} ewperf_boot_step_t;
+
+void ewperf_boot_step(ewperf_boot_step_t step);
+
+/* TSC frequency in Hz, zero if unknown.  The platform sets it so that
+   durations can be converted in time. */
+void ewperf_set_tsc_freq(UINT64 freq);
+UINT64 ewperf_get_tsc_freq(void);
+
+/* Convert a TSC ticks number in microseconds, or return TICKS if the
+   TSC frequency is unknown. */
+UINT64 ewperf_to_us(UINT64 ticks);
+UINT64 ewperf_to_ns(UINT64 ticks);
+
+/* Firmware Basic Boot Performance Table as defined by the ACPI
+   specification.  The basic boot performance record immediately
+   follows the header and string event records, one per marker and
+   two per interval, follow. */
+#define EWPERF_FBPT_SIGNATURE		0x54504246 /* "FBPT" */
+
+typedef struct ewperf_fbpt_header {
+	UINT32 signature;
+	UINT32 length;
+} __attribute__((packed)) ewperf_fbpt_header_t;
+
+typedef struct ewperf_record_header {
+	UINT16 type;
+	UINT8 length;
+	UINT8 revision;
+} __attribute__((packed)) ewperf_record_header_t;
+
+#define EWPERF_BASIC_BOOT_RECORD_TYPE	0x0002
+
+typedef struct ewperf_basic_boot_record {
+	ewperf_record_header_t header;
+	UINT32 reserved;
+	UINT64 reset_end;
+	UINT64 load_image_start;
+	UINT64 start_image_start;
+	UINT64 exit_boot_services_entry;
+	UINT64 exit_boot_services_exit;
+} __attribute__((packed)) ewperf_basic_boot_record_t;
+
+/* Dynamic string event record, PROGRESS_ID is one of the
+   EWPERF_PROGRESS_* values below. */
+#define EWPERF_STRING_EVENT_RECORD_TYPE	0x1011
+#define EWPERF_PROGRESS_MARKER		0x0040
+#define EWPERF_PROGRESS_START		0x0050
+#define EWPERF_PROGRESS_END		0x0051
+
+typedef struct ewperf_string_event_record {
+	ewperf_record_header_t header;
+	UINT16 progress_id;
+	UINT32 apic_id;
+	UINT64 timestamp;	/* nanoseconds */
+	EFI_GUID guid;
+	CHAR8 string[];
+} __attribute__((packed)) ewperf_string_event_record_t;
+
+/* Build the FBPT of the recorded entries in a newly allocated
+   buffer. */
+EFI_STATUS ewperf_build_fbpt(void **fbpt_p, UINTN *size_p);
+
+/* Write the FBPT of the recorded entries in the CAPACITY bytes long
+   FBPT buffer.  The last entries are left out if they do not fit. */
+EFI_STATUS ewperf_write_fbpt(void *fbpt, UINTN capacity);
+
+/* Refresh the basic boot record of FBPT with the current boot steps
+   timestamps. */
+void ewperf_update_fbpt(void *fbpt);
+
+/* Install the EFI Timestamp and efiwrapper Performance protocols */
+EFI_STATUS ewperf_init(EFI_SYSTEM_TABLE *st);
+EFI_STATUS ewperf_free(EFI_SYSTEM_TABLE *st);
+
+#endif	/* _EWPERF_H_ */
@@ -0,0 +1,73 @@
+/** @file
+  This file defines the efiwrapper Block Copy Protocol.
+
+  Copyright (c) 2026, Intel Corporation. All rights reserved.<BR>
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution. The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#ifndef __EFIWRAPPER_BLOCK_COPY_PROTOCOL_H__
+#define __EFIWRAPPER_BLOCK_COPY_PROTOCOL_H__
+
+#include <efi.h>
+#include <efiapi.h>
+
+#define EFIWRAPPER_BLOCK_COPY_PROTOCOL_GUID \
+  { \
+    0x8d2f61a4, 0x5b3e, 0x4c07, { 0xa1, 0x96, 0x2e, 0xd8, 0x47, 0x0b, 0x9c, 0x53 } \
+  }
+
+typedef struct _EFIWRAPPER_BLOCK_COPY_PROTOCOL EFIWRAPPER_BLOCK_COPY_PROTOCOL;
+
+#define EFIWRAPPER_BLOCK_COPY_PROTOCOL_REVISION 0x00010000
+
+/**
+  Copy a range of blocks to another location of the same media.
+
+  The blocks are copied by the device itself when it supports it
+  (NVMe Copy, file system copy_file_range()), otherwise they are read
+  and written back through memory with the reads and writes
+  overlapping.  The source and destination ranges may overlap.
+
+  @param[in]  This               The protocol instance pointer.
+  @param[in]  MediaId            The media ID that the request is for.
+  @param[in]  SrcLba             The starting logical block address to copy from.
+  @param[in]  DstLba             The starting logical block address to copy to.
+  @param[in]  Size               The number of bytes to copy, a multiple of
+                                 the block size.
+
+  @retval EFI_SUCCESS            The blocks were copied.
+  @retval EFI_MEDIA_CHANGED      The MediaId is not for the current media.
+  @retval EFI_BAD_BUFFER_SIZE    Size is not a multiple of the block size.
+  @retval EFI_INVALID_PARAMETER  A range is not valid for the media.
+  @retval EFI_OUT_OF_RESOURCES   The copy buffers could not be allocated.
+  @retval EFI_DEVICE_ERROR       The device reported an error.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EFIWRAPPER_BLOCK_COPY) (
+  IN EFIWRAPPER_BLOCK_COPY_PROTOCOL  *This,
+  IN UINT32                          MediaId,
+  IN EFI_LBA                         SrcLba,
+  IN EFI_LBA                         DstLba,
+  IN UINTN                           Size
+  );
+
+///
+/// The efiwrapper Block Copy Protocol is installed on the handle of
+/// each storage device and partition, along with the
+/// EFI_BLOCK_IO_PROTOCOL.
+///
+struct _EFIWRAPPER_BLOCK_COPY_PROTOCOL {
+  UINT64                   Revision;
+  EFIWRAPPER_BLOCK_COPY    CopyBlocks;
+};
+
+#endif
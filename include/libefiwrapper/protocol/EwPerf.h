@@ -0,0 +1,84 @@
+/** @file
+  This file defines the efiwrapper Performance Protocol.
+
+  Copyright (c) 2026, Intel Corporation. All rights reserved.<BR>
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution. The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#ifndef __EFIWRAPPER_PERF_PROTOCOL_H__
+#define __EFIWRAPPER_PERF_PROTOCOL_H__
+
+#include <efi.h>
+#include <efiapi.h>
+
+#define EFIWRAPPER_PERF_PROTOCOL_GUID \
+  { \
+    0x3c8d1f4e, 0x5a27, 0x4b6e, { 0x9d, 0x41, 0x7e, 0x0b, 0x2a, 0x93, 0xc6, 0x58 } \
+  }
+
+typedef struct _EFIWRAPPER_PERF_PROTOCOL EFIWRAPPER_PERF_PROTOCOL;
+
+#define EFIWRAPPER_PERF_PROTOCOL_REVISION 0x00010000
+
+/**
+  Record a named boot phase marker at the current timestamp.
+
+  @param[in]  This                The protocol instance pointer.
+  @param[in]  Name                The marker name.  It is copied.
+
+  @retval EFI_SUCCESS             The marker was recorded.
+  @retval EFI_INVALID_PARAMETER   Name is NULL.
+  @retval EFI_OUT_OF_RESOURCES    The record table is full.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EFIWRAPPER_PERF_MARK) (
+  IN EFIWRAPPER_PERF_PROTOCOL   *This,
+  IN CONST CHAR8                *Name
+  );
+
+/**
+  Record a named boot phase which ran from StartTimestamp to
+  EndTimestamp.  Timestamps are values returned by the
+  EFI_TIMESTAMP_PROTOCOL GetTimestamp() function.
+
+  @param[in]  This                The protocol instance pointer.
+  @param[in]  Name                The phase name.  It is copied.
+  @param[in]  StartTimestamp      The beginning of the phase.
+  @param[in]  EndTimestamp        The end of the phase.
+
+  @retval EFI_SUCCESS             The phase was recorded.
+  @retval EFI_INVALID_PARAMETER   Name is NULL or EndTimestamp is lower than
+                                  StartTimestamp.
+  @retval EFI_OUT_OF_RESOURCES    The record table is full.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EFIWRAPPER_PERF_RECORD) (
+  IN EFIWRAPPER_PERF_PROTOCOL   *This,
+  IN CONST CHAR8                *Name,
+  IN UINT64                     StartTimestamp,
+  IN UINT64                     EndTimestamp
+  );
+
+///
+/// The efiwrapper Performance Protocol collects the boot phases
+/// which are published in the ACPI Firmware Performance Data Table
+/// at ExitBootServices().
+///
+struct _EFIWRAPPER_PERF_PROTOCOL {
+  UINT64                     Revision;
+  EFIWRAPPER_PERF_MARK       Mark;
+  EFIWRAPPER_PERF_RECORD     Record;
+};
+
+#endif
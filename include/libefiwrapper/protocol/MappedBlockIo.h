@@ -0,0 +1,75 @@
+/** @file
+  This file defines the efiwrapper Mapped Block I/O Protocol.
+
+  Copyright (c) 2026, Intel Corporation. All rights reserved.<BR>
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution. The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#ifndef __EFIWRAPPER_MAPPED_BLOCK_IO_PROTOCOL_H__
+#define __EFIWRAPPER_MAPPED_BLOCK_IO_PROTOCOL_H__
+
+#include <efi.h>
+#include <efiapi.h>
+
+#define EFIWRAPPER_MAPPED_BLOCK_IO_PROTOCOL_GUID \
+  { \
+    0xa47b2e19, 0x6c0d, 0x4f83, { 0x8b, 0x5a, 0xd1, 0x39, 0x0e, 0x72, 0xc6, 0x4f } \
+  }
+
+typedef struct _EFIWRAPPER_MAPPED_BLOCK_IO_PROTOCOL EFIWRAPPER_MAPPED_BLOCK_IO_PROTOCOL;
+
+#define EFIWRAPPER_MAPPED_BLOCK_IO_PROTOCOL_REVISION 0x00010000
+
+/**
+  Return a direct pointer to a range of blocks, without any copy.
+
+  Only memory mapped storage devices, such as the host disk in mmap
+  mode, support this function.  The returned memory must not be
+  written.  It holds the blocks content at the time of the call and
+  remains valid until the storage device is removed, later writes to
+  the range may or may not be visible through it.
+
+  @param[in]  This               The protocol instance pointer.
+  @param[in]  MediaId            The media ID that the request is for.
+  @param[in]  Lba                The starting logical block address to map.
+  @param[in]  BufferSize         The number of bytes to map, a multiple of
+                                 the block size.
+  @param[out] Buffer             The address of the first mapped block.
+
+  @retval EFI_SUCCESS            Buffer points to the blocks.
+  @retval EFI_UNSUPPORTED        The storage device is not memory mapped,
+                                 the blocks must be read with ReadBlocks().
+  @retval EFI_MEDIA_CHANGED      The MediaId is not for the current media.
+  @retval EFI_BAD_BUFFER_SIZE    BufferSize is not a multiple of the block size.
+  @retval EFI_INVALID_PARAMETER  The range is not valid for the media or
+                                 Buffer is NULL.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EFIWRAPPER_MAP_BLOCKS) (
+  IN  EFIWRAPPER_MAPPED_BLOCK_IO_PROTOCOL  *This,
+  IN  UINT32                               MediaId,
+  IN  EFI_LBA                              Lba,
+  IN  UINTN                                BufferSize,
+  OUT VOID                                 **Buffer
+  );
+
+///
+/// The efiwrapper Mapped Block I/O Protocol is installed on the handle
+/// of each storage device and partition, along with the
+/// EFI_BLOCK_IO_PROTOCOL.
+///
+struct _EFIWRAPPER_MAPPED_BLOCK_IO_PROTOCOL {
+  UINT64                   Revision;
+  EFIWRAPPER_MAP_BLOCKS    MapBlocks;
+};
+
+#endif
@@ -0,0 +1,111 @@
+/** @file
+  This file defines the efiwrapper Media Statistics Protocol.
+
+  Copyright (c) 2026, Intel Corporation. All rights reserved.<BR>
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution. The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#ifndef __EFIWRAPPER_MEDIA_STATS_PROTOCOL_H__
+#define __EFIWRAPPER_MEDIA_STATS_PROTOCOL_H__
+
+#include <efi.h>
+#include <efiapi.h>
+
+#define EFIWRAPPER_MEDIA_STATS_PROTOCOL_GUID \
+  { \
+    0x8a61c0d2, 0x4f3b, 0x4e19, { 0xb2, 0x7c, 0x15, 0xd6, 0x3e, 0x90, 0x4a, 0xe1 } \
+  }
+
+typedef struct _EFIWRAPPER_MEDIA_STATS_PROTOCOL EFIWRAPPER_MEDIA_STATS_PROTOCOL;
+
+#define EFIWRAPPER_MEDIA_STATS_PROTOCOL_REVISION 0x00010000
+
+typedef enum {
+  MediaStatsRead,
+  MediaStatsWrite,
+  MediaStatsErase,
+  MediaStatsFlush,
+  MediaStatsOpMax
+} EFIWRAPPER_MEDIA_STATS_OP;
+
+///
+/// Bucket i of SizeHistogram counts the requests of [2^i, 2^(i+1)[
+/// bytes.  Bucket i of LatencyHistogram counts the requests which
+/// completed in [2^i, 2^(i+1)[ microseconds, bucket 0 includes the
+/// requests faster than a microsecond.  The last bucket of each
+/// histogram also counts all the larger values.
+///
+#define EFIWRAPPER_MEDIA_STATS_SIZE_BUCKETS     32
+#define EFIWRAPPER_MEDIA_STATS_LATENCY_BUCKETS  24
+
+typedef struct {
+  UINT64    Count;
+  UINT64    Errors;
+  UINT64    Bytes;
+  ///
+  /// Sum and maximum of the requests latency in microseconds.  The
+  /// latency fields stay zero while the timestamp counter frequency
+  /// is unknown.
+  ///
+  UINT64    TotalLatency;
+  UINT64    MaxLatency;
+  UINT64    SizeHistogram[EFIWRAPPER_MEDIA_STATS_SIZE_BUCKETS];
+  UINT64    LatencyHistogram[EFIWRAPPER_MEDIA_STATS_LATENCY_BUCKETS];
+} EFIWRAPPER_MEDIA_OP_STATS;
+
+typedef struct {
+  EFIWRAPPER_MEDIA_OP_STATS  Op[MediaStatsOpMax];
+} EFIWRAPPER_MEDIA_STATS;
+
+/**
+  Retrieve the I/O statistics of the media.
+
+  @param[in]   This              The protocol instance pointer.
+  @param[out]  Stats             The statistics since the media registration
+                                 or the last ResetStats() call.
+
+  @retval EFI_SUCCESS            The statistics were copied to Stats.
+  @retval EFI_INVALID_PARAMETER  Stats is NULL.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EFIWRAPPER_MEDIA_GET_STATS) (
+  IN  EFIWRAPPER_MEDIA_STATS_PROTOCOL  *This,
+  OUT EFIWRAPPER_MEDIA_STATS           *Stats
+  );
+
+/**
+  Reset the I/O statistics of the media.
+
+  @param[in]   This              The protocol instance pointer.
+
+  @retval EFI_SUCCESS            The statistics were reset.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EFIWRAPPER_MEDIA_RESET_STATS) (
+  IN  EFIWRAPPER_MEDIA_STATS_PROTOCOL  *This
+  );
+
+///
+/// The efiwrapper Media Statistics Protocol is installed on the
+/// handle of each storage device, along with the EFI_BLOCK_IO_PROTOCOL.
+/// The statistics of a device include the requests made through the
+/// handles of its partitions.
+///
+struct _EFIWRAPPER_MEDIA_STATS_PROTOCOL {
+  UINT64                         Revision;
+  EFIWRAPPER_MEDIA_GET_STATS     GetStats;
+  EFIWRAPPER_MEDIA_RESET_STATS   ResetStats;
+};
+
+#endif
@@ -0,0 +1,113 @@
+/** @file
+  This file defines the efiwrapper Partition Index Protocol.
+
+  Copyright (c) 2026, Intel Corporation. All rights reserved.<BR>
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution. The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#ifndef __EFIWRAPPER_PARTITION_INDEX_PROTOCOL_H__
+#define __EFIWRAPPER_PARTITION_INDEX_PROTOCOL_H__
+
+#include <efi.h>
+#include <efiapi.h>
+
+#define EFIWRAPPER_PARTITION_INDEX_PROTOCOL_GUID \
+  { \
+    0x5e1f7a93, 0xc86d, 0x4a02, { 0x8b, 0x3e, 0x62, 0xd4, 0x0f, 0x97, 0xa1, 0x2c } \
+  }
+
+typedef struct _EFIWRAPPER_PARTITION_INDEX_PROTOCOL EFIWRAPPER_PARTITION_INDEX_PROTOCOL;
+
+#define EFIWRAPPER_PARTITION_INDEX_PROTOCOL_REVISION 0x00010000
+
+#define EFIWRAPPER_PARTITION_NAME_LENGTH  36
+
+typedef struct {
+  ///
+  /// One-based index of the entry in the GPT partition entry array.
+  ///
+  UINT32      Number;
+  EFI_GUID    TypeGuid;
+  EFI_GUID    UniqueGuid;
+  EFI_LBA     StartingLba;
+  EFI_LBA     EndingLba;
+  UINT64      Attributes;
+  ///
+  /// NULL terminated copy of the GPT partition name.
+  ///
+  CHAR16      Name[EFIWRAPPER_PARTITION_NAME_LENGTH + 1];
+  ///
+  /// Child handle exposing the partition Block I/O, Disk I/O and
+  /// Device Path protocols.  NULL if it could not be installed.
+  ///
+  EFI_HANDLE  Handle;
+} EFIWRAPPER_PARTITION_INFO;
+
+/**
+  Look a partition up by name.
+
+  @param[in]   This              The protocol instance pointer.
+  @param[in]   Name              The NULL terminated partition name.  The
+                                 comparison is case sensitive.
+  @param[out]  Info              The partition description.
+
+  @retval EFI_SUCCESS            The partition was found.
+  @retval EFI_NOT_FOUND          No partition is named Name.
+  @retval EFI_INVALID_PARAMETER  Name or Info is NULL.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EFIWRAPPER_PARTITION_FIND_BY_NAME) (
+  IN  EFIWRAPPER_PARTITION_INDEX_PROTOCOL  *This,
+  IN  CONST CHAR16                         *Name,
+  OUT CONST EFIWRAPPER_PARTITION_INFO      **Info
+  );
+
+/**
+  Look a partition up by unique partition GUID.
+
+  @param[in]   This              The protocol instance pointer.
+  @param[in]   Guid              The unique partition GUID.
+  @param[out]  Info              The partition description.
+
+  @retval EFI_SUCCESS            The partition was found.
+  @retval EFI_NOT_FOUND          No partition has the Guid unique GUID.
+  @retval EFI_INVALID_PARAMETER  Guid or Info is NULL.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EFIWRAPPER_PARTITION_FIND_BY_GUID) (
+  IN  EFIWRAPPER_PARTITION_INDEX_PROTOCOL  *This,
+  IN  CONST EFI_GUID                       *Guid,
+  OUT CONST EFIWRAPPER_PARTITION_INFO      **Info
+  );
+
+///
+/// The efiwrapper Partition Index Protocol is installed on the handle
+/// of each storage device holding a valid GUID Partition Table.  It
+/// describes the partitions as parsed and validated at initialization
+/// so that looking a partition up does not issue any I/O.  After a
+/// write to the GPT blocks of the device, the next protocol lookup or
+/// FlushBlocks() call parses the GPT again: Partitions is reallocated
+/// and the handles of the partitions which changed are replaced, their
+/// previous handles and interfaces are then no longer valid.
+///
+struct _EFIWRAPPER_PARTITION_INDEX_PROTOCOL {
+  UINT64                             Revision;
+  EFI_GUID                           DiskGuid;
+  UINTN                              NumberOfPartitions;
+  CONST EFIWRAPPER_PARTITION_INFO    *Partitions;
+  EFIWRAPPER_PARTITION_FIND_BY_NAME  FindByName;
+  EFIWRAPPER_PARTITION_FIND_BY_GUID  FindByGuid;
+};
+
+#endif
@@ -0,0 +1,74 @@
+/** @file
+  This file defines the efiwrapper Sparse Write Protocol.
+
+  Copyright (c) 2026, Intel Corporation. All rights reserved.<BR>
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution. The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#ifndef __EFIWRAPPER_SPARSE_WRITE_PROTOCOL_H__
+#define __EFIWRAPPER_SPARSE_WRITE_PROTOCOL_H__
+
+#include <efi.h>
+#include <efiapi.h>
+
+#define EFIWRAPPER_SPARSE_WRITE_PROTOCOL_GUID \
+  { \
+    0x5f0a7c3e, 0x92d1, 0x4b58, { 0xb4, 0x0e, 0x6c, 0x1f, 0xa3, 0x27, 0xd9, 0x84 } \
+  }
+
+typedef struct _EFIWRAPPER_SPARSE_WRITE_PROTOCOL EFIWRAPPER_SPARSE_WRITE_PROTOCOL;
+
+#define EFIWRAPPER_SPARSE_WRITE_PROTOCOL_REVISION 0x00010000
+
+/**
+  Write an Android sparse image.
+
+  The chunks are decoded in order.  Consecutive RAW chunks are written
+  with a single vectored write, DONT_CARE chunks leave the blocks
+  untouched, FILL chunks of zeroes are zeroed by the device when it
+  supports it and other FILL chunks are written from a pattern buffer.
+
+  @param[in]  This               The protocol instance pointer.
+  @param[in]  MediaId            The media ID that the request is for.
+  @param[in]  Lba                The logical block address the image starts at.
+  @param[in]  Buffer             The sparse image.
+  @param[in]  BufferSize         The size of the sparse image in bytes.
+
+  @retval EFI_SUCCESS            The image was written.
+  @retval EFI_MEDIA_CHANGED      The MediaId is not for the current media.
+  @retval EFI_INVALID_PARAMETER  Buffer is not a valid sparse image or the
+                                 image does not fit on the media.
+  @retval EFI_UNSUPPORTED        The image format version or block size is
+                                 not supported.
+  @retval EFI_OUT_OF_RESOURCES   The FILL pattern buffer could not be allocated.
+  @retval EFI_DEVICE_ERROR       The device reported an error.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EFIWRAPPER_SPARSE_WRITE) (
+  IN EFIWRAPPER_SPARSE_WRITE_PROTOCOL  *This,
+  IN UINT32                            MediaId,
+  IN EFI_LBA                           Lba,
+  IN VOID                              *Buffer,
+  IN UINTN                             BufferSize
+  );
+
+///
+/// The efiwrapper Sparse Write Protocol is installed on the handle of
+/// each storage device and partition, along with the
+/// EFI_BLOCK_IO_PROTOCOL.
+///
+struct _EFIWRAPPER_SPARSE_WRITE_PROTOCOL {
+  UINT64                      Revision;
+  EFIWRAPPER_SPARSE_WRITE     WriteSparse;
+};
+
+#endif
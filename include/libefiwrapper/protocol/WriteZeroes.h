@@ -0,0 +1,71 @@
+/** @file
+  This file defines the efiwrapper Write Zeroes Protocol.
+
+  Copyright (c) 2026, Intel Corporation. All rights reserved.<BR>
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution. The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#ifndef __EFIWRAPPER_WRITE_ZEROES_PROTOCOL_H__
+#define __EFIWRAPPER_WRITE_ZEROES_PROTOCOL_H__
+
+#include <efi.h>
+#include <efiapi.h>
+
+#define EFIWRAPPER_WRITE_ZEROES_PROTOCOL_GUID \
+  { \
+    0x3c9e52b7, 0x1d84, 0x4a6f, { 0x9e, 0x21, 0x7b, 0x05, 0xc8, 0xd4, 0xf3, 0x6a } \
+  }
+
+typedef struct _EFIWRAPPER_WRITE_ZEROES_PROTOCOL EFIWRAPPER_WRITE_ZEROES_PROTOCOL;
+
+#define EFIWRAPPER_WRITE_ZEROES_PROTOCOL_REVISION 0x00010000
+
+/**
+  Zero a range of blocks.
+
+  The blocks are zeroed by the device itself when it supports it
+  (NVMe Write Zeroes, SCSI UNMAP or WRITE SAME, virtio-blk
+  WRITE_ZEROES, eMMC TRIM, file system hole punching), otherwise
+  zeroes are written.  In both cases, the blocks read as zeroes once
+  the function returns.
+
+  @param[in]  This               The protocol instance pointer.
+  @param[in]  MediaId            The media ID that the request is for.
+  @param[in]  Lba                The starting logical block address to zero.
+  @param[in]  Size               The number of bytes to zero, a multiple of
+                                 the block size.
+
+  @retval EFI_SUCCESS            The blocks were zeroed.
+  @retval EFI_MEDIA_CHANGED      The MediaId is not for the current media.
+  @retval EFI_BAD_BUFFER_SIZE    Size is not a multiple of the block size.
+  @retval EFI_INVALID_PARAMETER  The range is not valid for the media.
+  @retval EFI_DEVICE_ERROR       The device reported an error.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EFIWRAPPER_WRITE_ZEROES) (
+  IN EFIWRAPPER_WRITE_ZEROES_PROTOCOL  *This,
+  IN UINT32                            MediaId,
+  IN EFI_LBA                           Lba,
+  IN UINTN                             Size
+  );
+
+///
+/// The efiwrapper Write Zeroes Protocol is installed on the handle of
+/// each storage device and partition, along with the
+/// EFI_BLOCK_IO_PROTOCOL.
+///
+struct _EFIWRAPPER_WRITE_ZEROES_PROTOCOL {
+  UINT64                     Revision;
+  EFIWRAPPER_WRITE_ZEROES    WriteZeroes;
+};
+
+#endif
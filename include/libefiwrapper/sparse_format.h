@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2026, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _SPARSE_FORMAT_H_
+#define _SPARSE_FORMAT_H_
+
+#include <efi.h>
+#include <efiapi.h>
+
+/* Android sparse image format: a file header followed by
+   TOTAL_CHUNKS chunks, each one a chunk header followed by its
+   data. */
+#define SPARSE_HEADER_MAGIC	0xed26ff3a
+#define SPARSE_MAJOR_VERSION	1
+
+#define CHUNK_TYPE_RAW		0xCAC1
+#define CHUNK_TYPE_FILL		0xCAC2
+#define CHUNK_TYPE_DONT_CARE	0xCAC3
+#define CHUNK_TYPE_CRC32	0xCAC4
+
+typedef struct sparse_header {
+	UINT32 magic;
+	UINT16 major_version;
+	UINT16 minor_version;
+	UINT16 file_hdr_sz;
+	UINT16 chunk_hdr_sz;
+	UINT32 blk_sz;
+	UINT32 total_blks;
+	UINT32 total_chunks;
+	UINT32 image_checksum;
+} __attribute__((__packed__)) sparse_header_t;
+
+typedef struct chunk_header {
+	UINT16 chunk_type;
+	UINT16 reserved;
+	UINT32 chunk_sz;
+	UINT32 total_sz;
+} __attribute__((__packed__)) chunk_header_t;
+
+#endif	/* _SPARSE_FORMAT_H_ */
@@ -35,6 +35,46 @@
 #include <efi.h>
 #include <efiapi.h>
 
+enum storage_type {
+	STORAGE_EMMC,
+	STORAGE_UFS,
+	STORAGE_SDCARD,
+	STORAGE_SATA,
+	STORAGE_NVME,
+	STORAGE_VIRTUAL,
+	STORAGE_ALL
+};
+
+/* STORAGE_OP_ERASE requests are queued and executed by the media
+   layer with the erase() function, they never reach submit(). */
+enum storage_op {
+	STORAGE_OP_READ,
+	STORAGE_OP_WRITE,
+	STORAGE_OP_ERASE
+};
+
+/* Asynchronous request descriptor.  The submitter fills OP, LBA,
+   COUNT, BUF and COMPLETE.  The backend sets STATUS and calls
+   COMPLETE once the request is finished, from its poll() function
+   only, so that completions are always delivered in the caller
+   context. */
+typedef struct storage_req {
+	enum storage_op op;
+	EFI_LBA lba;
+	EFI_LBA count;
+	void *buf;
+	EFI_STATUS status;
+	void (*complete)(struct storage_req *req);
+	/* Reserved to the backend, typically to queue the request. */
+	struct storage_req *next;
+} storage_req_t;
+
+/* Scatter-gather segment, LEN is a multiple of the block size. */
+typedef struct storage_seg {
+	void *buf;
+	UINTN len;
+} storage_seg_t;
+
 typedef struct storage {
 	EFI_STATUS (*init)(struct storage *s);
 	EFI_LBA (*read)(struct storage *s, EFI_LBA start, EFI_LBA count,
@@ -42,6 +82,41 @@ typedef struct storage {
 	EFI_LBA (*write)(struct storage *s, EFI_LBA start, EFI_LBA count,
 			 const void *buf);
 	EFI_STATUS (*erase)(struct storage *s, EFI_LBA start, UINTN Size);
+	/* Optional vectored operations: transfer COUNT blocks starting
+	   at START from or to the NB_SEGS segments of SEGS, as a single
+	   device command whenever possible. */
+	EFI_LBA (*readv)(struct storage *s, EFI_LBA start, EFI_LBA count,
+			 const storage_seg_t *segs, UINTN nb_segs);
+	EFI_LBA (*writev)(struct storage *s, EFI_LBA start, EFI_LBA count,
+			  const storage_seg_t *segs, UINTN nb_segs);
+	/* Optional: zero COUNT blocks starting at START without any
+	   data transfer.  EFI_UNSUPPORTED, at any time, makes the media
+	   layer write zeroes instead. */
+	EFI_STATUS (*write_zeroes)(struct storage *s, EFI_LBA start,
+				   EFI_LBA count);
+	/* Optional: copy COUNT blocks from SRC to DST inside the
+	   device, the ranges never overlap.  EFI_UNSUPPORTED, at any
+	   time, makes the media layer copy through memory instead. */
+	EFI_STATUS (*copy)(struct storage *s, EFI_LBA src, EFI_LBA dst,
+			   EFI_LBA count);
+	/* Optional: make the previous writes persistent. */
+	EFI_STATUS (*flush)(struct storage *s);
+	/* Optional: return in ADDR a read-only pointer to the COUNT
+	   blocks starting at START, valid until the storage is freed.
+	   EFI_UNSUPPORTED if the blocks are not memory mapped. */
+	EFI_STATUS (*map)(struct storage *s, EFI_LBA start, EFI_LBA count,
+			  const void **addr);
+	/* Optional asynchronous interface.  submit() queues REQ and
+	   returns immediately, poll() reaps the finished requests.  If
+	   submit() is NULL, requests are emulated with read() and
+	   write(). */
+	EFI_STATUS (*submit)(struct storage *s, storage_req_t *req);
+	void (*poll)(struct storage *s);
+	/* Optimal erase granularity in blocks, erase commands are split
+	   on its boundaries.  Zero stands for one block. */
+	UINT32 erase_granularity;
+	/* Device type, selects the device path messaging node */
+	enum storage_type type;
 	UINT8 pci_function;
 	UINT8 pci_device;
 	EFI_LBA blk_cnt;
@@ -49,16 +124,6 @@ typedef struct storage {
 	void *priv;
 } storage_t;
 
-enum storage_type {
-	STORAGE_EMMC,
-	STORAGE_UFS,
-	STORAGE_SDCARD,
-	STORAGE_SATA,
-	STORAGE_NVME,
-	STORAGE_VIRTUAL,
-	STORAGE_ALL
-};
-
 typedef enum {
 	OsBootDeviceSata,
 	OsBootDeviceSd,
@@ -81,9 +146,35 @@ EFI_STATUS storage_init(EFI_SYSTEM_TABLE *st, storage_t *storage,
 			EFI_HANDLE *handle_p);
 EFI_STATUS storage_free(EFI_SYSTEM_TABLE *st, EFI_HANDLE handle);
 
+/* Deliver the completion of the finished asynchronous requests of all
+   the storage devices.  Return EFI_NOT_READY if some requests are
+   still in flight. */
+EFI_STATUS storage_poll(void);
+
+enum storage_trace_op {
+	STORAGE_TRACE_READ,
+	STORAGE_TRACE_WRITE,
+	STORAGE_TRACE_ERASE,
+	STORAGE_TRACE_FLUSH
+};
+
+/* Called once per read, write, erase or flush request served by the
+   media layer, on completion, with the COUNT storage blocks from LBA
+   it covers, its submission and completion TSC timestamps and its
+   status.  Flush requests cover no block. */
+typedef void (*storage_trace_t)(storage_t *storage,
+				enum storage_trace_op op, EFI_LBA lba,
+				EFI_LBA count, UINT64 start, UINT64 end,
+				EFI_STATUS status);
+
+/* Report the requests of all the storage devices to TRACE, NULL to
+   stop. */
+void storage_set_trace(storage_trace_t trace);
+
 EFI_STATUS identify_boot_media();
 
 boot_dev_t* get_boot_media();
 UINT8 get_boot_media_device_path_type(void);
+UINT8 get_storage_device_path_type(enum storage_type type);
 
 #endif	/* _STORAGE_H_ */
@@ -3,6 +3,7 @@ LOCAL_PATH := $(call my-dir)
 LIBEFIWRAPPER_SRC_FILES := \
 	ewvar.c \
 	ewdrv.c \
+	ewperf.c \
 	protocol.c \
 	core.c \
 	lib.c \
@@ -13,7 +14,9 @@ LIBEFIWRAPPER_SRC_FILES := \
 	serialio.c \
 	storage.c \
 	blockio.c \
+	blockio2.c \
 	diskio.c \
+	diskio2.c \
 	interface.c \
 	media.c \
 	conf_table.c \
@@ -22,7 +25,14 @@ LIBEFIWRAPPER_SRC_FILES := \
 	ewarg.c \
 	sdio.c \
 	ewlib.c \
-	eraseblk.c
+	eraseblk.c \
+	mediastats.c \
+	writezeroes.c \
+	blockcopy.c \
+	sparse.c \
+	mappedblkio.c \
+	partition.c \
+	blkcache.c
 
 include $(CLEAR_VARS)
 LOCAL_MODULE := libefiwrapper-$(TARGET_BUILD_VARIANT)
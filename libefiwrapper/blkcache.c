@@ -0,0 +1,418 @@
+/*
+ * Copyright (c) 2026, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "blkcache.h"
+#include "external.h"
+
+/* Maximum number of contiguous dirty blocks written at once by
+   blkcache_flush(). */
+#define FLUSH_RUN_BLOCKS	32
+
+struct entry {
+	EFI_LBA lba;
+	BOOLEAN valid;
+	BOOLEAN dirty;
+	unsigned char *data;
+	struct entry *hnext;
+	struct entry *prev;
+	struct entry *next;
+};
+
+struct blkcache {
+	storage_t *storage;
+	UINT32 blksz;
+	BOOLEAN write_back;
+	UINTN nb_entries;
+	UINTN nb_dirty;
+	struct entry *entries;
+	struct entry **buckets;
+	UINTN mask;
+	/* LRU list sentinel: lru.next is the most recently used
+	   entry, lru.prev the least recently used one. */
+	struct entry lru;
+	struct entry **sorted;
+	unsigned char *data;
+	unsigned char *flush_buf;
+	blkcache_stats_t stats;
+};
+
+static UINTN hash(blkcache_t *cache, EFI_LBA lba)
+{
+	return (UINTN)((lba * 0x9E3779B97F4A7C15ULL) >> 32) & cache->mask;
+}
+
+static struct entry *lookup(blkcache_t *cache, EFI_LBA lba)
+{
+	struct entry *e;
+
+	for (e = cache->buckets[hash(cache, lba)]; e; e = e->hnext)
+		if (e->lba == lba)
+			return e;
+
+	return NULL;
+}
+
+static void hash_insert(blkcache_t *cache, struct entry *e)
+{
+	struct entry **head = &cache->buckets[hash(cache, e->lba)];
+
+	e->hnext = *head;
+	*head = e;
+}
+
+static void hash_remove(blkcache_t *cache, struct entry *e)
+{
+	struct entry **cur = &cache->buckets[hash(cache, e->lba)];
+
+	for (; *cur; cur = &(*cur)->hnext)
+		if (*cur == e) {
+			*cur = e->hnext;
+			break;
+		}
+}
+
+static void lru_unlink(struct entry *e)
+{
+	e->prev->next = e->next;
+	e->next->prev = e->prev;
+}
+
+static void lru_touch(blkcache_t *cache, struct entry *e)
+{
+	lru_unlink(e);
+	e->prev = &cache->lru;
+	e->next = cache->lru.next;
+	cache->lru.next->prev = e;
+	cache->lru.next = e;
+}
+
+static void lru_add_tail(blkcache_t *cache, struct entry *e)
+{
+	e->next = &cache->lru;
+	e->prev = cache->lru.prev;
+	cache->lru.prev->next = e;
+	cache->lru.prev = e;
+}
+
+static void lru_demote(blkcache_t *cache, struct entry *e)
+{
+	lru_unlink(e);
+	lru_add_tail(cache, e);
+}
+
+static void drop(blkcache_t *cache, struct entry *e)
+{
+	if (e->dirty)
+		cache->nb_dirty--;
+	hash_remove(cache, e);
+	e->valid = FALSE;
+	e->dirty = FALSE;
+	lru_demote(cache, e);
+}
+
+/* Return the least recently used entry, ready to be reused.  A dirty
+   victim triggers the write-back of all the dirty entries so that
+   they reach the device as a few sorted and contiguous writes. */
+static struct entry *evict(blkcache_t *cache)
+{
+	EFI_STATUS ret;
+	struct entry *e = cache->lru.prev;
+
+	if (!e->valid)
+		return e;
+
+	if (e->dirty) {
+		ret = blkcache_flush(cache);
+		if (EFI_ERROR(ret))
+			return NULL;
+	}
+
+	hash_remove(cache, e);
+	e->valid = FALSE;
+	cache->stats.evictions++;
+
+	return e;
+}
+
+static struct entry *insert(blkcache_t *cache, EFI_LBA lba, const void *data)
+{
+	struct entry *e;
+
+	e = evict(cache);
+	if (!e)
+		return NULL;
+
+	e->lba = lba;
+	e->valid = TRUE;
+	e->dirty = FALSE;
+	memcpy(e->data, data, cache->blksz);
+	hash_insert(cache, e);
+	lru_touch(cache, e);
+
+	return e;
+}
+
+blkcache_t *blkcache_new(storage_t *storage, UINTN nb_blocks,
+			 BOOLEAN write_back)
+{
+	blkcache_t *cache;
+	UINTN i, nb_buckets;
+
+	if (!storage || !storage->blk_sz || !nb_blocks)
+		return NULL;
+
+	cache = calloc(1, sizeof(*cache));
+	if (!cache)
+		return NULL;
+
+	for (nb_buckets = 1; nb_buckets < nb_blocks; nb_buckets <<= 1)
+		;
+
+	cache->storage = storage;
+	cache->blksz = storage->blk_sz;
+	cache->write_back = write_back;
+	cache->nb_entries = nb_blocks;
+	cache->mask = nb_buckets - 1;
+	cache->entries = calloc(nb_blocks, sizeof(*cache->entries));
+	cache->buckets = calloc(nb_buckets, sizeof(*cache->buckets));
+	cache->sorted = calloc(nb_blocks, sizeof(*cache->sorted));
+	cache->data = malloc(nb_blocks * cache->blksz);
+	cache->flush_buf = malloc(FLUSH_RUN_BLOCKS * cache->blksz);
+	if (!cache->entries || !cache->buckets || !cache->sorted ||
+	    !cache->data || !cache->flush_buf) {
+		blkcache_free(cache);
+		return NULL;
+	}
+
+	cache->lru.next = cache->lru.prev = &cache->lru;
+	for (i = 0; i < nb_blocks; i++) {
+		cache->entries[i].data = cache->data + i * cache->blksz;
+		lru_add_tail(cache, &cache->entries[i]);
+	}
+
+	return cache;
+}
+
+void blkcache_free(blkcache_t *cache)
+{
+	if (!cache)
+		return;
+
+	free(cache->flush_buf);
+	free(cache->data);
+	free(cache->sorted);
+	free(cache->buckets);
+	free(cache->entries);
+	free(cache);
+}
+
+/* Apply the dirty cached blocks of [LBA, LBA + COUNT[ on top of BUF
+   which has just been read from the device. */
+static void overlay_dirty(blkcache_t *cache, EFI_LBA lba, EFI_LBA count,
+			  unsigned char *buf)
+{
+	struct entry *e;
+	UINTN i;
+
+	for (i = 0; cache->nb_dirty && i < cache->nb_entries; i++) {
+		e = &cache->entries[i];
+		if (e->dirty && e->lba >= lba && e->lba - lba < count)
+			memcpy(buf + (e->lba - lba) * cache->blksz, e->data,
+			       cache->blksz);
+	}
+}
+
+EFI_STATUS blkcache_read(blkcache_t *cache, EFI_LBA lba, EFI_LBA count,
+			 void *buf)
+{
+	storage_t *s = cache->storage;
+	unsigned char *dst = buf;
+	struct entry *e;
+	EFI_LBA i, j, k;
+
+	if (count >= BLKCACHE_BYPASS_BLOCKS) {
+		cache->stats.bypassed++;
+		if (s->read(s, lba, count, buf) != count)
+			return EFI_DEVICE_ERROR;
+		overlay_dirty(cache, lba, count, buf);
+		return EFI_SUCCESS;
+	}
+
+	for (i = 0; i < count; i = j) {
+		e = lookup(cache, lba + i);
+		if (e) {
+			memcpy(dst + i * cache->blksz, e->data, cache->blksz);
+			lru_touch(cache, e);
+			cache->stats.hits++;
+			j = i + 1;
+			continue;
+		}
+
+		/* Read the whole run of missing blocks at once. */
+		for (j = i + 1; j < count && !lookup(cache, lba + j); j++)
+			;
+		cache->stats.misses += j - i;
+
+		if (s->read(s, lba + i, j - i, dst + i * cache->blksz) != j - i)
+			return EFI_DEVICE_ERROR;
+
+		for (k = i; k < j; k++)
+			if (!insert(cache, lba + k, dst + k * cache->blksz))
+				return EFI_DEVICE_ERROR;
+	}
+
+	return EFI_SUCCESS;
+}
+
+EFI_STATUS blkcache_write(blkcache_t *cache, EFI_LBA lba, EFI_LBA count,
+			  const void *buf)
+{
+	storage_t *s = cache->storage;
+	const unsigned char *src = buf;
+	struct entry *e;
+	EFI_LBA i;
+
+	if (count >= BLKCACHE_BYPASS_BLOCKS) {
+		cache->stats.bypassed++;
+		if (s->write(s, lba, count, buf) != count)
+			return EFI_DEVICE_ERROR;
+		blkcache_invalidate(cache, lba, count);
+		return EFI_SUCCESS;
+	}
+
+	if (!cache->write_back && s->write(s, lba, count, buf) != count)
+		return EFI_DEVICE_ERROR;
+
+	for (i = 0; i < count; i++) {
+		e = lookup(cache, lba + i);
+		if (e) {
+			memcpy(e->data, src + i * cache->blksz, cache->blksz);
+			lru_touch(cache, e);
+		} else {
+			e = insert(cache, lba + i, src + i * cache->blksz);
+			if (!e)
+				return EFI_DEVICE_ERROR;
+		}
+
+		if (cache->write_back && !e->dirty) {
+			e->dirty = TRUE;
+			cache->nb_dirty++;
+		}
+	}
+
+	return EFI_SUCCESS;
+}
+
+static EFI_STATUS write_run(blkcache_t *cache, struct entry **run, UINTN n)
+{
+	storage_t *s = cache->storage;
+	unsigned char *data;
+	UINTN i;
+
+	if (n == 1)
+		data = run[0]->data;
+	else {
+		data = cache->flush_buf;
+		for (i = 0; i < n; i++)
+			memcpy(data + i * cache->blksz, run[i]->data,
+			       cache->blksz);
+	}
+
+	if (s->write(s, run[0]->lba, n, data) != n)
+		return EFI_DEVICE_ERROR;
+
+	for (i = 0; i < n; i++)
+		run[i]->dirty = FALSE;
+	cache->nb_dirty -= n;
+	cache->stats.writebacks += n;
+
+	return EFI_SUCCESS;
+}
+
+EFI_STATUS blkcache_flush(blkcache_t *cache)
+{
+	EFI_STATUS ret;
+	struct entry *e;
+	UINTN i, j, n, start;
+
+	if (!cache->nb_dirty)
+		return EFI_SUCCESS;
+
+	/* Collect the dirty entries sorted by LBA.  They are usually
+	   written in ascending order so an insertion sort is cheap. */
+	for (i = 0, n = 0; i < cache->nb_entries; i++) {
+		e = &cache->entries[i];
+		if (!e->dirty)
+			continue;
+
+		for (j = n; j > 0 && cache->sorted[j - 1]->lba > e->lba; j--)
+			cache->sorted[j] = cache->sorted[j - 1];
+		cache->sorted[j] = e;
+		n++;
+	}
+
+	for (start = 0; start < n; start = i) {
+		for (i = start + 1; i < n && i - start < FLUSH_RUN_BLOCKS &&
+			     cache->sorted[i]->lba == cache->sorted[i - 1]->lba + 1;
+		     i++)
+			;
+
+		ret = write_run(cache, &cache->sorted[start], i - start);
+		if (EFI_ERROR(ret))
+			return ret;
+	}
+
+	return EFI_SUCCESS;
+}
+
+void blkcache_invalidate(blkcache_t *cache, EFI_LBA lba, EFI_LBA count)
+{
+	struct entry *e;
+	UINTN i;
+
+	if (count > cache->nb_entries) {
+		for (i = 0; i < cache->nb_entries; i++) {
+			e = &cache->entries[i];
+			if (e->valid && e->lba >= lba && e->lba - lba < count)
+				drop(cache, e);
+		}
+		return;
+	}
+
+	for (i = 0; i < count; i++) {
+		e = lookup(cache, lba + i);
+		if (e)
+			drop(cache, e);
+	}
+}
+
+void blkcache_get_stats(blkcache_t *cache, blkcache_stats_t *stats)
+{
+	memcpy(stats, &cache->stats, sizeof(*stats));
+}
@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2026, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _BLKCACHE_H_
+#define _BLKCACHE_H_
+
+#include <efi.h>
+#include <efiapi.h>
+#include <storage.h>
+
+/* Default number of cached blocks, can be overridden with the
+   EW.blkcache=<blocks> argument.  Zero disables the cache: it is
+   opt-in since it changes how the requests reach the storage. */
+#ifndef BLKCACHE_DEFAULT_BLOCKS
+#define BLKCACHE_DEFAULT_BLOCKS	0
+#endif
+
+/* Transfers of at least this number of blocks bypass the cache. */
+#ifndef BLKCACHE_BYPASS_BLOCKS
+#define BLKCACHE_BYPASS_BLOCKS	64
+#endif
+
+typedef struct blkcache_stats {
+	UINT64 hits;
+	UINT64 misses;
+	UINT64 bypassed;
+	UINT64 evictions;
+	UINT64 writebacks;
+} blkcache_stats_t;
+
+typedef struct blkcache blkcache_t;
+
+/* Allocate a block cache of NB_BLOCKS blocks in front of STORAGE.  If
+   WRITE_BACK is TRUE, writes are kept in the cache until they are
+   evicted or blkcache_flush() is called. */
+blkcache_t *blkcache_new(storage_t *storage, UINTN nb_blocks,
+			 BOOLEAN write_back);
+void blkcache_free(blkcache_t *cache);
+
+EFI_STATUS blkcache_read(blkcache_t *cache, EFI_LBA lba, EFI_LBA count,
+			 void *buf);
+EFI_STATUS blkcache_write(blkcache_t *cache, EFI_LBA lba, EFI_LBA count,
+			  const void *buf);
+EFI_STATUS blkcache_flush(blkcache_t *cache);
+
+/* Drop the COUNT blocks starting at LBA, dirty or not. */
+void blkcache_invalidate(blkcache_t *cache, EFI_LBA lba, EFI_LBA count);
+
+void blkcache_get_stats(blkcache_t *cache, blkcache_stats_t *stats);
+
+#endif	/* _BLKCACHE_H_ */
@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2026, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "blockcopy.h"
+#include "external.h"
+#include "interface.h"
+
+typedef struct block_copy {
+	EFIWRAPPER_BLOCK_COPY_PROTOCOL interface;
+	media_t *media;
+} block_copy_t;
+
+static EFIAPI EFI_STATUS
+copy_blocks(EFIWRAPPER_BLOCK_COPY_PROTOCOL *This, UINT32 MediaId,
+	    EFI_LBA SrcLba, EFI_LBA DstLba, UINTN Size)
+{
+	block_copy_t *bc = (block_copy_t *)This;
+	media_t *media;
+	EFI_LBA count;
+
+	if (!This || !bc->media)
+		return EFI_INVALID_PARAMETER;
+
+	media = bc->media;
+	if (media->m.MediaId != MediaId)
+		return EFI_MEDIA_CHANGED;
+
+	if (Size % media->m.BlockSize)
+		return EFI_BAD_BUFFER_SIZE;
+
+	count = Size / media->m.BlockSize;
+	if (SrcLba > media->m.LastBlock ||
+	    count > media->m.LastBlock + 1 - SrcLba ||
+	    DstLba > media->m.LastBlock ||
+	    count > media->m.LastBlock + 1 - DstLba)
+		return EFI_INVALID_PARAMETER;
+
+	return media_copy(media, SrcLba, DstLba, count);
+}
+
+static EFI_GUID block_copy_guid = EFIWRAPPER_BLOCK_COPY_PROTOCOL_GUID;
+
+EFI_STATUS block_copy_init(EFI_SYSTEM_TABLE *st, media_t *media,
+			   EFI_HANDLE *handle)
+{
+	EFI_STATUS ret;
+	block_copy_t *bc;
+
+	static block_copy_t block_copy_default = {
+		.interface = {
+			.Revision = EFIWRAPPER_BLOCK_COPY_PROTOCOL_REVISION,
+			.CopyBlocks = copy_blocks
+		}
+	};
+
+	ret = interface_init(st, &block_copy_guid, handle,
+			     &block_copy_default,
+			     sizeof(block_copy_default), (void **)&bc);
+	if (EFI_ERROR(ret))
+		return ret;
+
+	bc->media = media;
+
+	return EFI_SUCCESS;
+}
+
+EFI_STATUS block_copy_free(EFI_SYSTEM_TABLE *st, EFI_HANDLE handle)
+{
+	return interface_free(st, &block_copy_guid, handle);
+}
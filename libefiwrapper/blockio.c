@@ -32,6 +32,7 @@
 #include "blockio.h"
 #include "external.h"
 #include "interface.h"
+#include "partition.h"
 
 #include <efilib.h>
 
@@ -49,7 +50,6 @@ static EFI_STATUS blockio_access(BOOLEAN read, EFI_BLOCK_IO *This,
 	media_t *media;
 	UINT32 blksz;
 	UINTN size;
-	EFI_LBA count;
 
 	if (!This)
 		return EFI_INVALID_PARAMETER;
@@ -69,12 +69,13 @@ static EFI_STATUS blockio_access(BOOLEAN read, EFI_BLOCK_IO *This,
 		return EFI_BAD_BUFFER_SIZE;
 
 	size = BufferSize / blksz;
+	if (LBA > media->m.LastBlock || size > media->m.LastBlock + 1 - LBA)
+		return EFI_INVALID_PARAMETER;
+
 	if (read)
-		count = media->storage->read(media->storage, LBA, size, Buffer);
-	else
-		count = media->storage->write(media->storage, LBA, size, Buffer);
+		return media_read(media, LBA, size, Buffer);
 
-	return count == size ? EFI_SUCCESS : EFI_DEVICE_ERROR;
+	return media_write(media, LBA, size, Buffer);
 }
 
 static EFIAPI EFI_STATUS
@@ -92,9 +93,23 @@ blockio_read(EFI_BLOCK_IO *This, UINT32 MediaId, EFI_LBA LBA,
 }
 
 static EFIAPI EFI_STATUS
-blockio_flush(__attribute__((__unused__)) EFI_BLOCK_IO *This)
+blockio_flush(EFI_BLOCK_IO *This)
 {
-	return EFI_SUCCESS;
+	EFI_STATUS ret;
+
+	if (!This)
+		return EFI_INVALID_PARAMETER;
+
+	if (!This->Media)
+		return EFI_NO_MEDIA;
+
+	ret = media_flush((media_t *)This->Media);
+
+	/* A GPT update ends with a flush.  This may release THIS if
+	   its partition changed. */
+	partition_refresh();
+
+	return ret;
 }
 
 static EFI_GUID blockio_guid = BLOCK_IO_PROTOCOL;
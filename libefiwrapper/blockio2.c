@@ -0,0 +1,200 @@
+/*
+ * Copyright (c) 2026, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "blockio2.h"
+#include "protocol/BlockIo2.h"
+#include "external.h"
+#include "interface.h"
+#include "partition.h"
+
+#include <efilib.h>
+
+typedef struct blockio2 {
+	EFI_BLOCK_IO2_PROTOCOL interface;
+	EFI_BOOT_SERVICES *bs;
+} blockio2_t;
+
+typedef struct blockio2_req {
+	media_req_t mreq;
+	EFI_BOOT_SERVICES *bs;
+	EFI_BLOCK_IO2_TOKEN *token;
+} blockio2_req_t;
+
+static EFIAPI EFI_STATUS
+blockio2_reset(__attribute__((__unused__)) EFI_BLOCK_IO2_PROTOCOL *This,
+	       __attribute__((__unused__)) BOOLEAN ExtendedVerification)
+{
+	return EFI_SUCCESS;
+}
+
+static void blockio2_complete(media_req_t *mreq)
+{
+	blockio2_req_t *req = (blockio2_req_t *)mreq;
+
+	req->token->TransactionStatus = mreq->req.status;
+	uefi_call_wrapper(req->bs->SignalEvent, 1, req->token->Event);
+	free(req);
+}
+
+static EFI_STATUS blockio2_access(enum storage_op op,
+				  EFI_BLOCK_IO2_PROTOCOL *This,
+				  UINT32 MediaId, EFI_LBA LBA,
+				  EFI_BLOCK_IO2_TOKEN *Token,
+				  UINTN BufferSize, VOID *Buffer)
+{
+	EFI_STATUS ret;
+	blockio2_req_t *req;
+	media_t *media;
+	UINT32 blksz;
+	UINTN count;
+
+	if (!This || !Buffer)
+		return EFI_INVALID_PARAMETER;
+
+	if (!This->Media)
+		return EFI_NO_MEDIA;
+
+	media = (media_t *)This->Media;
+	if (MediaId != media->m.MediaId)
+		return EFI_MEDIA_CHANGED;
+
+	blksz = media->m.BlockSize;
+	if (!blksz)
+		return EFI_INVALID_PARAMETER;
+
+	if (BufferSize % blksz)
+		return EFI_BAD_BUFFER_SIZE;
+
+	count = BufferSize / blksz;
+	if (LBA > media->m.LastBlock || count > media->m.LastBlock + 1 - LBA)
+		return EFI_INVALID_PARAMETER;
+
+	if (!Token || !Token->Event) {
+		if (op == STORAGE_OP_READ)
+			return media_read(media, LBA, count, Buffer);
+		return media_write(media, LBA, count, Buffer);
+	}
+
+	req = calloc(1, sizeof(*req));
+	if (!req)
+		return EFI_OUT_OF_RESOURCES;
+
+	req->bs = ((blockio2_t *)This)->bs;
+	req->token = Token;
+	req->mreq.complete = blockio2_complete;
+	req->mreq.req.op = op;
+	req->mreq.req.lba = LBA;
+	req->mreq.req.count = count;
+	req->mreq.req.buf = Buffer;
+
+	Token->TransactionStatus = EFI_NOT_READY;
+	ret = media_submit(media, &req->mreq);
+	if (EFI_ERROR(ret))
+		free(req);
+
+	return ret;
+}
+
+static EFIAPI EFI_STATUS
+blockio2_read(EFI_BLOCK_IO2_PROTOCOL *This, UINT32 MediaId, EFI_LBA LBA,
+	      EFI_BLOCK_IO2_TOKEN *Token, UINTN BufferSize, VOID *Buffer)
+{
+	return blockio2_access(STORAGE_OP_READ, This, MediaId, LBA, Token,
+			       BufferSize, Buffer);
+}
+
+static EFIAPI EFI_STATUS
+blockio2_write(EFI_BLOCK_IO2_PROTOCOL *This, UINT32 MediaId, EFI_LBA LBA,
+	       EFI_BLOCK_IO2_TOKEN *Token, UINTN BufferSize, VOID *Buffer)
+{
+	return blockio2_access(STORAGE_OP_WRITE, This, MediaId, LBA, Token,
+			       BufferSize, Buffer);
+}
+
+static EFIAPI EFI_STATUS
+blockio2_flush(EFI_BLOCK_IO2_PROTOCOL *This, EFI_BLOCK_IO2_TOKEN *Token)
+{
+	EFI_STATUS ret;
+	media_t *media;
+
+	if (!This)
+		return EFI_INVALID_PARAMETER;
+
+	if (!This->Media)
+		return EFI_NO_MEDIA;
+
+	/* All the outstanding writes must reach the device first. */
+	media = (media_t *)This->Media;
+	media_drain(media);
+
+	ret = media_flush(media);
+	if (!EFI_ERROR(ret) && Token && Token->Event) {
+		Token->TransactionStatus = EFI_SUCCESS;
+		uefi_call_wrapper(((blockio2_t *)This)->bs->SignalEvent, 1,
+				  Token->Event);
+	}
+
+	/* See blockio_flush() */
+	partition_refresh();
+
+	return ret;
+}
+
+static EFI_GUID blockio2_guid = EFI_BLOCK_IO2_PROTOCOL_GUID;
+
+EFI_STATUS blockio2_init(EFI_SYSTEM_TABLE *st, media_t *media,
+			 EFI_HANDLE *handle)
+{
+	static blockio2_t blockio2_default = {
+		.interface = {
+			.Reset = blockio2_reset,
+			.ReadBlocksEx = blockio2_read,
+			.WriteBlocksEx = blockio2_write,
+			.FlushBlocksEx = blockio2_flush
+		}
+	};
+	EFI_STATUS ret;
+	blockio2_t *blockio2;
+
+	ret = interface_init(st, &blockio2_guid, handle,
+			     &blockio2_default, sizeof(blockio2_default),
+			     (void **)&blockio2);
+	if (EFI_ERROR(ret))
+		return ret;
+
+	blockio2->interface.Media = &media->m;
+	blockio2->bs = st->BootServices;
+
+	return EFI_SUCCESS;
+}
+
+EFI_STATUS blockio2_free(EFI_SYSTEM_TABLE *st, EFI_HANDLE handle)
+{
+	return interface_free(st, &blockio2_guid, handle);
+}
@@ -30,9 +30,13 @@
  */
 
 #include "bs.h"
+#include "ewdrv.h"
+#include "ewperf.h"
 #include "lib.h"
 #include "protocol.h"
 
+#include <storage.h>
+
 static EFIAPI EFI_TPL
 bs_raise_TPL(__attribute__((__unused__)) EFI_TPL NewTpl)
 {
@@ -97,6 +101,7 @@ typedef struct event {
 	EFI_TPL tpl;
 	EFI_EVENT_NOTIFY notify;
 	VOID *context;
+	BOOLEAN signaled;
 } event_t;
 
 static EFIAPI EFI_STATUS
@@ -121,6 +126,7 @@ bs_create_event(UINT32 Type,
 	event->tpl = NotifyTpl;
 	event->notify = NotifyFunction;
 	event->context = NotifyContext;
+	event->signaled = FALSE;
 	*Event = event;
 
 	return EFI_SUCCESS;
@@ -134,14 +140,6 @@ bs_set_timer(__attribute__((__unused__)) EFI_EVENT Event,
 	return EFI_UNSUPPORTED;
 }
 
-static EFIAPI EFI_STATUS
-bs_wait_for_event(__attribute__((__unused__)) UINTN NumberOfEvents,
-		  __attribute__((__unused__)) EFI_EVENT *Event,
-		  __attribute__((__unused__)) UINTN *Index)
-{
-	return EFI_UNSUPPORTED;
-}
-
 static EFIAPI EFI_STATUS
 bs_signal_event(EFI_EVENT Event)
 {
@@ -150,8 +148,10 @@ bs_signal_event(EFI_EVENT Event)
 	if (!Event)
 		return EFI_INVALID_PARAMETER;
 
-	if (event->type != EVT_NOTIFY_SIGNAL)
+	if (event->type != EVT_NOTIFY_SIGNAL) {
+		event->signaled = TRUE;
 		return EFI_SUCCESS;
+	}
 
 	event->notify(Event, event->context);
 
@@ -166,9 +166,63 @@ bs_close_event(EFI_EVENT Event)
 }
 
 static EFIAPI EFI_STATUS
-bs_check_event(__attribute__((__unused__)) EFI_EVENT Event)
+bs_check_event(EFI_EVENT Event)
 {
-	return EFI_UNSUPPORTED;
+	event_t *event = (event_t *)Event;
+
+	if (!Event || event->type == EVT_NOTIFY_SIGNAL)
+		return EFI_INVALID_PARAMETER;
+
+	/* Asynchronous storage requests complete from here. */
+	storage_poll();
+
+	if (!event->signaled && event->type == EVT_NOTIFY_WAIT)
+		event->notify(Event, event->context);
+
+	if (!event->signaled)
+		return EFI_NOT_READY;
+
+	event->signaled = FALSE;
+	return EFI_SUCCESS;
+}
+
+static EFIAPI EFI_STATUS
+bs_wait_for_event(UINTN NumberOfEvents,
+		  EFI_EVENT *Event,
+		  UINTN *Index)
+{
+	EFI_STATUS ret;
+	UINTN i;
+
+	if (!NumberOfEvents || !Event || !Index)
+		return EFI_INVALID_PARAMETER;
+
+	for (i = 0; i < NumberOfEvents; i++) {
+		if (!Event[i])
+			return EFI_INVALID_PARAMETER;
+
+		if (((event_t *)Event[i])->type == EVT_NOTIFY_SIGNAL) {
+			*Index = i;
+			return EFI_UNSUPPORTED;
+		}
+	}
+
+	for (;;) {
+		for (i = 0; i < NumberOfEvents; i++) {
+			ret = bs_check_event(Event[i]);
+			if (ret == EFI_NOT_READY)
+				continue;
+
+			*Index = i;
+			return ret;
+		}
+
+		/* Nothing but the storage polling and the notify
+		   functions can signal the events: WaitForEvent()
+		   blocks until one of them does, sleeping in between
+		   like the driver scheduler. */
+		ewdrv_idle();
+	}
 }
 
 static EFIAPI EFI_STATUS
@@ -232,6 +286,10 @@ static EFIAPI EFI_STATUS
 bs_exit_boot_services(__attribute__((__unused__)) EFI_HANDLE ImageHandle,
 		      __attribute__((__unused__)) UINTN MapKey)
 {
+	/* Nothing is torn down here: the exit step is left to the
+	   ExitBootServices() overrides which do. */
+	ewperf_boot_step(EWPERF_EXIT_BOOT_SERVICES_ENTRY);
+
 	return EFI_SUCCESS;
 }
 
@@ -43,7 +43,7 @@ static EFIAPI EFI_STATUS
 conin_read_key(__attribute__((__unused__)) struct _SIMPLE_INPUT_INTERFACE *This,
 	       __attribute__((__unused__)) EFI_INPUT_KEY *Key)
 {
-	return EFI_NOT_FOUND;
+	return EFI_NOT_READY;
 }
 
 static EFI_GUID guid = SIMPLE_TEXT_OUTPUT_PROTOCOL;
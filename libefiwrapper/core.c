@@ -34,6 +34,7 @@
 #include "conout.h"
 #include "ewarg.h"
 #include "ewlog.h"
+#include "ewperf.h"
 #include "ewvar.h"
 #include "lib.h"
 #include "rs.h"
@@ -86,6 +87,7 @@ static struct component {
 	EFI_STATUS (*free)(EFI_SYSTEM_TABLE *st);
 } COMPONENTS[] = {
 	{ "boot services", bs_init, NULL },
+	{ "performance", ewperf_init, ewperf_free },
 	{ "runtime services", rs_init, NULL },
 	{ "console in", conin_init, conin_free },
 	{ "console out", conout_init, conout_free },
@@ -130,12 +132,18 @@ EFI_STATUS efiwrapper_init(int argc, char **argv, EFI_SYSTEM_TABLE **st_p,
 {
 	EFI_STATUS ret;
 	size_t i, j;
+	UINT64 start;
 
 	if ((argc && !argv) || !st_p || !img_handle)
 		return EFI_INVALID_PARAMETER;
 
+	ewperf_boot_step(EWPERF_RESET_END);
+
 	for (i = 0; i < ARRAY_SIZE(COMPONENTS); i++) {
+		start = ewperf_tsc();
 		ret = COMPONENTS[i].init(&st);
+		ewperf_record(EWPERF_COMPONENT_INIT, COMPONENTS[i].name,
+			      start, ewperf_tsc());
 		if (EFI_ERROR(ret)) {
 			ewerr("%s failed to initilized", COMPONENTS[i].name);
 			goto err_components;
@@ -162,11 +170,16 @@ EFI_STATUS efiwrapper_init(int argc, char **argv, EFI_SYSTEM_TABLE **st_p,
 	if (EFI_ERROR(ret))
 		goto err_load_options;
 
+	start = ewperf_tsc();
 	ret = ewarg_init(argc, argv);
+	ewperf_record(EWPERF_COMPONENT_INIT, "arguments", start, ewperf_tsc());
 	if (EFI_ERROR(ret))
 		goto err_load_options;
 
+	start = ewperf_tsc();
 	ret = identify_boot_media();
+	ewperf_record(EWPERF_COMPONENT_INIT, "boot media", start,
+		      ewperf_tsc());
 	if (EFI_ERROR(ret))
 		goto err_load_options;
 
@@ -199,11 +212,15 @@ EFI_STATUS efiwrapper_free(EFI_HANDLE img_handle)
 {
 	EFI_STATUS ret;
 	size_t i;
+	UINT64 start;
 
 	for (i = 0; i < ARRAY_SIZE(COMPONENTS); i++) {
 		if (!COMPONENTS[i].free)
 			continue;
+		start = ewperf_tsc();
 		ret = COMPONENTS[i].free(&st);
+		ewperf_record(EWPERF_COMPONENT_FREE, COMPONENTS[i].name,
+			      start, ewperf_tsc());
 		if (EFI_ERROR(ret)) {
 			ewerr("%s failed to exit", COMPONENTS[i].name);
 			return ret;
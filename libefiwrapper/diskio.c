@@ -38,157 +38,320 @@ typedef struct diskio {
 	media_t *media;
 } diskio_t;
 
-static EFI_STATUS read_block(media_t *media, EFI_LBA lba,
-			     unsigned char **block)
+static EFI_STATUS check_access(EFI_DISK_IO_PROTOCOL *This, UINT32 MediaId,
+				UINT64 Offset, UINTN BufferSize, VOID *Buffer,
+				media_t **media)
 {
-	EFI_LBA count;
-
-	*block = malloc(media->m.BlockSize);
-	if (!*block)
-		return EFI_OUT_OF_RESOURCES;
-
-	count = media->storage->read(media->storage, lba, 1, *block);
-	if (count != 1) {
-		free(*block);
-		return EFI_DEVICE_ERROR;
-	}
-
-	return EFI_SUCCESS;
-}
-
-static EFIAPI EFI_STATUS
-diskio_read(EFI_DISK_IO_PROTOCOL *This,
-	    UINT32 MediaId,
-	    UINT64 Offset,
-	    UINTN BufferSize,
-	    VOID *Buffer)
-{
-	EFI_STATUS ret;
 	diskio_t *diskio = (diskio_t *)This;
-	UINT32 count, size;
 	UINT32 blksz;
- 	unsigned char *buf = Buffer, *block;
-	media_t *media;
 
 	if (!This || !Buffer)
 		return EFI_INVALID_PARAMETER;
 
 	if (!diskio->media)
 		return EFI_INVALID_PARAMETER;
-	media = diskio->media;
+	*media = diskio->media;
 
-	if (media->m.MediaId != MediaId)
+	if ((*media)->m.MediaId != MediaId)
 		return EFI_MEDIA_CHANGED;
 
-	blksz = media->m.BlockSize;
+	blksz = (*media)->m.BlockSize;
 	if (!blksz)
 		return EFI_INVALID_PARAMETER;
 
-	if (Offset % blksz) {
-		ret = read_block(media, Offset / blksz, &block);
-		if (EFI_ERROR(ret))
-			return ret;
+	if (Offset + BufferSize < Offset ||
+	    Offset + BufferSize > ((*media)->m.LastBlock + 1) * blksz)
+		return EFI_INVALID_PARAMETER;
 
-		size = min(blksz - (Offset % blksz), BufferSize);
-		memcpy(buf, block + (Offset % blksz), size);
-		free(block);
+	return EFI_SUCCESS;
+}
 
-		buf += size;
-		Offset += size;
-		BufferSize -= size;
+/* Adapt the read-ahead window: it doubles on each sequential read and
+   is disabled as soon as the access pattern becomes random. */
+static void update_readahead(media_t *media, UINT64 Offset, UINTN BufferSize)
+{
+	UINTN min_blocks;
+
+	if (Offset != media->ra_next)
+		media->ra_blocks = 0;
+	else if (media->ra_blocks)
+		media->ra_blocks = min(media->ra_blocks * 2,
+				       media->bounce_blocks);
+	else {
+		min_blocks = MEDIA_READAHEAD_MIN / media->m.BlockSize;
+		media->ra_blocks = min(max(min_blocks, 1),
+				       media->bounce_blocks);
 	}
 
-	size = BufferSize / blksz;
-	if (size > 0) {
-		count = media->storage->read(media->storage, Offset / blksz, size, buf);
-		if (count != size)
-			return EFI_DEVICE_ERROR;
-		size *= blksz;
-		BufferSize -= size;
-		Offset += size;
-		buf += size;
+	media->ra_next = Offset + BufferSize;
+}
+
+/* Describe a COUNT blocks transfer starting at byte OFF of block LBA
+   with SIZE bytes of BUF: the first block, and the last one if it is
+   partial, are staged in the bounce buffer. */
+static UINTN edges_segs(media_t *media, UINTN count, UINTN off, UINTN size,
+			unsigned char *buf, storage_seg_t segs[3])
+{
+	UINT32 blksz = media->m.BlockSize;
+	UINTN nb = 0, tail;
+
+	tail = (off + size) % blksz ? 1 : 0;
+
+	segs[nb].buf = media->bounce;
+	segs[nb++].len = blksz;
+	segs[nb].buf = buf + blksz - off;
+	segs[nb++].len = (count - 1 - tail) * blksz;
+	if (tail) {
+		segs[nb].buf = media->bounce + blksz;
+		segs[nb++].len = blksz;
 	}
-	if (BufferSize) {
-		ret = read_block(media, Offset / blksz, &block);
+
+	return nb;
+}
+
+static EFI_STATUS edges_readv(media_t *media, EFI_LBA lba, UINTN count,
+			      UINTN off, UINTN size, unsigned char *buf)
+{
+	UINT32 blksz = media->m.BlockSize;
+	storage_seg_t segs[3];
+	EFI_STATUS ret;
+	UINTN nb;
+
+	nb = edges_segs(media, count, off, size, buf, segs);
+	ret = media_readv(media, lba, segs, nb);
+	if (EFI_ERROR(ret))
+		return ret;
+
+	memcpy(buf, media->bounce + off, blksz - off);
+	if (nb == 3)
+		memcpy((unsigned char *)segs[1].buf + segs[1].len,
+		       media->bounce + blksz, (off + size) % blksz);
+
+	return EFI_SUCCESS;
+}
+
+static EFI_STATUS edges_writev(media_t *media, EFI_LBA lba, UINTN count,
+			       UINTN off, UINTN size, unsigned char *buf)
+{
+	UINT32 blksz = media->m.BlockSize;
+	storage_seg_t segs[3];
+	EFI_STATUS ret;
+	UINTN nb;
+
+	nb = edges_segs(media, count, off, size, buf, segs);
+	if (off) {
+		ret = media_read(media, lba, 1, media->bounce);
+		if (EFI_ERROR(ret))
+			return ret;
+	}
+	if (nb == 3) {
+		ret = media_read(media, lba + count - 1, 1,
+				 media->bounce + blksz);
 		if (EFI_ERROR(ret))
 			return ret;
-		memcpy(buf, block, BufferSize);
-		free(block);
 	}
 
-	return EFI_SUCCESS;
+	memcpy(media->bounce + off, buf, blksz - off);
+	if (nb == 3)
+		memcpy(media->bounce + blksz, (unsigned char *)segs[1].buf +
+		       segs[1].len, (off + size) % blksz);
+
+	return media_writev(media, lba, segs, nb);
 }
 
-static EFIAPI EFI_STATUS
-diskio_write(EFI_DISK_IO_PROTOCOL *This,
-	     UINT32 MediaId,
-	     UINT64 Offset,
-	     UINTN BufferSize,
-	     VOID *Buffer)
+EFI_STATUS diskio_read_bytes(media_t *media, UINT64 Offset,
+			     UINTN BufferSize, VOID *Buffer)
 {
 	EFI_STATUS ret;
-	diskio_t *diskio = (diskio_t *)This;
-	UINT32 count, size;
+	unsigned char *buf = Buffer;
+	UINTN off, size, count, window;
+	EFI_LBA lba;
 	UINT32 blksz;
-	unsigned char *buf = Buffer, *block;
-	media_t *media;
 
-	if (!This || !Buffer)
-		return EFI_INVALID_PARAMETER;
+	ret = media_alloc_bounce(media);
+	if (EFI_ERROR(ret))
+		return ret;
 
-	if (!diskio->media)
-		return EFI_INVALID_PARAMETER;
-	media = diskio->media;
+	blksz = media->m.BlockSize;
+	update_readahead(media, Offset, BufferSize);
+
+	while (BufferSize) {
+		lba = Offset / blksz;
+		off = Offset % blksz;
+
+		if (media->ra_count && lba >= media->ra_lba &&
+		    lba < media->ra_lba + media->ra_count) {
+			size = (media->ra_lba + media->ra_count - lba) * blksz;
+			size = min(size - off, BufferSize);
+			memcpy(buf, media->bounce +
+			       (lba - media->ra_lba) * blksz + off, size);
+			buf += size;
+			Offset += size;
+			BufferSize -= size;
+			continue;
+		}
 
-	if (media->m.MediaId != MediaId)
-		return EFI_MEDIA_CHANGED;
+		count = (off + BufferSize + blksz - 1) / blksz;
+
+		/* Aligned blocks not covered by the read-ahead window
+		   are read straight into the caller buffer. */
+		if (!off && BufferSize >= blksz && count >= media->ra_blocks) {
+			count = BufferSize / blksz;
+			ret = media_read(media, lba, count, buf);
+			if (EFI_ERROR(ret))
+				return ret;
+
+			size = count * blksz;
+			buf += size;
+			Offset += size;
+			BufferSize -= size;
+			continue;
+		}
+
+		/* Large unaligned read: the partial edge blocks land in
+		   the bounce buffer and the aligned middle straight in
+		   the caller buffer, in a single vectored command. */
+		if (count > 2 && count >= media->ra_blocks) {
+			media->ra_count = 0;
+			ret = edges_readv(media, lba, count, off, BufferSize, buf);
+			if (EFI_ERROR(ret))
+				return ret;
+			break;
+		}
+
+		/* Unaligned head, tail or small sequential read: fill
+		   the bounce buffer with as many blocks as possible. */
+		window = max(count, media->ra_blocks);
+		window = min(window, media->bounce_blocks);
+		window = min(window, media->m.LastBlock + 1 - lba);
+
+		media->ra_count = 0;
+		ret = media_read(media, lba, window, media->bounce);
+		if (EFI_ERROR(ret))
+			return ret;
+
+		media->ra_lba = lba;
+		media->ra_count = window;
+	}
+
+	return EFI_SUCCESS;
+}
+
+EFI_STATUS diskio_write_bytes(media_t *media, UINT64 Offset,
+			      UINTN BufferSize, VOID *Buffer)
+{
+	EFI_STATUS ret;
+	unsigned char *buf = Buffer, *last;
+	UINTN off, size, count;
+	BOOLEAN head, tail;
+	EFI_LBA lba;
+	UINT32 blksz;
+
+	ret = media_alloc_bounce(media);
+	if (EFI_ERROR(ret))
+		return ret;
 
 	blksz = media->m.BlockSize;
-	if (!blksz)
-		return EFI_INVALID_PARAMETER;
+	media->ra_next = 0;
+
+	while (BufferSize) {
+		lba = Offset / blksz;
+		off = Offset % blksz;
+
+		if (!off && BufferSize >= blksz) {
+			count = BufferSize / blksz;
+			ret = media_write(media, lba, count, buf);
+			if (EFI_ERROR(ret))
+				return ret;
+
+			size = count * blksz;
+			buf += size;
+			Offset += size;
+			BufferSize -= size;
+			continue;
+		}
 
-	if (Offset % blksz) {
-		ret = read_block(media, Offset / blksz, &block);
+		/* Large unaligned write: send the partial edge blocks
+		   from the bounce buffer and the aligned middle from the
+		   caller buffer in a single vectored command. */
+		count = (off + BufferSize + blksz - 1) / blksz;
+		if (count > 2 && (media->storage->writev ||
+				  count > media->bounce_blocks)) {
+			media->ra_count = 0;
+			return edges_writev(media, lba, count, off,
+					    BufferSize, buf);
+		}
+
+		/* Unaligned head or tail: merge it with as much of the
+		   following data as the bounce buffer can hold so that
+		   a single write reaches the device. */
+		count = min(count, media->bounce_blocks);
+		size = min(count * blksz - off, BufferSize);
+		head = off != 0;
+		tail = (off + size) % blksz != 0;
+		last = media->bounce + (count - 1) * blksz;
+
+		media->ra_count = 0;
+		if (head && tail && count <= 2)
+			ret = media_read(media, lba, count, media->bounce);
+		else {
+			if (head)
+				ret = media_read(media, lba, 1, media->bounce);
+			if (!EFI_ERROR(ret) && tail)
+				ret = media_read(media, lba + count - 1, 1, last);
+		}
 		if (EFI_ERROR(ret))
 			return ret;
 
-		size = min(blksz - (Offset % blksz), BufferSize);
-		memcpy(block + (Offset % blksz), buf, size);
+		memcpy(media->bounce + off, buf, size);
+		ret = media_write(media, lba, count, media->bounce);
+		if (EFI_ERROR(ret))
+			return ret;
 
-		count = media->storage->write(media->storage, Offset / blksz, 1, block);
-		free(block);
-		if (count != 1)
-			return EFI_DEVICE_ERROR;
+		/* The bounce buffer now mirrors the device content. */
+		media->ra_lba = lba;
+		media->ra_count = count;
 
 		buf += size;
 		Offset += size;
 		BufferSize -= size;
 	}
 
-	size = BufferSize / blksz;
-	if (size > 0) {
-		count = media->storage->write(media->storage, Offset / blksz, size, buf);
-		if (count != size)
-			return EFI_DEVICE_ERROR;
+	return EFI_SUCCESS;
+}
 
-		size *= blksz;
-		BufferSize -= size;
-		Offset += size;
-		buf += size;
-	}
-	if (BufferSize) {
-		ret = read_block(media, Offset / blksz, &block);
-		if (EFI_ERROR(ret))
-			return ret;
+static EFIAPI EFI_STATUS
+diskio_read(EFI_DISK_IO_PROTOCOL *This,
+	    UINT32 MediaId,
+	    UINT64 Offset,
+	    UINTN BufferSize,
+	    VOID *Buffer)
+{
+	EFI_STATUS ret;
+	media_t *media;
 
-		memcpy(block, buf, BufferSize);
-		count = media->storage->write(media->storage, Offset / blksz, 1, block);
-		free(block);
-		if (count != 1)
-			return EFI_DEVICE_ERROR;
-	}
+	ret = check_access(This, MediaId, Offset, BufferSize, Buffer, &media);
+	if (EFI_ERROR(ret))
+		return ret;
 
-	return EFI_SUCCESS;
+	return diskio_read_bytes(media, Offset, BufferSize, Buffer);
+}
+
+static EFIAPI EFI_STATUS
+diskio_write(EFI_DISK_IO_PROTOCOL *This,
+	     UINT32 MediaId,
+	     UINT64 Offset,
+	     UINTN BufferSize,
+	     VOID *Buffer)
+{
+	EFI_STATUS ret;
+	media_t *media;
+
+	ret = check_access(This, MediaId, Offset, BufferSize, Buffer, &media);
+	if (EFI_ERROR(ret))
+		return ret;
+
+	return diskio_write_bytes(media, Offset, BufferSize, Buffer);
 }
 
 static EFI_GUID diskio_guid = DISK_IO_PROTOCOL;
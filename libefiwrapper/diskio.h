@@ -41,4 +41,10 @@ EFI_STATUS diskio_init(EFI_SYSTEM_TABLE *st, media_t *media,
 		       EFI_HANDLE *handle);
 EFI_STATUS diskio_free(EFI_SYSTEM_TABLE *st, EFI_HANDLE handle);
 
+/* Byte granular accesses.  The range must be within the media. */
+EFI_STATUS diskio_read_bytes(media_t *media, UINT64 Offset,
+			     UINTN BufferSize, VOID *Buffer);
+EFI_STATUS diskio_write_bytes(media_t *media, UINT64 Offset,
+			      UINTN BufferSize, VOID *Buffer);
+
 #endif	/* _DISKIO_H_ */
@@ -0,0 +1,416 @@
+/*
+ * Copyright (c) 2026, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "diskio.h"
+#include "diskio2.h"
+#include "protocol/DiskIo2.h"
+#include "interface.h"
+#include "lib.h"
+
+/* Transfers are split in block requests of DISKIO2_CHUNK_SIZE bytes.
+   At most DISKIO2_QUEUE_DEPTH of them are in flight at a time for a
+   given DiskIo2 interface, the others wait in its queue. */
+#define DISKIO2_CHUNK_SIZE	(128 * 1024)
+#define DISKIO2_QUEUE_DEPTH	8
+
+typedef struct diskio2 diskio2_t;
+
+typedef struct task {
+	diskio2_t *diskio2;
+	EFI_DISK_IO2_TOKEN *token;
+	EFI_STATUS status;
+	UINTN pending;
+	struct task *next;
+} task_t;
+
+typedef struct sub {
+	media_req_t mreq;
+	task_t *task;
+	struct sub *next;
+	/* Partial block reads land in BLOCK, then COPY_SIZE bytes at
+	   COPY_OFFSET are copied to COPY_DST. */
+	unsigned char *copy_dst;
+	UINTN copy_offset;
+	UINTN copy_size;
+	unsigned char block[0];
+} sub_t;
+
+struct diskio2 {
+	EFI_DISK_IO2_PROTOCOL interface;
+	media_t *media;
+	EFI_BOOT_SERVICES *bs;
+	sub_t *queue;
+	sub_t *queue_last;
+	UINTN inflight;
+	BOOLEAN pumping;
+	task_t *tasks;
+};
+
+static void task_done(task_t *task)
+{
+	diskio2_t *diskio2 = task->diskio2;
+	task_t **cur;
+
+	for (cur = &diskio2->tasks; *cur; cur = &(*cur)->next)
+		if (*cur == task) {
+			*cur = task->next;
+			break;
+		}
+
+	task->token->TransactionStatus = task->status;
+	uefi_call_wrapper(diskio2->bs->SignalEvent, 1, task->token->Event);
+	free(task);
+}
+
+static void pump(diskio2_t *diskio2);
+
+static void sub_complete(media_req_t *mreq)
+{
+	sub_t *sub = (sub_t *)mreq;
+	task_t *task = sub->task;
+	diskio2_t *diskio2 = task->diskio2;
+
+	if (EFI_ERROR(mreq->req.status)) {
+		if (!EFI_ERROR(task->status))
+			task->status = mreq->req.status;
+	} else if (sub->copy_dst)
+		memcpy(sub->copy_dst, sub->block + sub->copy_offset,
+		       sub->copy_size);
+
+	free(sub);
+	diskio2->inflight--;
+	if (--task->pending == 0)
+		task_done(task);
+
+	pump(diskio2);
+}
+
+/* Submit the queued requests up to the queue depth.  Requests may
+   complete synchronously, the PUMPING flag turns the resulting
+   recursion into iterations of this loop. */
+static void pump(diskio2_t *diskio2)
+{
+	EFI_STATUS ret;
+	sub_t *sub;
+
+	if (diskio2->pumping)
+		return;
+
+	diskio2->pumping = TRUE;
+	while (diskio2->queue && diskio2->inflight < DISKIO2_QUEUE_DEPTH) {
+		sub = diskio2->queue;
+		diskio2->queue = sub->next;
+		diskio2->inflight++;
+
+		ret = media_submit(diskio2->media, &sub->mreq);
+		if (EFI_ERROR(ret)) {
+			sub->mreq.req.status = ret;
+			sub_complete(&sub->mreq);
+		}
+	}
+	diskio2->pumping = FALSE;
+}
+
+static sub_t *sub_new(task_t *task, enum storage_op op, EFI_LBA lba,
+		      EFI_LBA count, void *buf, UINTN block_size)
+{
+	sub_t *sub;
+
+	sub = calloc(1, sizeof(*sub) + block_size);
+	if (!sub)
+		return NULL;
+
+	sub->task = task;
+	sub->mreq.complete = sub_complete;
+	sub->mreq.req.op = op;
+	sub->mreq.req.lba = lba;
+	sub->mreq.req.count = count;
+	sub->mreq.req.buf = buf ? buf : sub->block;
+
+	return sub;
+}
+
+/* Split the [OFFSET, OFFSET + SIZE[ range in block requests.  For
+   writes, the unaligned head and tail are written synchronously since
+   they require a read-modify-write cycle. */
+static EFI_STATUS split(diskio2_t *diskio2, task_t *task, enum storage_op op,
+			UINT64 offset, UINTN size, unsigned char *buf,
+			sub_t **first, UINTN *nb)
+{
+	EFI_STATUS ret;
+	media_t *media = diskio2->media;
+	UINT32 blksz = media->m.BlockSize;
+	UINTN off, chunk, count, len;
+	sub_t *sub, **last = first;
+
+	*nb = 0;
+	*first = NULL;
+	chunk = max(DISKIO2_CHUNK_SIZE / blksz, 1);
+
+	off = offset % blksz;
+	len = min(blksz - off, size);
+	if (op == STORAGE_OP_WRITE && (off || size < blksz)) {
+		ret = diskio_write_bytes(media, offset, len, buf);
+		if (EFI_ERROR(ret))
+			return ret;
+		offset += len;
+		buf += len;
+		size -= len;
+	} else if (off || size < blksz) {
+		sub = sub_new(task, op, offset / blksz, 1, NULL, blksz);
+		if (!sub)
+			return EFI_OUT_OF_RESOURCES;
+		sub->copy_dst = buf;
+		sub->copy_offset = off;
+		sub->copy_size = len;
+		*last = sub;
+		last = &sub->next;
+		(*nb)++;
+		offset += len;
+		buf += len;
+		size -= len;
+	}
+
+	while (size >= blksz) {
+		count = min(size / blksz, chunk);
+		sub = sub_new(task, op, offset / blksz, count, buf, 0);
+		if (!sub)
+			return EFI_OUT_OF_RESOURCES;
+		*last = sub;
+		last = &sub->next;
+		(*nb)++;
+		offset += count * blksz;
+		buf += count * blksz;
+		size -= count * blksz;
+	}
+
+	if (!size)
+		return EFI_SUCCESS;
+
+	if (op == STORAGE_OP_WRITE)
+		return diskio_write_bytes(media, offset, size, buf);
+
+	sub = sub_new(task, op, offset / blksz, 1, NULL, blksz);
+	if (!sub)
+		return EFI_OUT_OF_RESOURCES;
+	sub->copy_dst = buf;
+	sub->copy_size = size;
+	*last = sub;
+	(*nb)++;
+
+	return EFI_SUCCESS;
+}
+
+static EFI_STATUS diskio2_access(enum storage_op op,
+				 EFI_DISK_IO2_PROTOCOL *This,
+				 UINT32 MediaId, UINT64 Offset,
+				 EFI_DISK_IO2_TOKEN *Token,
+				 UINTN BufferSize, VOID *Buffer)
+{
+	EFI_STATUS ret;
+	diskio2_t *diskio2 = (diskio2_t *)This;
+	media_t *media;
+	task_t *task;
+	sub_t *first, *next;
+	UINTN nb;
+
+	if (!This || !Buffer)
+		return EFI_INVALID_PARAMETER;
+
+	media = diskio2->media;
+	if (!media)
+		return EFI_INVALID_PARAMETER;
+
+	if (media->m.MediaId != MediaId)
+		return EFI_MEDIA_CHANGED;
+
+	if (!media->m.BlockSize)
+		return EFI_INVALID_PARAMETER;
+
+	if (Offset + BufferSize < Offset ||
+	    Offset + BufferSize > (media->m.LastBlock + 1) * media->m.BlockSize)
+		return EFI_INVALID_PARAMETER;
+
+	if (!Token || !Token->Event) {
+		if (op == STORAGE_OP_READ)
+			return diskio_read_bytes(media, Offset, BufferSize,
+						 Buffer);
+		return diskio_write_bytes(media, Offset, BufferSize, Buffer);
+	}
+
+	task = calloc(1, sizeof(*task));
+	if (!task)
+		return EFI_OUT_OF_RESOURCES;
+
+	task->diskio2 = diskio2;
+	task->token = Token;
+	task->status = EFI_SUCCESS;
+
+	ret = split(diskio2, task, op, Offset, BufferSize, Buffer, &first, &nb);
+	if (EFI_ERROR(ret)) {
+		for (; first; first = next) {
+			next = first->next;
+			free(first);
+		}
+		free(task);
+		return ret;
+	}
+
+	Token->TransactionStatus = EFI_NOT_READY;
+	task->pending = nb;
+	task->next = diskio2->tasks;
+	diskio2->tasks = task;
+	if (!nb) {
+		task_done(task);
+		return EFI_SUCCESS;
+	}
+
+	if (diskio2->queue)
+		diskio2->queue_last->next = first;
+	else
+		diskio2->queue = first;
+	for (diskio2->queue_last = first; diskio2->queue_last->next;
+	     diskio2->queue_last = diskio2->queue_last->next)
+		;
+
+	pump(diskio2);
+
+	return EFI_SUCCESS;
+}
+
+static EFIAPI EFI_STATUS
+diskio2_read(EFI_DISK_IO2_PROTOCOL *This, UINT32 MediaId, UINT64 Offset,
+	     EFI_DISK_IO2_TOKEN *Token, UINTN BufferSize, VOID *Buffer)
+{
+	return diskio2_access(STORAGE_OP_READ, This, MediaId, Offset, Token,
+			      BufferSize, Buffer);
+}
+
+static EFIAPI EFI_STATUS
+diskio2_write(EFI_DISK_IO2_PROTOCOL *This, UINT32 MediaId, UINT64 Offset,
+	      EFI_DISK_IO2_TOKEN *Token, UINTN BufferSize, VOID *Buffer)
+{
+	return diskio2_access(STORAGE_OP_WRITE, This, MediaId, Offset, Token,
+			      BufferSize, Buffer);
+}
+
+static EFIAPI EFI_STATUS
+diskio2_cancel(EFI_DISK_IO2_PROTOCOL *This)
+{
+	diskio2_t *diskio2 = (diskio2_t *)This;
+	task_t *task;
+	sub_t *sub, *next;
+
+	if (!This)
+		return EFI_INVALID_PARAMETER;
+
+	for (task = diskio2->tasks; task; task = task->next)
+		task->status = EFI_ABORTED;
+
+	/* Queued requests are dropped... */
+	sub = diskio2->queue;
+	diskio2->queue = NULL;
+	for (; sub; sub = next) {
+		next = sub->next;
+		task = sub->task;
+		free(sub);
+		if (--task->pending == 0)
+			task_done(task);
+	}
+
+	/* ...but the submitted ones cannot be recalled: wait for them
+	   so that the caller buffers can safely be released. */
+	media_drain(diskio2->media);
+
+	return EFI_SUCCESS;
+}
+
+static EFIAPI EFI_STATUS
+diskio2_flush(EFI_DISK_IO2_PROTOCOL *This, EFI_DISK_IO2_TOKEN *Token)
+{
+	EFI_STATUS ret;
+	diskio2_t *diskio2 = (diskio2_t *)This;
+
+	if (!This || !diskio2->media)
+		return EFI_INVALID_PARAMETER;
+
+	media_drain(diskio2->media);
+	ret = media_flush(diskio2->media);
+	if (!Token || !Token->Event)
+		return ret;
+
+	Token->TransactionStatus = ret;
+	uefi_call_wrapper(diskio2->bs->SignalEvent, 1, Token->Event);
+
+	return EFI_SUCCESS;
+}
+
+static EFI_GUID diskio2_guid = EFI_DISK_IO2_PROTOCOL_GUID;
+
+EFI_STATUS diskio2_init(EFI_SYSTEM_TABLE *st, media_t *media,
+			EFI_HANDLE *handle)
+{
+	static diskio2_t diskio2_default = {
+		.interface = {
+			.Revision = EFI_DISK_IO2_PROTOCOL_REVISION,
+			.Cancel = diskio2_cancel,
+			.ReadDiskEx = diskio2_read,
+			.WriteDiskEx = diskio2_write,
+			.FlushDiskEx = diskio2_flush
+		}
+	};
+	EFI_STATUS ret;
+	diskio2_t *diskio2;
+
+	ret = interface_init(st, &diskio2_guid, handle,
+			     &diskio2_default, sizeof(diskio2_default),
+			     (void **)&diskio2);
+	if (EFI_ERROR(ret))
+		return ret;
+
+	diskio2->media = media;
+	diskio2->bs = st->BootServices;
+
+	return EFI_SUCCESS;
+}
+
+EFI_STATUS diskio2_free(EFI_SYSTEM_TABLE *st, EFI_HANDLE handle)
+{
+	EFI_STATUS ret;
+	EFI_DISK_IO2_PROTOCOL *diskio2;
+
+	ret = uefi_call_wrapper(st->BootServices->HandleProtocol, 3,
+				handle, &diskio2_guid, (VOID **)&diskio2);
+	if (EFI_ERROR(ret))
+		return ret;
+
+	diskio2_cancel(diskio2);
+
+	return interface_free(st, &diskio2_guid, handle);
+}
@@ -39,14 +39,42 @@
 typedef struct eraseblock {
 	EFI_ERASE_BLOCK_PROTOCOL interface;
 	media_t *media;
+	EFI_BOOT_SERVICES *bs;
 } eraseblk_t;
 
-static EFI_STATUS storage_erase_block(EFI_ERASE_BLOCK_PROTOCOL *This,
-				 UINT32 MediaId, EFI_LBA LBA, UINTN Size)
+typedef struct eraseblk_req {
+	media_req_t mreq;
+	EFI_BOOT_SERVICES *bs;
+	EFI_ERASE_BLOCK_TOKEN *token;
+} eraseblk_req_t;
+
+static void erase_block_complete(media_req_t *mreq)
+{
+	eraseblk_req_t *req = (eraseblk_req_t *)mreq;
+
+	req->token->TransactionStatus = mreq->req.status;
+	uefi_call_wrapper(req->bs->SignalEvent, 1, req->token->Event);
+	free(req);
+}
+
+/* Requests with a token event are queued: the media layer merges
+   them with the other queued erases and erases them in the
+   background of the storage polling. */
+EFI_STATUS
+EFIAPI
+erase_block (
+  IN     EFI_ERASE_BLOCK_PROTOCOL      *This,
+  IN     UINT32                        MediaId,
+  IN     EFI_LBA                       Lba,
+  IN OUT EFI_ERASE_BLOCK_TOKEN         *Token,
+  IN     UINTN                         Size
+  )
 {
-	EFI_STATUS ret;
 	eraseblk_t *eraseblk = (eraseblk_t *)This;
+	eraseblk_req_t *req;
+	EFI_STATUS ret;
 	media_t *media;
+	EFI_LBA count;
 
 	if (!This)
 		return EFI_INVALID_PARAMETER;
@@ -58,25 +86,36 @@ static EFI_STATUS storage_erase_block(EFI_ERASE_BLOCK_PROTOCOL *This,
 	if (media->m.MediaId != MediaId)
 		return EFI_MEDIA_CHANGED;
 
-	if (media->storage->erase)
-		ret = media->storage->erase(media->storage, LBA, Size);
-	else
-		return EFI_UNSUPPORTED;
+	count = (Size + media->m.BlockSize - 1) / media->m.BlockSize;
+	if (Lba > media->m.LastBlock || count > media->m.LastBlock + 1 - Lba)
+		return EFI_INVALID_PARAMETER;
 
-	return ret;
-}
+	if (!Token || !Token->Event)
+		return media_erase(media, Lba, Size);
 
-EFI_STATUS
-EFIAPI
-erase_block (
-  IN     EFI_ERASE_BLOCK_PROTOCOL      *This,
-  IN     UINT32                        MediaId,
-  IN     EFI_LBA                       Lba,
-  __attribute__((__unused__)) IN OUT EFI_ERASE_BLOCK_TOKEN         *Token,
-  IN     UINTN                         Size
-  )
-{
-	return storage_erase_block(This, MediaId, Lba, Size);
+	if (!count) {
+		Token->TransactionStatus = EFI_SUCCESS;
+		uefi_call_wrapper(eraseblk->bs->SignalEvent, 1, Token->Event);
+		return EFI_SUCCESS;
+	}
+
+	req = calloc(1, sizeof(*req));
+	if (!req)
+		return EFI_OUT_OF_RESOURCES;
+
+	req->bs = eraseblk->bs;
+	req->token = Token;
+	req->mreq.complete = erase_block_complete;
+	req->mreq.req.op = STORAGE_OP_ERASE;
+	req->mreq.req.lba = Lba;
+	req->mreq.req.count = count;
+
+	Token->TransactionStatus = EFI_NOT_READY;
+	ret = media_submit(media, &req->mreq);
+	if (EFI_ERROR(ret))
+		free(req);
+
+	return ret;
 }
 
 static EFI_GUID erase_block_guid = EFI_ERASE_BLOCK_PROTOCOL_GUID;
@@ -90,7 +129,6 @@ EFI_STATUS erase_block_init(EFI_SYSTEM_TABLE *st, media_t *media,
 	static eraseblk_t erase_block_default = {
 		.interface = {
 			.Revision = EFI_ERASE_BLOCK_PROTOCOL_REVISION,
-			.EraseLengthGranularity = 1,
 			.EraseBlocks = erase_block,
 		}
 	};
@@ -101,7 +139,10 @@ EFI_STATUS erase_block_init(EFI_SYSTEM_TABLE *st, media_t *media,
 	if (EFI_ERROR(ret))
 		return ret;
 
+	eraseblk->interface.EraseLengthGranularity =
+		media_erase_granularity(media);
 	eraseblk->media = media;
+	eraseblk->bs = st->BootServices;
 
 	return EFI_SUCCESS;
 }
@@ -32,51 +32,475 @@
 #include <stddef.h>
 
 #include "ewdrv.h"
+#include "ewlib.h"
 #include "ewlog.h"
+#include "ewperf.h"
+#include "external.h"
+#include "storage.h"
 
-EFI_STATUS ewdrv_init(EFI_SYSTEM_TABLE *st)
+/* Delay between two rounds of polling when none of the driver
+   initializations made progress. */
+#define POLL_DELAY	(10 * 1000)	/* nanoseconds */
+
+typedef enum drv_state {
+	DRV_PENDING,
+	DRV_LAZY,
+	DRV_STARTING,
+	DRV_POLLING,
+	DRV_RUNNING,
+	DRV_DONE,
+	DRV_FAILED
+} drv_state_t;
+
+typedef struct drv_ctx {
+	drv_state_t state;
+	UINT64 start;
+	void *job;
+	size_t nb_deps;
+	size_t *deps;
+} drv_ctx_t;
+
+static ewdrv_runner_t *runner;
+
+/* Drivers state, kept until ewdrv_exit() for the lazy drivers */
+static EFI_SYSTEM_TABLE *drv_st;
+static drv_ctx_t *drv_ctx;
+static size_t nb_drivers;
+static size_t nb_lazy;
+
+/* Drivers in initialization completion order */
+static ewdrv_t **initialized;
+static size_t nb_initialized;
+
+EFI_STATUS ewdrv_set_runner(ewdrv_runner_t *r)
 {
-	EFI_STATUS ret = EFI_SUCCESS;
-	size_t i, j;
+	if (r && (!r->start || !r->check || !r->lock || !r->unlock))
+		return EFI_INVALID_PARAMETER;
 
-	if (!ew_drivers)
-		return EFI_UNSUPPORTED;
+	runner = r;
+	return EFI_SUCCESS;
+}
 
-	for (i = 0; ew_drivers[i]; i++) {
-		ret = ew_drivers[i]->init(st);
-		if (EFI_ERROR(ret))
-			break;
-		ewdbg("'%s' driver succesfully initialized",
-		      ew_drivers[i]->name);
+void ewdrv_lock(void)
+{
+	if (runner)
+		runner->lock();
+}
+
+void ewdrv_unlock(void)
+{
+	if (runner)
+		runner->unlock();
+}
+
+static BOOLEAN find_driver(const char *name, size_t *idx)
+{
+	size_t i;
+
+	for (i = 0; ew_drivers[i]; i++)
+		if (!strncmp(ew_drivers[i]->name, name, strlen(name) + 1)) {
+			*idx = i;
+			return TRUE;
+		}
+
+	return FALSE;
+}
+
+static EFI_STATUS resolve_deps(drv_ctx_t *ctx, size_t nb)
+{
+	const char * const *dep;
+	size_t i, idx;
+
+	for (i = 0; i < nb; i++) {
+		if (!ew_drivers[i]->depends)
+			continue;
+
+		for (dep = ew_drivers[i]->depends; *dep; dep++)
+			ctx[i].nb_deps++;
+
+		ctx[i].deps = malloc(ctx[i].nb_deps * sizeof(*ctx[i].deps));
+		if (!ctx[i].deps)
+			return EFI_OUT_OF_RESOURCES;
+
+		ctx[i].nb_deps = 0;
+		for (dep = ew_drivers[i]->depends; *dep; dep++) {
+			if (!find_driver(*dep, &idx)) {
+				ewdbg("'%s' driver dependency '%s' is not available, ignored",
+				      ew_drivers[i]->name, *dep);
+				continue;
+			}
+			if (idx == i) {
+				ewerr("'%s' driver depends on itself",
+				      ew_drivers[i]->name);
+				return EFI_INVALID_PARAMETER;
+			}
+			ctx[i].deps[ctx[i].nb_deps++] = idx;
+		}
+	}
+
+	return EFI_SUCCESS;
+}
+
+/* Lazy drivers are left aside unless they handle the boot storage
+   type or a driver started at boot depends on them. */
+static void select_lazy(drv_ctx_t *ctx, size_t nb)
+{
+	boot_dev_t *boot_dev = get_boot_media();
+	BOOLEAN changed;
+	ewdrv_t *drv;
+	size_t i, j;
+
+	nb_lazy = 0;
+	for (i = 0; i < nb; i++) {
+		drv = ew_drivers[i];
+		if (!drv->lazy)
+			continue;
+		if (drv->storages && boot_dev &&
+		    drv->storages & EWDRV_STORAGE(boot_dev->type))
+			continue;
+		ctx[i].state = DRV_LAZY;
+		nb_lazy++;
 	}
 
+	do {
+		changed = FALSE;
+		for (i = 0; i < nb; i++) {
+			if (ctx[i].state != DRV_PENDING)
+				continue;
+			for (j = 0; j < ctx[i].nb_deps; j++) {
+				if (ctx[ctx[i].deps[j]].state != DRV_LAZY)
+					continue;
+				ctx[ctx[i].deps[j]].state = DRV_PENDING;
+				nb_lazy--;
+				changed = TRUE;
+			}
+		}
+	} while (changed);
+
+	for (i = 0; i < nb; i++)
+		if (ctx[i].state == DRV_LAZY)
+			ewdbg("'%s' driver initialization deferred",
+			      ew_drivers[i]->name);
+}
+
+static BOOLEAN is_ready(drv_ctx_t *ctx, size_t i)
+{
+	size_t j;
+
+	for (j = 0; j < ctx[i].nb_deps; j++)
+		if (ctx[ctx[i].deps[j]].state != DRV_DONE)
+			return FALSE;
+
+	return TRUE;
+}
+
+static void set_done(drv_ctx_t *ctx, size_t i, EFI_STATUS ret)
+{
+	ewperf_record(EWPERF_DRIVER_INIT, ew_drivers[i]->name,
+		      ctx[i].start, ewperf_tsc());
+
 	if (EFI_ERROR(ret)) {
 		ewerr("Failed to initialize '%s' driver", ew_drivers[i]->name);
-		for (j = 0; j < i; j++) {
-			if (!ew_drivers[j]->exit)
-				continue;
-			ew_drivers[j]->exit(st);
+		ctx[i].state = DRV_FAILED;
+		return;
+	}
+
+	ewdbg("'%s' driver succesfully initialized", ew_drivers[i]->name);
+	ctx[i].state = DRV_DONE;
+	initialized[nb_initialized++] = ew_drivers[i];
+}
+
+/* Start the initialization of the driver I.  Return TRUE if it has
+   been started. */
+static BOOLEAN start(EFI_SYSTEM_TABLE *st, drv_ctx_t *ctx, size_t i)
+{
+	ewdrv_t *drv = ew_drivers[i];
+	EFI_STATUS ret;
+
+	ctx[i].start = ewperf_tsc();
+	if (drv->concurrent && runner) {
+		ret = runner->start(drv, st, &ctx[i].job);
+		if (!EFI_ERROR(ret)) {
+			ctx[i].state = DRV_RUNNING;
+			return TRUE;
 		}
+		ewdbg("Failed to start '%s' driver initialization thread",
+		      drv->name);
 	}
 
+	ctx[i].state = DRV_STARTING;
+	ret = drv->init(st);
+	if (!EFI_ERROR(ret) && drv->poll)
+		ctx[i].state = DRV_POLLING;
+	else
+		set_done(ctx, i, ret);
+
+	return TRUE;
+}
+
+/* Collect the status of the running initializations.  Return TRUE if
+   at least one has completed. */
+static BOOLEAN collect(EFI_SYSTEM_TABLE *st, drv_ctx_t *ctx, size_t nb,
+		       size_t *running)
+{
+	BOOLEAN progress = FALSE;
+	EFI_STATUS ret;
+	size_t i;
+
+	*running = 0;
+	for (i = 0; i < nb; i++) {
+		if (ctx[i].state == DRV_POLLING)
+			ret = ew_drivers[i]->poll(st);
+		else if (ctx[i].state == DRV_RUNNING)
+			ret = runner->check(ctx[i].job);
+		else
+			continue;
+
+		if (ret == EFI_NOT_READY) {
+			(*running)++;
+			continue;
+		}
+
+		set_done(ctx, i, ret);
+		progress = TRUE;
+	}
+
+	return progress;
+}
+
+void ewdrv_idle(void)
+{
+	ndelay(POLL_DELAY);
+}
+
+static void idle(void)
+{
+	ewdrv_unlock();
+	ewdrv_idle();
+	ewdrv_lock();
+}
+
+static EFI_STATUS schedule(EFI_SYSTEM_TABLE *st, drv_ctx_t *ctx, size_t nb)
+{
+	EFI_STATUS ret = EFI_SUCCESS;
+	BOOLEAN progress, pending;
+	size_t i, running;
+
+	for (;;) {
+		progress = FALSE;
+		for (i = 0; !EFI_ERROR(ret) && i < nb; i++) {
+			if (ctx[i].state == DRV_PENDING && is_ready(ctx, i))
+				progress |= start(st, ctx, i);
+			if (ctx[i].state == DRV_FAILED)
+				ret = EFI_LOAD_ERROR;
+		}
+
+		progress |= collect(st, ctx, nb, &running);
+		for (i = 0; !EFI_ERROR(ret) && i < nb; i++)
+			if (ctx[i].state == DRV_FAILED)
+				ret = EFI_LOAD_ERROR;
+
+		/* On failure, wait for the running initializations to
+		   complete before releasing. */
+		if (EFI_ERROR(ret) && !running)
+			return ret;
+
+		for (pending = FALSE, i = 0; i < nb; i++)
+			if (ctx[i].state == DRV_PENDING)
+				pending = TRUE;
+
+		if (!pending && !running)
+			return EFI_SUCCESS;
+
+		if (progress)
+			continue;
+
+		if (!running) {
+			for (i = 0; i < nb; i++)
+				if (ctx[i].state == DRV_PENDING)
+					ewerr("'%s' driver dependencies cannot be satisfied",
+					      ew_drivers[i]->name);
+			return EFI_INVALID_PARAMETER;
+		}
+
+		idle();
+	}
+}
+
+/* Synchronously initialize the lazy driver I and the lazy drivers it
+   depends on. */
+static EFI_STATUS start_lazy(size_t i)
+{
+	ewdrv_t *drv = ew_drivers[i];
+	EFI_STATUS ret;
+	size_t j;
+
+	if (drv_ctx[i].state != DRV_LAZY)
+		return EFI_SUCCESS;
+
+	drv_ctx[i].state = DRV_STARTING;
+	nb_lazy--;
+
+	for (j = 0; j < drv_ctx[i].nb_deps; j++) {
+		ret = start_lazy(drv_ctx[i].deps[j]);
+		if (EFI_ERROR(ret))
+			goto err;
+	}
+
+	ewdbg("Starting '%s' driver on demand", drv->name);
+	drv_ctx[i].start = ewperf_tsc();
+	ret = drv->init(drv_st);
+	if (!EFI_ERROR(ret) && drv->poll)
+		while ((ret = drv->poll(drv_st)) == EFI_NOT_READY)
+			ewdrv_idle();
+
+	set_done(drv_ctx, i, ret);
+	return ret;
+
+err:
+	ewerr("Failed to initialize '%s' driver dependencies", drv->name);
+	drv_ctx[i].state = DRV_FAILED;
 	return ret;
 }
 
-EFI_STATUS ewdrv_exit(EFI_SYSTEM_TABLE *st)
+static BOOLEAN provides(ewdrv_t *drv, EFI_GUID *protocol)
+{
+	const EFI_GUID * const *guid;
+
+	if (!drv->provides)
+		return FALSE;
+
+	for (guid = drv->provides; *guid; guid++)
+		if (!guidcmp((EFI_GUID *)*guid, protocol))
+			return TRUE;
+
+	return FALSE;
+}
+
+void ewdrv_provide(EFI_GUID *protocol)
+{
+	size_t i;
+
+	if (!nb_lazy || !protocol)
+		return;
+
+	for (i = 0; i < nb_drivers; i++)
+		if (drv_ctx[i].state == DRV_LAZY &&
+		    provides(ew_drivers[i], protocol))
+			start_lazy(i);
+}
+
+static EFI_STATUS exit_driver(EFI_SYSTEM_TABLE *st, ewdrv_t *drv)
 {
 	EFI_STATUS ret;
+	UINT64 start;
+
+	if (!drv->exit)
+		return EFI_SUCCESS;
+
+	start = ewperf_tsc();
+	ret = drv->exit(st);
+	ewperf_record(EWPERF_DRIVER_EXIT, drv->name, start, ewperf_tsc());
+
+	return ret;
+}
+
+static void exit_initialized(EFI_SYSTEM_TABLE *st)
+{
+	while (nb_initialized) {
+		nb_initialized--;
+		exit_driver(st, initialized[nb_initialized]);
+	}
+}
+
+static void free_ctx(void)
+{
 	size_t i;
 
+	for (i = 0; drv_ctx && i < nb_drivers; i++)
+		free(drv_ctx[i].deps);
+	free(drv_ctx);
+	drv_ctx = NULL;
+	nb_drivers = nb_lazy = 0;
+
+	free(initialized);
+	initialized = NULL;
+}
+
+EFI_STATUS ewdrv_init(EFI_SYSTEM_TABLE *st)
+{
+	EFI_STATUS ret;
+	size_t nb;
+
 	if (!ew_drivers)
 		return EFI_UNSUPPORTED;
 
-	for (i = 0; ew_drivers[i]; i++) {
-		if (!ew_drivers[i]->exit)
-			continue;
-		ret = ew_drivers[i]->exit(st);
+	if (drv_ctx)
+		return EFI_ALREADY_STARTED;
+
+	for (nb = 0; ew_drivers[nb]; nb++)
+		;
+
+	drv_ctx = calloc(nb ? nb : 1, sizeof(*drv_ctx));
+	if (!drv_ctx)
+		return EFI_OUT_OF_RESOURCES;
+	nb_drivers = nb;
+
+	initialized = calloc(nb ? nb : 1, sizeof(*initialized));
+	if (!initialized) {
+		ret = EFI_OUT_OF_RESOURCES;
+		goto err;
+	}
+	nb_initialized = 0;
+
+	ret = resolve_deps(drv_ctx, nb);
+	if (EFI_ERROR(ret))
+		goto err;
+
+	select_lazy(drv_ctx, nb);
+	drv_st = st;
+
+	ewdrv_lock();
+	ret = schedule(st, drv_ctx, nb);
+	if (EFI_ERROR(ret))
+		exit_initialized(st);
+	ewdrv_unlock();
+
+	if (EFI_ERROR(ret))
+		goto err;
+
+	return EFI_SUCCESS;
+
+err:
+	free_ctx();
+	return ret;
+}
+
+EFI_STATUS ewdrv_exit(EFI_SYSTEM_TABLE *st)
+{
+	EFI_STATUS ret;
+	ewdrv_t *drv;
+
+	if (!ew_drivers)
+		return EFI_UNSUPPORTED;
+
+	if (!drv_ctx)
+		return EFI_NOT_STARTED;
+
+	/* Lazy drivers cannot be started anymore */
+	nb_lazy = 0;
+
+	/* Release the drivers in the reverse initialization order so
+	   that a driver is released before its dependencies. */
+	while (nb_initialized) {
+		drv = initialized[nb_initialized - 1];
+		ret = exit_driver(st, drv);
 		if (EFI_ERROR(ret))
 			return ret;
+		nb_initialized--;
 	}
 
+	free_ctx();
+
 	return EFI_SUCCESS;
 }
@@ -0,0 +1,409 @@
+/*
+ * Copyright (c) 2026, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "external.h"
+#include "ewlib.h"
+#include "ewperf.h"
+#include "interface.h"
+#include "protocol/EwPerf.h"
+#include "protocol/Timestamp.h"
+
+#define MAX_ENTRIES	256
+#define MAX_RECORD_LEN	255
+
+static ewperf_entry_t entries[MAX_ENTRIES];
+static UINTN nb_entries;
+static UINT64 tsc_freq;
+static UINT64 boot_steps[EWPERF_NB_BOOT_STEPS];
+static ewperf_clock_t clock_source;
+static UINT64 virtual_ticks;
+
+void ewperf_set_clock(ewperf_clock_t clock)
+{
+	clock_source = clock;
+}
+
+UINT64 ewperf_tsc(void)
+{
+	return (clock_source ? clock_source() : 0) +
+		__atomic_load_n(&virtual_ticks, __ATOMIC_RELAXED);
+}
+
+static EFI_STATUS add_entry(ewperf_kind_t kind, const char *name,
+			    UINT64 start, UINT64 end)
+{
+	ewperf_entry_t *entry;
+
+	if (nb_entries == ARRAY_SIZE(entries))
+		return EFI_OUT_OF_RESOURCES;
+
+	entry = &entries[nb_entries++];
+	entry->kind = kind;
+	entry->name = name;
+	entry->start = start;
+	entry->end = end;
+
+	return EFI_SUCCESS;
+}
+
+void ewperf_record(ewperf_kind_t kind, const char *name,
+		   UINT64 start, UINT64 end)
+{
+	add_entry(kind, name, start, end);
+}
+
+static EFI_STATUS record_copy(ewperf_kind_t kind, const char *name,
+			      UINT64 start, UINT64 end)
+{
+	EFI_STATUS ret;
+	char *copy;
+
+	copy = strdup(name);
+	if (!copy)
+		return EFI_OUT_OF_RESOURCES;
+
+	ret = add_entry(kind, copy, start, end);
+	if (EFI_ERROR(ret))
+		free(copy);
+
+	return ret;
+}
+
+EFI_STATUS ewperf_mark(const char *name)
+{
+	UINT64 now = ewperf_tsc();
+
+	if (!name)
+		return EFI_INVALID_PARAMETER;
+
+	return record_copy(EWPERF_MARKER, name, now, now);
+}
+
+EFI_STATUS ewperf_get(const ewperf_entry_t **entries_p, UINTN *nb_p)
+{
+	if (!entries_p || !nb_p)
+		return EFI_INVALID_PARAMETER;
+
+	*entries_p = entries;
+	*nb_p = nb_entries;
+
+	return EFI_SUCCESS;
+}
+
+const char *ewperf_kind_str(ewperf_kind_t kind)
+{
+	static const char *STR[] = {
+		[EWPERF_COMPONENT_INIT] = "component init",
+		[EWPERF_COMPONENT_FREE] = "component free",
+		[EWPERF_DRIVER_INIT] = "driver init",
+		[EWPERF_DRIVER_EXIT] = "driver exit",
+		[EWPERF_MARKER] = "marker",
+		[EWPERF_PHASE] = "phase"
+	};
+
+	if ((UINTN)kind >= ARRAY_SIZE(STR))
+		return "unknown";
+
+	return STR[kind];
+}
+
+void ewperf_boot_step(ewperf_boot_step_t step)
+{
+	if (step >= EWPERF_NB_BOOT_STEPS || boot_steps[step])
+		return;
+
+	boot_steps[step] = ewperf_tsc();
+}
+
+void ewperf_set_tsc_freq(UINT64 freq)
+{
+	tsc_freq = freq;
+}
+
+UINT64 ewperf_get_tsc_freq(void)
+{
+	return tsc_freq;
+}
+
+static UINT64 convert(UINT64 ticks, UINT64 unit)
+{
+	if (!tsc_freq)
+		return ticks;
+
+	return ticks / tsc_freq * unit + ticks % tsc_freq * unit / tsc_freq;
+}
+
+void ewperf_advance_ns(UINT64 ns)
+{
+	UINT64 ticks;
+
+	ticks = ns / 1000000000 * tsc_freq +
+		ns % 1000000000 * tsc_freq / 1000000000;
+	__atomic_add_fetch(&virtual_ticks, ticks, __ATOMIC_RELAXED);
+}
+
+UINT64 ewperf_to_us(UINT64 ticks)
+{
+	return convert(ticks, 1000000);
+}
+
+UINT64 ewperf_to_ns(UINT64 ticks)
+{
+	return convert(ticks, 1000000000);
+}
+
+/* Length of the string event record of ENTRY */
+static UINTN string_record_len(const ewperf_entry_t *entry)
+{
+	UINTN len;
+
+	len = sizeof(ewperf_string_event_record_t) +
+		strlen(ewperf_kind_str(entry->kind)) + 1 +
+		strlen(entry->name) + 1;
+
+	return min(len, (UINTN)MAX_RECORD_LEN);
+}
+
+static UINT8 *add_string_record(UINT8 *cur, const ewperf_entry_t *entry,
+				UINT16 progress_id, UINT64 timestamp)
+{
+	ewperf_string_event_record_t *record = (void *)cur;
+	UINTN len = string_record_len(entry);
+
+	memset(record, 0, len);
+	record->header.type = EWPERF_STRING_EVENT_RECORD_TYPE;
+	record->header.length = len;
+	record->header.revision = 1;
+	record->progress_id = progress_id;
+	record->timestamp = ewperf_to_ns(timestamp);
+	snprintf((char *)record->string, len - sizeof(*record), "%s:%s",
+		 ewperf_kind_str(entry->kind), entry->name);
+
+	return cur + len;
+}
+
+void ewperf_update_fbpt(void *fbpt)
+{
+	ewperf_basic_boot_record_t *basic;
+
+	basic = (void *)((UINT8 *)fbpt + sizeof(ewperf_fbpt_header_t));
+	basic->reset_end = ewperf_to_ns(boot_steps[EWPERF_RESET_END]);
+	basic->load_image_start = ewperf_to_ns(boot_steps[EWPERF_LOAD_IMAGE]);
+	basic->start_image_start = ewperf_to_ns(boot_steps[EWPERF_START_IMAGE]);
+	basic->exit_boot_services_entry =
+		ewperf_to_ns(boot_steps[EWPERF_EXIT_BOOT_SERVICES_ENTRY]);
+	basic->exit_boot_services_exit =
+		ewperf_to_ns(boot_steps[EWPERF_EXIT_BOOT_SERVICES_EXIT]);
+}
+
+/* Size of the FBPT holding the first NB recorded entries */
+static UINTN fbpt_size(UINTN nb)
+{
+	UINTN i, size;
+
+	size = sizeof(ewperf_fbpt_header_t) +
+		sizeof(ewperf_basic_boot_record_t);
+	for (i = 0; i < nb; i++) {
+		size += string_record_len(&entries[i]);
+		if (entries[i].kind != EWPERF_MARKER)
+			size += string_record_len(&entries[i]);
+	}
+
+	return size;
+}
+
+EFI_STATUS ewperf_write_fbpt(void *fbpt, UINTN capacity)
+{
+	ewperf_fbpt_header_t *header = fbpt;
+	ewperf_basic_boot_record_t *basic;
+	const ewperf_entry_t *entry;
+	UINTN i, nb;
+	UINT8 *cur;
+
+	if (!fbpt)
+		return EFI_INVALID_PARAMETER;
+
+	if (capacity < fbpt_size(0))
+		return EFI_BUFFER_TOO_SMALL;
+
+	for (nb = nb_entries; fbpt_size(nb) > capacity; nb--)
+		;
+
+	memset(fbpt, 0, fbpt_size(nb));
+	header->signature = EWPERF_FBPT_SIGNATURE;
+	header->length = fbpt_size(nb);
+
+	basic = (void *)(header + 1);
+	basic->header.type = EWPERF_BASIC_BOOT_RECORD_TYPE;
+	basic->header.length = sizeof(*basic);
+	basic->header.revision = 2;
+	ewperf_update_fbpt(header);
+
+	cur = (UINT8 *)(basic + 1);
+	for (i = 0; i < nb; i++) {
+		entry = &entries[i];
+		if (entry->kind == EWPERF_MARKER) {
+			cur = add_string_record(cur, entry,
+						EWPERF_PROGRESS_MARKER,
+						entry->start);
+			continue;
+		}
+		cur = add_string_record(cur, entry, EWPERF_PROGRESS_START,
+					entry->start);
+		cur = add_string_record(cur, entry, EWPERF_PROGRESS_END,
+					entry->end);
+	}
+
+	return EFI_SUCCESS;
+}
+
+EFI_STATUS ewperf_build_fbpt(void **fbpt_p, UINTN *size_p)
+{
+	EFI_STATUS ret;
+	UINTN size;
+	void *fbpt;
+
+	if (!fbpt_p || !size_p)
+		return EFI_INVALID_PARAMETER;
+
+	size = fbpt_size(nb_entries);
+	fbpt = malloc(size);
+	if (!fbpt)
+		return EFI_OUT_OF_RESOURCES;
+
+	ret = ewperf_write_fbpt(fbpt, size);
+	if (EFI_ERROR(ret)) {
+		free(fbpt);
+		return ret;
+	}
+
+	*fbpt_p = fbpt;
+	*size_p = size;
+
+	return EFI_SUCCESS;
+}
+
+static EFIAPI UINT64 get_timestamp(void)
+{
+	return ewperf_tsc();
+}
+
+static EFIAPI EFI_STATUS
+get_properties(EFI_TIMESTAMP_PROPERTIES *Properties)
+{
+	if (!Properties)
+		return EFI_INVALID_PARAMETER;
+
+	if (!tsc_freq)
+		return EFI_DEVICE_ERROR;
+
+	Properties->Frequency = tsc_freq;
+	Properties->EndValue = ~0ULL;
+
+	return EFI_SUCCESS;
+}
+
+static EFIAPI EFI_STATUS
+perf_mark(__attribute__((__unused__)) EFIWRAPPER_PERF_PROTOCOL *This,
+	  CONST CHAR8 *Name)
+{
+	return ewperf_mark((const char *)Name);
+}
+
+static EFIAPI EFI_STATUS
+perf_record(__attribute__((__unused__)) EFIWRAPPER_PERF_PROTOCOL *This,
+	    CONST CHAR8 *Name, UINT64 StartTimestamp, UINT64 EndTimestamp)
+{
+	if (!Name || EndTimestamp < StartTimestamp)
+		return EFI_INVALID_PARAMETER;
+
+	return record_copy(EWPERF_PHASE, (const char *)Name,
+			   StartTimestamp, EndTimestamp);
+}
+
+static EFI_GUID timestamp_guid = EFI_TIMESTAMP_PROTOCOL_GUID;
+static EFI_GUID perf_guid = EFIWRAPPER_PERF_PROTOCOL_GUID;
+static EFI_HANDLE handle;
+
+EFI_STATUS ewperf_init(EFI_SYSTEM_TABLE *st)
+{
+	static EFI_TIMESTAMP_PROTOCOL timestamp_default = {
+		.GetTimestamp = get_timestamp,
+		.GetProperties = get_properties
+	};
+	static EFIWRAPPER_PERF_PROTOCOL perf_default = {
+		.Revision = EFIWRAPPER_PERF_PROTOCOL_REVISION,
+		.Mark = perf_mark,
+		.Record = perf_record
+	};
+	EFI_TIMESTAMP_PROTOCOL *timestamp;
+	EFIWRAPPER_PERF_PROTOCOL *perf;
+	EFI_STATUS ret;
+
+	if (!st)
+		return EFI_INVALID_PARAMETER;
+
+	if (handle)
+		return EFI_ALREADY_STARTED;
+
+	ret = interface_init(st, &timestamp_guid, &handle,
+			     &timestamp_default, sizeof(timestamp_default),
+			     (void **)&timestamp);
+	if (EFI_ERROR(ret))
+		return ret;
+
+	ret = interface_init(st, &perf_guid, &handle,
+			     &perf_default, sizeof(perf_default),
+			     (void **)&perf);
+	if (EFI_ERROR(ret)) {
+		interface_free(st, &timestamp_guid, handle);
+		handle = NULL;
+	}
+
+	return ret;
+}
+
+EFI_STATUS ewperf_free(EFI_SYSTEM_TABLE *st)
+{
+	EFI_STATUS ret;
+
+	if (!handle)
+		return EFI_INVALID_PARAMETER;
+
+	ret = interface_free(st, &perf_guid, handle);
+	if (EFI_ERROR(ret))
+		return ret;
+
+	ret = interface_free(st, &timestamp_guid, handle);
+	if (!EFI_ERROR(ret))
+		handle = NULL;
+
+	return ret;
+}
@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2026, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "mappedblkio.h"
+#include "external.h"
+#include "interface.h"
+
+typedef struct mapped_blockio {
+	EFIWRAPPER_MAPPED_BLOCK_IO_PROTOCOL interface;
+	media_t *media;
+} mapped_blockio_t;
+
+static EFIAPI EFI_STATUS
+map_blocks(EFIWRAPPER_MAPPED_BLOCK_IO_PROTOCOL *This, UINT32 MediaId,
+	   EFI_LBA Lba, UINTN BufferSize, VOID **Buffer)
+{
+	mapped_blockio_t *mb = (mapped_blockio_t *)This;
+	media_t *media;
+	EFI_LBA count;
+
+	if (!This || !mb->media || !Buffer)
+		return EFI_INVALID_PARAMETER;
+
+	media = mb->media;
+	if (media->m.MediaId != MediaId)
+		return EFI_MEDIA_CHANGED;
+
+	if (BufferSize % media->m.BlockSize)
+		return EFI_BAD_BUFFER_SIZE;
+
+	count = BufferSize / media->m.BlockSize;
+	if (Lba > media->m.LastBlock || count > media->m.LastBlock + 1 - Lba)
+		return EFI_INVALID_PARAMETER;
+
+	return media_map(media, Lba, count, (const void **)Buffer);
+}
+
+static EFI_GUID mapped_blockio_guid = EFIWRAPPER_MAPPED_BLOCK_IO_PROTOCOL_GUID;
+
+EFI_STATUS mapped_blockio_init(EFI_SYSTEM_TABLE *st, media_t *media,
+			       EFI_HANDLE *handle)
+{
+	EFI_STATUS ret;
+	mapped_blockio_t *mb;
+
+	static mapped_blockio_t mapped_blockio_default = {
+		.interface = {
+			.Revision = EFIWRAPPER_MAPPED_BLOCK_IO_PROTOCOL_REVISION,
+			.MapBlocks = map_blocks
+		}
+	};
+
+	ret = interface_init(st, &mapped_blockio_guid, handle,
+			     &mapped_blockio_default,
+			     sizeof(mapped_blockio_default), (void **)&mb);
+	if (EFI_ERROR(ret))
+		return ret;
+
+	mb->media = media;
+
+	return EFI_SUCCESS;
+}
+
+EFI_STATUS mapped_blockio_free(EFI_SYSTEM_TABLE *st, EFI_HANDLE handle)
+{
+	return interface_free(st, &mapped_blockio_guid, handle);
+}
@@ -32,6 +32,35 @@
 #include "external.h"
 #include "interface.h"
 #include "media.h"
+#include "ewarg.h"
+#include "ewlog.h"
+#include "ewlib.h"
+#include "ewperf.h"
+
+#define EW_BLKCACHE "EW.blkcache"
+#define EW_BLKCACHE_WB "EW.blkcache.wb"
+
+static blkcache_t *new_cache(storage_t *storage)
+{
+	const char *val;
+	UINTN nb_blocks = BLKCACHE_DEFAULT_BLOCKS;
+	BOOLEAN write_back = FALSE;
+
+	val = ewarg_getval(EW_BLKCACHE);
+	if (val)
+		nb_blocks = strtoull(val, NULL, 10);
+
+	val = ewarg_getval(EW_BLKCACHE_WB);
+	if (val)
+		write_back = strtoull(val, NULL, 10) != 0;
+
+	if (!nb_blocks)
+		return NULL;
+
+	return blkcache_new(storage, nb_blocks, write_back);
+}
+
+static media_t *medias;
 
 media_t *media_new(storage_t *storage)
 {
@@ -48,10 +77,50 @@ media_t *media_new(storage_t *storage)
 	media->m.LastBlock = storage->blk_cnt - 1;
 
 	media->storage = storage;
+	media->cache = new_cache(storage);
+
+	media->bounce_blocks = max(MEDIA_BOUNCE_SIZE / storage->blk_sz, 2);
+	media->bounce = malloc(media->bounce_blocks * storage->blk_sz);
+	if (!media->bounce) {
+		blkcache_free(media->cache);
+		free(media);
+		return NULL;
+	}
 
 	return media;
 }
 
+media_t *media_new_partition(media_t *parent, EFI_LBA start, EFI_LBA end)
+{
+	media_t *media;
+
+	media = calloc(1, sizeof(*media));
+	if (!media)
+		return NULL;
+
+	memcpy(&media->m, &parent->m, sizeof(media->m));
+	media->m.LogicalPartition = TRUE;
+	media->m.LastBlock = end - start;
+
+	media->storage = parent->storage;
+	media->cache = parent->cache;
+	media->parent = parent;
+	media->offset = parent->offset + start;
+	media->bounce_blocks = parent->bounce_blocks;
+
+	return media;
+}
+
+EFI_STATUS media_alloc_bounce(media_t *media)
+{
+	if (media->bounce)
+		return EFI_SUCCESS;
+
+	media->bounce = malloc(media->bounce_blocks * media->m.BlockSize);
+
+	return media->bounce ? EFI_SUCCESS : EFI_OUT_OF_RESOURCES;
+}
+
 /* Randomly generated GUID */
 static EFI_GUID media_guid = { 0xd4b39595, 0xe31b, 0x48d5,
 			       { 0xac, 0xa3, 0x03, 0x1c, 0x61, 0x42, 0xc7, 0xab } };
@@ -59,12 +128,861 @@ static EFI_GUID media_guid = { 0xd4b39595, 0xe31b, 0x48d5,
 EFI_STATUS media_register(EFI_SYSTEM_TABLE *st, media_t *media,
 			  EFI_HANDLE *handle)
 {
-	return uefi_call_wrapper(st->BootServices->InstallProtocolInterface, 4,
-				 handle, &media_guid,
-				 EFI_NATIVE_INTERFACE, media);
+	EFI_STATUS ret;
+
+	ret = uefi_call_wrapper(st->BootServices->InstallProtocolInterface, 4,
+				handle, &media_guid,
+				EFI_NATIVE_INTERFACE, media);
+	if (EFI_ERROR(ret))
+		return ret;
+
+	media->next = medias;
+	medias = media;
+
+	return EFI_SUCCESS;
 }
 
 EFI_STATUS media_free(EFI_SYSTEM_TABLE *st, EFI_HANDLE handle)
 {
+	EFI_STATUS ret;
+	media_t *media, **cur;
+	blkcache_stats_t stats;
+
+	ret = uefi_call_wrapper(st->BootServices->HandleProtocol, 3,
+				handle, &media_guid, (VOID **)&media);
+	if (EFI_ERROR(ret))
+		return ret;
+
+	media_drain(media);
+	for (cur = &medias; *cur; cur = &(*cur)->next)
+		if (*cur == media) {
+			*cur = media->next;
+			break;
+		}
+
+	if (media->cache && !media->parent) {
+		ret = blkcache_flush(media->cache);
+		if (EFI_ERROR(ret))
+			ewerr("Failed to flush the block cache");
+
+		blkcache_get_stats(media->cache, &stats);
+		ewdbg("Block cache: %llu hits, %llu misses, %llu bypassed, "
+		      "%llu evictions, %llu write-backs",
+		      (unsigned long long)stats.hits,
+		      (unsigned long long)stats.misses,
+		      (unsigned long long)stats.bypassed,
+		      (unsigned long long)stats.evictions,
+		      (unsigned long long)stats.writebacks);
+
+		blkcache_free(media->cache);
+	}
+	media->cache = NULL;
+
+	free(media->bounce);
+	media->bounce = NULL;
+
 	return interface_free(st, &media_guid, handle);
 }
+
+/* Drop the read-ahead windows of the medias sharing the MEDIA
+   storage which overlap the [LBA, LBA + COUNT[ blocks of MEDIA. */
+static void ra_invalidate(media_t *media, EFI_LBA lba, EFI_LBA count)
+{
+	media_t *cur;
+	EFI_LBA start;
+
+	lba += media->offset;
+	for (cur = medias; cur; cur = cur->next) {
+		if (cur->storage != media->storage || !cur->ra_count)
+			continue;
+
+		start = cur->offset + cur->ra_lba;
+		if (lba < start + cur->ra_count && start < lba + count)
+			cur->ra_count = 0;
+	}
+}
+
+static UINTN log2_bucket(UINT64 value, UINTN nb_buckets)
+{
+	UINTN i;
+
+	for (i = 0; value > 1 && i < nb_buckets - 1; i++)
+		value >>= 1;
+
+	return i;
+}
+
+static storage_trace_t trace;
+
+void media_set_trace(storage_trace_t fn)
+{
+	trace = fn;
+}
+
+/* The latency is not accounted when the TSC frequency is unknown
+   since it cannot be converted in microseconds. */
+static void add_stats(EFIWRAPPER_MEDIA_OP_STATS *stats, UINT64 bytes,
+		      UINT64 ticks, EFI_STATUS ret)
+{
+	UINT64 latency;
+
+	stats->Count++;
+	if (EFI_ERROR(ret))
+		stats->Errors++;
+	else
+		stats->Bytes += bytes;
+
+	if (bytes)
+		stats->SizeHistogram[log2_bucket(bytes,
+			EFIWRAPPER_MEDIA_STATS_SIZE_BUCKETS)]++;
+
+	if (!ewperf_get_tsc_freq())
+		return;
+
+	latency = ewperf_to_us(ticks);
+	stats->TotalLatency += latency;
+	stats->MaxLatency = max(stats->MaxLatency, latency);
+	stats->LatencyHistogram[log2_bucket(latency,
+		EFIWRAPPER_MEDIA_STATS_LATENCY_BUCKETS)]++;
+}
+
+/* Account a request of OP type on the COUNT storage blocks from LBA
+   which started at START and completed with RET.  Partition requests
+   are also accounted to the disk media since only the latter has the
+   MediaStats protocol.  RET is returned for convenience. */
+static EFI_STATUS account(media_t *media, EFIWRAPPER_MEDIA_STATS_OP op,
+			  EFI_LBA lba, EFI_LBA count, UINT64 start,
+			  EFI_STATUS ret)
+{
+	static const enum storage_trace_op TRACE_OPS[] = {
+		[MediaStatsRead] = STORAGE_TRACE_READ,
+		[MediaStatsWrite] = STORAGE_TRACE_WRITE,
+		[MediaStatsErase] = STORAGE_TRACE_ERASE,
+		[MediaStatsFlush] = STORAGE_TRACE_FLUSH
+	};
+	UINT64 bytes = count * media->m.BlockSize;
+	UINT64 end = ewperf_tsc();
+
+	if (trace)
+		trace(media->storage, TRACE_OPS[op], lba, count, start, end,
+		      ret);
+
+	if (media->written && !EFI_ERROR(ret) &&
+	    (op == MediaStatsWrite || op == MediaStatsErase))
+		media->written(media->written_priv, lba, count);
+
+	for (; media; media = media->parent)
+		add_stats(&media->stats.Op[op], bytes, end - start, ret);
+
+	return ret;
+}
+
+UINT32 media_erase_granularity(media_t *media)
+{
+	return max(media->storage->erase_granularity, 1U);
+}
+
+/* Number of blocks of the first erase command of the [LBA, LBA +
+   COUNT[ storage range: up to the next granularity boundary if LBA
+   is unaligned, as many whole granules as possible otherwise. */
+static EFI_LBA erase_chunk(media_t *media, EFI_LBA lba, EFI_LBA count)
+{
+	EFI_LBA gran = media_erase_granularity(media), max_count;
+
+	max_count = max(MEDIA_ERASE_CHUNK / media->m.BlockSize / gran, 1) *
+		gran;
+
+	if (lba % gran)
+		return min(gran - lba % gran, count);
+
+	if (count < gran)
+		return count;
+
+	return min(count - count % gran, max_count);
+}
+
+static EFI_STATUS erase_range(media_t *media, EFI_LBA lba, EFI_LBA count)
+{
+	storage_t *s = media->storage;
+	EFI_STATUS ret;
+	EFI_LBA n;
+
+	for (; count; lba += n, count -= n) {
+		n = erase_chunk(media, lba, count);
+		ret = s->erase(s, lba, n * s->blk_sz);
+		if (EFI_ERROR(ret))
+			return ret;
+	}
+
+	return EFI_SUCCESS;
+}
+
+static BOOLEAN extents_overlap(media_extent_t *e, EFI_LBA lba,
+			       EFI_LBA count)
+{
+	for (; e && e->lba < lba + count; e = e->next)
+		if (lba < e->lba + e->count)
+			return TRUE;
+
+	return FALSE;
+}
+
+/* Insert [LBA, LBA + COUNT[ in the sorted LIST, merged with the
+   extents it overlaps or is adjacent to. */
+static EFI_STATUS extents_add(media_extent_t **list, EFI_LBA lba,
+			      EFI_LBA count)
+{
+	media_extent_t **cur, *e, *next;
+	EFI_LBA end = lba + count;
+
+	for (cur = list; *cur && (*cur)->lba + (*cur)->count < lba;
+	     cur = &(*cur)->next)
+		;
+
+	if (!*cur || (*cur)->lba > end) {
+		e = malloc(sizeof(*e));
+		if (!e)
+			return EFI_OUT_OF_RESOURCES;
+
+		e->lba = lba;
+		e->count = count;
+		e->next = *cur;
+		*cur = e;
+		return EFI_SUCCESS;
+	}
+
+	e = *cur;
+	end = max(end, e->lba + e->count);
+	e->lba = min(e->lba, lba);
+	while (e->next && e->next->lba <= end) {
+		next = e->next;
+		end = max(end, next->lba + next->count);
+		e->next = next->next;
+		free(next);
+	}
+	e->count = end - e->lba;
+
+	return EFI_SUCCESS;
+}
+
+/* Erase the next chunk of the queued ranges of MEDIA.  A failure is
+   reported to all the queued requests covering the chunk. */
+static void erase_next(media_t *media)
+{
+	media_extent_t *e = media->erase_extents;
+	storage_t *s = media->storage;
+	storage_req_t *req;
+	EFI_STATUS ret;
+	EFI_LBA n;
+
+	n = erase_chunk(media, e->lba, e->count);
+	ret = s->erase(s, e->lba, n * s->blk_sz);
+	if (EFI_ERROR(ret))
+		for (req = media->erase_reqs; req; req = req->next)
+			if (req->lba < e->lba + n &&
+			    e->lba < req->lba + req->count)
+				req->status = ret;
+
+	e->lba += n;
+	e->count -= n;
+	if (!e->count) {
+		media->erase_extents = e->next;
+		free(e);
+	}
+}
+
+static void media_complete(storage_req_t *req);
+
+/* Make one erase command of progress and complete the requests which
+   have been entirely erased. */
+static void erase_poll(media_t *media)
+{
+	storage_req_t **cur, *req, *done = NULL;
+
+	if (media->erase_extents)
+		erase_next(media);
+
+	for (cur = &media->erase_reqs; (req = *cur); ) {
+		if (extents_overlap(media->erase_extents, req->lba,
+				    req->count)) {
+			cur = &req->next;
+			continue;
+		}
+		*cur = req->next;
+		req->next = done;
+		done = req;
+	}
+
+	/* The completion callbacks may queue new requests. */
+	while ((req = done)) {
+		done = req->next;
+		media_complete(req);
+	}
+}
+
+/* Reads and writes must not overtake the queued erases they overlap.
+   The requests themselves are completed by the next erase_poll(). */
+static void erase_sync(media_t *media, EFI_LBA lba, EFI_LBA count)
+{
+	media_t *root = media->parent ? media->parent : media;
+
+	if (!root->erase_extents ||
+	    !extents_overlap(root->erase_extents, media->offset + lba, count))
+		return;
+
+	while (root->erase_extents)
+		erase_next(root);
+}
+
+static EFI_STATUS do_read(media_t *media, EFI_LBA lba, EFI_LBA count,
+			  void *buf)
+{
+	storage_t *s = media->storage;
+
+	erase_sync(media, lba, count);
+	lba += media->offset;
+	if (media->cache)
+		return blkcache_read(media->cache, lba, count, buf);
+
+	return s->read(s, lba, count, buf) == count ? EFI_SUCCESS :
+		EFI_DEVICE_ERROR;
+}
+
+static EFI_STATUS do_write(media_t *media, EFI_LBA lba, EFI_LBA count,
+			   const void *buf)
+{
+	storage_t *s = media->storage;
+
+	erase_sync(media, lba, count);
+	ra_invalidate(media, lba, count);
+	lba += media->offset;
+
+	if (media->cache)
+		return blkcache_write(media->cache, lba, count, buf);
+
+	return s->write(s, lba, count, buf) == count ? EFI_SUCCESS :
+		EFI_DEVICE_ERROR;
+}
+
+EFI_STATUS media_read(media_t *media, EFI_LBA lba, EFI_LBA count, void *buf)
+{
+	UINT64 start = ewperf_tsc();
+
+	return account(media, MediaStatsRead, media->offset + lba, count,
+		       start, do_read(media, lba, count, buf));
+}
+
+EFI_STATUS media_write(media_t *media, EFI_LBA lba, EFI_LBA count,
+		       const void *buf)
+{
+	UINT64 start = ewperf_tsc();
+
+	return account(media, MediaStatsWrite, media->offset + lba, count,
+		       start, do_write(media, lba, count, buf));
+}
+
+/* Segments are transferred one by one through the block cache, if
+   any, or when the storage has no vectored operation. */
+static EFI_STATUS do_readv(media_t *media, EFI_LBA lba, EFI_LBA count,
+			   const storage_seg_t *segs, UINTN nb_segs)
+{
+	storage_t *s = media->storage;
+	EFI_STATUS ret;
+	UINTN i;
+
+	erase_sync(media, lba, count);
+	if (!media->cache && s->readv && nb_segs > 1)
+		return s->readv(s, media->offset + lba, count,
+				segs, nb_segs) == count ?
+			EFI_SUCCESS : EFI_DEVICE_ERROR;
+
+	for (i = 0; i < nb_segs; lba += segs[i++].len / s->blk_sz) {
+		ret = do_read(media, lba, segs[i].len / s->blk_sz,
+			      segs[i].buf);
+		if (EFI_ERROR(ret))
+			return ret;
+	}
+
+	return EFI_SUCCESS;
+}
+
+static EFI_STATUS do_writev(media_t *media, EFI_LBA lba, EFI_LBA count,
+			    const storage_seg_t *segs, UINTN nb_segs)
+{
+	storage_t *s = media->storage;
+	EFI_STATUS ret;
+	UINTN i;
+
+	erase_sync(media, lba, count);
+	if (!media->cache && s->writev && nb_segs > 1) {
+		ra_invalidate(media, lba, count);
+		return s->writev(s, media->offset + lba, count,
+				 segs, nb_segs) == count ?
+			EFI_SUCCESS : EFI_DEVICE_ERROR;
+	}
+
+	for (i = 0; i < nb_segs; lba += segs[i++].len / s->blk_sz) {
+		ret = do_write(media, lba, segs[i].len / s->blk_sz,
+			       segs[i].buf);
+		if (EFI_ERROR(ret))
+			return ret;
+	}
+
+	return EFI_SUCCESS;
+}
+
+static EFI_LBA segs_count(media_t *media, const storage_seg_t *segs,
+			  UINTN nb_segs)
+{
+	EFI_LBA count = 0;
+	UINTN i;
+
+	for (i = 0; i < nb_segs; i++)
+		count += segs[i].len / media->m.BlockSize;
+
+	return count;
+}
+
+EFI_STATUS media_readv(media_t *media, EFI_LBA lba,
+		       const storage_seg_t *segs, UINTN nb_segs)
+{
+	UINT64 start = ewperf_tsc();
+	EFI_LBA count = segs_count(media, segs, nb_segs);
+
+	return account(media, MediaStatsRead, media->offset + lba, count,
+		       start, do_readv(media, lba, count, segs, nb_segs));
+}
+
+EFI_STATUS media_writev(media_t *media, EFI_LBA lba,
+			const storage_seg_t *segs, UINTN nb_segs)
+{
+	UINT64 start = ewperf_tsc();
+	EFI_LBA count = segs_count(media, segs, nb_segs);
+
+	return account(media, MediaStatsWrite, media->offset + lba, count,
+		       start, do_writev(media, lba, count, segs, nb_segs));
+}
+
+EFI_STATUS media_flush(media_t *media)
+{
+	storage_t *s = media->storage;
+	UINT64 start = ewperf_tsc();
+	EFI_STATUS ret = EFI_SUCCESS;
+
+	if (media->cache)
+		ret = blkcache_flush(media->cache);
+
+	if (!EFI_ERROR(ret) && s->flush)
+		ret = s->flush(s);
+
+	return account(media, MediaStatsFlush, 0, 0, start, ret);
+}
+
+/* The block cache is written back first so that the mapping holds
+   the latest data.  Mapped blocks are accounted as read. */
+EFI_STATUS media_map(media_t *media, EFI_LBA lba, EFI_LBA count,
+		     const void **addr)
+{
+	storage_t *s = media->storage;
+	UINT64 start = ewperf_tsc();
+	EFI_STATUS ret;
+
+	if (!s->map)
+		return EFI_UNSUPPORTED;
+
+	erase_sync(media, lba, count);
+	if (media->cache) {
+		ret = blkcache_flush(media->cache);
+		if (EFI_ERROR(ret))
+			return ret;
+	}
+
+	ret = s->map(s, media->offset + lba, count, addr);
+	if (ret == EFI_UNSUPPORTED)
+		return ret;
+
+	return account(media, MediaStatsRead, media->offset + lba, count,
+		       start, ret);
+}
+
+EFI_STATUS media_erase(media_t *media, EFI_LBA lba, UINTN size)
+{
+	storage_t *s = media->storage;
+	UINT64 start = ewperf_tsc();
+	EFI_LBA count;
+
+	if (!s->erase)
+		return EFI_UNSUPPORTED;
+
+	count = (size + media->m.BlockSize - 1) / media->m.BlockSize;
+	ra_invalidate(media, lba, count);
+	lba += media->offset;
+	if (media->cache)
+		blkcache_invalidate(media->cache, lba, count);
+
+	return account(media, MediaStatsErase, lba, count, start,
+		       erase_range(media, lba, count));
+}
+
+/* Write COUNT blocks from LBA out of a shared zero-filled buffer. */
+static EFI_STATUS write_zeroes_emulate(media_t *media, EFI_LBA lba,
+				       EFI_LBA count)
+{
+	static void *zeroes;
+	storage_seg_t segs[MEDIA_ZEROES_SEGS];
+	EFI_LBA blocks = MEDIA_ZEROES_SIZE / media->m.BlockSize, n;
+	EFI_STATUS ret;
+	UINTN i;
+
+	if (!zeroes) {
+		zeroes = calloc(1, MEDIA_ZEROES_SIZE);
+		if (!zeroes)
+			return EFI_OUT_OF_RESOURCES;
+	}
+
+	for (; count; lba += n, count -= n) {
+		for (i = 0, n = 0; i < ARRAY_SIZE(segs) && n < count; i++) {
+			segs[i].buf = zeroes;
+			segs[i].len = min(blocks, count - n) *
+				media->m.BlockSize;
+			n += segs[i].len / media->m.BlockSize;
+		}
+
+		ret = do_writev(media, lba, n, segs, i);
+		if (EFI_ERROR(ret))
+			return ret;
+	}
+
+	return EFI_SUCCESS;
+}
+
+static EFI_STATUS do_write_zeroes(media_t *media, EFI_LBA lba,
+				  EFI_LBA count)
+{
+	storage_t *s = media->storage;
+	EFI_STATUS ret;
+
+	if (!s->write_zeroes)
+		return write_zeroes_emulate(media, lba, count);
+
+	erase_sync(media, lba, count);
+	ra_invalidate(media, lba, count);
+	if (media->cache)
+		blkcache_invalidate(media->cache, media->offset + lba, count);
+
+	ret = s->write_zeroes(s, media->offset + lba, count);
+	if (ret == EFI_UNSUPPORTED)
+		return write_zeroes_emulate(media, lba, count);
+
+	return ret;
+}
+
+EFI_STATUS media_write_zeroes(media_t *media, EFI_LBA lba, EFI_LBA count)
+{
+	UINT64 start = ewperf_tsc();
+
+	if (!count)
+		return EFI_SUCCESS;
+
+	return account(media, MediaStatsWrite, media->offset + lba, count,
+		       start, do_write_zeroes(media, lba, count));
+}
+
+static EFI_STATUS account_req(media_req_t *mreq, EFI_STATUS ret)
+{
+	static const EFIWRAPPER_MEDIA_STATS_OP OPS[] = {
+		[STORAGE_OP_READ] = MediaStatsRead,
+		[STORAGE_OP_WRITE] = MediaStatsWrite,
+		[STORAGE_OP_ERASE] = MediaStatsErase
+	};
+	storage_req_t *req = &mreq->req;
+
+	return account(mreq->media, OPS[req->op], req->lba, req->count,
+		       mreq->start, ret);
+}
+
+static UINTN completing;
+
+/* Asynchronous requests latency covers their whole life, from
+   media_submit() to their completion. */
+static void media_complete(storage_req_t *req)
+{
+	media_req_t *mreq = (media_req_t *)req;
+
+	account_req(mreq, req->status);
+	mreq->media->inflight--;
+	completing++;
+	mreq->complete(mreq);
+	completing--;
+}
+
+BOOLEAN media_completing(void)
+{
+	return completing != 0;
+}
+
+/* Erase requests are queued on the disk media, merged with the
+   already queued ones, and progressively erased by erase_poll(). */
+static EFI_STATUS erase_submit(media_t *media, media_req_t *mreq)
+{
+	media_t *root = media->parent ? media->parent : media;
+	storage_req_t *req = &mreq->req;
+	EFI_STATUS ret;
+
+	if (!media->storage->erase)
+		return EFI_UNSUPPORTED;
+
+	ra_invalidate(media, req->lba, req->count);
+	req->lba += media->offset;
+	if (media->cache)
+		blkcache_invalidate(media->cache, req->lba, req->count);
+
+	ret = extents_add(&root->erase_extents, req->lba, req->count);
+	if (EFI_ERROR(ret))
+		return ret;
+
+	mreq->media = root;
+	mreq->start = ewperf_tsc();
+	req->status = EFI_SUCCESS;
+	req->complete = media_complete;
+	req->next = root->erase_reqs;
+	root->erase_reqs = req;
+	root->inflight++;
+
+	return EFI_SUCCESS;
+}
+
+EFI_STATUS media_submit(media_t *media, media_req_t *mreq)
+{
+	EFI_STATUS ret;
+	storage_t *s = media->storage;
+	storage_req_t *req = &mreq->req;
+
+	if (req->op == STORAGE_OP_ERASE)
+		return erase_submit(media, mreq);
+
+	mreq->media = media;
+	mreq->start = ewperf_tsc();
+	req->complete = media_complete;
+	media->inflight++;
+
+	/* Small requests are served synchronously when the block cache
+	   is enabled since they are likely to hit it. */
+	if (!s->submit ||
+	    (media->cache && req->count < BLKCACHE_BYPASS_BLOCKS)) {
+		if (req->op == STORAGE_OP_READ)
+			req->status = do_read(media, req->lba, req->count,
+					      req->buf);
+		else
+			req->status = do_write(media, req->lba, req->count,
+					       req->buf);
+		req->lba += media->offset;
+		media_complete(req);
+		return EFI_SUCCESS;
+	}
+
+	erase_sync(media, req->lba, req->count);
+	if (req->op == STORAGE_OP_WRITE)
+		ra_invalidate(media, req->lba, req->count);
+
+	req->lba += media->offset;
+	if (req->op == STORAGE_OP_WRITE) {
+		if (media->cache)
+			blkcache_invalidate(media->cache, req->lba, req->count);
+	} else if (media->cache) {
+		/* Make the dirty blocks visible to the device. */
+		ret = blkcache_flush(media->cache);
+		if (EFI_ERROR(ret)) {
+			media->inflight--;
+			return account_req(mreq, ret);
+		}
+	}
+
+	ret = s->submit(s, req);
+	if (EFI_ERROR(ret)) {
+		media->inflight--;
+		account_req(mreq, ret);
+	}
+
+	return ret;
+}
+
+void media_drain(media_t *media)
+{
+	storage_t *s = media->storage;
+
+	while (media->inflight && (media->erase_reqs || s->poll)) {
+		if (media->erase_reqs)
+			erase_poll(media);
+		if (s->poll)
+			s->poll(s);
+	}
+}
+
+EFI_STATUS media_poll_all(void)
+{
+	media_t *media;
+	BOOLEAN pending = FALSE;
+
+	for (media = medias; media; media = media->next) {
+		if (!media->inflight)
+			continue;
+
+		if (media->erase_reqs)
+			erase_poll(media);
+
+		if (media->storage->poll)
+			media->storage->poll(media->storage);
+
+		if (media->inflight)
+			pending = TRUE;
+	}
+
+	return pending ? EFI_NOT_READY : EFI_SUCCESS;
+}
+
+typedef struct copy_req {
+	media_req_t mreq;
+	BOOLEAN done;
+} copy_req_t;
+
+static void copy_complete(media_req_t *mreq)
+{
+	((copy_req_t *)mreq)->done = TRUE;
+}
+
+static void copy_submit(media_t *media, copy_req_t *creq, enum storage_op op,
+			EFI_LBA lba, EFI_LBA count, void *buf)
+{
+	storage_req_t *req = &creq->mreq.req;
+	EFI_STATUS ret;
+
+	creq->done = FALSE;
+	creq->mreq.complete = copy_complete;
+	req->op = op;
+	req->lba = lba;
+	req->count = count;
+	req->buf = buf;
+
+	ret = media_submit(media, &creq->mreq);
+	if (EFI_ERROR(ret)) {
+		req->status = ret;
+		creq->done = TRUE;
+	}
+}
+
+static EFI_STATUS copy_wait(media_t *media, copy_req_t *creq)
+{
+	storage_t *s = media->storage;
+
+	while (!creq->done && s->poll)
+		s->poll(s);
+
+	return creq->done ? creq->mreq.req.status : EFI_DEVICE_ERROR;
+}
+
+/* Double buffered copy: chunk K is written out while chunk K + 1 is
+   read in.  When DST overlaps the end of the source range, chunks
+   are copied from the last one so that the source blocks are always
+   read before being overwritten.  In both directions, the chunk being
+   read never overlaps the chunks being written. */
+static EFI_STATUS copy_pipelined(media_t *media, EFI_LBA src, EFI_LBA dst,
+				 EFI_LBA count)
+{
+	EFI_LBA chunk = MEDIA_COPY_CHUNK / media->m.BlockSize;
+	BOOLEAN backward = dst > src && dst < src + count;
+	EFI_LBA left = count, n, off;
+	copy_req_t rd, wr[2];
+	unsigned char *buf[2];
+	EFI_STATUS ret, status;
+	UINTN cur, i;
+
+	buf[0] = malloc(2 * MEDIA_COPY_CHUNK);
+	if (!buf[0])
+		return EFI_OUT_OF_RESOURCES;
+	buf[1] = buf[0] + MEDIA_COPY_CHUNK;
+
+	for (i = 0; i < ARRAY_SIZE(wr); i++) {
+		wr[i].done = TRUE;
+		wr[i].mreq.req.status = EFI_SUCCESS;
+	}
+
+	n = min(chunk, left);
+	off = backward ? left - n : 0;
+	copy_submit(media, &rd, STORAGE_OP_READ, src + off, n, buf[0]);
+
+	for (cur = 0; ; cur = !cur) {
+		ret = copy_wait(media, &rd);
+		if (EFI_ERROR(ret))
+			break;
+
+		copy_submit(media, &wr[cur], STORAGE_OP_WRITE, dst + off, n,
+			    buf[cur]);
+		left -= n;
+
+		/* The next chunk is read in the buffer of the previous
+		   write. */
+		ret = copy_wait(media, &wr[!cur]);
+		if (EFI_ERROR(ret) || !left)
+			break;
+
+		n = min(chunk, left);
+		off = backward ? left - n : count - left;
+		copy_submit(media, &rd, STORAGE_OP_READ, src + off, n,
+			    buf[!cur]);
+	}
+
+	/* The buffers can only be released once all the requests are
+	   completed. */
+	copy_wait(media, &rd);
+	for (i = 0; i < ARRAY_SIZE(wr); i++) {
+		status = copy_wait(media, &wr[i]);
+		if (!EFI_ERROR(ret))
+			ret = status;
+	}
+
+	free(buf[0]);
+	return ret;
+}
+
+static EFI_STATUS copy_native(media_t *media, EFI_LBA src, EFI_LBA dst,
+			      EFI_LBA count)
+{
+	storage_t *s = media->storage;
+	EFI_STATUS ret;
+
+	if (!s->copy || (src < dst + count && dst < src + count))
+		return EFI_UNSUPPORTED;
+
+	erase_sync(media, src, count);
+	erase_sync(media, dst, count);
+	ra_invalidate(media, dst, count);
+	if (media->cache) {
+		blkcache_invalidate(media->cache, media->offset + dst, count);
+		/* Make the dirty source blocks visible to the device. */
+		ret = blkcache_flush(media->cache);
+		if (EFI_ERROR(ret))
+			return ret;
+	}
+
+	return s->copy(s, media->offset + src, media->offset + dst, count);
+}
+
+EFI_STATUS media_copy(media_t *media, EFI_LBA src, EFI_LBA dst,
+		      EFI_LBA count)
+{
+	UINT64 start = ewperf_tsc();
+	EFI_STATUS ret;
+
+	if (!count || src == dst)
+		return EFI_SUCCESS;
+
+	ret = copy_native(media, src, dst, count);
+	if (ret != EFI_UNSUPPORTED)
+		return account(media, MediaStatsWrite, media->offset + dst,
+			       count, start, ret);
+
+	/* The reads and writes of the fallback are accounted by
+	   media_submit(). */
+	return copy_pipelined(media, src, dst, count);
+}
@@ -35,15 +35,136 @@
 #include <efi.h>
 #include <efiapi.h>
 #include <storage.h>
+#include <protocol/MediaStats.h>
+
+#include "blkcache.h"
+
+/* Size of the per-media bounce buffer used by DiskIo for unaligned
+   accesses.  It also holds the read-ahead window, which grows from
+   MEDIA_READAHEAD_MIN up to this size on sequential reads. */
+#ifndef MEDIA_BOUNCE_SIZE
+#define MEDIA_BOUNCE_SIZE	(128 * 1024)
+#endif
+
+#ifndef MEDIA_READAHEAD_MIN
+#define MEDIA_READAHEAD_MIN	(4 * 1024)
+#endif
+
+/* Largest erase command issued to the storage.  Queued erases
+   progress by one such command per media_poll_all() call. */
+#ifndef MEDIA_ERASE_CHUNK
+#define MEDIA_ERASE_CHUNK	(64 * 1024 * 1024)
+#endif
+
+/* Size of the zero-filled buffer used to emulate write_zeroes(),
+   a multiple of the largest block size.  Up to MEDIA_ZEROES_SEGS
+   copies of it are written by a single vectored command. */
+#ifndef MEDIA_ZEROES_SIZE
+#define MEDIA_ZEROES_SIZE	(64 * 1024)
+#endif
+#define MEDIA_ZEROES_SEGS	16
+
+/* Size of each of the two buffers used to copy blocks through
+   memory: a chunk is written out while the next one is read in. */
+#ifndef MEDIA_COPY_CHUNK
+#define MEDIA_COPY_CHUNK	(1024 * 1024)
+#endif
+
+typedef struct media_extent {
+	EFI_LBA lba;
+	EFI_LBA count;
+	struct media_extent *next;
+} media_extent_t;
 
 typedef struct media {
 	EFI_BLOCK_IO_MEDIA m;
 	storage_t *storage;
+	blkcache_t *cache;
+	/* Partition media: blocks are OFFSET blocks away from the
+	   PARENT media ones and the block cache is the PARENT one. */
+	struct media *parent;
+	EFI_LBA offset;
+	unsigned char *bounce;
+	UINTN bounce_blocks;
+	/* Read-ahead window: RA_COUNT blocks from RA_LBA are valid in
+	   the bounce buffer. */
+	EFI_LBA ra_lba;
+	UINTN ra_count;
+	UINTN ra_blocks;
+	UINT64 ra_next;
+	/* Number of asynchronous requests in flight */
+	UINTN inflight;
+	/* Queued erase requests and the sorted, merged, storage block
+	   ranges they still have to erase */
+	storage_req_t *erase_reqs;
+	media_extent_t *erase_extents;
+	/* Per operation statistics of the requests served by the
+	   media accessors below */
+	EFIWRAPPER_MEDIA_STATS stats;
+	/* Disk media: WRITTEN is called with WRITTEN_PRIV once a write
+	   or an erase of the COUNT blocks from LBA issued on this media
+	   succeeded, possibly from storage_poll().  It must not issue
+	   any I/O. */
+	void (*written)(void *priv, EFI_LBA lba, EFI_LBA count);
+	void *written_priv;
+	struct media *next;
 } media_t;
 
+/* Asynchronous media request.  COMPLETE is called once REQ.status is
+   set, either from media_submit() for synchronously emulated requests
+   or from storage_poll().  Erase requests are always completed from
+   storage_poll() or media_drain(). */
+typedef struct media_req {
+	storage_req_t req;
+	media_t *media;
+	void (*complete)(struct media_req *mreq);
+	void *priv;
+	/* Submission timestamp, in TSC ticks */
+	UINT64 start;
+} media_req_t;
+
 media_t *media_new(storage_t *storage);
+/* Create the media of the [START, END] blocks range of PARENT.  Its
+   bounce buffer is allocated on first use by media_alloc_bounce(). */
+media_t *media_new_partition(media_t *parent, EFI_LBA start, EFI_LBA end);
+EFI_STATUS media_alloc_bounce(media_t *media);
 EFI_STATUS media_register(EFI_SYSTEM_TABLE *st, media_t *media,
 			  EFI_HANDLE *handle);
 EFI_STATUS media_free(EFI_SYSTEM_TABLE *st, EFI_HANDLE handle);
 
+/* Block level accessors used by the BlockIo, DiskIo and EraseBlock
+   protocols.  They go through the media block cache if any. */
+EFI_STATUS media_read(media_t *media, EFI_LBA lba, EFI_LBA count, void *buf);
+EFI_STATUS media_write(media_t *media, EFI_LBA lba, EFI_LBA count,
+		       const void *buf);
+/* Vectored accessors: transfer the NB_SEGS segments of SEGS to or
+   from consecutive blocks starting at LBA, with a single storage
+   command when the storage supports it. */
+EFI_STATUS media_readv(media_t *media, EFI_LBA lba,
+		       const storage_seg_t *segs, UINTN nb_segs);
+EFI_STATUS media_writev(media_t *media, EFI_LBA lba,
+			const storage_seg_t *segs, UINTN nb_segs);
+EFI_STATUS media_flush(media_t *media);
+/* Return in ADDR a read-only pointer to COUNT blocks from LBA if the
+   storage is memory mapped, EFI_UNSUPPORTED otherwise. */
+EFI_STATUS media_map(media_t *media, EFI_LBA lba, EFI_LBA count,
+		     const void **addr);
+EFI_STATUS media_erase(media_t *media, EFI_LBA lba, UINTN size);
+/* Zero COUNT blocks from LBA, natively if the storage supports it. */
+EFI_STATUS media_write_zeroes(media_t *media, EFI_LBA lba, EFI_LBA count);
+/* Copy COUNT blocks from SRC to DST, the ranges may overlap. */
+EFI_STATUS media_copy(media_t *media, EFI_LBA src, EFI_LBA dst,
+		      EFI_LBA count);
+UINT32 media_erase_granularity(media_t *media);
+
+EFI_STATUS media_submit(media_t *media, media_req_t *mreq);
+/* Wait for all the asynchronous requests of MEDIA to complete. */
+void media_drain(media_t *media);
+EFI_STATUS media_poll_all(void);
+/* TRUE while the COMPLETE callback of a request runs, from which
+   no media can be released. */
+BOOLEAN media_completing(void);
+/* See storage_set_trace() */
+void media_set_trace(storage_trace_t trace);
+
 #endif	/* _MEDIA_H_ */
@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2026, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "mediastats.h"
+#include "external.h"
+#include "interface.h"
+
+typedef struct media_stats {
+	EFIWRAPPER_MEDIA_STATS_PROTOCOL interface;
+	media_t *media;
+} media_stats_t;
+
+static EFIAPI EFI_STATUS
+get_stats(EFIWRAPPER_MEDIA_STATS_PROTOCOL *This,
+	  EFIWRAPPER_MEDIA_STATS *Stats)
+{
+	media_stats_t *media_stats = (media_stats_t *)This;
+
+	if (!This || !Stats || !media_stats->media)
+		return EFI_INVALID_PARAMETER;
+
+	memcpy(Stats, &media_stats->media->stats, sizeof(*Stats));
+
+	return EFI_SUCCESS;
+}
+
+static EFIAPI EFI_STATUS
+reset_stats(EFIWRAPPER_MEDIA_STATS_PROTOCOL *This)
+{
+	media_stats_t *media_stats = (media_stats_t *)This;
+
+	if (!This || !media_stats->media)
+		return EFI_INVALID_PARAMETER;
+
+	memset(&media_stats->media->stats, 0,
+	       sizeof(media_stats->media->stats));
+
+	return EFI_SUCCESS;
+}
+
+static EFI_GUID media_stats_guid = EFIWRAPPER_MEDIA_STATS_PROTOCOL_GUID;
+
+EFI_STATUS media_stats_init(EFI_SYSTEM_TABLE *st, media_t *media,
+			    EFI_HANDLE *handle)
+{
+	EFI_STATUS ret;
+	media_stats_t *media_stats;
+
+	static media_stats_t media_stats_default = {
+		.interface = {
+			.Revision = EFIWRAPPER_MEDIA_STATS_PROTOCOL_REVISION,
+			.GetStats = get_stats,
+			.ResetStats = reset_stats
+		}
+	};
+
+	ret = interface_init(st, &media_stats_guid, handle,
+			     &media_stats_default, sizeof(media_stats_default),
+			     (void **)&media_stats);
+	if (EFI_ERROR(ret))
+		return ret;
+
+	media_stats->media = media;
+
+	return EFI_SUCCESS;
+}
+
+EFI_STATUS media_stats_free(EFI_SYSTEM_TABLE *st, EFI_HANDLE handle)
+{
+	return interface_free(st, &media_stats_guid, handle);
+}
@@ -0,0 +1,703 @@
+/*
+ * Copyright (c) 2026, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "partition.h"
+#include "blockio.h"
+#include "blockio2.h"
+#include "diskio.h"
+#include "diskio2.h"
+#include "writezeroes.h"
+#include "blockcopy.h"
+#include "sparse.h"
+#include "mappedblkio.h"
+#include "external.h"
+#include "interface.h"
+#include "lib.h"
+#include "ewlog.h"
+
+#include <efilib.h>
+
+#define GPT_SIGNATURE		"EFI PART"
+#define GPT_HEADER_LBA		1
+#define GPT_HEADER_MIN_SIZE	92
+/* Bounds of the partition entry array size, the specification
+   minimum is 16 KiB. */
+#define GPT_ENTRIES_MIN_SIZE	(16 * 1024)
+#define GPT_ENTRIES_MAX_SIZE	(1024 * 1024)
+
+typedef struct gpt_header {
+	char signature[8];
+	UINT32 revision;
+	UINT32 size;
+	UINT32 crc32;
+	UINT32 reserved;
+	UINT64 my_lba;
+	UINT64 alternate_lba;
+	UINT64 first_usable_lba;
+	UINT64 last_usable_lba;
+	EFI_GUID disk_guid;
+	UINT64 entries_lba;
+	UINT32 nb_entries;
+	UINT32 entry_size;
+	UINT32 entries_crc32;
+} __attribute__((__packed__)) gpt_header_t;
+
+typedef struct gpt_entry {
+	EFI_GUID type;
+	EFI_GUID unique;
+	UINT64 starting_lba;
+	UINT64 ending_lba;
+	UINT64 attributes;
+	CHAR16 name[EFIWRAPPER_PARTITION_NAME_LENGTH];
+} __attribute__((__packed__)) gpt_entry_t;
+
+typedef struct partition_index {
+	EFIWRAPPER_PARTITION_INDEX_PROTOCOL interface;
+	media_t *media;
+	EFIWRAPPER_PARTITION_INFO *parts;
+	UINTN nb_parts;
+	/* Open addressing hash tables of PARTS indexes plus one, zero
+	   marks an empty slot.  Both have MASK + 1 slots. */
+	UINT32 *by_name;
+	UINT32 *by_guid;
+	UINTN mask;
+} partition_index_t;
+
+static EFI_GUID index_guid = EFIWRAPPER_PARTITION_INDEX_PROTOCOL_GUID;
+static EFI_GUID dp_guid = DEVICE_PATH_PROTOCOL;
+
+/* FNV-1a */
+static UINT32 hash_bytes(const void *data, UINTN size)
+{
+	const UINT8 *p = data;
+	UINT32 hash = 2166136261U;
+
+	while (size--)
+		hash = (hash ^ *p++) * 16777619U;
+
+	return hash;
+}
+
+static UINT32 hash_name(const CHAR16 *name)
+{
+	UINTN len;
+
+	for (len = 0; len < EFIWRAPPER_PARTITION_NAME_LENGTH && name[len]; len++)
+		;
+
+	return hash_bytes(name, len * sizeof(*name));
+}
+
+static BOOLEAN name_equal(const CHAR16 *name1, const CHAR16 *name2)
+{
+	UINTN i;
+
+	for (i = 0; i <= EFIWRAPPER_PARTITION_NAME_LENGTH; i++) {
+		if (name1[i] != name2[i])
+			return FALSE;
+		if (!name1[i])
+			return TRUE;
+	}
+
+	return FALSE;
+}
+
+static void index_insert(partition_index_t *index, UINT32 *table,
+			 UINT32 hash, UINTN part)
+{
+	UINTN i;
+
+	for (i = hash & index->mask; table[i]; i = (i + 1) & index->mask)
+		;
+	table[i] = part + 1;
+}
+
+static EFIAPI EFI_STATUS
+find_by_name(EFIWRAPPER_PARTITION_INDEX_PROTOCOL *This,
+	     CONST CHAR16 *Name,
+	     CONST EFIWRAPPER_PARTITION_INFO **Info)
+{
+	partition_index_t *index = (partition_index_t *)This;
+	UINTN i;
+
+	if (!This || !Name || !Info)
+		return EFI_INVALID_PARAMETER;
+
+	for (i = hash_name(Name) & index->mask; index->by_name[i];
+	     i = (i + 1) & index->mask)
+		if (name_equal(index->parts[index->by_name[i] - 1].Name,
+			       Name)) {
+			*Info = &index->parts[index->by_name[i] - 1];
+			return EFI_SUCCESS;
+		}
+
+	return EFI_NOT_FOUND;
+}
+
+static EFIAPI EFI_STATUS
+find_by_guid(EFIWRAPPER_PARTITION_INDEX_PROTOCOL *This,
+	     CONST EFI_GUID *Guid,
+	     CONST EFIWRAPPER_PARTITION_INFO **Info)
+{
+	partition_index_t *index = (partition_index_t *)This;
+	UINTN i;
+
+	if (!This || !Guid || !Info)
+		return EFI_INVALID_PARAMETER;
+
+	for (i = hash_bytes(Guid, sizeof(*Guid)) & index->mask;
+	     index->by_guid[i]; i = (i + 1) & index->mask)
+		if (!memcmp(&index->parts[index->by_guid[i] - 1].UniqueGuid,
+			    Guid, sizeof(*Guid))) {
+			*Info = &index->parts[index->by_guid[i] - 1];
+			return EFI_SUCCESS;
+		}
+
+	return EFI_NOT_FOUND;
+}
+
+static BOOLEAN header_valid(media_t *media, gpt_header_t *hdr, EFI_LBA lba)
+{
+	UINT32 crc, expected;
+	UINT64 entries_blocks;
+
+	if (memcmp(hdr->signature, GPT_SIGNATURE, sizeof(hdr->signature)) ||
+	    hdr->size < GPT_HEADER_MIN_SIZE ||
+	    hdr->size > media->m.BlockSize || hdr->my_lba != lba)
+		return FALSE;
+
+	expected = hdr->crc32;
+	hdr->crc32 = 0;
+	crc32(hdr, hdr->size, &crc);
+	hdr->crc32 = expected;
+	if (crc != expected)
+		return FALSE;
+
+	if (hdr->entry_size < sizeof(gpt_entry_t) || hdr->entry_size % 8 ||
+	    !hdr->nb_entries ||
+	    (UINT64)hdr->nb_entries * hdr->entry_size > GPT_ENTRIES_MAX_SIZE)
+		return FALSE;
+
+	entries_blocks = ((UINT64)hdr->nb_entries * hdr->entry_size +
+			  media->m.BlockSize - 1) / media->m.BlockSize;
+
+	return hdr->entries_lba <= media->m.LastBlock &&
+		entries_blocks <= media->m.LastBlock + 1 - hdr->entries_lba &&
+		hdr->first_usable_lba <= hdr->last_usable_lba &&
+		hdr->last_usable_lba <= media->m.LastBlock;
+}
+
+/* Read and validate the GPT header at LBA and its partition entry
+   array.  On success, *ENTRIES_P is the allocated array. */
+static EFI_STATUS read_gpt(media_t *media, EFI_LBA lba, gpt_header_t *hdr,
+			   unsigned char **entries_p)
+{
+	EFI_STATUS ret;
+	unsigned char *buf;
+	UINTN size, blocks;
+	UINT32 crc;
+
+	buf = malloc(media->m.BlockSize);
+	if (!buf)
+		return EFI_OUT_OF_RESOURCES;
+
+	ret = media_read(media, lba, 1, buf);
+	if (EFI_ERROR(ret))
+		goto out;
+
+	memcpy(hdr, buf, sizeof(*hdr));
+	if (!header_valid(media, (gpt_header_t *)buf, lba)) {
+		ret = EFI_NOT_FOUND;
+		goto out;
+	}
+	free(buf);
+
+	size = hdr->nb_entries * hdr->entry_size;
+	blocks = (size + media->m.BlockSize - 1) / media->m.BlockSize;
+	buf = malloc(blocks * media->m.BlockSize);
+	if (!buf)
+		return EFI_OUT_OF_RESOURCES;
+
+	/* The whole array is read at once. */
+	ret = media_read(media, hdr->entries_lba, blocks, buf);
+	if (EFI_ERROR(ret))
+		goto out;
+
+	crc32(buf, size, &crc);
+	if (crc != hdr->entries_crc32) {
+		ret = EFI_CRC_ERROR;
+		goto out;
+	}
+
+	*entries_p = buf;
+	return EFI_SUCCESS;
+
+out:
+	free(buf);
+	return ret;
+}
+
+static BOOLEAN is_unused(const gpt_entry_t *entry)
+{
+	static const EFI_GUID unused;
+
+	return !memcmp(&entry->type, &unused, sizeof(unused));
+}
+
+static EFI_STATUS build_index(partition_index_t *index, gpt_header_t *hdr,
+			      unsigned char *entries)
+{
+	EFIWRAPPER_PARTITION_INFO *part;
+	gpt_entry_t *entry;
+	UINTN i, slots;
+
+	index->parts = calloc(hdr->nb_entries, sizeof(*index->parts));
+	if (!index->parts)
+		return EFI_OUT_OF_RESOURCES;
+
+	for (i = 0; i < hdr->nb_entries; i++) {
+		entry = (gpt_entry_t *)(entries + i * hdr->entry_size);
+		if (is_unused(entry))
+			continue;
+
+		if (entry->starting_lba < hdr->first_usable_lba ||
+		    entry->ending_lba > hdr->last_usable_lba ||
+		    entry->starting_lba > entry->ending_lba) {
+			ewerr("GPT entry %u is out of the usable blocks",
+			      (unsigned int)i + 1);
+			continue;
+		}
+
+		part = &index->parts[index->nb_parts++];
+		part->Number = i + 1;
+		memcpy(&part->TypeGuid, &entry->type, sizeof(part->TypeGuid));
+		memcpy(&part->UniqueGuid, &entry->unique,
+		       sizeof(part->UniqueGuid));
+		part->StartingLba = entry->starting_lba;
+		part->EndingLba = entry->ending_lba;
+		part->Attributes = entry->attributes;
+		memcpy(part->Name, entry->name, sizeof(entry->name));
+	}
+
+	/* Keep the load factor under one half. */
+	for (slots = 1; slots < index->nb_parts * 2; slots <<= 1)
+		;
+	index->mask = slots - 1;
+
+	index->by_name = calloc(slots, sizeof(*index->by_name));
+	index->by_guid = calloc(slots, sizeof(*index->by_guid));
+	if (!index->by_name || !index->by_guid)
+		return EFI_OUT_OF_RESOURCES;
+
+	for (i = 0; i < index->nb_parts; i++) {
+		part = &index->parts[i];
+		index_insert(index, index->by_name, hash_name(part->Name), i);
+		index_insert(index, index->by_guid,
+			     hash_bytes(&part->UniqueGuid,
+					sizeof(part->UniqueGuid)), i);
+	}
+
+	return EFI_SUCCESS;
+}
+
+/* Partition device path: the disk one followed by a hard drive media
+   node. */
+static EFI_DEVICE_PATH *partition_dp(EFI_SYSTEM_TABLE *st, EFI_HANDLE disk,
+				     EFIWRAPPER_PARTITION_INFO *part)
+{
+	EFI_STATUS ret;
+	EFI_DEVICE_PATH *disk_dp, *node, *dp;
+	HARDDRIVE_DEVICE_PATH *hd;
+	UINTN len;
+
+	ret = uefi_call_wrapper(st->BootServices->HandleProtocol, 3,
+				disk, &dp_guid, (VOID **)&disk_dp);
+	if (EFI_ERROR(ret))
+		return NULL;
+
+	for (node = disk_dp; !IsDevicePathEndType(node);
+	     node = NextDevicePathNode(node))
+		;
+	len = (UINT8 *)node - (UINT8 *)disk_dp;
+
+	dp = malloc(len + sizeof(*hd) + sizeof(*node));
+	if (!dp)
+		return NULL;
+
+	memcpy(dp, disk_dp, len);
+	hd = (HARDDRIVE_DEVICE_PATH *)((UINT8 *)dp + len);
+	memset(hd, 0, sizeof(*hd));
+	hd->Header.Type = MEDIA_DEVICE_PATH;
+	hd->Header.SubType = MEDIA_HARDDRIVE_DP;
+	SetDevicePathNodeLength(&hd->Header, sizeof(*hd));
+	hd->PartitionNumber = part->Number;
+	hd->PartitionStart = part->StartingLba;
+	hd->PartitionSize = part->EndingLba - part->StartingLba + 1;
+	memcpy(hd->Signature, &part->UniqueGuid, sizeof(hd->Signature));
+	hd->MBRType = MBR_TYPE_EFI_PARTITION_TABLE_HEADER;
+	hd->SignatureType = SIGNATURE_TYPE_GUID;
+
+	node = (EFI_DEVICE_PATH *)(hd + 1);
+	SetDevicePathEndNode(node);
+
+	return dp;
+}
+
+static struct child_interface {
+	const char *name;
+	EFI_STATUS (*init)(EFI_SYSTEM_TABLE *, media_t *, EFI_HANDLE *);
+	EFI_STATUS (*free)(EFI_SYSTEM_TABLE *, EFI_HANDLE);
+} CHILD_INTERFACES[] = {
+	{ "media", media_register, media_free },
+	{ "blockio", blockio_init, blockio_free },
+	{ "blockio2", blockio2_init, blockio2_free },
+	{ "diskio", diskio_init, diskio_free },
+	{ "diskio2", diskio2_init, diskio2_free },
+	{ "write zeroes", write_zeroes_init, write_zeroes_free },
+	{ "block copy", block_copy_init, block_copy_free },
+	{ "sparse write", sparse_write_init, sparse_write_free },
+	{ "mapped blockio", mapped_blockio_init, mapped_blockio_free }
+};
+
+static void free_child(EFI_SYSTEM_TABLE *st, EFI_HANDLE handle, UINTN nb)
+{
+	EFI_STATUS ret;
+
+	while (nb--) {
+		ret = CHILD_INTERFACES[nb].free(st, handle);
+		if (EFI_ERROR(ret))
+			ewerr("Failed to unregister partition %s interface",
+			      CHILD_INTERFACES[nb].name);
+	}
+
+	ret = interface_free(st, &dp_guid, handle);
+	if (EFI_ERROR(ret))
+		ewerr("Failed to unregister partition device path");
+}
+
+static EFI_STATUS install_child(EFI_SYSTEM_TABLE *st, EFI_HANDLE disk,
+				media_t *disk_media,
+				EFIWRAPPER_PARTITION_INFO *part)
+{
+	EFI_STATUS ret;
+	EFI_DEVICE_PATH *dp;
+	EFI_HANDLE handle = NULL;
+	media_t *media;
+	UINTN i;
+
+	dp = partition_dp(st, disk, part);
+	if (!dp)
+		return EFI_OUT_OF_RESOURCES;
+
+	ret = uefi_call_wrapper(st->BootServices->InstallProtocolInterface, 4,
+				&handle, &dp_guid, EFI_NATIVE_INTERFACE, dp);
+	if (EFI_ERROR(ret)) {
+		free(dp);
+		return ret;
+	}
+
+	media = media_new_partition(disk_media, part->StartingLba,
+				    part->EndingLba);
+	if (!media) {
+		free_child(st, handle, 0);
+		return EFI_OUT_OF_RESOURCES;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(CHILD_INTERFACES); i++) {
+		ret = CHILD_INTERFACES[i].init(st, media, &handle);
+		if (EFI_ERROR(ret)) {
+			/* Once registered, the media is released by
+			   media_free(). */
+			if (i == 0)
+				free(media);
+			free_child(st, handle, i);
+			return ret;
+		}
+	}
+
+	part->Handle = handle;
+
+	return EFI_SUCCESS;
+}
+
+static void free_index(partition_index_t *index)
+{
+	free(index->parts);
+	free(index->by_name);
+	free(index->by_guid);
+}
+
+static void free_children(EFI_SYSTEM_TABLE *st, partition_index_t *index)
+{
+	UINTN i;
+
+	for (i = 0; i < index->nb_parts; i++)
+		if (index->parts[i].Handle) {
+			free_child(st, index->parts[i].Handle,
+				   ARRAY_SIZE(CHILD_INTERFACES));
+			index->parts[i].Handle = NULL;
+		}
+}
+
+/* Hand the child handles of the OLD partitions over to the identical
+   FRESH ones so that their interfaces remain valid across a scan. */
+static void keep_children(partition_index_t *old, partition_index_t *fresh)
+{
+	EFIWRAPPER_PARTITION_INFO *o, *n;
+	UINTN i, j;
+
+	for (i = 0; i < fresh->nb_parts; i++) {
+		n = &fresh->parts[i];
+		for (j = 0; j < old->nb_parts; j++) {
+			o = &old->parts[j];
+			if (o->Handle && o->Number == n->Number &&
+			    o->StartingLba == n->StartingLba &&
+			    o->EndingLba == n->EndingLba &&
+			    !memcmp(&o->UniqueGuid, &n->UniqueGuid,
+				    sizeof(n->UniqueGuid))) {
+				n->Handle = o->Handle;
+				o->Handle = NULL;
+				break;
+			}
+		}
+	}
+}
+
+/* The blocks outside of the usable ones hold the GPT headers and
+   partition entry arrays.  Writing them only marks the disk STALE:
+   the partitions are scanned again by partition_refresh(). */
+typedef struct gpt_watch {
+	EFI_SYSTEM_TABLE *st;
+	EFI_HANDLE handle;
+	media_t *media;
+	partition_index_t *index;
+	EFI_LBA first_usable;
+	EFI_LBA last_usable;
+	BOOLEAN stale;
+	struct gpt_watch *next;
+} gpt_watch_t;
+
+static gpt_watch_t *watches;
+
+static EFI_STATUS drop_index(gpt_watch_t *watch)
+{
+	EFI_STATUS ret;
+
+	free_children(watch->st, watch->index);
+	free_index(watch->index);
+	ret = interface_free(watch->st, &index_guid, watch->handle);
+	watch->index = NULL;
+
+	return ret;
+}
+
+/* Parse the GPT of the WATCH disk, install or update the Partition
+   Index Protocol and install the partition handles.  The handles of
+   the partitions left unchanged since the previous scan are kept.
+   The usable blocks range of WATCH is updated. */
+static EFI_STATUS scan(gpt_watch_t *watch)
+{
+	static partition_index_t index_default = {
+		.interface = {
+			.Revision = EFIWRAPPER_PARTITION_INDEX_PROTOCOL_REVISION,
+			.FindByName = find_by_name,
+			.FindByGuid = find_by_guid
+		}
+	};
+	EFI_STATUS ret;
+	media_t *media = watch->media;
+	partition_index_t *index, fresh;
+	unsigned char *entries;
+	gpt_header_t hdr;
+	EFI_LBA blocks;
+	UINTN i;
+
+	/* Without GPT, the blocks a minimal one would use are
+	   watched. */
+	blocks = 1 + GPT_ENTRIES_MIN_SIZE / media->m.BlockSize;
+	watch->first_usable = GPT_HEADER_LBA + blocks;
+	watch->last_usable = media->m.LastBlock > blocks ?
+		media->m.LastBlock - blocks : 0;
+
+	ret = read_gpt(media, GPT_HEADER_LBA, &hdr, &entries);
+	if (EFI_ERROR(ret)) {
+		ret = read_gpt(media, media->m.LastBlock, &hdr, &entries);
+		if (EFI_ERROR(ret)) {
+			ewdbg("No valid GUID Partition Table");
+			if (ret == EFI_OUT_OF_RESOURCES)
+				return ret;
+			return watch->index ? drop_index(watch) : EFI_SUCCESS;
+		}
+		ewerr("Primary GPT is invalid, using the backup GPT");
+	}
+
+	watch->first_usable = hdr.first_usable_lba;
+	watch->last_usable = hdr.last_usable_lba;
+
+	memset(&fresh, 0, sizeof(fresh));
+	ret = build_index(&fresh, &hdr, entries);
+	free(entries);
+	if (EFI_ERROR(ret)) {
+		free_index(&fresh);
+		return ret;
+	}
+
+	index = watch->index;
+	if (index) {
+		keep_children(index, &fresh);
+		free_children(watch->st, index);
+		free_index(index);
+	} else {
+		ret = interface_init(watch->st, &index_guid, &watch->handle,
+				     &index_default, sizeof(index_default),
+				     (void **)&index);
+		if (EFI_ERROR(ret)) {
+			free_index(&fresh);
+			return ret;
+		}
+		index->media = media;
+		watch->index = index;
+	}
+
+	index->parts = fresh.parts;
+	index->nb_parts = fresh.nb_parts;
+	index->by_name = fresh.by_name;
+	index->by_guid = fresh.by_guid;
+	index->mask = fresh.mask;
+
+	memcpy(&index->interface.DiskGuid, &hdr.disk_guid,
+	       sizeof(index->interface.DiskGuid));
+	index->interface.NumberOfPartitions = index->nb_parts;
+	index->interface.Partitions = index->parts;
+
+	/* A partition without handle remains in the index. */
+	for (i = 0; i < index->nb_parts; i++) {
+		if (index->parts[i].Handle)
+			continue;
+
+		ret = install_child(watch->st, watch->handle, media,
+				    &index->parts[i]);
+		if (EFI_ERROR(ret))
+			ewerr("Failed to install partition %u handle",
+			      index->parts[i].Number);
+	}
+
+	return EFI_SUCCESS;
+}
+
+/* Called from account(), possibly while the storage completes
+   requests: no I/O can be issued and no handle can be released. */
+static void gpt_written(void *priv, EFI_LBA lba, EFI_LBA count)
+{
+	gpt_watch_t *watch = priv;
+
+	if (count && (lba < watch->first_usable ||
+		      lba + count - 1 > watch->last_usable))
+		watch->stale = TRUE;
+}
+
+void partition_refresh(void)
+{
+	static BOOLEAN scanning;
+	gpt_watch_t *watch;
+	EFI_STATUS ret;
+
+	/* scan() itself looks protocols up. */
+	if (scanning || media_completing())
+		return;
+
+	scanning = TRUE;
+	for (watch = watches; watch; watch = watch->next) {
+		if (!watch->stale)
+			continue;
+
+		watch->stale = FALSE;
+		ewdbg("GPT written, scanning the partitions again");
+		ret = scan(watch);
+		if (EFI_ERROR(ret))
+			ewerr("Failed to scan the partitions, ret=0x%zx",
+			      (size_t)ret);
+	}
+	scanning = FALSE;
+}
+
+EFI_STATUS partition_init(EFI_SYSTEM_TABLE *st, media_t *media,
+			  EFI_HANDLE *handle)
+{
+	EFI_STATUS ret;
+	gpt_watch_t *watch;
+
+	if (media->m.LastBlock <= GPT_HEADER_LBA)
+		return EFI_SUCCESS;
+
+	watch = calloc(1, sizeof(*watch));
+	if (!watch)
+		return EFI_OUT_OF_RESOURCES;
+
+	watch->st = st;
+	watch->handle = *handle;
+	watch->media = media;
+
+	ret = scan(watch);
+	if (EFI_ERROR(ret)) {
+		free(watch);
+		return ret;
+	}
+
+	watch->next = watches;
+	watches = watch;
+	media->written = gpt_written;
+	media->written_priv = watch;
+
+	return EFI_SUCCESS;
+}
+
+EFI_STATUS partition_free(__attribute__((__unused__)) EFI_SYSTEM_TABLE *st,
+			  EFI_HANDLE handle)
+{
+	EFI_STATUS ret = EFI_SUCCESS;
+	gpt_watch_t **cur, *watch;
+
+	for (cur = &watches; *cur; cur = &(*cur)->next)
+		if ((*cur)->handle == handle)
+			break;
+
+	watch = *cur;
+	if (!watch)
+		return EFI_SUCCESS;
+
+	*cur = watch->next;
+	watch->media->written = NULL;
+	if (watch->index)
+		ret = drop_index(watch);
+	free(watch);
+
+	return ret;
+}
@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2026, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef _PARTITION_H_
+#define _PARTITION_H_
+
+#include <efi.h>
+#include <efiapi.h>
+#include <protocol/PartitionIndex.h>
+#include "media.h"
+
+/* Parse the GUID Partition Table of MEDIA, install a child handle
+   per partition and the Partition Index Protocol on HANDLE.  A media
+   without a valid GPT is not an error. */
+EFI_STATUS partition_init(EFI_SYSTEM_TABLE *st, media_t *media,
+			  EFI_HANDLE *handle);
+EFI_STATUS partition_free(EFI_SYSTEM_TABLE *st, EFI_HANDLE handle);
+
+/* Scan again the partitions of the medias whose GPT blocks were
+   written since their last scan.  The handles of the changed
+   partitions are released.  It is called by the protocol lookups and
+   FlushBlocks(), and does nothing from a request completion. */
+void partition_refresh(void);
+
+#endif
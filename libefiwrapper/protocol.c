@@ -30,21 +30,54 @@
  */
 
 #include <ewvar.h>
+#include <ewdrv.h>
 #include "lib.h"
+#include "partition.h"
 #include "protocol.h"
 
 static EFI_GUID dp_guid = DEVICE_PATH_PROTOCOL;
 
-#define MAX_INTERFACE_NUMBER 32
-
+/* Handles are allocated along with their first interface and
+   released with their last one.  A non-NULL handle unknown to
+   InstallProtocolInterface() is adopted as is.  Lookups only go
+   through the interfaces of the matching handle, partition handles
+   holding about ten interfaces each. */
 typedef struct interface {
-	EFI_HANDLE handle;
 	EFI_GUID protocol;
 	VOID *interface;
-	BOOLEAN installed;
+	struct interface *next;
 } interface_t;
 
-static interface_t INTERFACES[MAX_INTERFACE_NUMBER];
+typedef struct handle {
+	EFI_HANDLE id;
+	interface_t *interfaces;
+	struct handle *next;
+} handle_t;
+
+/* In creation order */
+static handle_t *handles;
+
+static handle_t *find_handle(EFI_HANDLE Handle)
+{
+	handle_t *h;
+
+	for (h = handles; h; h = h->next)
+		if (h->id == Handle)
+			return h;
+
+	return NULL;
+}
+
+static interface_t *find_interface(handle_t *h, EFI_GUID *Protocol)
+{
+	interface_t *inte;
+
+	for (inte = h->interfaces; inte; inte = inte->next)
+		if (!guidcmp(&inte->protocol, Protocol))
+			return inte;
+
+	return NULL;
+}
 
 static EFIAPI EFI_STATUS
 install_protocol_interface(EFI_HANDLE *Handle,
@@ -52,39 +85,46 @@ install_protocol_interface(EFI_HANDLE *Handle,
 			   EFI_INTERFACE_TYPE InterfaceType,
 			   VOID *Interface)
 {
-	interface_t *inte;
-	unsigned int i;
+	interface_t *inte, **cur;
+	handle_t *h, **last;
 
 	if (!Handle || !Protocol ||
 	    InterfaceType != EFI_NATIVE_INTERFACE)
 		return EFI_INVALID_PARAMETER;
 
-	if (*Handle) {
-		for (i = 0; i < ARRAY_SIZE(INTERFACES); i++)
-			if (INTERFACES[i].installed &&
-			    !guidcmp(&INTERFACES[i].protocol, Protocol) &&
-			    INTERFACES[i].handle == *Handle)
-				return EFI_INVALID_PARAMETER;
-	}
+	h = *Handle ? find_handle(*Handle) : NULL;
+	if (h && find_interface(h, Protocol))
+		return EFI_INVALID_PARAMETER;
+
+	inte = malloc(sizeof(*inte));
+	if (!inte)
+		return EFI_OUT_OF_RESOURCES;
 
-	for (i = 0; i < ARRAY_SIZE(INTERFACES); i++) {
-		inte = &INTERFACES[i];
-		if (!inte->installed) {
-			if (*Handle)
-				inte->handle = *Handle;
-			else {
-				inte->handle = inte;
-				*Handle = inte->handle;
-			}
-			memcpy(&inte->protocol, Protocol, sizeof(*Protocol));
-			inte->interface = Interface;
-			inte->installed = TRUE;
+	memcpy(&inte->protocol, Protocol, sizeof(*Protocol));
+	inte->interface = Interface;
+	inte->next = NULL;
 
-			return EFI_SUCCESS;
+	if (!h) {
+		h = malloc(sizeof(*h));
+		if (!h) {
+			free(inte);
+			return EFI_OUT_OF_RESOURCES;
 		}
+
+		h->id = *Handle ? *Handle : h;
+		h->interfaces = NULL;
+		h->next = NULL;
+		for (last = &handles; *last; last = &(*last)->next)
+			;
+		*last = h;
 	}
 
-	return EFI_OUT_OF_RESOURCES;
+	for (cur = &h->interfaces; *cur; cur = &(*cur)->next)
+		;
+	*cur = inte;
+	*Handle = h->id;
+
+	return EFI_SUCCESS;
 }
 
 static EFIAPI EFI_STATUS
@@ -93,16 +133,19 @@ reinstall_protocol_interface(EFI_HANDLE Handle,
 			     VOID *OldInterface,
 			     VOID *NewInterface)
 {
-	unsigned int i;
+	interface_t *inte;
+	handle_t *h;
 
 	if (!Handle || !Protocol)
 		return EFI_INVALID_PARAMETER;
 
-	for (i = 0; i < ARRAY_SIZE(INTERFACES); i++)
-		if (INTERFACES[i].installed &&
-		    INTERFACES[i].handle == Handle &&
-		    INTERFACES[i].interface == OldInterface) {
-			INTERFACES[i].interface = NewInterface;
+	h = find_handle(Handle);
+	if (!h)
+		return EFI_NOT_FOUND;
+
+	for (inte = h->interfaces; inte; inte = inte->next)
+		if (inte->interface == OldInterface) {
+			inte->interface = NewInterface;
 			return EFI_SUCCESS;
 		}
 
@@ -114,23 +157,35 @@ uninstall_protocol_interface(EFI_HANDLE Handle,
 			     EFI_GUID *Protocol,
 			     VOID *Interface)
 {
-	interface_t *inte;
-	unsigned int i;
+	interface_t *inte, **cur;
+	handle_t *h, **hcur;
 
 	if (!Handle || !Protocol)
 		return EFI_INVALID_PARAMETER;
 
-	for (i = 0; i < ARRAY_SIZE(INTERFACES); i++) {
-		inte = &INTERFACES[i];
-		if (inte->installed && inte->handle == Handle &&
-		    !guidcmp(&inte->protocol, Protocol) &&
-		    inte->interface == Interface) {
-			inte->installed = FALSE;
-			return EFI_SUCCESS;
-		}
+	h = find_handle(Handle);
+	if (!h)
+		return EFI_NOT_FOUND;
+
+	for (cur = &h->interfaces; (inte = *cur); cur = &inte->next)
+		if (!guidcmp(&inte->protocol, Protocol) &&
+		    inte->interface == Interface)
+			break;
+
+	if (!inte)
+		return EFI_NOT_FOUND;
+
+	*cur = inte->next;
+	free(inte);
+
+	if (!h->interfaces) {
+		for (hcur = &handles; *hcur != h; hcur = &(*hcur)->next)
+			;
+		*hcur = h->next;
+		free(h);
 	}
 
-	return EFI_NOT_FOUND;
+	return EFI_SUCCESS;
 }
 
 static EFIAPI EFI_STATUS
@@ -139,22 +194,33 @@ handle_protocol(EFI_HANDLE Handle,
 		VOID **Interface)
 {
 	interface_t *inte;
-	unsigned int i;
+	handle_t *h;
 
 	if (!Handle || !Protocol || !Interface)
 		return EFI_INVALID_PARAMETER;
 
-	for (i = 0; i < ARRAY_SIZE(INTERFACES); i++) {
-		inte = &INTERFACES[i];
-		if (inte->installed &&
-		    inte->handle == Handle &&
-		    !guidcmp(&inte->protocol, Protocol)) {
-			*Interface = inte->interface;
-			return EFI_SUCCESS;
-		}
-	}
+	/* The partition handles are brought up to date with the GPT
+	   before any lookup. */
+	ewdrv_provide(Protocol);
+	partition_refresh();
 
-	return EFI_NOT_FOUND;
+	h = find_handle(Handle);
+	if (!h)
+		return EFI_NOT_FOUND;
+
+	inte = find_interface(h, Protocol);
+	if (!inte)
+		return EFI_NOT_FOUND;
+
+	*Interface = inte->interface;
+
+	return EFI_SUCCESS;
+}
+
+static BOOLEAN handle_match(handle_t *h, EFI_LOCATE_SEARCH_TYPE SearchType,
+			    EFI_GUID *Protocol)
+{
+	return SearchType == AllHandles || find_interface(h, Protocol) != NULL;
 }
 
 static EFIAPI EFI_STATUS
@@ -164,8 +230,8 @@ locate_handle(EFI_LOCATE_SEARCH_TYPE SearchType,
 	      UINTN *BufferSize,
 	      EFI_HANDLE *Buffer)
 {
-	interface_t *inte;
-	unsigned int i, nb = 0;
+	handle_t *h;
+	unsigned int nb = 0;
 
 	if (!Protocol || !BufferSize || !Buffer)
 		return EFI_INVALID_PARAMETER;
@@ -178,19 +244,18 @@ locate_handle(EFI_LOCATE_SEARCH_TYPE SearchType,
 	if (SearchType == ByRegisterNotify)
 		return EFI_UNSUPPORTED;
 
-	for (i = 0; i < ARRAY_SIZE(INTERFACES); i++) {
-		inte = &INTERFACES[i];
-		if (!inte->installed)
-			continue;
+	if (SearchType == ByProtocol)
+		ewdrv_provide(Protocol);
+	partition_refresh();
 
-		if (SearchType == ByProtocol &&
-		    guidcmp(&inte->protocol, Protocol))
+	for (h = handles; h; h = h->next) {
+		if (!handle_match(h, SearchType, Protocol))
 			continue;
 
 		if ((nb + 1) * sizeof(*Buffer) > *BufferSize)
 			return EFI_BUFFER_TOO_SMALL;
 
-		Buffer[nb++] = inte->handle;
+		Buffer[nb++] = h->id;
 	}
 
 	if (nb == 0)
@@ -298,8 +363,8 @@ locate_handle_buffer(EFI_LOCATE_SEARCH_TYPE SearchType,
 		     UINTN *NoHandles,
 		     EFI_HANDLE **Buffer)
 {
-	interface_t *inte;
-	unsigned int i, nb, cur;
+	handle_t *h;
+	unsigned int nb, cur;
 	EFI_HANDLE *buf;
 
 	if (!Protocol || !NoHandles || !Buffer)
@@ -313,15 +378,13 @@ locate_handle_buffer(EFI_LOCATE_SEARCH_TYPE SearchType,
 	if (SearchType == ByRegisterNotify)
 		return EFI_UNSUPPORTED;
 
-	for (i = 0, nb = 0; i < ARRAY_SIZE(INTERFACES); i++) {
-		inte = &INTERFACES[i];
-		if (!inte->installed)
-			continue;
+	if (SearchType == ByProtocol)
+		ewdrv_provide(Protocol);
+	partition_refresh();
 
-		if (SearchType == ByProtocol &&
-		    !guidcmp(&inte->protocol, Protocol))
+	for (h = handles, nb = 0; h; h = h->next)
+		if (handle_match(h, SearchType, Protocol))
 			nb++;
-	}
 
 	if (nb == 0)
 		return EFI_NOT_FOUND;
@@ -330,17 +393,9 @@ locate_handle_buffer(EFI_LOCATE_SEARCH_TYPE SearchType,
 	if (!buf)
 		return EFI_OUT_OF_RESOURCES;
 
-	for (i = 0, cur = 0; i < ARRAY_SIZE(INTERFACES); i++) {
-		inte = &INTERFACES[i];
-		if (!inte->installed)
-			continue;
-
-		if (SearchType == ByProtocol &&
-		    guidcmp(&inte->protocol, Protocol))
-			continue;
-
-		buf[cur++] = inte->handle;
-	}
+	for (h = handles, cur = 0; h; h = h->next)
+		if (handle_match(h, SearchType, Protocol))
+			buf[cur++] = h->id;
 
 	*NoHandles = nb;
 	*Buffer = buf;
@@ -349,11 +404,29 @@ locate_handle_buffer(EFI_LOCATE_SEARCH_TYPE SearchType,
 }
 
 static EFIAPI EFI_STATUS
-locate_protocol(__attribute__((__unused__)) EFI_GUID *Protocol,
+locate_protocol(EFI_GUID *Protocol,
 		__attribute__((__unused__)) VOID *Registration,
-		__attribute__((__unused__)) VOID **Interface)
+		VOID **Interface)
 {
-	return EFI_UNSUPPORTED;
+	interface_t *inte;
+	handle_t *h;
+
+	if (!Protocol || !Interface)
+		return EFI_INVALID_PARAMETER;
+
+	ewdrv_provide(Protocol);
+	partition_refresh();
+
+	for (h = handles; h; h = h->next) {
+		inte = find_interface(h, Protocol);
+		if (inte) {
+			*Interface = inte->interface;
+			return EFI_SUCCESS;
+		}
+	}
+
+	*Interface = NULL;
+	return EFI_NOT_FOUND;
 }
 
 EFI_STATUS protocol_init_bs(EFI_BOOT_SERVICES *bs)
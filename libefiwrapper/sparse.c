@@ -0,0 +1,290 @@
+/*
+ * Copyright (c) 2026, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "sparse.h"
+#include "external.h"
+#include "interface.h"
+#include "ewlib.h"
+#include "ewlog.h"
+#include "sparse_format.h"
+
+typedef struct sparse_write {
+	EFIWRAPPER_SPARSE_WRITE_PROTOCOL interface;
+	media_t *media;
+} sparse_write_t;
+
+/* The RAW and FILL chunks data are gathered in SEGS, to be written
+   with a single vectored write from block START.  NEXT is the block
+   the next chunk starts at. */
+typedef struct sparse_writer {
+	media_t *media;
+	EFI_LBA start;
+	EFI_LBA next;
+	storage_seg_t segs[SPARSE_MAX_SEGS];
+	UINTN nb_segs;
+	UINT32 *fill;
+	UINT32 fill_value;
+} sparse_writer_t;
+
+static EFI_STATUS flush_segs(sparse_writer_t *sw)
+{
+	EFI_STATUS ret;
+
+	if (!sw->nb_segs)
+		return EFI_SUCCESS;
+
+	ret = media_writev(sw->media, sw->start, sw->segs, sw->nb_segs);
+	sw->nb_segs = 0;
+	sw->start = sw->next;
+
+	return ret;
+}
+
+static EFI_STATUS push_seg(sparse_writer_t *sw, void *buf, UINTN len)
+{
+	EFI_STATUS ret;
+
+	if (!len)
+		return EFI_SUCCESS;
+
+	if (sw->nb_segs == ARRAY_SIZE(sw->segs)) {
+		ret = flush_segs(sw);
+		if (EFI_ERROR(ret))
+			return ret;
+	}
+
+	sw->segs[sw->nb_segs].buf = buf;
+	sw->segs[sw->nb_segs].len = len;
+	sw->nb_segs++;
+	sw->next += len / sw->media->m.BlockSize;
+
+	return EFI_SUCCESS;
+}
+
+static EFI_STATUS skip(sparse_writer_t *sw, EFI_LBA count)
+{
+	EFI_STATUS ret;
+
+	ret = flush_segs(sw);
+	sw->next += count;
+	sw->start = sw->next;
+
+	return ret;
+}
+
+static EFI_STATUS fill(sparse_writer_t *sw, UINT32 value, EFI_LBA count)
+{
+	UINT64 left = count * sw->media->m.BlockSize;
+	EFI_STATUS ret;
+	UINTN i, n;
+
+	if (!value) {
+		ret = flush_segs(sw);
+		if (EFI_ERROR(ret))
+			return ret;
+
+		ret = media_write_zeroes(sw->media, sw->next, count);
+		sw->next += count;
+		sw->start = sw->next;
+		return ret;
+	}
+
+	/* The pending segments may point to the previous pattern. */
+	if (!sw->fill || sw->fill_value != value) {
+		ret = flush_segs(sw);
+		if (EFI_ERROR(ret))
+			return ret;
+
+		if (!sw->fill) {
+			sw->fill = malloc(SPARSE_FILL_SIZE);
+			if (!sw->fill)
+				return EFI_OUT_OF_RESOURCES;
+		}
+
+		for (i = 0; i < SPARSE_FILL_SIZE / sizeof(*sw->fill); i++)
+			sw->fill[i] = value;
+		sw->fill_value = value;
+	}
+
+	for (; left; left -= n) {
+		n = min(left, SPARSE_FILL_SIZE);
+		ret = push_seg(sw, sw->fill, n);
+		if (EFI_ERROR(ret))
+			return ret;
+	}
+
+	return EFI_SUCCESS;
+}
+
+static EFI_STATUS write_chunk(sparse_writer_t *sw, sparse_header_t *hdr,
+			      chunk_header_t *chunk, const UINT8 *data)
+{
+	UINT64 size = (UINT64)chunk->chunk_sz * hdr->blk_sz;
+	UINTN data_sz = chunk->total_sz - hdr->chunk_hdr_sz;
+	EFI_LBA count = size / sw->media->m.BlockSize;
+	UINT32 value;
+
+	switch (chunk->chunk_type) {
+	case CHUNK_TYPE_RAW:
+		if (data_sz != size)
+			return EFI_INVALID_PARAMETER;
+		return push_seg(sw, (void *)data, data_sz);
+
+	case CHUNK_TYPE_FILL:
+		if (data_sz != sizeof(value))
+			return EFI_INVALID_PARAMETER;
+		memcpy(&value, data, sizeof(value));
+		return fill(sw, value, count);
+
+	case CHUNK_TYPE_DONT_CARE:
+		if (data_sz)
+			return EFI_INVALID_PARAMETER;
+		return skip(sw, count);
+
+	case CHUNK_TYPE_CRC32:
+		if (data_sz != sizeof(UINT32))
+			return EFI_INVALID_PARAMETER;
+		return EFI_SUCCESS;
+	}
+
+	return EFI_INVALID_PARAMETER;
+}
+
+EFI_STATUS sparse_write(media_t *media, EFI_LBA lba, const void *image,
+			UINTN size)
+{
+	const UINT8 *p = image, *end = p + size;
+	EFI_STATUS ret = EFI_SUCCESS;
+	sparse_header_t hdr;
+	chunk_header_t chunk;
+	sparse_writer_t sw;
+	UINT64 blocks = 0;
+	UINT32 i;
+
+	if (size < sizeof(hdr))
+		return EFI_INVALID_PARAMETER;
+
+	memcpy(&hdr, p, sizeof(hdr));
+	if (hdr.magic != SPARSE_HEADER_MAGIC ||
+	    hdr.file_hdr_sz < sizeof(hdr) || hdr.file_hdr_sz > size ||
+	    hdr.chunk_hdr_sz < sizeof(chunk))
+		return EFI_INVALID_PARAMETER;
+
+	if (hdr.major_version != SPARSE_MAJOR_VERSION ||
+	    !hdr.blk_sz || hdr.blk_sz % media->m.BlockSize ||
+	    hdr.blk_sz % sizeof(UINT32))
+		return EFI_UNSUPPORTED;
+
+	if (lba > media->m.LastBlock ||
+	    (UINT64)hdr.total_blks * (hdr.blk_sz / media->m.BlockSize) >
+	    media->m.LastBlock + 1 - lba)
+		return EFI_INVALID_PARAMETER;
+
+	memset(&sw, 0, sizeof(sw));
+	sw.media = media;
+	sw.start = sw.next = lba;
+
+	for (p += hdr.file_hdr_sz, i = 0; i < hdr.total_chunks; i++) {
+		if ((UINTN)(end - p) < hdr.chunk_hdr_sz) {
+			ret = EFI_INVALID_PARAMETER;
+			break;
+		}
+
+		memcpy(&chunk, p, sizeof(chunk));
+		blocks += chunk.chunk_sz;
+		if (chunk.total_sz < hdr.chunk_hdr_sz ||
+		    chunk.total_sz > (UINTN)(end - p) ||
+		    blocks > hdr.total_blks) {
+			ret = EFI_INVALID_PARAMETER;
+			break;
+		}
+
+		ret = write_chunk(&sw, &hdr, &chunk, p + hdr.chunk_hdr_sz);
+		if (EFI_ERROR(ret))
+			break;
+
+		p += chunk.total_sz;
+	}
+
+	if (ret == EFI_INVALID_PARAMETER)
+		ewerr("Invalid sparse image chunk %u", i);
+
+	if (!EFI_ERROR(ret))
+		ret = flush_segs(&sw);
+
+	free(sw.fill);
+	return ret;
+}
+
+static EFIAPI EFI_STATUS
+write_sparse(EFIWRAPPER_SPARSE_WRITE_PROTOCOL *This, UINT32 MediaId,
+	     EFI_LBA Lba, VOID *Buffer, UINTN BufferSize)
+{
+	sparse_write_t *sparse = (sparse_write_t *)This;
+
+	if (!This || !sparse->media || !Buffer)
+		return EFI_INVALID_PARAMETER;
+
+	if (sparse->media->m.MediaId != MediaId)
+		return EFI_MEDIA_CHANGED;
+
+	return sparse_write(sparse->media, Lba, Buffer, BufferSize);
+}
+
+static EFI_GUID sparse_write_guid = EFIWRAPPER_SPARSE_WRITE_PROTOCOL_GUID;
+
+EFI_STATUS sparse_write_init(EFI_SYSTEM_TABLE *st, media_t *media,
+			     EFI_HANDLE *handle)
+{
+	EFI_STATUS ret;
+	sparse_write_t *sparse;
+
+	static sparse_write_t sparse_write_default = {
+		.interface = {
+			.Revision = EFIWRAPPER_SPARSE_WRITE_PROTOCOL_REVISION,
+			.WriteSparse = write_sparse
+		}
+	};
+
+	ret = interface_init(st, &sparse_write_guid, handle,
+			     &sparse_write_default,
+			     sizeof(sparse_write_default), (void **)&sparse);
+	if (EFI_ERROR(ret))
+		return ret;
+
+	sparse->media = media;
+
+	return EFI_SUCCESS;
+}
+
+EFI_STATUS sparse_write_free(EFI_SYSTEM_TABLE *st, EFI_HANDLE handle)
+{
+	return interface_free(st, &sparse_write_guid, handle);
+}
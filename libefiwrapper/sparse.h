@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) 2026, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef _SPARSE_H_
+#define _SPARSE_H_
+
+#include <efi.h>
+#include <efiapi.h>
+#include <protocol/SparseWrite.h>
+#include "media.h"
+
+/* Largest number of segments of a vectored write of RAW and FILL
+   chunks. */
+#define SPARSE_MAX_SEGS		64
+
+/* Size of the pattern buffer FILL chunks are written from, a
+   multiple of the media block size. */
+#ifndef SPARSE_FILL_SIZE
+#define SPARSE_FILL_SIZE	(64 * 1024)
+#endif
+
+/* Write the SIZE bytes Android sparse IMAGE from block LBA. */
+EFI_STATUS sparse_write(media_t *media, EFI_LBA lba, const void *image,
+			UINTN size);
+
+EFI_STATUS sparse_write_init(EFI_SYSTEM_TABLE *st, media_t *media,
+			     EFI_HANDLE *handle);
+EFI_STATUS sparse_write_free(EFI_SYSTEM_TABLE *st, EFI_HANDLE handle);
+
+#endif
@@ -30,11 +30,19 @@
  */
 
 #include "blockio.h"
+#include "blockio2.h"
 #include "diskio.h"
+#include "diskio2.h"
 #include "eraseblk.h"
 #include "external.h"
 #include "lib.h"
 #include "media.h"
+#include "mediastats.h"
+#include "partition.h"
+#include "writezeroes.h"
+#include "blockcopy.h"
+#include "sparse.h"
+#include "mappedblkio.h"
 #include "interface.h"
 #include "ewlog.h"
 #include "ewarg.h"
@@ -113,7 +121,8 @@ static EFI_STATUS dp_init(EFI_SYSTEM_TABLE *st, media_t *media,
 	dp->ctrl.Header.SubType = HW_CONTROLLER_DP;
 	SetDevicePathNodeLength(&dp->ctrl.Header, sizeof(dp->ctrl));
 
-	dp->msg_device_path.Header.SubType = get_boot_media_device_path_type();
+	dp->msg_device_path.Header.SubType =
+		get_storage_device_path_type(media->storage->type);
 	dp->msg_device_path.Header.Type = MESSAGING_DEVICE_PATH;
 	dp->msg_device_path.Pun = 0;
 	dp->msg_device_path.Lun = 0;
@@ -145,8 +154,16 @@ static struct storage_interface {
 	{ "media", media_register, media_free },
 	{ "device path", dp_init, dp_free },
 	{ "blockio", blockio_init, blockio_free },
+	{ "blockio2", blockio2_init, blockio2_free },
 	{ "diskio", diskio_init, diskio_free },
-	{ "eraseblock", erase_block_init, erase_block_free }
+	{ "diskio2", diskio2_init, diskio2_free },
+	{ "eraseblock", erase_block_init, erase_block_free },
+	{ "media stats", media_stats_init, media_stats_free },
+	{ "write zeroes", write_zeroes_init, write_zeroes_free },
+	{ "block copy", block_copy_init, block_copy_free },
+	{ "sparse write", sparse_write_init, sparse_write_free },
+	{ "mapped blockio", mapped_blockio_init, mapped_blockio_free },
+	{ "partitions", partition_init, partition_free }
 };
 
 EFI_STATUS storage_init(EFI_SYSTEM_TABLE *st, storage_t *storage,
@@ -182,13 +199,17 @@ EFI_STATUS storage_init(EFI_SYSTEM_TABLE *st, storage_t *storage,
 	return EFI_SUCCESS;
 
 err:
-	for (j = 0; j < i; j++) {
-		tmp_ret = STORAGE_INTERFACES[i].free(st, handle);
+	for (j = i; j > 0; j--) {
+		tmp_ret = STORAGE_INTERFACES[j - 1].free(st, handle);
 		if (EFI_ERROR(tmp_ret))
 			ewerr("Failed to unregister %s interface",
-			      STORAGE_INTERFACES[i].name);
+			      STORAGE_INTERFACES[j - 1].name);
+	}
+	/* Once registered, the media is released by media_free(). */
+	if (i == 0) {
+		blkcache_free(media->cache);
+		free(media);
 	}
-	free(media);
 	return ret;
 }
 
@@ -200,11 +221,13 @@ EFI_STATUS storage_free(EFI_SYSTEM_TABLE *st, EFI_HANDLE handle)
 	if (!st || !handle)
 		return EFI_INVALID_PARAMETER;
 
-	for (i = 0; i < ARRAY_SIZE(STORAGE_INTERFACES); i++) {
-		ret = STORAGE_INTERFACES[i].free(st, handle);
+	/* Interfaces are released in the reverse order so that the
+	   partitions go before their disk media. */
+	for (i = ARRAY_SIZE(STORAGE_INTERFACES); i > 0; i--) {
+		ret = STORAGE_INTERFACES[i - 1].free(st, handle);
 		if (EFI_ERROR(ret)) {
 			ewerr("Failed to unregister %s interface",
-			      STORAGE_INTERFACES[i].name);
+			      STORAGE_INTERFACES[i - 1].name);
 			return ret;
 		}
 	}
@@ -212,6 +235,16 @@ EFI_STATUS storage_free(EFI_SYSTEM_TABLE *st, EFI_HANDLE handle)
 	return EFI_SUCCESS;
 }
 
+EFI_STATUS storage_poll(void)
+{
+	return media_poll_all();
+}
+
+void storage_set_trace(storage_trace_t trace)
+{
+	media_set_trace(trace);
+}
+
 static enum storage_type convert_sbl_dev_type(SBL_OS_BOOT_MEDIUM_TYPE type)
 {
 	switch(type) {
@@ -311,7 +344,12 @@ boot_dev_t* get_boot_media()
 
 UINT8 get_boot_media_device_path_type(void)
 {
-	switch(boot_dev.type)
+	return get_storage_device_path_type(boot_dev.type);
+}
+
+UINT8 get_storage_device_path_type(enum storage_type type)
+{
+	switch(type)
 	{
 	case STORAGE_EMMC:
 		return MSG_EMMC_DP;
@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2026, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "writezeroes.h"
+#include "external.h"
+#include "interface.h"
+
+typedef struct write_zeroes {
+	EFIWRAPPER_WRITE_ZEROES_PROTOCOL interface;
+	media_t *media;
+} write_zeroes_t;
+
+static EFIAPI EFI_STATUS
+write_zeroes(EFIWRAPPER_WRITE_ZEROES_PROTOCOL *This, UINT32 MediaId,
+	     EFI_LBA Lba, UINTN Size)
+{
+	write_zeroes_t *wz = (write_zeroes_t *)This;
+	media_t *media;
+	EFI_LBA count;
+
+	if (!This || !wz->media)
+		return EFI_INVALID_PARAMETER;
+
+	media = wz->media;
+	if (media->m.MediaId != MediaId)
+		return EFI_MEDIA_CHANGED;
+
+	if (Size % media->m.BlockSize)
+		return EFI_BAD_BUFFER_SIZE;
+
+	count = Size / media->m.BlockSize;
+	if (Lba > media->m.LastBlock || count > media->m.LastBlock + 1 - Lba)
+		return EFI_INVALID_PARAMETER;
+
+	return media_write_zeroes(media, Lba, count);
+}
+
+static EFI_GUID write_zeroes_guid = EFIWRAPPER_WRITE_ZEROES_PROTOCOL_GUID;
+
+EFI_STATUS write_zeroes_init(EFI_SYSTEM_TABLE *st, media_t *media,
+			     EFI_HANDLE *handle)
+{
+	EFI_STATUS ret;
+	write_zeroes_t *wz;
+
+	static write_zeroes_t write_zeroes_default = {
+		.interface = {
+			.Revision = EFIWRAPPER_WRITE_ZEROES_PROTOCOL_REVISION,
+			.WriteZeroes = write_zeroes
+		}
+	};
+
+	ret = interface_init(st, &write_zeroes_guid, handle,
+			     &write_zeroes_default,
+			     sizeof(write_zeroes_default), (void **)&wz);
+	if (EFI_ERROR(ret))
+		return ret;
+
+	wz->media = media;
+
+	return EFI_SUCCESS;
+}
+
+EFI_STATUS write_zeroes_free(EFI_SYSTEM_TABLE *st, EFI_HANDLE handle)
+{
+	return interface_free(st, &write_zeroes_guid, handle);
+}
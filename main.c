@@ -36,6 +36,14 @@
 #include <ewvar.h>
 #include <ewdrv.h>
 #include <ewlog.h>
+#include <ewperf.h>
+
+/* The firmware runs on IA: boot-time measurements use the Time Stamp
+   Counter whose frequency the ACPI driver sets. */
+static UINT64 read_tsc(void)
+{
+	return __builtin_ia32_rdtsc();
+}
 
 /* Entry point */
 int main(int argc, char **argv)
@@ -44,6 +52,8 @@ int main(int argc, char **argv)
 	EFI_SYSTEM_TABLE *st;
 	EFI_STATUS ret;
 
+	ewperf_set_clock(read_tsc);
+
 	ret = efiwrapper_init(argc, argv, &st, &image);
 	if (ret) {
 		ewerr("efiwrapper library initialization failed");
@@ -56,6 +66,7 @@ int main(int argc, char **argv)
 		return EXIT_FAILURE;
 	}
 
+	ewperf_boot_step(EWPERF_START_IMAGE);
 	ret = efi_main(image, st);
 	if (EFI_ERROR(ret))
 		ewerr("The EFI program exited with error code: 0x%x", ret);